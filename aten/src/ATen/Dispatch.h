@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ATen/Type.h>
+#include <ATen/core/BFloat16.h>
 #include <ATen/core/Half.h>
 #include <c10/util/Exception.h>
 
@@ -33,6 +34,20 @@
     }                                                                        \
   }()
 
+#define AT_DISPATCH_FLOATING_TYPES_AND_HALF_AND_BFLOAT16(TYPE, NAME, ...)    \
+  [&] {                                                                      \
+    const at::Type& the_type = TYPE;                                         \
+    switch (the_type.scalarType()) {                                         \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Double, double, __VA_ARGS__)      \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Float, float, __VA_ARGS__)        \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Half, at::Half, __VA_ARGS__)      \
+      AT_PRIVATE_CASE_TYPE(                                                  \
+          at::ScalarType::BFloat16, at::BFloat16, __VA_ARGS__)               \
+      default:                                                               \
+        AT_ERROR(#NAME, " not implemented for '", the_type.toString(), "'"); \
+    }                                                                        \
+  }()
+
 #define AT_DISPATCH_FLOATING_AND_COMPLEX_TYPES(TYPE, NAME, ...)              \
   [&] {                                                                      \
     const at::Type& the_type = TYPE;                                         \
@@ -98,6 +113,25 @@
     }                                                                        \
   }()
 
+#define AT_DISPATCH_ALL_TYPES_AND_HALF_AND_BFLOAT16(TYPE, NAME, ...)         \
+  [&] {                                                                      \
+    const at::Type& the_type = TYPE;                                         \
+    switch (the_type.scalarType()) {                                         \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Byte, uint8_t, __VA_ARGS__)       \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Char, int8_t, __VA_ARGS__)        \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Double, double, __VA_ARGS__)      \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Float, float, __VA_ARGS__)        \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Int, int32_t, __VA_ARGS__)        \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Long, int64_t, __VA_ARGS__)       \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Short, int16_t, __VA_ARGS__)      \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Half, at::Half, __VA_ARGS__)      \
+      AT_PRIVATE_CASE_TYPE(                                                  \
+          at::ScalarType::BFloat16, at::BFloat16, __VA_ARGS__)               \
+      default:                                                               \
+        AT_ERROR(#NAME, " not implemented for '", the_type.toString(), "'"); \
+    }                                                                        \
+  }()
+
 #define AT_DISPATCH_COMPLEX_TYPES(TYPE, NAME, ...)                           \
   [&] {                                                                      \
     const at::Type& the_type = TYPE;                                         \
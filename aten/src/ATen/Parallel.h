@@ -1,8 +1,10 @@
 #pragma once
 #include <ATen/ATen.h>
+#include <ATen/Config.h>
 #include <atomic>
 #include <cstddef>
 #include <exception>
+#include <functional>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -18,11 +20,73 @@ namespace internal {
 constexpr int64_t GRAIN_SIZE = 32768;
 } // namespace internal
 
+// Backends that parallel_for and parallel_reduce can run on.
+//
+// OpenMP: `#pragma omp parallel`, one static chunk per thread. Nested calls
+// run serially on the calling thread.
+//
+// Native: a work-stealing pool built on c10::ThreadPool. The range is cut
+// into GRAIN_SIZE-bounded chunks that are distributed over per-worker deques;
+// idle workers steal from the back of other workers' deques, and the calling
+// thread always participates, so nested calls are parallelized as well
+// instead of being serialized.
+//
+// The default is picked at build time (ATEN_THREADING=OMP|NATIVE) and can
+// be overridden at run time with the ATEN_PARALLEL_BACKEND environment
+// variable ("openmp" or "native") or set_parallel_backend().
+enum class ParallelBackend { OpenMP, Native };
+
+CAFFE2_API void set_parallel_backend(ParallelBackend backend);
+CAFFE2_API ParallelBackend get_parallel_backend();
+
+// Thread pools
+//
+// ATen owns two pools and every CPU parallelism source should go through
+// them so that the total number of threads stays bounded:
+//
+//  - the intra-op pool, used by parallel_for/parallel_reduce inside a single
+//    op (the OpenMP runtime or the native work-stealing pool);
+//  - the inter-op pool (c10::global_work_queue()), used to run independent
+//    ops concurrently: JIT fork/wait and, if they opt in with
+//    --caffe2_net_async_use_interop_pool, caffe2 async nets.
+//
+// The intra-op size defaults to OMP_NUM_THREADS/MKL_NUM_THREADS, or the
+// number of cores; the inter-op size to ATEN_NUM_INTEROP_THREADS, or 1.
+// The native intra-op pool and the inter-op pool are sized on first use, so
+// changing their size afterwards is an error.
+CAFFE2_API void set_num_intraop_threads(int nthreads);
+CAFFE2_API int get_num_intraop_threads();
+CAFFE2_API void set_num_interop_threads(int nthreads);
+CAFFE2_API int get_num_interop_threads();
+
+// Runs func asynchronously on the inter-op pool.
+CAFFE2_API void launch(std::function<void()> func);
+
+namespace internal {
+inline bool use_native_backend() {
+  return get_parallel_backend() == ParallelBackend::Native;
+}
+
+// Implemented in ParallelNative.cpp
+CAFFE2_API void parallel_run_native(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f);
+CAFFE2_API int native_get_max_threads();
+CAFFE2_API int native_get_thread_num();
+CAFFE2_API bool native_in_parallel_region();
+CAFFE2_API void native_set_num_threads(int nthreads);
+} // namespace internal
+
 inline int64_t divup(int64_t x, int64_t y) {
   return (x + y - 1) / y;
 }
 
 inline int get_max_threads() {
+  if (internal::use_native_backend()) {
+    return internal::native_get_max_threads();
+  }
 #ifdef _OPENMP
   return omp_get_max_threads();
 #else
@@ -31,6 +95,9 @@ inline int get_max_threads() {
 }
 
 inline int get_thread_num() {
+  if (internal::use_native_backend()) {
+    return internal::native_get_thread_num();
+  }
 #ifdef _OPENMP
   return omp_get_thread_num();
 #else
@@ -39,6 +106,9 @@ inline int get_thread_num() {
 }
 
 inline bool in_parallel_region() {
+  if (internal::use_native_backend()) {
+    return internal::native_in_parallel_region();
+  }
 #ifdef _OPENMP
   return omp_in_parallel();
 #else
@@ -52,6 +122,13 @@ inline void parallel_for(
     const int64_t end,
     const int64_t grain_size,
     const F& f) {
+  if (internal::use_native_backend()) {
+    internal::parallel_run_native(
+        begin, end, grain_size, [&f](int64_t begin_, int64_t end_) {
+          f(begin_, end_);
+        });
+    return;
+  }
 #ifdef _OPENMP
   std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
   std::exception_ptr eptr;
@@ -95,6 +172,20 @@ inline scalar_t parallel_reduce(
     const int64_t num_results = divup((end - begin), grain_size);
     std::vector<scalar_t> results(num_results);
     scalar_t* results_data = results.data();
+    if (internal::use_native_backend()) {
+      // Each result slot covers exactly one grain, so the combination order
+      // below is the same as with OpenMP regardless of which worker ran it.
+      internal::parallel_run_native(
+          0, num_results, 1, [&](int64_t id_begin, int64_t id_end) {
+            for (int64_t id = id_begin; id < id_end; id++) {
+              int64_t i = begin + id * grain_size;
+              results_data[id] =
+                  f(i, i + std::min(end - i, grain_size), ident);
+            }
+          });
+      return std::accumulate(
+          results_data, results_data + results.size(), ident, sf);
+    }
 #pragma omp parallel for if ((end - begin) >= grain_size)
     for (int64_t id = 0; id < num_results; id++) {
       int64_t i = begin + id * grain_size;
@@ -0,0 +1,35 @@
+#include <ATen/Parallel.h>
+#include <ATen/core/thread_pool.h>
+
+#include <TH/TH.h>
+
+#include <utility>
+
+namespace at {
+
+void set_num_intraop_threads(int nthreads) {
+  AT_CHECK(nthreads > 0, "Expected positive number of threads");
+  // Also sets at::get_num_threads(), which the native pool reads when it is
+  // created; keep OpenMP and MKL in sync with it.
+  internal::native_set_num_threads(nthreads);
+  THSetNumThreads(nthreads);
+}
+
+int get_num_intraop_threads() {
+  return get_max_threads();
+}
+
+void set_num_interop_threads(int nthreads) {
+  AT_CHECK(nthreads > 0, "Expected positive number of threads");
+  c10::set_num_interop_threads(nthreads);
+}
+
+int get_num_interop_threads() {
+  return static_cast<int>(c10::get_num_interop_threads());
+}
+
+void launch(std::function<void()> func) {
+  c10::global_work_queue().run(std::move(func));
+}
+
+} // namespace at
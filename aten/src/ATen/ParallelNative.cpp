@@ -0,0 +1,261 @@
+#include <ATen/Parallel.h>
+#include <ATen/core/thread_pool.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace at {
+
+namespace {
+
+ParallelBackend compute_default_backend() {
+  auto envar = std::getenv("ATEN_PARALLEL_BACKEND");
+  if (envar) {
+    if (strcmp(envar, "native") == 0) {
+      return ParallelBackend::Native;
+    }
+    if (strcmp(envar, "openmp") == 0) {
+      return ParallelBackend::OpenMP;
+    }
+    AT_WARN("ignoring invalid value for ATEN_PARALLEL_BACKEND: ", envar);
+  }
+#if AT_PARALLEL_NATIVE()
+  return ParallelBackend::Native;
+#else
+  return ParallelBackend::OpenMP;
+#endif
+}
+
+std::atomic<ParallelBackend>& backend() {
+  static std::atomic<ParallelBackend> backend_(compute_default_backend());
+  return backend_;
+}
+
+// Number of chunks each participant gets up front. More than one chunk per
+// worker lets fast workers steal the tail of slow ones.
+constexpr int64_t CHUNKS_PER_WORKER = 4;
+
+// Thread-local state describing the parallel region the current thread is
+// executing in, if any.
+thread_local bool in_parallel_region_ = false;
+thread_local int thread_num_ = 0;
+
+struct ParallelRegionGuard {
+  explicit ParallelRegionGuard(int thread_num)
+      : prev_in_region_(in_parallel_region_), prev_thread_num_(thread_num_) {
+    in_parallel_region_ = true;
+    thread_num_ = thread_num;
+  }
+  ~ParallelRegionGuard() {
+    in_parallel_region_ = prev_in_region_;
+    thread_num_ = prev_thread_num_;
+  }
+
+ private:
+  bool prev_in_region_;
+  int prev_thread_num_;
+};
+
+// Size the pool was created with, 0 until it is first used. Guarded by
+// intraop_pool_mutex_ together with the requested size (at::get_num_threads),
+// so that the size cannot change between the check in native_set_num_threads
+// and the creation of the pool.
+std::mutex intraop_pool_mutex_;
+int intraop_pool_size_ = 0;
+
+int intraop_pool_size() {
+  int num_threads = get_num_threads();
+  if (num_threads > 0) {
+    return num_threads;
+  }
+  return std::max<int>(std::thread::hardware_concurrency(), 1);
+}
+
+// The pool holds one thread less than the requested parallelism because the
+// calling thread always takes part in the work.
+c10::ThreadPool& intraop_pool() {
+  static c10::ThreadPool pool([] {
+    std::lock_guard<std::mutex> lock(intraop_pool_mutex_);
+    intraop_pool_size_ = intraop_pool_size();
+    return intraop_pool_size_ - 1;
+  }());
+  return pool;
+}
+
+// State shared between the participants of one parallel_run_native call.
+// Chunks are pre-distributed over one deque per participant; a participant
+// pops from the front of its own deque and steals from the back of the
+// others once it runs dry.
+//
+// Helper tasks may be dequeued by the pool long after the call returned
+// (e.g. when all workers were busy), so the task is reference counted and
+// the callable is only touched after a chunk was successfully claimed, which
+// implies the caller is still waiting.
+struct ParallelTask {
+  using range_t = std::pair<int64_t, int64_t>;
+
+  struct WorkerDeque {
+    std::mutex mutex;
+    std::deque<range_t> chunks;
+  };
+
+  ParallelTask(
+      size_t num_workers,
+      int64_t num_chunks,
+      const std::function<void(int64_t, int64_t)>& f)
+      : deques(num_workers),
+        remaining(num_chunks),
+        next_worker(1),
+        fn(f) {}
+
+  bool pop(size_t worker, range_t& chunk) {
+    {
+      auto& own = deques[worker];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.chunks.empty()) {
+        chunk = own.chunks.front();
+        own.chunks.pop_front();
+        return true;
+      }
+    }
+    for (size_t i = 1; i < deques.size(); i++) {
+      auto& victim = deques[(worker + i) % deques.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.chunks.empty()) {
+        chunk = victim.chunks.back();
+        victim.chunks.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void work(size_t worker) {
+    range_t chunk;
+    while (pop(worker, chunk)) {
+      {
+        ParallelRegionGuard guard(worker);
+        try {
+          fn(chunk.first, chunk.second);
+        } catch (...) {
+          if (!err_flag.test_and_set()) {
+            eptr = std::current_exception();
+          }
+        }
+      }
+      if (--remaining == 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.notify_all();
+      }
+    }
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return remaining.load() == 0; });
+  }
+
+  std::vector<WorkerDeque> deques;
+  std::atomic<int64_t> remaining;
+  std::atomic<size_t> next_worker;
+  std::mutex mutex;
+  std::condition_variable done;
+  std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
+  std::exception_ptr eptr;
+  const std::function<void(int64_t, int64_t)>& fn;
+};
+
+} // namespace
+
+void set_parallel_backend(ParallelBackend b) {
+  backend().store(b);
+}
+
+ParallelBackend get_parallel_backend() {
+  return backend().load();
+}
+
+namespace internal {
+
+int native_get_max_threads() {
+  return static_cast<int>(intraop_pool().size()) + 1;
+}
+
+int native_get_thread_num() {
+  return thread_num_;
+}
+
+bool native_in_parallel_region() {
+  return in_parallel_region_;
+}
+
+void native_set_num_threads(int nthreads) {
+  std::lock_guard<std::mutex> lock(intraop_pool_mutex_);
+  AT_CHECK(
+      intraop_pool_size_ == 0 || intraop_pool_size_ == nthreads,
+      "Cannot set the number of intra-op threads to ", nthreads,
+      " after the native thread pool was started with ", intraop_pool_size_);
+  set_num_threads(nthreads);
+}
+
+void parallel_run_native(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f) {
+  if (begin >= end) {
+    return;
+  }
+  const int64_t range = end - begin;
+  grain_size = std::max<int64_t>(grain_size, 1);
+
+  auto& pool = intraop_pool();
+  const int64_t num_workers =
+      std::min<int64_t>(pool.size() + 1, divup(range, grain_size));
+  if (range < grain_size || num_workers <= 1) {
+    ParallelRegionGuard guard(0);
+    f(begin, end);
+    return;
+  }
+
+  const int64_t chunk_size = std::max(
+      grain_size, divup(range, num_workers * CHUNKS_PER_WORKER));
+  const int64_t num_chunks = divup(range, chunk_size);
+
+  auto task = std::make_shared<ParallelTask>(num_workers, num_chunks, f);
+  // Hand out contiguous runs of chunks so each worker starts on its own
+  // region of memory.
+  const int64_t chunks_per_worker = divup(num_chunks, num_workers);
+  for (int64_t c = 0; c < num_chunks; c++) {
+    int64_t chunk_begin = begin + c * chunk_size;
+    task->deques[c / chunks_per_worker].chunks.emplace_back(
+        chunk_begin, std::min(end, chunk_begin + chunk_size));
+  }
+
+  for (int64_t i = 1; i < num_workers; i++) {
+    pool.run([task] {
+      size_t worker = task->next_worker++;
+      if (worker < task->deques.size()) {
+        task->work(worker);
+      }
+    });
+  }
+
+  task->work(0);
+  task->wait();
+
+  if (task->eptr) {
+    std::rethrow_exception(task->eptr);
+  }
+}
+
+} // namespace internal
+} // namespace at
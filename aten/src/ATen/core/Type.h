@@ -50,6 +50,7 @@ enum class TypeID {
   CPULong,
   CPUShort,
   CPUHalf,
+  CPUBFloat16,
   SparseCPUByte,
   SparseCPUChar,
   SparseCPUDouble,
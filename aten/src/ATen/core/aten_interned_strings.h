@@ -47,6 +47,8 @@ _(aten, _convolution) \
 _(aten, _convolution_double_backward) \
 _(aten, _convolution_nogroup) \
 _(aten, _copy_ignoring_overlaps) \
+_(aten, _cpu_conv2d) \
+_(aten, _cpu_conv2d_backward) \
 _(aten, _cos) \
 _(aten, _cosh) \
 _(aten, _ctc_loss) \
@@ -71,6 +73,7 @@ _(aten, _dot) \
 _(aten, _embedding_bag) \
 _(aten, _embedding_bag_backward) \
 _(aten, _embedding_bag_dense_backward) \
+_(aten, _embedding_bag_per_sample_weights_backward) \
 _(aten, _embedding_bag_sparse_backward) \
 _(aten, _erf) \
 _(aten, _erfc) \
@@ -339,6 +342,9 @@ _(aten, fractional_max_pool2d_forward) \
 _(aten, frobenius_norm) \
 _(aten, full) \
 _(aten, full_like) \
+_(aten, fused_rowwise_dequantize) \
+_(aten, fused_rowwise_embedding_bag) \
+_(aten, fused_rowwise_quantize) \
 _(aten, gather) \
 _(aten, ge) \
 _(aten, gels) \
@@ -536,13 +536,33 @@ struct C10_EXPORT ivalue::Future final : c10::intrusive_ptr_target {
     callbacks.clear();
   }
 
+  // Completes the future with an error instead of a value, e.g. when the
+  // task computing it threw. value() rethrows it.
+  void markCompletedWithError(std::string error_message) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      AT_ASSERT(!completed());
+      has_error_ = true;
+      error_message_ = std::move(error_message);
+    }
+    markCompleted(IValue());
+  }
+
   // Get the result of the current future.
   IValue value() {
     std::unique_lock<std::mutex> lock(mutex_);
     AT_ASSERT(completed());
+    if (has_error_) {
+      AT_ERROR(error_message_);
+    }
     return value_;
   }
 
+  bool hasError() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return has_error_;
+  }
+
   void addCallback(std::function<void(void)> callback) {
     std::unique_lock<std::mutex> lock(mutex_);
     if (completed()) {
@@ -570,6 +590,8 @@ struct C10_EXPORT ivalue::Future final : c10::intrusive_ptr_target {
   std::mutex mutex_;
   IValue value_; // when finished the value
   std::atomic_bool completed_ = {false}; // is this future complete
+  bool has_error_ = false;
+  std::string error_message_;
   std::vector<std::function<void(void)>> callbacks;
 };
 
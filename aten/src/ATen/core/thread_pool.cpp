@@ -1,5 +1,10 @@
 #include <ATen/core/thread_pool.h>
 #include <ATen/core/ivalue.h>
+#include <c10/util/Exception.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
 
 namespace c10 {
 
@@ -131,8 +136,57 @@ void ThreadPool::main_loop(std::size_t index) {
   } // while running_
 }
 
+namespace {
+
+size_t default_num_interop_threads() {
+  if (const char* env_p = std::getenv("ATEN_NUM_INTEROP_THREADS")) {
+    int nthreads = std::atoi(env_p);
+    if (nthreads > 0) {
+      return nthreads;
+    }
+    AT_WARN("ignoring invalid value for ATEN_NUM_INTEROP_THREADS: ", env_p);
+  }
+  // a single thread, as before the pool could be sized, so that it does not
+  // compete with the intra-op threads unless asked to
+  return 1;
+}
+
+// 0 means "not set yet"; the default is computed lazily.
+std::atomic<size_t> num_interop_threads{0};
+// Guards interop_pool_created, so that the size cannot change between the
+// check in set_num_interop_threads and the creation of the pool.
+std::mutex interop_pool_mutex;
+bool interop_pool_created = false;
+
+} // namespace
+
+void set_num_interop_threads(size_t nthreads) {
+  AT_CHECK(nthreads > 0, "Expected positive number of threads");
+  std::lock_guard<std::mutex> lock(interop_pool_mutex);
+  AT_CHECK(
+      !interop_pool_created || nthreads == get_num_interop_threads(),
+      "Cannot set the number of inter-op threads after parallel work has "
+      "started");
+  num_interop_threads.store(nthreads);
+}
+
+size_t get_num_interop_threads() {
+  size_t nthreads = num_interop_threads.load();
+  if (nthreads == 0) {
+    size_t expected = 0;
+    num_interop_threads.compare_exchange_strong(
+        expected, default_num_interop_threads());
+    nthreads = num_interop_threads.load();
+  }
+  return nthreads;
+}
+
 ThreadPool& global_work_queue() {
-  static ThreadPool thread_pool(1);
+  static ThreadPool thread_pool([] {
+    std::lock_guard<std::mutex> lock(interop_pool_mutex);
+    interop_pool_created = true;
+    return get_num_interop_threads();
+  }());
 
   return thread_pool;
 }
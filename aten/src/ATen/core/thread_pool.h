@@ -100,6 +100,15 @@ class CAFFE2_API ThreadPool : public c10::TaskThreadPoolBase {
   void main_loop(std::size_t index);
 };
 
+// The inter-op pool: runs JIT forks and continuations (and, with
+// --caffe2_net_async_use_interop_pool, caffe2 async net tasks). Its size is
+// fixed when it is first used.
 CAFFE2_API ThreadPool& global_work_queue();
 
+// Sets the size of the pool returned by global_work_queue(). Defaults to the
+// ATEN_NUM_INTEROP_THREADS environment variable, or 1.
+// Throws if the pool has already been created with a different size.
+CAFFE2_API void set_num_interop_threads(size_t nthreads);
+CAFFE2_API size_t get_num_interop_threads();
+
 } // namespace c10
@@ -5,7 +5,11 @@
 #include "vec256_base.h"
 #include "vec256_float.h"
 #include "vec256_double.h"
+#include "vec256_float_avx512.h"
+#include "vec256_double_avx512.h"
 #include "vec256_int.h"
+#include "vec256_int_avx512.h"
+#include "vec256_reduced_float.h"
 
 #include <algorithm>
 #include <cstddef>
@@ -33,7 +37,89 @@ std::ostream& operator<<(std::ostream& stream, const Vec256<T>& vec) {
 }
 
 
-#if defined(__AVX__) && !defined(_MSC_VER)
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ CAST (AVX512) ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+template<>
+Vec256<float> cast<float, double>(const Vec256<double>& src) {
+  return _mm512_castpd_ps(src);
+}
+
+template<>
+Vec256<double> cast<double, float>(const Vec256<float>& src) {
+  return _mm512_castps_pd(src);
+}
+
+#define DEFINE_FLOAT_INT_CAST(int_t, float_t, float_ch)            \
+template<>                                                         \
+Vec256<int_t> cast<int_t, float_t>(const Vec256<float_t>& src) {   \
+  return _mm512_castp ## float_ch ## _si512(src);                  \
+}                                                                  \
+template<>                                                         \
+Vec256<float_t> cast<float_t, int_t>(const Vec256<int_t>& src) {   \
+  return _mm512_castsi512_p ## float_ch (src);                     \
+}
+
+DEFINE_FLOAT_INT_CAST(int64_t, double, d)
+DEFINE_FLOAT_INT_CAST(int32_t, double, d)
+DEFINE_FLOAT_INT_CAST(int16_t, double, d)
+DEFINE_FLOAT_INT_CAST(int64_t, float, s)
+DEFINE_FLOAT_INT_CAST(int32_t, float, s)
+DEFINE_FLOAT_INT_CAST(int16_t, float, s)
+
+#undef DEFINE_FLOAT_INT_CAST
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ GATHER ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+template<int64_t scale = 1>
+c10::guts::enable_if_t<scale == 1 || scale == 2 || scale == 4 || scale == 8, Vec256<double>>
+inline gather(const double* base_addr, const Vec256<int64_t>& vindex) {
+  return _mm512_i64gather_pd(vindex, base_addr, scale);
+}
+
+template<int64_t scale = 1>
+c10::guts::enable_if_t<scale == 1 || scale == 2 || scale == 4 || scale == 8, Vec256<float>>
+inline gather(const float* base_addr, const Vec256<int32_t>& vindex) {
+  return _mm512_i32gather_ps(vindex, base_addr, scale);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ MASK GATHER ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+template<int64_t scale = 1>
+c10::guts::enable_if_t<scale == 1 || scale == 2 || scale == 4 || scale == 8, Vec256<double>>
+inline mask_gather(const Vec256<double>& src, const double* base_addr,
+                   const Vec256<int64_t>& vindex, const Vec256<double>& mask) {
+  auto m = _mm512_movepi64_mask(_mm512_castpd_si512(mask));
+  return _mm512_mask_i64gather_pd(src, m, vindex, base_addr, scale);
+}
+
+template<int64_t scale = 1>
+c10::guts::enable_if_t<scale == 1 || scale == 2 || scale == 4 || scale == 8, Vec256<float>>
+inline mask_gather(const Vec256<float>& src, const float* base_addr,
+                   const Vec256<int32_t>& vindex, const Vec256<float>& mask) {
+  auto m = _mm512_movepi32_mask(_mm512_castps_si512(mask));
+  return _mm512_mask_i32gather_ps(src, m, vindex, base_addr, scale);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ CONVERT ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Truncates, like the generic version
+template<>
+Vec256<int64_t>
+inline convert_to_int_of_same_size<double>(const Vec256<double> &src) {
+  return _mm512_cvttpd_epi64(src);
+}
+
+template<>
+Vec256<int32_t>
+inline convert_to_int_of_same_size<float>(const Vec256<float> &src) {
+  return _mm512_cvttps_epi32(src);
+}
+
+// (De)interleave use the generic versions.
+
+#elif defined(__AVX__) && !defined(_MSC_VER)
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ CAST (AVX) ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
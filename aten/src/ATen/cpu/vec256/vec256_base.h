@@ -22,6 +22,17 @@ namespace at {
 namespace vec256 {
 namespace {
 
+// Width of a vector register in bytes. Kernels compiled for the AVX512
+// capability use 512-bit registers; despite its name, Vec256<T> then holds
+// 64 bytes and every type that doesn't have a native AVX512 specialization
+// falls back to the emulated implementation below at that width, so that
+// Vec256<T>::size == Vec256<int_same_size_t<T>>::size still holds.
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+static constexpr int VECTOR_WIDTH = 64;
+#else
+static constexpr int VECTOR_WIDTH = 32;
+#endif
+
 template<size_t n> struct int_of_size;
 
 #define DEFINE_INT_OF_SIZE(int_t) \
@@ -37,15 +48,24 @@ DEFINE_INT_OF_SIZE(int8_t);
 template <typename T>
 using int_same_size_t = typename int_of_size<sizeof(T)>::type;
 
+template <class T>
+struct Vec256;
+
+// A width-neutral name for Vec256<T>, whose width depends on the capability
+// as described above: 32 bytes, or 64 bytes with AVX512. Prefer it in new
+// kernels, and use Vectorized<T>::size rather than 256 / (8 * sizeof(T)).
+template <class T>
+using Vectorized = Vec256<T>;
+
 // NOTE: If you specialize on a type, you must define all operations!
 
 // emulates vectorized types
 template <class T>
 struct Vec256 {
 private:
-  T values[32 / sizeof(T)] = {0};
+  T values[VECTOR_WIDTH / sizeof(T)] = {0};
 public:
-  static constexpr int size = 32 / sizeof(T);
+  static constexpr int size = VECTOR_WIDTH / sizeof(T);
   Vec256() {}
   Vec256(T val) {
     for (int i = 0; i != size; i++) {
@@ -106,7 +126,7 @@ public:
   }
   static Vec256<T> loadu(const void* ptr) {
     Vec256 vec;
-    std::memcpy(vec.values, ptr, 32);
+    std::memcpy(vec.values, ptr, VECTOR_WIDTH);
     return vec;
   }
   static Vec256<T> loadu(const void* ptr, int64_t count) {
@@ -386,6 +406,7 @@ inline mask_gather(const Vec256<T>& src, T const* base_addr,
 // Cast a given vector to another type without changing the bits representation.
 // So a Vec<double> of 256 bits containing all ones can be cast to a
 // Vec<int64_t> of 256 bits containing all ones (i.e., four negative 1s).
+// (With AVX512 the same holds at 512 bits, i.e. eight negative 1s.)
 namespace {
   // There is a struct here because we don't have static_if and I can't
   // partially specialize a templated function.
@@ -10,7 +10,7 @@ namespace at {
 namespace vec256 {
 namespace {
 
-#if defined(__AVX__) && !defined(_MSC_VER)
+#if defined(__AVX__) && !defined(__AVX512F__) && !defined(_MSC_VER)
 
 template <> class Vec256<double> {
 private:
@@ -7,7 +7,8 @@ namespace at {
 namespace vec256 {
 namespace {
 
-#ifdef __AVX2__
+// Kernels compiled for the AVX512 capability use vec256_int_avx512.h instead
+#if defined(__AVX2__) && !(defined(__AVX512F__) && !defined(_MSC_VER))
 
 struct Vec256i {
 protected:
@@ -0,0 +1,371 @@
+#pragma once
+
+#include "intrinsics.h"
+#include "vec256_base.h"
+
+// 512-bit Vec256<int64_t>, Vec256<int32_t> and Vec256<int16_t>, used by
+// kernels compiled for CPUCapability::AVX512 (-mavx512f -mavx512dq
+// -mavx512vl -mavx512bw). They have as many lanes as the 512-bit float and
+// double types of the same size, and comparison results and blend masks keep
+// the all-ones/all-zeros lane representation of the AVX2 version.
+
+namespace at {
+namespace vec256 {
+namespace {
+
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+
+struct Vec512i {
+protected:
+  __m512i values;
+public:
+  Vec512i() {}
+  Vec512i(__m512i v) : values(v) {}
+  operator __m512i() const {
+    return values;
+  }
+};
+
+template <>
+struct Vec256<int64_t> : public Vec512i {
+  static constexpr int size = 8;
+  using Vec512i::Vec512i;
+  Vec256() {}
+  Vec256(int64_t v) { values = _mm512_set1_epi64(v); }
+  Vec256(int64_t val1, int64_t val2, int64_t val3, int64_t val4,
+         int64_t val5, int64_t val6, int64_t val7, int64_t val8) {
+    values = _mm512_set_epi64(val8, val7, val6, val5, val4, val3, val2, val1);
+  }
+  template <int64_t mask>
+  static Vec256<int64_t> blend(Vec256<int64_t> a, Vec256<int64_t> b) {
+    return _mm512_mask_blend_epi64(static_cast<__mmask8>(mask), a.values, b.values);
+  }
+  static Vec256<int64_t> blendv(const Vec256<int64_t>& a, const Vec256<int64_t>& b,
+                                const Vec256<int64_t>& mask) {
+    return _mm512_mask_blend_epi64(_mm512_movepi64_mask(mask.values), a.values, b.values);
+  }
+  static Vec256<int64_t> arange(int64_t base = 0, int64_t step = 1) {
+    return Vec256<int64_t>(
+      base,            base +     step, base + 2 * step, base + 3 * step,
+      base + 4 * step, base + 5 * step, base + 6 * step, base + 7 * step);
+  }
+  static Vec256<int64_t>
+  set(Vec256<int64_t> a, Vec256<int64_t> b, int64_t count = size) {
+    if (count >= size) {
+      return b;
+    }
+    auto mask = static_cast<__mmask8>((1 << count) - 1);
+    return _mm512_mask_blend_epi64(mask, a.values, b.values);
+  }
+  static Vec256<int64_t> loadu(const void* ptr) {
+    return _mm512_loadu_si512(ptr);
+  }
+  static Vec256<int64_t> loadu(const void* ptr, int64_t count) {
+    if (count == size)
+      return loadu(ptr);
+    // masked-out lanes are not accessed, so this never reads past the end
+    auto mask = static_cast<__mmask8>((1 << count) - 1);
+    return _mm512_maskz_loadu_epi64(mask, ptr);
+  }
+  void store(void* ptr, int count = size) const {
+    if (count == size) {
+      _mm512_storeu_si512(ptr, values);
+    } else if (count > 0) {
+      auto mask = static_cast<__mmask8>((1 << count) - 1);
+      _mm512_mask_storeu_epi64(ptr, mask, values);
+    }
+  }
+  const int64_t& operator[](int idx) const  = delete;
+  int64_t& operator[](int idx)  = delete;
+  Vec256<int64_t> abs() const {
+    return _mm512_abs_epi64(values);
+  }
+  Vec256<int64_t> operator==(const Vec256<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmpeq_epi64_mask(values, other.values));
+  }
+  Vec256<int64_t> operator!=(const Vec256<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmpneq_epi64_mask(values, other.values));
+  }
+  Vec256<int64_t> operator<(const Vec256<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmplt_epi64_mask(values, other.values));
+  }
+  Vec256<int64_t> operator<=(const Vec256<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmple_epi64_mask(values, other.values));
+  }
+  Vec256<int64_t> operator>(const Vec256<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmpgt_epi64_mask(values, other.values));
+  }
+  Vec256<int64_t> operator>=(const Vec256<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmpge_epi64_mask(values, other.values));
+  }
+};
+
+template <>
+struct Vec256<int32_t> : public Vec512i {
+  static constexpr int size = 16;
+  using Vec512i::Vec512i;
+  Vec256() {}
+  Vec256(int32_t v) { values = _mm512_set1_epi32(v); }
+  Vec256(int32_t val1, int32_t val2, int32_t val3, int32_t val4,
+         int32_t val5, int32_t val6, int32_t val7, int32_t val8,
+         int32_t val9, int32_t val10, int32_t val11, int32_t val12,
+         int32_t val13, int32_t val14, int32_t val15, int32_t val16) {
+    values = _mm512_setr_epi32(val1, val2, val3, val4, val5, val6, val7, val8,
+                               val9, val10, val11, val12, val13, val14, val15, val16);
+  }
+  template <int64_t mask>
+  static Vec256<int32_t> blend(Vec256<int32_t> a, Vec256<int32_t> b) {
+    return _mm512_mask_blend_epi32(static_cast<__mmask16>(mask), a.values, b.values);
+  }
+  static Vec256<int32_t> blendv(const Vec256<int32_t>& a, const Vec256<int32_t>& b,
+                                const Vec256<int32_t>& mask) {
+    return _mm512_mask_blend_epi32(_mm512_movepi32_mask(mask.values), a.values, b.values);
+  }
+  static Vec256<int32_t> arange(int32_t base = 0, int32_t step = 1) {
+    return Vec256<int32_t>(
+      base,             base +      step, base +  2 * step, base +  3 * step,
+      base +  4 * step, base +  5 * step, base +  6 * step, base +  7 * step,
+      base +  8 * step, base +  9 * step, base + 10 * step, base + 11 * step,
+      base + 12 * step, base + 13 * step, base + 14 * step, base + 15 * step);
+  }
+  static Vec256<int32_t>
+  set(Vec256<int32_t> a, Vec256<int32_t> b, int32_t count = size) {
+    if (count >= size) {
+      return b;
+    }
+    auto mask = static_cast<__mmask16>((1 << count) - 1);
+    return _mm512_mask_blend_epi32(mask, a.values, b.values);
+  }
+  static Vec256<int32_t> loadu(const void* ptr) {
+    return _mm512_loadu_si512(ptr);
+  }
+  static Vec256<int32_t> loadu(const void* ptr, int32_t count) {
+    if (count == size)
+      return loadu(ptr);
+    auto mask = static_cast<__mmask16>((1 << count) - 1);
+    return _mm512_maskz_loadu_epi32(mask, ptr);
+  }
+  void store(void* ptr, int count = size) const {
+    if (count == size) {
+      _mm512_storeu_si512(ptr, values);
+    } else if (count > 0) {
+      auto mask = static_cast<__mmask16>((1 << count) - 1);
+      _mm512_mask_storeu_epi32(ptr, mask, values);
+    }
+  }
+  const int32_t& operator[](int idx) const  = delete;
+  int32_t& operator[](int idx)  = delete;
+  Vec256<int32_t> abs() const {
+    return _mm512_abs_epi32(values);
+  }
+  Vec256<int32_t> operator==(const Vec256<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmpeq_epi32_mask(values, other.values));
+  }
+  Vec256<int32_t> operator!=(const Vec256<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmpneq_epi32_mask(values, other.values));
+  }
+  Vec256<int32_t> operator<(const Vec256<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmplt_epi32_mask(values, other.values));
+  }
+  Vec256<int32_t> operator<=(const Vec256<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmple_epi32_mask(values, other.values));
+  }
+  Vec256<int32_t> operator>(const Vec256<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmpgt_epi32_mask(values, other.values));
+  }
+  Vec256<int32_t> operator>=(const Vec256<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmpge_epi32_mask(values, other.values));
+  }
+};
+
+template <>
+void convert(const int32_t *src, float *dst, int64_t n) {
+  int64_t i;
+  // int32_t and float have same size
+#pragma unroll
+  for (i = 0; i <= (n - Vec256<int32_t>::size); i += Vec256<int32_t>::size) {
+    auto input_vec = _mm512_loadu_si512(src + i);
+    auto output_vec = _mm512_cvtepi32_ps(input_vec);
+    _mm512_storeu_ps(dst + i, output_vec);
+  }
+#pragma unroll
+  for (; i < n; i++) {
+    dst[i] = static_cast<float>(src[i]);
+  }
+}
+
+template <>
+void convert(const int32_t *src, double *dst, int64_t n) {
+  int64_t i;
+  // int32_t has half the size of double
+#pragma unroll
+  for (i = 0; i <= (n - Vec256<double>::size); i += Vec256<double>::size) {
+    auto input_256_vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    auto output_vec = _mm512_cvtepi32_pd(input_256_vec);
+    _mm512_storeu_pd(dst + i, output_vec);
+  }
+#pragma unroll
+  for (; i < n; i++) {
+    dst[i] = static_cast<double>(src[i]);
+  }
+}
+
+template <>
+struct Vec256<int16_t> : public Vec512i {
+  static constexpr int size = 32;
+  using Vec512i::Vec512i;
+  Vec256() {}
+  Vec256(int16_t v) { values = _mm512_set1_epi16(v); }
+  template<typename... Args,
+           typename = c10::guts::enable_if_t<(sizeof...(Args) == size)>>
+  Vec256(Args... vals) {
+    int16_t tmp_values[size] = { static_cast<int16_t>(vals)... };
+    values = _mm512_loadu_si512(tmp_values);
+  }
+  template <int64_t mask>
+  static Vec256<int16_t> blend(Vec256<int16_t> a, Vec256<int16_t> b) {
+    return _mm512_mask_blend_epi16(static_cast<__mmask32>(mask), a.values, b.values);
+  }
+  static Vec256<int16_t> blendv(const Vec256<int16_t>& a, const Vec256<int16_t>& b,
+                                const Vec256<int16_t>& mask) {
+    return _mm512_mask_blend_epi16(_mm512_movepi16_mask(mask.values), a.values, b.values);
+  }
+  static Vec256<int16_t> arange(int16_t base = 0, int16_t step = 1) {
+    int16_t tmp_values[size];
+    for (int i = 0; i < size; i++) {
+      tmp_values[i] = base + i * step;
+    }
+    return loadu(tmp_values);
+  }
+  static Vec256<int16_t>
+  set(Vec256<int16_t> a, Vec256<int16_t> b, int16_t count = size) {
+    if (count >= size) {
+      return b;
+    }
+    auto mask = static_cast<__mmask32>((1u << count) - 1);
+    return _mm512_mask_blend_epi16(mask, a.values, b.values);
+  }
+  static Vec256<int16_t> loadu(const void* ptr) {
+    return _mm512_loadu_si512(ptr);
+  }
+  static Vec256<int16_t> loadu(const void* ptr, int16_t count) {
+    if (count == size)
+      return loadu(ptr);
+    auto mask = static_cast<__mmask32>((1u << count) - 1);
+    return _mm512_maskz_loadu_epi16(mask, ptr);
+  }
+  void store(void* ptr, int count = size) const {
+    if (count == size) {
+      _mm512_storeu_si512(ptr, values);
+    } else if (count > 0) {
+      auto mask = static_cast<__mmask32>((1u << count) - 1);
+      _mm512_mask_storeu_epi16(ptr, mask, values);
+    }
+  }
+  const int16_t& operator[](int idx) const  = delete;
+  int16_t& operator[](int idx)  = delete;
+  Vec256<int16_t> abs() const {
+    return _mm512_abs_epi16(values);
+  }
+  Vec256<int16_t> operator==(const Vec256<int16_t>& other) const {
+    return _mm512_movm_epi16(_mm512_cmpeq_epi16_mask(values, other.values));
+  }
+  Vec256<int16_t> operator!=(const Vec256<int16_t>& other) const {
+    return _mm512_movm_epi16(_mm512_cmpneq_epi16_mask(values, other.values));
+  }
+  Vec256<int16_t> operator<(const Vec256<int16_t>& other) const {
+    return _mm512_movm_epi16(_mm512_cmplt_epi16_mask(values, other.values));
+  }
+  Vec256<int16_t> operator<=(const Vec256<int16_t>& other) const {
+    return _mm512_movm_epi16(_mm512_cmple_epi16_mask(values, other.values));
+  }
+  Vec256<int16_t> operator>(const Vec256<int16_t>& other) const {
+    return _mm512_movm_epi16(_mm512_cmpgt_epi16_mask(values, other.values));
+  }
+  Vec256<int16_t> operator>=(const Vec256<int16_t>& other) const {
+    return _mm512_movm_epi16(_mm512_cmpge_epi16_mask(values, other.values));
+  }
+};
+
+template <>
+Vec256<int64_t> inline operator+(const Vec256<int64_t>& a, const Vec256<int64_t>& b) {
+  return _mm512_add_epi64(a, b);
+}
+
+template <>
+Vec256<int32_t> inline operator+(const Vec256<int32_t>& a, const Vec256<int32_t>& b) {
+  return _mm512_add_epi32(a, b);
+}
+
+template <>
+Vec256<int16_t> inline operator+(const Vec256<int16_t>& a, const Vec256<int16_t>& b) {
+  return _mm512_add_epi16(a, b);
+}
+
+template <>
+Vec256<int64_t> inline operator-(const Vec256<int64_t>& a, const Vec256<int64_t>& b) {
+  return _mm512_sub_epi64(a, b);
+}
+
+template <>
+Vec256<int32_t> inline operator-(const Vec256<int32_t>& a, const Vec256<int32_t>& b) {
+  return _mm512_sub_epi32(a, b);
+}
+
+template <>
+Vec256<int16_t> inline operator-(const Vec256<int16_t>& a, const Vec256<int16_t>& b) {
+  return _mm512_sub_epi16(a, b);
+}
+
+// Unlike AVX2, AVX512DQ has an int64_t multiply
+template <>
+Vec256<int64_t> inline operator*(const Vec256<int64_t>& a, const Vec256<int64_t>& b) {
+  return _mm512_mullo_epi64(a, b);
+}
+
+template <>
+Vec256<int32_t> inline operator*(const Vec256<int32_t>& a, const Vec256<int32_t>& b) {
+  return _mm512_mullo_epi32(a, b);
+}
+
+template <>
+Vec256<int16_t> inline operator*(const Vec256<int16_t>& a, const Vec256<int16_t>& b) {
+  return _mm512_mullo_epi16(a, b);
+}
+
+template <typename T>
+Vec256<T> inline intdiv_512(const Vec256<T>& a, const Vec256<T>& b) {
+  T values_a[Vec256<T>::size];
+  T values_b[Vec256<T>::size];
+  a.store(values_a);
+  b.store(values_b);
+  for (int i = 0; i != Vec256<T>::size; i++) {
+    values_a[i] /= values_b[i];
+  }
+  return Vec256<T>::loadu(values_a);
+}
+
+#define DEFINE_INTEGER_BINARY_OP(op, func)                                                \
+template <>                                                                               \
+Vec256<int64_t> inline operator op(const Vec256<int64_t>& a, const Vec256<int64_t>& b) {  \
+  return func(a, b);                                                                      \
+}                                                                                         \
+template <>                                                                               \
+Vec256<int32_t> inline operator op(const Vec256<int32_t>& a, const Vec256<int32_t>& b) {  \
+  return func(a, b);                                                                      \
+}                                                                                         \
+template <>                                                                               \
+Vec256<int16_t> inline operator op(const Vec256<int16_t>& a, const Vec256<int16_t>& b) {  \
+  return func(a, b);                                                                      \
+}
+
+DEFINE_INTEGER_BINARY_OP(/, intdiv_512)
+DEFINE_INTEGER_BINARY_OP(&, _mm512_and_si512)
+DEFINE_INTEGER_BINARY_OP(|, _mm512_or_si512)
+DEFINE_INTEGER_BINARY_OP(^, _mm512_xor_si512)
+
+#undef DEFINE_INTEGER_BINARY_OP
+
+#endif
+
+}}}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "intrinsics.h"
+#include "vec256_base.h"
+#include "vec256_float.h"
+#include "vec256_float_avx512.h"
+
+#include <ATen/core/BFloat16.h>
+#include <ATen/core/Half.h>
+
+#include <algorithm>
+#include <cstring>
+
+// Vec256 for the 16-bit floating point types, Half and BFloat16.
+//
+// None of the supported instruction sets has arithmetic on 16-bit floats, so
+// a vector holds as many elements as Vec256<int16_t> but keeps them widened to
+// float in two Vec256<float> halves. Loads and stores convert (F16C for Half,
+// a shift and a round-to-nearest-even for BFloat16) and every operation runs
+// on the float halves: a chain of operations is rounded to 16 bits once, when
+// the result is stored, rather than after every step.
+//
+// Comparison results and blend masks use the float lane representation. They
+// can be passed to blendv and the bitwise operators but don't survive a
+// round trip through store() and loadu().
+
+namespace at {
+namespace vec256 {
+namespace {
+
+// Converts between Vec256<float>::size 16-bit values in memory and a
+// Vec256<float>.
+template <typename T>
+struct ReducedFloatConvert;
+
+template <>
+struct ReducedFloatConvert<Half> {
+  static inline Vec256<float> load(const Half* src) {
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+    return _mm512_cvtph_ps(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)));
+#elif defined(__AVX__) && defined(__F16C__) && !defined(_MSC_VER)
+    return _mm256_cvtph_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+#else
+    __at_align32__ float tmp[Vec256<float>::size];
+    for (int64_t i = 0; i < Vec256<float>::size; i++) {
+      tmp[i] = static_cast<float>(src[i]);
+    }
+    return Vec256<float>::loadu(tmp);
+#endif
+  }
+  static inline void store(Half* dst, const Vec256<float>& src) {
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst),
+        _mm512_cvtps_ph(src, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#elif defined(__AVX__) && defined(__F16C__) && !defined(_MSC_VER)
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst),
+        _mm256_cvtps_ph(src, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#else
+    __at_align32__ float tmp[Vec256<float>::size];
+    src.store(tmp);
+    for (int64_t i = 0; i < Vec256<float>::size; i++) {
+      dst[i] = static_cast<Half>(tmp[i]);
+    }
+#endif
+  }
+};
+
+// bfloat16 is the upper half of a float, so widening is a zero-extend and a
+// shift. Narrowing matches c10::detail::bf16_from_fp32_value: round to
+// nearest even, and keep NaNs quiet.
+template <>
+struct ReducedFloatConvert<BFloat16> {
+  static inline Vec256<float> load(const BFloat16* src) {
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+    auto x = _mm512_cvtepu16_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(x, 16));
+#elif defined(__AVX2__) && !defined(_MSC_VER)
+    auto x = _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(x, 16));
+#else
+    __at_align32__ float tmp[Vec256<float>::size];
+    for (int64_t i = 0; i < Vec256<float>::size; i++) {
+      tmp[i] = static_cast<float>(src[i]);
+    }
+    return Vec256<float>::loadu(tmp);
+#endif
+  }
+  static inline void store(BFloat16* dst, const Vec256<float>& src) {
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+    auto x = _mm512_castps_si512(src);
+    auto hi = _mm512_srli_epi32(x, 16);
+    auto bias = _mm512_add_epi32(
+        _mm512_and_si512(hi, _mm512_set1_epi32(1)), _mm512_set1_epi32(0x7FFF));
+    auto rounded = _mm512_srli_epi32(_mm512_add_epi32(x, bias), 16);
+    auto nan = _mm512_cmp_ps_mask(src, src, _CMP_UNORD_Q);
+    auto quiet = _mm512_or_si512(hi, _mm512_set1_epi32(0x0040));
+    auto r = _mm512_mask_blend_epi32(nan, rounded, quiet);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst), _mm512_cvtepi32_epi16(r));
+#elif defined(__AVX2__) && !defined(_MSC_VER)
+    auto x = _mm256_castps_si256(src);
+    auto hi = _mm256_srli_epi32(x, 16);
+    auto bias = _mm256_add_epi32(
+        _mm256_and_si256(hi, _mm256_set1_epi32(1)), _mm256_set1_epi32(0x7FFF));
+    auto rounded = _mm256_srli_epi32(_mm256_add_epi32(x, bias), 16);
+    auto nan = _mm256_castps_si256(_mm256_cmp_ps(src, src, _CMP_UNORD_Q));
+    auto quiet = _mm256_or_si256(hi, _mm256_set1_epi32(0x0040));
+    auto r = _mm256_blendv_epi8(rounded, quiet, nan);
+    // packus works within 128-bit lanes: {r0..r3, r0..r3, r4..r7, r4..r7};
+    // gather the low quadword of each lane.
+    auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0xD8);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(packed));
+#else
+    __at_align32__ float tmp[Vec256<float>::size];
+    src.store(tmp);
+    for (int64_t i = 0; i < Vec256<float>::size; i++) {
+      dst[i] = static_cast<BFloat16>(tmp[i]);
+    }
+#endif
+  }
+};
+
+template <typename T>
+class Vec256ReducedFloat {
+protected:
+  using fVec = Vec256<float>;
+  using Convert = ReducedFloatConvert<T>;
+  fVec lo;
+  fVec hi;
+public:
+  static constexpr int size = 2 * fVec::size;
+  Vec256ReducedFloat() {}
+  Vec256ReducedFloat(const fVec& lo, const fVec& hi) : lo(lo), hi(hi) {}
+  Vec256ReducedFloat(float val) : lo(val), hi(val) {}
+  Vec256ReducedFloat(T val) : Vec256ReducedFloat(static_cast<float>(val)) {}
+  const fVec& low() const {
+    return lo;
+  }
+  const fVec& high() const {
+    return hi;
+  }
+  template <int64_t mask>
+  static Vec256<T> blend(const Vec256<T>& a, const Vec256<T>& b) {
+    return Vec256<T>(
+        fVec::template blend<mask & ((int64_t(1) << fVec::size) - 1)>(a.lo, b.lo),
+        fVec::template blend<(mask >> fVec::size)>(a.hi, b.hi));
+  }
+  static Vec256<T> blendv(const Vec256<T>& a, const Vec256<T>& b,
+                          const Vec256<T>& mask) {
+    return Vec256<T>(fVec::blendv(a.lo, b.lo, mask.lo),
+                     fVec::blendv(a.hi, b.hi, mask.hi));
+  }
+  static Vec256<T> arange(float base = 0.f, float step = 1.f) {
+    return Vec256<T>(fVec::arange(base, step),
+                     fVec::arange(base + fVec::size * step, step));
+  }
+  static Vec256<T> set(const Vec256<T>& a, const Vec256<T>& b,
+                       int64_t count = size) {
+    return Vec256<T>(
+        fVec::set(a.lo, b.lo, std::min<int64_t>(count, fVec::size)),
+        fVec::set(a.hi, b.hi, std::max<int64_t>(count - fVec::size, 0)));
+  }
+  static Vec256<T> loadu(const void* ptr) {
+    auto src = reinterpret_cast<const T*>(ptr);
+    return Vec256<T>(Convert::load(src), Convert::load(src + fVec::size));
+  }
+  static Vec256<T> loadu(const void* ptr, int64_t count) {
+    __at_align32__ T tmp[size];
+    std::memset(static_cast<void*>(tmp), 0, sizeof(tmp));
+    std::memcpy(static_cast<void*>(tmp), ptr, count * sizeof(T));
+    return loadu(tmp);
+  }
+  void store(void* ptr, int64_t count = size) const {
+    auto dst = reinterpret_cast<T*>(ptr);
+    if (count == size) {
+      Convert::store(dst, lo);
+      Convert::store(dst + fVec::size, hi);
+    } else if (count > 0) {
+      __at_align32__ T tmp[size];
+      Convert::store(tmp, lo);
+      Convert::store(tmp + fVec::size, hi);
+      std::memcpy(ptr, static_cast<const void*>(tmp), count * sizeof(T));
+    }
+  }
+  const T& operator[](int idx) const = delete;
+  T& operator[](int idx) = delete;
+  Vec256<T> map(float (*f)(float)) const {
+    return Vec256<T>(lo.map(f), hi.map(f));
+  }
+#define DEFINE_UNARY_OP(op)              \
+  Vec256<T> op() const {                 \
+    return Vec256<T>(lo.op(), hi.op());  \
+  }
+  DEFINE_UNARY_OP(abs)
+  DEFINE_UNARY_OP(acos)
+  DEFINE_UNARY_OP(asin)
+  DEFINE_UNARY_OP(atan)
+  DEFINE_UNARY_OP(erf)
+  DEFINE_UNARY_OP(erfc)
+  DEFINE_UNARY_OP(exp)
+  DEFINE_UNARY_OP(expm1)
+  DEFINE_UNARY_OP(log)
+  DEFINE_UNARY_OP(log2)
+  DEFINE_UNARY_OP(log10)
+  DEFINE_UNARY_OP(log1p)
+  DEFINE_UNARY_OP(sin)
+  DEFINE_UNARY_OP(sinh)
+  DEFINE_UNARY_OP(cos)
+  DEFINE_UNARY_OP(cosh)
+  DEFINE_UNARY_OP(ceil)
+  DEFINE_UNARY_OP(floor)
+  DEFINE_UNARY_OP(neg)
+  DEFINE_UNARY_OP(round)
+  DEFINE_UNARY_OP(tan)
+  DEFINE_UNARY_OP(tanh)
+  DEFINE_UNARY_OP(trunc)
+  DEFINE_UNARY_OP(sqrt)
+  DEFINE_UNARY_OP(reciprocal)
+  DEFINE_UNARY_OP(rsqrt)
+#undef DEFINE_UNARY_OP
+  Vec256<T> pow(const Vec256<T>& b) const {
+    return Vec256<T>(lo.pow(b.lo), hi.pow(b.hi));
+  }
+#define DEFINE_COMP(binary_pred)                                       \
+  Vec256<T> operator binary_pred(const Vec256<T>& other) const {       \
+    return Vec256<T>(lo binary_pred other.lo, hi binary_pred other.hi); \
+  }
+  DEFINE_COMP(==)
+  DEFINE_COMP(!=)
+  DEFINE_COMP(>=)
+  DEFINE_COMP(<=)
+  DEFINE_COMP(>)
+  DEFINE_COMP(<)
+#undef DEFINE_COMP
+};
+
+template <> class Vec256<Half> : public Vec256ReducedFloat<Half> {
+public:
+  using Vec256ReducedFloat<Half>::Vec256ReducedFloat;
+  Vec256() {}
+};
+
+template <> class Vec256<BFloat16> : public Vec256ReducedFloat<BFloat16> {
+public:
+  using Vec256ReducedFloat<BFloat16>::Vec256ReducedFloat;
+  Vec256() {}
+};
+
+#define DEFINE_REDUCED_FLOAT_BINARY_OP(T, op)                           \
+template <>                                                             \
+Vec256<T> inline operator op(const Vec256<T>& a, const Vec256<T>& b) {  \
+  return Vec256<T>(a.low() op b.low(), a.high() op b.high());           \
+}
+
+#define DEFINE_REDUCED_FLOAT_OPS(T)                                     \
+DEFINE_REDUCED_FLOAT_BINARY_OP(T, +)                                    \
+DEFINE_REDUCED_FLOAT_BINARY_OP(T, -)                                    \
+DEFINE_REDUCED_FLOAT_BINARY_OP(T, *)                                    \
+DEFINE_REDUCED_FLOAT_BINARY_OP(T, /)                                    \
+DEFINE_REDUCED_FLOAT_BINARY_OP(T, &)                                    \
+DEFINE_REDUCED_FLOAT_BINARY_OP(T, |)                                    \
+DEFINE_REDUCED_FLOAT_BINARY_OP(T, ^)                                    \
+template <>                                                             \
+Vec256<T> inline maximum(const Vec256<T>& a, const Vec256<T>& b) {      \
+  return Vec256<T>(maximum(a.low(), b.low()),                           \
+                   maximum(a.high(), b.high()));                        \
+}                                                                       \
+template <>                                                             \
+Vec256<T> inline minimum(const Vec256<T>& a, const Vec256<T>& b) {      \
+  return Vec256<T>(minimum(a.low(), b.low()),                           \
+                   minimum(a.high(), b.high()));                        \
+}                                                                       \
+template <>                                                             \
+Vec256<T> inline fmadd(const Vec256<T>& a, const Vec256<T>& b,          \
+                       const Vec256<T>& c) {                            \
+  return Vec256<T>(fmadd(a.low(), b.low(), c.low()),                    \
+                   fmadd(a.high(), b.high(), c.high()));                \
+}
+
+DEFINE_REDUCED_FLOAT_OPS(Half)
+DEFINE_REDUCED_FLOAT_OPS(BFloat16)
+
+#undef DEFINE_REDUCED_FLOAT_OPS
+#undef DEFINE_REDUCED_FLOAT_BINARY_OP
+
+}}}
@@ -73,10 +73,12 @@ inline void vrsqrt(scalar_t* out, scalar_t* in, int64_t size) {
 // this. This duplication is also necessary since not all functions (e.g. rsqrt)
 // might be part of cmath.
 
+// The 16-bit floating point types compute in float, so the dummy call uses
+// whatever type std::op returns for them.
 #define IMPLEMENT_VML_BUG(op)                                          \
   template <typename scalar_t>                                          \
   inline void v##op(scalar_t* out, const scalar_t* in, int64_t size) {  \
-    DL_RUNTIME_BUG(op, scalar_t)                                        \
+    DL_RUNTIME_BUG(op, decltype(std::op(scalar_t())))                   \
     parallel_for(0, size, 2048, [out, in](int64_t begin, int64_t end) { \
       map([](const Vec256<scalar_t>& x) { return x.op(); },             \
           out + begin,                                                  \
@@ -168,6 +168,7 @@ scalar_types = [
     ('Long', 'int64_t', 'Long', 'int64_t', False),
     ('Short', 'int16_t', 'Long', 'int16_t', False),
     ('Half', 'Half', 'Double', 'at::Half', True),
+    ('BFloat16', 'BFloat16', 'Double', 'at::BFloat16', True),
 ]
 
 # shared environment for non-derived base classes Type.h Tensor.h Storage.h
@@ -293,7 +294,7 @@ def generate_storage_type_and_tensor(backend, density, scalar_type, declarations
         env['storage_device'] = 'throw std::runtime_error("CPU storage has no device");'
         env['Generator'] = 'CPUGenerator'
     env['AS_REAL'] = env['ScalarType']
-    if scalar_name == "Half":
+    if scalar_name in ("Half", "BFloat16"):
         env['SparseTensor'] = 'Tensor'
         if backend == "CUDA":
             env['AS_REAL'] = 'convert<at::Half,double>'
@@ -331,9 +332,12 @@ def iterate_types():
     for backend in backends:
         for density in densities:
             for scalar_type in scalar_types:
-                if density == 'Sparse' and scalar_type[0] == 'Half':
+                if density == 'Sparse' and scalar_type[0] in ('Half', 'BFloat16'):
                     # THS does not do half type yet.
                     continue
+                if backend == 'CUDA' and scalar_type[0] == 'BFloat16':
+                    # THC has no bfloat16 type.
+                    continue
                 yield (backend, density, scalar_type)
 
 
@@ -2,6 +2,7 @@
 #include "ATen/NativeFunctions.h"
 
 #include "ATen/Config.h"
+#include "ATen/native/ConvolutionCPU.h"
 
 static const int MIOPEN_DIM_MAX = 4;
 
@@ -28,6 +29,7 @@ struct ConvParams {
   bool use_cudnn(const at::Tensor& input) const;
   bool use_miopen(const at::Tensor& input) const;
   bool use_mkldnn(const at::Tensor& input) const;
+  bool use_cpu_conv2d(const at::Tensor& input, const at::Tensor& weight) const;
   bool is_depthwise(const at::Tensor& input, const at::Tensor& weight) const;
 };
 
@@ -145,6 +147,13 @@ auto ConvParams::use_mkldnn(const at::Tensor& input) const -> bool {
   return false;
 }
 
+auto ConvParams::use_cpu_conv2d(const at::Tensor& input, const at::Tensor& weight) const -> bool {
+  return !transposed &&
+         input.ndimension() == 4 &&
+         select_conv2d_cpu_algorithm(input, weight, stride, padding, dilation, groups)
+             != Conv2dCPUAlgorithm::None;
+}
+
 // We currently only have depthwise support for the case where groups ==
 // nInputPlane and nInputPlane == nOutputPlane (the latter due to the lack of
 // a depthwise multiplier)
@@ -381,6 +390,12 @@ at::Tensor _convolution(
 
     output = at::mkldnn_convolution(input, weight, bias, params.padding, params.stride, params.dilation, params.groups);
 #endif
+  } else if (params.use_cpu_conv2d(input, weight)) {
+    AT_CHECK(!bias.defined() || (input.type() == bias.type()),
+             "Input type (", input.type().toString(), ") and bias type (", bias.type().toString(),
+             ") should be the same");
+
+    output = at::_cpu_conv2d(input, weight, bias, params.padding, params.stride, params.dilation, params.groups);
   } else {
     if (params.groups == 1) {
       output = at::_convolution_nogroup(
@@ -0,0 +1,301 @@
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+
+#include <ATen/native/ConvolutionCPU.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace at { namespace native {
+
+DEFINE_DISPATCH(conv2d_direct_stub);
+DEFINE_DISPATCH(conv2d_backward_input_stub);
+DEFINE_DISPATCH(conv2d_backward_weight_stub);
+DEFINE_DISPATCH(winograd_weight_transform_stub);
+DEFINE_DISPATCH(winograd_input_transform_stub);
+DEFINE_DISPATCH(winograd_output_transform_stub);
+
+namespace {
+
+// Winograd needs enough channels for the per-position matrix multiplies to
+// amortize the transforms.
+constexpr int64_t kWinogradMinChannels = 8;
+// Outputs at least this large use F(4x4,3x3), which does fewer multiplies but
+// wastes more work on partial tiles.
+constexpr int64_t kWinograd4x4MinOutputSize = 16;
+// The direct convolution loses to im2col + GEMM once every output reads many
+// input values (576 = 64 channels of a 3x3 kernel).
+constexpr int64_t kDirectMaxReduction = 576;
+// Upper bound on the transformed input and products buffers of one chunk of
+// Winograd tiles, in bytes.
+constexpr int64_t kWinogradChunkBytes = 8 << 20;
+
+Conv2dCPUParams make_params(IntList stride, IntList padding, IntList dilation, int64_t groups) {
+  Conv2dCPUParams params;
+  for (int i = 0; i < 2; i++) {
+    params.stride[i] = stride[i];
+    params.padding[i] = padding[i];
+    params.dilation[i] = dilation[i];
+  }
+  params.groups = groups;
+  return params;
+}
+
+int64_t output_size(int64_t input_size, int64_t kernel_size, int64_t stride,
+                    int64_t padding, int64_t dilation) {
+  return (input_size + 2 * padding - dilation * (kernel_size - 1) - 1) / stride + 1;
+}
+
+bool is_pointwise(const Tensor& weight, IntList padding) {
+  return weight.size(2) == 1 && weight.size(3) == 1 && padding[0] == 0 && padding[1] == 0;
+}
+
+bool is_winograd_compatible(const Tensor& weight, IntList stride, IntList dilation) {
+  return weight.size(2) == 3 && weight.size(3) == 3 &&
+         stride[0] == 1 && stride[1] == 1 && dilation[0] == 1 && dilation[1] == 1;
+}
+
+// The input subsampled by stride, which is what a 1x1 kernel reads.
+Tensor pointwise_input(const Tensor& input, IntList stride) {
+  if (stride[0] == 1 && stride[1] == 1) {
+    return input;
+  }
+  return input.slice(2, 0, input.size(2), stride[0])
+              .slice(3, 0, input.size(3), stride[1]).contiguous();
+}
+
+Tensor conv2d_pointwise(const Tensor& input, const Tensor& weight, const Tensor& bias,
+                        IntList stride, int64_t groups) {
+  auto x = pointwise_input(input, stride);
+  int64_t batch = x.size(0), output_h = x.size(2), output_w = x.size(3);
+  int64_t output_channels = weight.size(0);
+  auto w = weight.view({groups, output_channels / groups, weight.size(1)});
+  auto output = at::empty({batch, output_channels, output_h, output_w}, input.options());
+  for (int64_t n = 0; n < batch; n++) {
+    auto output_n = output[n].view({groups, output_channels / groups, output_h * output_w});
+    at::bmm_out(output_n, w, x[n].view({groups, x.size(1) / groups, output_h * output_w}));
+  }
+  if (bias.defined()) {
+    output.add_(bias.view({1, output_channels, 1, 1}));
+  }
+  return output;
+}
+
+Tensor conv2d_direct(const Tensor& input, const Tensor& weight, const Tensor& bias,
+                     const Conv2dCPUParams& params) {
+  auto output = at::empty({
+      input.size(0), weight.size(0),
+      output_size(input.size(2), weight.size(2), params.stride[0], params.padding[0], params.dilation[0]),
+      output_size(input.size(3), weight.size(3), params.stride[1], params.padding[1], params.dilation[1])},
+      input.options());
+  conv2d_direct_stub(kCPU, output, input, weight, bias, params);
+  return output;
+}
+
+// Transforms the whole weight once, then walks the tiles in chunks small
+// enough to keep the transformed input and the products in cache-friendly
+// buffers.
+Tensor conv2d_winograd(const Tensor& input, const Tensor& weight, const Tensor& bias,
+                       IntList padding, int64_t groups, int64_t m) {
+  int64_t batch = input.size(0), channels = input.size(1);
+  int64_t output_channels = weight.size(0);
+  int64_t group_channels = channels / groups;
+  int64_t group_output_channels = output_channels / groups;
+  int64_t output_h = output_size(input.size(2), 3, 1, padding[0], 1);
+  int64_t output_w = output_size(input.size(3), 3, 1, padding[1], 1);
+  int64_t positions = (m + 2) * (m + 2);
+  int64_t tiles_h = (output_h + m - 1) / m;
+  int64_t tiles_w = (output_w + m - 1) / m;
+  int64_t tiles = batch * tiles_h * tiles_w;
+
+  auto output = at::empty({batch, output_channels, output_h, output_w}, input.options());
+  if (tiles == 0) {
+    return output;
+  }
+  auto transformed_weight = at::empty({groups * positions, group_output_channels, group_channels},
+                                      input.options());
+  winograd_weight_transform_stub(kCPU, transformed_weight, weight, m, groups);
+
+  int64_t tile_bytes = groups * positions * (group_channels + group_output_channels) *
+                       input.type().elementSizeInBytes();
+  int64_t chunk = std::max<int64_t>(std::min(kWinogradChunkBytes / tile_bytes, tiles), 1);
+  auto transformed_input = at::empty({groups * positions, group_channels, chunk}, input.options());
+  auto products = at::empty({groups * positions, group_output_channels, chunk}, input.options());
+  for (int64_t tile_begin = 0; tile_begin < tiles; tile_begin += chunk) {
+    int64_t tile_end = std::min(tile_begin + chunk, tiles);
+    if (tile_end - tile_begin != chunk) {
+      transformed_input = at::empty({groups * positions, group_channels, tile_end - tile_begin},
+                                    input.options());
+      products = at::empty({groups * positions, group_output_channels, tile_end - tile_begin},
+                           input.options());
+    }
+    winograd_input_transform_stub(kCPU, transformed_input, input, m, groups,
+                                  padding[0], padding[1], tiles_h, tiles_w, tile_begin, tile_end);
+    at::bmm_out(products, transformed_weight, transformed_input);
+    winograd_output_transform_stub(kCPU, output, products, bias, m, groups,
+                                   tiles_h, tiles_w, tile_begin, tile_end);
+  }
+  return output;
+}
+
+// The weight gradient as im2col + GEMM, one image at a time: the columns of
+// image n are its padded input viewed as {channels, kh, kw, oh, ow} windows,
+// and each group accumulates grad_output[n] times its columns transposed.
+Tensor conv2d_backward_weight_gemm(const Tensor& input, const Tensor& grad_output,
+                                   const Tensor& weight, IntList stride, IntList padding,
+                                   IntList dilation, int64_t groups) {
+  int64_t batch = input.size(0), channels = input.size(1);
+  int64_t kernel_h = weight.size(2), kernel_w = weight.size(3);
+  int64_t output_h = grad_output.size(2), output_w = grad_output.size(3);
+  int64_t group_output_channels = weight.size(0) / groups;
+  int64_t reduction = weight.size(1) * kernel_h * kernel_w;
+  auto padded = at::constant_pad_nd(input, {padding[1], padding[1], padding[0], padding[0]}, 0);
+  int64_t row_stride = padded.stride(2), channel_stride = padded.stride(1);
+  auto grad_weight = at::zeros({groups, group_output_channels, reduction}, weight.options());
+  for (int64_t n = 0; n < batch; n++) {
+    auto columns = padded[n].as_strided(
+        {channels, kernel_h, kernel_w, output_h, output_w},
+        {channel_stride, dilation[0] * row_stride, dilation[1],
+         stride[0] * row_stride, stride[1]});
+    grad_weight.baddbmm_(
+        grad_output[n].view({groups, group_output_channels, output_h * output_w}),
+        columns.reshape({groups, reduction, output_h * output_w}).transpose(1, 2));
+  }
+  return grad_weight.view(weight.sizes());
+}
+
+} // anonymous namespace
+
+Conv2dCPUAlgorithm select_conv2d_cpu_algorithm(
+    const Tensor& input, const Tensor& weight, IntList stride, IntList padding,
+    IntList dilation, int64_t groups) {
+  if (input.type().backend() != Backend::CPU || input.dim() != 4 || weight.dim() != 4 ||
+      input.type() != weight.type() ||
+      (input.type().scalarType() != kFloat && input.type().scalarType() != kDouble)) {
+    return Conv2dCPUAlgorithm::None;
+  }
+  if (is_pointwise(weight, padding)) {
+    return Conv2dCPUAlgorithm::Pointwise;
+  }
+  int64_t group_channels = weight.size(1);
+  int64_t group_output_channels = weight.size(0) / groups;
+  if (is_winograd_compatible(weight, stride, dilation) &&
+      group_channels >= kWinogradMinChannels && group_output_channels >= kWinogradMinChannels) {
+    int64_t output_h = output_size(input.size(2), 3, 1, padding[0], 1);
+    int64_t output_w = output_size(input.size(3), 3, 1, padding[1], 1);
+    if (output_h >= kWinograd4x4MinOutputSize && output_w >= kWinograd4x4MinOutputSize) {
+      return Conv2dCPUAlgorithm::Winograd4x4;
+    }
+    if (output_h >= 4 && output_w >= 4) {
+      return Conv2dCPUAlgorithm::Winograd2x2;
+    }
+  }
+  if (groups > 1 && group_channels * weight.size(2) * weight.size(3) <= kDirectMaxReduction) {
+    return Conv2dCPUAlgorithm::Direct;
+  }
+  return Conv2dCPUAlgorithm::None;
+}
+
+Tensor _cpu_conv2d(const Tensor& self, const Tensor& weight, const Tensor& bias,
+                   IntList padding, IntList stride, IntList dilation, int64_t groups,
+                   int64_t algorithm) {
+  AT_CHECK(self.type().backend() == Backend::CPU, "_cpu_conv2d: expected a CPU tensor");
+  AT_CHECK(self.dim() == 4 && weight.dim() == 4,
+           "_cpu_conv2d: expected 4-d input and weight, got ", self.dim(), "-d and ",
+           weight.dim(), "-d");
+  AT_CHECK(padding.size() == 2 && stride.size() == 2 && dilation.size() == 2,
+           "_cpu_conv2d: expected 2 values of padding, stride and dilation");
+  AT_CHECK(self.type() == weight.type() && (!bias.defined() || bias.type() == self.type()),
+           "_cpu_conv2d: expected input, weight and bias of the same type");
+  AT_CHECK(groups > 0 && weight.size(0) % groups == 0 && self.size(1) == weight.size(1) * groups,
+           "_cpu_conv2d: weight of size ", weight.sizes(), " and groups=", groups,
+           " don't match an input of size ", self.sizes());
+  AT_CHECK(algorithm >= 0 && algorithm <= static_cast<int64_t>(Conv2dCPUAlgorithm::Winograd4x4),
+           "_cpu_conv2d: unknown algorithm ", algorithm);
+
+  auto algo = static_cast<Conv2dCPUAlgorithm>(algorithm);
+  if (algo == Conv2dCPUAlgorithm::None) {
+    algo = select_conv2d_cpu_algorithm(self, weight, stride, padding, dilation, groups);
+    if (algo == Conv2dCPUAlgorithm::None) {
+      algo = Conv2dCPUAlgorithm::Direct;
+    }
+  }
+  auto input = self.contiguous();
+  auto weight_ = weight.contiguous();
+  auto bias_ = bias.defined() ? bias.contiguous() : bias;
+  switch (algo) {
+    case Conv2dCPUAlgorithm::Pointwise:
+      AT_CHECK(is_pointwise(weight, padding),
+               "_cpu_conv2d: the pointwise algorithm needs a 1x1 kernel without padding");
+      return conv2d_pointwise(input, weight_, bias_, stride, groups);
+    case Conv2dCPUAlgorithm::Winograd2x2:
+    case Conv2dCPUAlgorithm::Winograd4x4:
+      AT_CHECK(is_winograd_compatible(weight, stride, dilation),
+               "_cpu_conv2d: the Winograd algorithms need a 3x3 kernel with unit stride and dilation");
+      return conv2d_winograd(input, weight_, bias_, padding, groups,
+                             algo == Conv2dCPUAlgorithm::Winograd2x2 ? 2 : 4);
+    default:
+      return conv2d_direct(input, weight_, bias_, make_params(stride, padding, dilation, groups));
+  }
+}
+
+std::tuple<Tensor, Tensor, Tensor> _cpu_conv2d_backward(
+    const Tensor& self, const Tensor& grad_output_, const Tensor& weight,
+    IntList padding, IntList stride, IntList dilation, int64_t groups,
+    std::array<bool, 3> output_mask) {
+  auto input = self.contiguous();
+  auto grad_output = grad_output_.contiguous();
+  auto weight_ = weight.contiguous();
+  auto params = make_params(stride, padding, dilation, groups);
+  int64_t kernel_h = weight.size(2), kernel_w = weight.size(3);
+
+  Tensor grad_input, grad_weight, grad_bias;
+  if (output_mask[0]) {
+    // With unit stride and dilation the input gradient is itself a
+    // convolution: of grad_output with the flipped, transposed weight.
+    bool as_forward = stride[0] == 1 && stride[1] == 1 && dilation[0] == 1 && dilation[1] == 1 &&
+                      padding[0] <= kernel_h - 1 && padding[1] <= kernel_w - 1;
+    Tensor transposed_weight;
+    std::vector<int64_t> transposed_padding_vec;
+    auto algo = Conv2dCPUAlgorithm::None;
+    if (as_forward) {
+      int64_t group_output_channels = weight.size(0) / groups;
+      transposed_weight = weight_.view({groups, group_output_channels, weight.size(1), kernel_h, kernel_w})
+                                 .transpose(1, 2).flip({3, 4})
+                                 .reshape({groups * weight.size(1), group_output_channels, kernel_h, kernel_w});
+      transposed_padding_vec = {kernel_h - 1 - padding[0], kernel_w - 1 - padding[1]};
+      algo = select_conv2d_cpu_algorithm(grad_output, transposed_weight, stride,
+                                         transposed_padding_vec, dilation, groups);
+    }
+    if (algo != Conv2dCPUAlgorithm::None && algo != Conv2dCPUAlgorithm::Direct) {
+      grad_input = at::_cpu_conv2d(grad_output, transposed_weight, Tensor(), transposed_padding_vec,
+                                   stride, dilation, groups, static_cast<int64_t>(algo));
+    } else {
+      grad_input = at::zeros_like(input);
+      conv2d_backward_input_stub(kCPU, grad_input, grad_output, weight_, params);
+    }
+  }
+  if (output_mask[1]) {
+    if (is_pointwise(weight, padding)) {
+      auto x = pointwise_input(input, stride);
+      int64_t batch = x.size(0), pixels = x.size(2) * x.size(3);
+      grad_weight = at::matmul(grad_output.view({batch, groups, weight.size(0) / groups, pixels}),
+                               x.view({batch, groups, weight.size(1), pixels}).transpose(2, 3))
+                        .sum(0).view(weight.sizes());
+    } else if (weight.size(1) * kernel_h * kernel_w > kDirectMaxReduction) {
+      // Same cut-off as the forward selection: with this many values per
+      // output the direct kernel loses to the GEMM.
+      grad_weight = conv2d_backward_weight_gemm(input, grad_output, weight_, stride, padding,
+                                                dilation, groups);
+    } else {
+      grad_weight = at::empty(weight.sizes(), weight.options());
+      conv2d_backward_weight_stub(kCPU, grad_weight, grad_output, input, params);
+    }
+  }
+  if (output_mask[2]) {
+    grad_bias = grad_output.sum({0, 2, 3});
+  }
+  return std::tuple<Tensor, Tensor, Tensor>{grad_input, grad_weight, grad_bias};
+}
+
+}} // namespace at::native
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+// Native CPU engine for 2-d convolution (conv1d is viewed as 2-d by
+// _convolution). Unlike thnn_conv2d it never unfolds the input into an im2col
+// buffer, and it handles groups in a single call:
+//
+//  - Pointwise: 1x1 kernels without padding are a batched matrix multiply of
+//    the weight with the (subsampled) input.
+//  - Direct: a blocked direct convolution, which suits grouped and depthwise
+//    layers, where every output channel reads few input channels.
+//  - Winograd F(2x2,3x3) and F(4x4,3x3): 3x3, stride 1, undilated layers with
+//    enough channels. Tiles of the input and the weight are transformed, the
+//    elementwise products become one matrix multiply per tile position, and
+//    the products are transformed back into output tiles.
+
+namespace at { namespace native {
+
+enum class Conv2dCPUAlgorithm : int64_t {
+  None = 0,  // not supported by the engine, or thnn_conv2d is expected to win
+  Direct = 1,
+  Pointwise = 2,
+  Winograd2x2 = 3,
+  Winograd4x4 = 4,
+};
+
+struct Conv2dCPUParams {
+  int64_t stride[2];
+  int64_t padding[2];
+  int64_t dilation[2];
+  int64_t groups;
+};
+
+// Picks an algorithm for a forward convolution of `input` with `weight`, both
+// 4-d. Returns None when the engine can't run it or is not expected to beat
+// the im2col implementation.
+Conv2dCPUAlgorithm select_conv2d_cpu_algorithm(
+    const Tensor& input, const Tensor& weight, IntList stride, IntList padding,
+    IntList dilation, int64_t groups);
+
+// All tensors are contiguous and NCHW; `bias` may be undefined. Outputs are
+// allocated by the caller, and grad_input must also be zero-filled.
+using conv2d_direct_fn = void(*)(Tensor& output, const Tensor& input, const Tensor& weight,
+                                 const Tensor& bias, const Conv2dCPUParams& params);
+using conv2d_backward_input_fn = void(*)(Tensor& grad_input, const Tensor& grad_output,
+                                         const Tensor& weight, const Conv2dCPUParams& params);
+using conv2d_backward_weight_fn = void(*)(Tensor& grad_weight, const Tensor& grad_output,
+                                          const Tensor& input, const Conv2dCPUParams& params);
+
+// Winograd transforms. `m` is the output tile size, 2 or 4, and tiles are
+// numbered row-major over (batch, tile row, tile column); the input and output
+// transforms cover the tiles [tile_begin, tile_end). Layouts, with
+// A = (m + 2)^2 positions per tile:
+//   transformed weight: (groups, A, output channels per group, channels per group)
+//   transformed input:  (groups, A, channels per group, tile_end - tile_begin)
+//   products:           (groups, A, output channels per group, tile_end - tile_begin)
+using winograd_weight_transform_fn = void(*)(Tensor& transformed, const Tensor& weight,
+                                             int64_t m, int64_t groups);
+using winograd_input_transform_fn = void(*)(Tensor& transformed, const Tensor& input,
+                                            int64_t m, int64_t groups,
+                                            int64_t pad_h, int64_t pad_w,
+                                            int64_t tiles_h, int64_t tiles_w,
+                                            int64_t tile_begin, int64_t tile_end);
+using winograd_output_transform_fn = void(*)(Tensor& output, const Tensor& products,
+                                             const Tensor& bias, int64_t m, int64_t groups,
+                                             int64_t tiles_h, int64_t tiles_w,
+                                             int64_t tile_begin, int64_t tile_end);
+
+DECLARE_DISPATCH(conv2d_direct_fn, conv2d_direct_stub);
+DECLARE_DISPATCH(conv2d_backward_input_fn, conv2d_backward_input_stub);
+DECLARE_DISPATCH(conv2d_backward_weight_fn, conv2d_backward_weight_stub);
+DECLARE_DISPATCH(winograd_weight_transform_fn, winograd_weight_transform_stub);
+DECLARE_DISPATCH(winograd_input_transform_fn, winograd_input_transform_stub);
+DECLARE_DISPATCH(winograd_output_transform_fn, winograd_output_transform_stub);
+
+}} // namespace at::native
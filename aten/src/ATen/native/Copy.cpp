@@ -4,6 +4,7 @@
 #include "ATen/CPUApplyUtils.h"
 #include "ATen/Dispatch.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/TensorIterator.h"
 #include "ATen/native/cpu/CopyKernel.h"
 
 namespace {
@@ -20,7 +21,7 @@ void _copy__cpu(at::Tensor& self, const at::Tensor& src) {
 template <typename self_T>
 void _copy__cpu(at::Tensor& self, const at::Tensor& src) {
   AT_CHECK(self.numel() == src.numel(), "sizes do not match");
-  AT_DISPATCH_ALL_TYPES_AND_HALF(src.type(), "_copy__cpu", [&]() {
+  AT_DISPATCH_ALL_TYPES_AND_HALF_AND_BFLOAT16(src.type(), "_copy__cpu", [&]() {
     _copy__cpu<self_T, scalar_t>(self, src);
   });
 }
@@ -42,7 +43,7 @@ Tensor& _s_copy__cpu(Tensor& self, const Tensor& src, bool non_blocking) {
     _s_copy_from(src, self, non_blocking);
     return self;
   }
-  AT_DISPATCH_ALL_TYPES_AND_HALF(
+  AT_DISPATCH_ALL_TYPES_AND_HALF_AND_BFLOAT16(
       self.type(), "_copy__cpu", [&]() { ::_copy__cpu<scalar_t>(self, src); });
   return self;
 }
@@ -58,7 +59,7 @@ void _copy_same_type_transpose_(Tensor& self, const Tensor& src) {
   }
   Tensor buf = empty({BLOCK_SZ, BLOCK_SZ}, self.options());
 
-  AT_DISPATCH_ALL_TYPES_AND_HALF(
+  AT_DISPATCH_ALL_TYPES_AND_HALF_AND_BFLOAT16(
       self.type(), "_copy_same_type_transpose_", [&]() {
         scalar_t* sp = src.data<scalar_t>();
         scalar_t* rp = self.data<scalar_t>();
@@ -100,6 +101,29 @@ void _copy_same_type_transpose_(Tensor& self, const Tensor& src) {
       });
 }
 
+// copy between tensors of the same shape but different layouts, e.g. NCHW ->
+// NHWC. TensorIterator coalesces what it can and tiles the two innermost
+// dimensions when the strides of self and src disagree (see get_tile_size).
+void _copy_same_type_strided_(Tensor& self, const Tensor& src) {
+  auto builder = TensorIterator::Builder();
+  builder.add_output(self);
+  builder.add_input(src);
+  builder.dont_resize_outputs();
+  builder.dont_compute_common_dtype();
+  auto iter = builder.build();
+
+  AT_DISPATCH_ALL_TYPES_AND_HALF_AND_BFLOAT16(
+      self.type(), "_copy_same_type_strided_", [&]() {
+        iter->for_each([](int ntensor, char** data, const int64_t* strides, int64_t n) {
+          char* dst = data[0];
+          const char* src = data[1];
+          for (int64_t i = 0; i < n; i++) {
+            *(scalar_t*)(dst + i * strides[0]) = *(const scalar_t*)(src + i * strides[1]);
+          }
+        });
+      });
+}
+
 void _copy_same_type__cpu(Tensor& self, const Tensor& src) {
   if (self.is_same(src)) {
     return;
@@ -111,10 +135,12 @@ void _copy_same_type__cpu(Tensor& self, const Tensor& src) {
       copy_kernel(kCPU, self, src);
     } else if (copy_transpose_valid(self, src)) {
       _copy_same_type_transpose_(self, src);
+    } else if (self.sizes().equals(src.sizes())) {
+      _copy_same_type_strided_(self, src);
     } else {
 #ifdef _OPENMP
       if (!in_parallel_region()) {
-        AT_DISPATCH_ALL_TYPES_AND_HALF(self.type(), "_copy_same_type_", [&]() {
+        AT_DISPATCH_ALL_TYPES_AND_HALF_AND_BFLOAT16(self.type(), "_copy_same_type_", [&]() {
           at::CPU_tensor_parallel_apply2<scalar_t, scalar_t>(
               self, src, [](scalar_t& self_val, const scalar_t& src_val) {
                 self_val = src_val;
@@ -132,7 +158,7 @@ void _copy_same_type__cpu(Tensor& self, const Tensor& src) {
   }
 
   if (serial_path) {
-    AT_DISPATCH_ALL_TYPES_AND_HALF(self.type(), "_copy_same_type_", [&]() {
+    AT_DISPATCH_ALL_TYPES_AND_HALF_AND_BFLOAT16(self.type(), "_copy_same_type_", [&]() {
       at::CPU_tensor_apply2<scalar_t, scalar_t>(
           self, src, [](scalar_t& self_val, const scalar_t& src_val) {
             self_val = src_val;
@@ -8,24 +8,18 @@
 
 namespace at { namespace native {
 
-static CPUCapability compute_cpu_capability() {
-  auto envar = std::getenv("ATEN_CPU_CAPABILITY");
-  if (envar) {
-    if (strcmp(envar, "avx2") == 0) {
-      return CPUCapability::AVX2;
-    }
-    if (strcmp(envar, "avx") == 0) {
-      return CPUCapability::AVX;
-    }
-    if (strcmp(envar, "default") == 0) {
-      return CPUCapability::DEFAULT;
-    }
-    AT_WARN("ignoring invalid value for ATEN_CPU_CAPABILITY: ", envar);
-  }
-
+static CPUCapability detect_cpu_capability() {
 #ifndef __powerpc__
   if (cpuinfo_initialize()) {
-    if (cpuinfo_has_x86_avx2() && cpuinfo_has_x86_fma3()) {
+    // The AVX512 kernels are built for the Skylake-SP subset (F, DQ, VL, BW).
+    if (cpuinfo_has_x86_avx512f() && cpuinfo_has_x86_avx512dq() &&
+        cpuinfo_has_x86_avx512vl() && cpuinfo_has_x86_avx512bw() &&
+        cpuinfo_has_x86_fma3()) {
+      return CPUCapability::AVX512;
+    }
+    // The AVX2 kernels also use F16C to convert Half vectors.
+    if (cpuinfo_has_x86_avx2() && cpuinfo_has_x86_fma3() &&
+        cpuinfo_has_x86_f16c()) {
       return CPUCapability::AVX2;
     }
     if (cpuinfo_has_x86_avx()) {
@@ -36,6 +30,35 @@ static CPUCapability compute_cpu_capability() {
   return CPUCapability::DEFAULT;
 }
 
+static CPUCapability compute_cpu_capability() {
+  auto detected = detect_cpu_capability();
+  auto envar = std::getenv("ATEN_CPU_CAPABILITY");
+  if (!envar) {
+    return detected;
+  }
+  CPUCapability forced;
+  if (strcmp(envar, "avx512") == 0) {
+    forced = CPUCapability::AVX512;
+  } else if (strcmp(envar, "avx2") == 0) {
+    forced = CPUCapability::AVX2;
+  } else if (strcmp(envar, "avx") == 0) {
+    forced = CPUCapability::AVX;
+  } else if (strcmp(envar, "default") == 0) {
+    forced = CPUCapability::DEFAULT;
+  } else {
+    AT_WARN("ignoring invalid value for ATEN_CPU_CAPABILITY: ", envar);
+    return detected;
+  }
+  // Running kernels built for instructions the CPU lacks would crash with
+  // SIGILL, so the capability can only be lowered.
+  if (static_cast<int>(forced) > static_cast<int>(detected)) {
+    AT_WARN("ATEN_CPU_CAPABILITY=", envar, " is not supported by this CPU, "
+            "using the best supported capability instead");
+    return detected;
+  }
+  return forced;
+}
+
 CPUCapability get_cpu_capability() {
   static CPUCapability capability = compute_cpu_capability();
   return capability;
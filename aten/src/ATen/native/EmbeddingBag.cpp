@@ -1,18 +1,9 @@
 #include "ATen/ATen.h"
 #include "ATen/TensorUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
 
-#include "TH/THBlasUtils.h"
-
-#include <cstring>
-#include <iostream>
-#include <memory>
-#include <sstream>
-#include <vector>
-
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include <tuple>
 
 namespace {
   const int MODE_SUM = 0;
@@ -23,6 +14,14 @@ namespace {
 namespace at {
 namespace native {
 
+DEFINE_DISPATCH(embedding_bag_sum_stub);
+DEFINE_DISPATCH(embedding_bag_max_stub);
+DEFINE_DISPATCH(embedding_bag_backward_sum_stub);
+DEFINE_DISPATCH(embedding_bag_backward_max_stub);
+DEFINE_DISPATCH(fused_rowwise_quantize_stub);
+DEFINE_DISPATCH(fused_rowwise_dequantize_stub);
+DEFINE_DISPATCH(fused_rowwise_embedding_bag_stub);
+
 static void make_offset2bag(const Tensor &offsets, const Tensor &indices,
                             Tensor &offset2bag) {
   offset2bag.index_add_(
@@ -31,34 +30,9 @@ static void make_offset2bag(const Tensor &offsets, const Tensor &indices,
   offset2bag = offset2bag.cumsum(0);     // offset2bag = [0 0 1 1 2]
 }
 
-// This function combines index_select (using select_indices as the index) and
-// index_add (using add_indices as the index), without creating an intermediary
-// tensor to hold the selected embeddings
-template<typename T>
-static void index_select_add(const Tensor &select_indices,
-                             const Tensor &add_indices,
-                             const Tensor &src,
-                             Tensor &output) {
-  auto add_indices_data = add_indices.data<int64_t>();
-  auto select_indices_data = select_indices.data<int64_t>();
-  auto src_data = src.data<T>();
-  auto output_data = output.data<T>();
-  auto numel = add_indices.numel();
-  int64_t ddim = src.size(1);
-  auto src_stride0 = src.stride(0);
-  auto src_stride1 = src.stride(1);
-  auto output_stride0 = output.stride(0);
-  auto output_stride1 = output.stride(1);
-  for (int64_t i = 0; i < numel; i++) {
-    THBlas_axpy<T>(ddim, 1,
-            src_data + src_stride0 * select_indices_data[i], src_stride1,
-            output_data + output_stride0 * add_indices_data[i], output_stride1);
-  }
-}
-
 static void make_bag_size(const Tensor &offsets, const Tensor &indices,
                           const int64_t mode, Tensor &bag_size) {
-  if (mode == MODE_MEAN || mode == MODE_MAX) {
+  if ((mode == MODE_MEAN || mode == MODE_MAX) && offsets.size(0) > 0) {
     // Compute this for MODE_MEAN and MODE_MAX (latter needed for backwards)
     if (offsets.size(0) != 1) {
       bag_size.slice(0, 0, bag_size.size(0) - 1, 1) =
@@ -69,26 +43,6 @@ static void make_bag_size(const Tensor &offsets, const Tensor &indices,
   }
 }
 
-static Tensor apply_bag_size(const Tensor &offsets, const Tensor &indices,
-                             const int64_t mode, Tensor &output,
-                             const Tensor &bag_size) {
-  if (mode == MODE_MEAN) {
-    if (offsets.size(0) == 1) {
-      auto bag_size_ = indices.size(0);
-      output /= bag_size_;
-    } else {
-      // Avoid dividing by 0 for empty bags.
-      // Instead we want empty bags to return all 0s
-      auto bag_size_ = at::max(bag_size, at::ones_like(bag_size))
-                           .to(output.options())
-                           .unsqueeze(1)
-                           .expand_as(output);
-      output /= bag_size_;
-    }
-  }
-  return output;
-}
-
 static Tensor apply_bag_size_backward(const Tensor &offsets,
                                       const Tensor &indices, const int64_t mode,
                                       Tensor &output, const Tensor &offset2bag,
@@ -108,45 +62,44 @@ static Tensor apply_bag_size_backward(const Tensor &offsets,
 }
 
 
-template <typename scalar_t>
-std::tuple<Tensor, Tensor, Tensor, Tensor> embedding_bag_cpu_max(
-  const Tensor& weight, const Tensor &indices, const Tensor& offset2bag, const Tensor& output, const Tensor& bag_size, const Tensor& offsets) {
-
-    auto max_indices = at::zeros({offsets.size(0), weight.size(1)}, indices.options());
-
-    int64_t numel = indices.numel();
-    int64_t dims = weight.size(1);
-    auto indices_data = indices.data<int64_t>();
-    auto offset2bag_data = offset2bag.data<int64_t>();
-
-    auto max_indices_data = max_indices.data<int64_t>();
-    auto max_indices_stride = max_indices.stride(0);
-
-    auto weight_data = weight.data<scalar_t>();
-    auto output_data = output.data<scalar_t>();
-    auto weight_stride0 = weight.stride(0);
-    auto weight_stride1 = weight.stride(1);
-    auto output_stride = output.stride(0);
-
-    for (int i = 0; i < numel; i++) {
-      auto bag = offset2bag_data[i];
-      auto word_idx = indices_data[i];
-
-
-      for (int dim = 0; dim < dims; dim++) {
-        auto& current_item = output_data[output_stride * bag + dim];
-        auto weight_item = weight_data[weight_stride0 * word_idx + dim * weight_stride1];
-
-        bool is_first_for_bag = (i == 0) || offset2bag_data[i - 1] != bag;
-
-        if (is_first_for_bag || weight_item > current_item) {
-          current_item = weight_item;
-          max_indices_data[max_indices_stride * bag + dim] = word_idx;
-        }
-      }
-    }
+static void check_offsets(const Tensor &offsets, const Tensor &indices) {
+  AT_CHECK(indices.dim() == 1, "embedding_bag: expected indices to be 1-D, but got ",
+           indices.dim(), "-D");
+  AT_CHECK(offsets.dim() == 1, "embedding_bag: expected offsets to be 1-D, but got ",
+           offsets.dim(), "-D");
+  auto offsets_data = offsets.data<int64_t>();
+  int64_t num_bags = offsets.numel();
+  int64_t numel = indices.numel();
+  if (num_bags == 0) {
+    // an empty batch, e.g. a 2-D input with no rows
+    AT_CHECK(numel == 0, "embedding_bag: expected no indices without offsets, but got ",
+             numel, " indices");
+    return;
+  }
+  AT_CHECK(offsets_data[0] == 0, "embedding_bag: offsets has to start with 0");
+  for (int64_t i = 1; i < num_bags; i++) {
+    AT_CHECK(offsets_data[i] >= offsets_data[i - 1] && offsets_data[i] <= numel,
+             "embedding_bag: offsets has to be non-decreasing and at most the ",
+             "number of indices (", numel, "), but offsets[", i, "] = ", offsets_data[i]);
+  }
+}
 
-    return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag, bag_size, max_indices);
+static void check_per_sample_weights(const Tensor &per_sample_weights,
+                                     const Tensor &weight, const Tensor &indices,
+                                     const int64_t mode) {
+  if (!per_sample_weights.defined()) {
+    return;
+  }
+  AT_CHECK(mode == MODE_SUM,
+           "embedding_bag: per_sample_weights is only supported for mode='sum'");
+  AT_CHECK(per_sample_weights.type() == weight.type(),
+           "embedding_bag: expected per_sample_weights to be of type ",
+           weight.type().toString(), " but got ", per_sample_weights.type().toString());
+  AT_CHECK(per_sample_weights.dim() == 1 &&
+               per_sample_weights.numel() == indices.numel(),
+           "embedding_bag: expected per_sample_weights to be a 1-D tensor with one "
+           "weight per index (", indices.numel(), "), but got size ",
+           per_sample_weights.sizes());
 }
 
 // embedding_bag wrapper to enforce contiguity in tensors other than `weight`.
@@ -155,9 +108,13 @@ std::tuple<Tensor, Tensor, Tensor, Tensor> embedding_bag_cpu_max(
 std::tuple<Tensor, Tensor, Tensor, Tensor>
 embedding_bag(const Tensor &weight, const Tensor &indices,
               const Tensor &offsets, const bool scale_grad_by_freq,
-              const int64_t mode, bool sparse) {
+              const int64_t mode, bool sparse,
+              const Tensor &per_sample_weights) {
   return at::_embedding_bag(weight, indices.contiguous(), offsets.contiguous(),
-                            scale_grad_by_freq, mode, sparse);
+                            scale_grad_by_freq, mode, sparse,
+                            per_sample_weights.defined()
+                                ? per_sample_weights.contiguous()
+                                : per_sample_weights);
   };
 
 // Assumes all input tensors except for `weight` are contiguous.
@@ -165,13 +122,17 @@ embedding_bag(const Tensor &weight, const Tensor &indices,
 std::tuple<Tensor, Tensor, Tensor, Tensor>
 _embedding_bag_cpu(const Tensor &weight, const Tensor &indices,
                   const Tensor &offsets, const bool scale_grad_by_freq,
-                  const int64_t mode, bool sparse) {
+                  const int64_t mode, bool sparse,
+                  const Tensor &per_sample_weights) {
   auto indices_arg = TensorArg(indices, "indices", 1);
   checkScalarType("embedding_bag", indices_arg, kLong);
   auto offsets_arg = TensorArg(offsets, "offsets", 1);
-  checkScalarType("embedding_bag", indices_arg, kLong);
+  checkScalarType("embedding_bag", offsets_arg, kLong);
   auto weight_arg = TensorArg(weight, "weight", 1);
   checkScalarTypes("embedding_bag", weight_arg, {kFloat, kDouble});
+  checkDim("embedding_bag", weight_arg, 2);
+  check_offsets(offsets, indices);
+  check_per_sample_weights(per_sample_weights, weight, indices, mode);
 
   auto bag_size = at::zeros(offsets.sizes(), indices.options());
   make_bag_size(offsets, indices, mode, bag_size);
@@ -190,19 +151,13 @@ _embedding_bag_cpu(const Tensor &weight, const Tensor &indices,
   auto output = at::zeros({offsets.size(0), weight.size(1)}, weight.options());
 
   if (mode == MODE_MEAN || mode == MODE_SUM) {
-    if (weight.scalar_type() == kFloat) {
-      index_select_add<float>(indices, offset2bag, weight, output);
-    } else if (weight.scalar_type() == kDouble) {
-      index_select_add<double>(indices, offset2bag, weight, output);
-    }
-    auto ret = apply_bag_size(offsets, indices, mode, output, bag_size);
-    return std::tuple<Tensor, Tensor, Tensor, Tensor>(ret, offset2bag, bag_size, bag_size);
+    embedding_bag_sum_stub(kCPU, output, weight, indices, offsets,
+                           per_sample_weights, mode == MODE_MEAN);
+    return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag, bag_size, bag_size);
   } else { // MODE_MAX
-    return AT_DISPATCH_FLOATING_TYPES_AND_HALF(
-      weight.type(), "embedding_bag_cpu_max", [&]() {
-        return embedding_bag_cpu_max<scalar_t>(weight, indices, offset2bag, output, bag_size, offsets);
-      }
-    );
+    auto max_indices = at::zeros({offsets.size(0), weight.size(1)}, indices.options());
+    embedding_bag_max_stub(kCPU, output, max_indices, weight, indices, offsets);
+    return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag, bag_size, max_indices);
   }
 }
 
@@ -215,7 +170,8 @@ Tensor _embedding_bag_backward(const Tensor &grad, const Tensor &indices,
                               const Tensor &max_indices_,
                               int64_t num_weights,
                               bool scale_grad_by_freq, int64_t mode,
-                              bool sparse) {
+                              bool sparse,
+                              const Tensor &per_sample_weights) {
   auto indices_arg = TensorArg(indices, "indices", 1);
   checkScalarType("embedding_bag", indices_arg, kLong);
   checkContiguous("embedding_bag", indices_arg);
@@ -229,21 +185,22 @@ Tensor _embedding_bag_backward(const Tensor &grad, const Tensor &indices,
   if (sparse) {
     return at::_embedding_bag_sparse_backward(
         grad, indices, offsets, offset2bag, bag_size_, num_weights,
-        scale_grad_by_freq, mode);
+        scale_grad_by_freq, mode, per_sample_weights);
   } else {
     return at::_embedding_bag_dense_backward(
         grad, indices, offsets, offset2bag, bag_size_, max_indices_, num_weights,
-        scale_grad_by_freq, mode);
+        scale_grad_by_freq, mode, per_sample_weights);
   }
 }
 
 Tensor _embedding_bag_dense_backward_cpu(const Tensor &grad_, const Tensor &indices_,
                                   const Tensor &offsets_,
-                                  const Tensor &offset2bag__,
+                                  const Tensor &offset2bag_,
                                   const Tensor &bag_size_,
                                   const Tensor& max_indices_, int64_t num_weights,
-                                  bool scale_grad_by_freq, int64_t mode) {
-  // indices_, offsets_ and offset2bag__ are assumed having correct dtypes and
+                                  bool scale_grad_by_freq, int64_t mode,
+                                  const Tensor &per_sample_weights) {
+  // indices_, offsets_ and offset2bag_ are assumed having correct dtypes and
   // contiguous here due to the checks in _embedding_bag_backward above.
   // Also see NOTE [ embedding_bag Native Functions ] in native_functions.yaml
   // for more details.
@@ -252,85 +209,21 @@ Tensor _embedding_bag_dense_backward_cpu(const Tensor &grad_, const Tensor &indi
   auto grad_arg = TensorArg(grad, "grad_", 1);
   checkScalarTypes("embedding_bag", grad_arg, {kFloat, kDouble});
 
-  Tensor &offset2bag_ = const_cast<Tensor &>(offset2bag__);
-
-  auto ind_sort_ = indices_.sort();
-  auto indices = std::get<0>(ind_sort_);
-  auto ind_sort = std::get<1>(ind_sort_);
-  auto offset2bag = offset2bag_.index_select(0, ind_sort);
-
-  auto indices_data = indices.data<int64_t>();
-  auto offsets_data = offsets_.data<int64_t>();
-  auto offset2bag_data = offset2bag.data<int64_t>();
-  int64_t numel = indices.numel();
-
-  std::vector<int64_t> counts(num_weights);
-  for (int i = 0; i < numel; i++) {
-    counts[indices_data[i]] = 0;
-  }
-  for (int i = 0; i < numel; i++) {
-    counts[indices_data[i]]++;
-  }
-
-  auto index_grad_weight =
-      at::zeros({num_weights, grad.size(1)}, grad.options()).contiguous();
-
-  std::vector<int64_t> counts_uniq;
-  counts_uniq.reserve(num_weights);
-  int64_t o = 0;
-  for (int64_t i = 0; i < numel; i += counts[indices_data[i]]) {
-    counts_uniq.push_back(counts[indices_data[i]]);
-    if (o > 0) {
-      counts_uniq[o] += counts_uniq[o - 1];
-    }
-    o++;
+  auto index_grad_weight = at::zeros({num_weights, grad.size(1)}, grad.options());
+  if (indices_.numel() == 0) {
+    return index_grad_weight;
   }
 
   if (mode == MODE_MEAN || mode == MODE_SUM) {
-    #pragma omp parallel for if (numel > 1000)
-      for (int64_t i = 0; i < (int64_t)counts_uniq.size(); i++) {
-        int64_t start = i == 0 ? 0 : counts_uniq[i - 1];
-        int64_t index = indices_data[start];
-        for (int64_t j = start; j < counts_uniq[i]; j++) {
-          int64_t source = offset2bag_data[j];
-          double scale = 1.0;
-          if (scale_grad_by_freq) {
-            scale /= counts[indices_data[i]];
-          }
-          if (mode == 1) { // MODE_MEAN
-            if (offsets_.size(0) == 1) {
-              auto bag_size = indices.size(0);
-              scale /= bag_size;
-            } else {
-              if (source == offsets_.size(0) - 1) {
-                scale /= indices.size(0) - offsets_data[offsets_.size(0) - 1];
-              } else {
-                scale /= offsets_data[source + 1] - offsets_data[source];
-              }
-            }
-          }
-          int64_t ddim = grad.size(1);
-          if (grad.scalar_type() == kFloat) {
-            auto igwd = index_grad_weight.data<float>();
-            auto gd = grad.data<float>();
-            THBlas_axpy<float>(ddim, (float)scale, gd + ddim * source, 1,
-                        igwd + ddim * index, 1);
-          } else if (grad.scalar_type() == kDouble) {
-            auto igwd = index_grad_weight.data<double>();
-            auto gd = grad.data<double>();
-            THBlas_axpy<double>(ddim, (double)scale, gd + ddim * source, 1,
-                         igwd + ddim * index, 1);
-          }
-        }
-      }
+    Tensor indices, ind_sort;
+    std::tie(indices, ind_sort) = indices_.sort();
+    embedding_bag_backward_sum_stub(
+        kCPU, index_grad_weight, grad, indices, ind_sort, offset2bag_, bag_size_,
+        per_sample_weights.defined() ? per_sample_weights.contiguous() : per_sample_weights,
+        mode == MODE_MEAN, scale_grad_by_freq);
   } else if (mode == MODE_MAX) {
-    auto nonempty_max_indices = max_indices_.index_select(0, bag_size_.nonzero().view(-1));
-    auto nonempty_grad = grad_.index_select(0, bag_size_.nonzero().view(-1));
-
-    for (int64_t dim = 0; dim < grad.size(1); dim++) {
-      index_grad_weight.select(1, dim).index_add_(
-        0, nonempty_max_indices.select(1, dim), nonempty_grad.select(1, dim));
-    }
+    embedding_bag_backward_max_stub(kCPU, index_grad_weight, grad,
+                                    max_indices_.contiguous(), bag_size_);
   }
 
   return index_grad_weight;
@@ -339,7 +232,7 @@ Tensor _embedding_bag_dense_backward_cpu(const Tensor &grad_, const Tensor &indi
 Tensor _embedding_bag_sparse_backward(
     const Tensor &grad_, const Tensor &indices, const Tensor &offsets,
     const Tensor &offset2bag, const Tensor &bag_size_, int64_t num_weights,
-    bool scale_grad_by_freq, int64_t mode) {
+    bool scale_grad_by_freq, int64_t mode, const Tensor &per_sample_weights) {
   // indices, offsets and offset2bag are assumed having correct dtypes and
   // contiguous here due to the checks in _embedding_bag_backward above.
   // Also see NOTE [ embedding_bag Native Functions ] in native_functions.yaml
@@ -349,8 +242,91 @@ Tensor _embedding_bag_sparse_backward(
   Tensor index_grad = grad_.index_select(0, offset2bag);
   index_grad = apply_bag_size_backward(offsets, indices, mode, index_grad,
                                        offset2bag, bag_size_);
+  if (per_sample_weights.defined()) {
+    index_grad.mul_(per_sample_weights.unsqueeze(1));
+  }
   return native::embedding_backward(index_grad, indices, num_weights, -1,
                                     scale_grad_by_freq, true);
 }
+
+// d(output[bag]) / d(per_sample_weights[i]) is the embedding row selected by
+// indices[i], for the bag that index belongs to.
+Tensor _embedding_bag_per_sample_weights_backward(
+    const Tensor &grad, const Tensor &weight, const Tensor &indices,
+    const Tensor &offset2bag, int64_t mode) {
+  AT_CHECK(mode == MODE_SUM,
+           "embedding_bag: per_sample_weights is only supported for mode='sum'");
+  return (grad.index_select(0, offset2bag) * weight.index_select(0, indices)).sum(1);
+}
+
+static int64_t fused_rowwise_params_bytes(int64_t bits) {
+  AT_CHECK(bits == 8 || bits == 4,
+           "fused_rowwise: expected bits to be 8 or 4, but got ", bits);
+  return bits == 8 ? 2 * sizeof(float) : 2 * sizeof(Half);
+}
+
+// Number of embedding columns stored in each row of `packed`. A 4-bit row
+// always holds an even number of columns; an odd embedding_dim is padded.
+static int64_t fused_rowwise_dim(const Tensor &packed, int64_t bits) {
+  auto packed_arg = TensorArg(packed, "packed", 1);
+  checkScalarType("fused_rowwise", packed_arg, kByte);
+  checkDim("fused_rowwise", packed_arg, 2);
+  int64_t params_bytes = fused_rowwise_params_bytes(bits);
+  AT_CHECK(packed.size(1) >= params_bytes,
+           "fused_rowwise: a packed row needs at least ", params_bytes,
+           " bytes for its scale and bias, but got ", packed.size(1));
+  int64_t row_bytes = packed.size(1) - params_bytes;
+  return bits == 8 ? row_bytes : 2 * row_bytes;
+}
+
+Tensor fused_rowwise_quantize_cpu(const Tensor &self, int64_t bits) {
+  auto self_arg = TensorArg(self, "self", 1);
+  checkScalarType("fused_rowwise_quantize", self_arg, kFloat);
+  checkDim("fused_rowwise_quantize", self_arg, 2);
+  int64_t dim = self.size(1);
+  int64_t row_bytes = bits == 8 ? dim : (dim + 1) / 2;
+  auto packed = at::empty({self.size(0), row_bytes + fused_rowwise_params_bytes(bits)},
+                          self.options().dtype(kByte));
+  fused_rowwise_quantize_stub(kCPU, packed, self.contiguous(), bits);
+  return packed;
+}
+
+Tensor fused_rowwise_dequantize_cpu(const Tensor &self, int64_t bits) {
+  int64_t dim = fused_rowwise_dim(self, bits);
+  auto weight = at::empty({self.size(0), dim}, self.options().dtype(kFloat));
+  fused_rowwise_dequantize_stub(kCPU, weight, self.contiguous(), bits);
+  return weight;
+}
+
+Tensor fused_rowwise_embedding_bag_cpu(const Tensor &weight, const Tensor &indices_,
+                                       const Tensor &offsets_, int64_t bits,
+                                       int64_t mode, const Tensor &per_sample_weights) {
+  int64_t dim = fused_rowwise_dim(weight, bits);
+  auto indices = indices_.contiguous();
+  auto offsets = offsets_.contiguous();
+  auto indices_arg = TensorArg(indices, "indices", 2);
+  checkScalarType("fused_rowwise_embedding_bag", indices_arg, kLong);
+  auto offsets_arg = TensorArg(offsets, "offsets", 3);
+  checkScalarType("fused_rowwise_embedding_bag", offsets_arg, kLong);
+  AT_CHECK(mode == MODE_SUM || mode == MODE_MEAN,
+           "fused_rowwise_embedding_bag: only mode='sum' and mode='mean' are supported");
+  check_offsets(offsets, indices);
+  if (per_sample_weights.defined()) {
+    AT_CHECK(mode == MODE_SUM,
+             "fused_rowwise_embedding_bag: per_sample_weights is only supported for mode='sum'");
+    AT_CHECK(per_sample_weights.scalar_type() == kFloat &&
+                 per_sample_weights.dim() == 1 &&
+                 per_sample_weights.numel() == indices.numel(),
+             "fused_rowwise_embedding_bag: expected per_sample_weights to be a 1-D float "
+             "tensor with one weight per index (", indices.numel(), ")");
+  }
+  auto output = at::zeros({offsets.size(0), dim}, weight.options().dtype(kFloat));
+  fused_rowwise_embedding_bag_stub(
+      kCPU, output, weight.contiguous(), indices, offsets,
+      per_sample_weights.defined() ? per_sample_weights.contiguous() : per_sample_weights,
+      bits, mode == MODE_MEAN);
+  return output;
+}
+
 }
 } // namespace at::native
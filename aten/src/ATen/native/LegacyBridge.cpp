@@ -57,6 +57,11 @@ Tensor pow(const Tensor& self, Scalar exponent) {
 Tensor& zero_(Tensor& self) {
   if (_has_native(self)) {
     return native_zero_(self);
+  } else if (self.type().backend() == Backend::CPU &&
+             (self.type().scalarType() == kHalf ||
+              self.type().scalarType() == kBFloat16)) {
+    // TH has no CPU math for the 16-bit floating point types.
+    return self.fill_(0);
   } else {
     return _th_zero_(self);
   }
@@ -713,21 +713,6 @@ Tensor median(const Tensor & self) {
   return at::_th_median(self);
 }
 
-std::tuple<Tensor &,Tensor &> sort_out(Tensor & values, Tensor & indices, const Tensor & self, int64_t dim, bool descending) {
-  return at::_th_sort_out(values, indices, self, dim, descending);
-}
-
-std::tuple<Tensor,Tensor> sort(const Tensor & self, int64_t dim, bool descending) {
-  return at::_th_sort(self, dim, descending);
-}
-std::tuple<Tensor &,Tensor &> topk_out(Tensor & values, Tensor & indices, const Tensor & self, int64_t k, int64_t dim, bool largest, bool sorted) {
-  return at::_th_topk_out(values, indices, self, k, dim, largest, sorted);
-}
-
-std::tuple<Tensor,Tensor> topk(const Tensor & self, int64_t k, int64_t dim, bool largest, bool sorted) {
-  return at::_th_topk(self, k, dim, largest, sorted);
-}
-
 Tensor all(const Tensor & self) {
   return at::_th_all(self);
 }
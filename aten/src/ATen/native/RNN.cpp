@@ -2,6 +2,7 @@
 
 #include "ATen/ATen.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/TensorUtils.h"
 
 namespace at { namespace native {
 
@@ -133,70 +134,55 @@ tpair_of<Tensor> hidden_slice(const tpair_of<Tensor>& t, int64_t start, int64_t
 // which means that it consumes an input tensor, and updates the previous hidden state.
 // It's a struct only because functional programming in C++ is a pain, and it's easier
 // to pass around "vtable pointers" than actual function pointers.
+//
+// The input only enters a cell through its projection by w_ih, which doesn't depend
+// on the hidden state. Cells therefore implement step(), which takes the projected
+// input, and layers project the inputs of all timesteps with a single matrix multiply
+// (see project_input) instead of one per step.
+
+// The input gates of every cell: input * w_ih^T + b_ih. Works on a single step
+// (batch, input_size) as well as on a whole sequence (seq_len, batch, input_size).
+Tensor project_input(const Tensor& input, const CellParams& params) {
+  return at::linear(input, params.w_ih, params.b_ih);
+}
 
 template<typename hidden_type_tmpl>
 struct Cell {
   using hidden_type = hidden_type_tmpl;
   virtual ~Cell() {} // This is really dumb, but enables projects with -Wnon-virtual-dtor to compile...
-  virtual hidden_type operator()(const Tensor& input, const hidden_type& hidden, const CellParams& params) const = 0;
+  virtual hidden_type step(const Tensor& input_gates, const hidden_type& hidden, const CellParams& params) const = 0;
+
+  hidden_type operator()(const Tensor& input, const hidden_type& hidden, const CellParams& params) const {
+    return step(project_input(input, params), hidden, params);
+  }
 };
 
 template<typename nonlinearity>
 struct SimpleCell : Cell<Tensor> {
-  hidden_type operator()(const Tensor& input, const hidden_type& hidden, const CellParams& params) const override {
-    return nonlinearity{}(at::linear(input, params.w_ih, params.b_ih) + at::linear(hidden, params.w_hh, params.b_hh));
+  hidden_type step(const Tensor& input_gates, const hidden_type& hidden, const CellParams& params) const override {
+    return nonlinearity{}(input_gates + at::linear(hidden, params.w_hh, params.b_hh));
   }
 };
 
-// TODO: can use inplace ops?
+// Both biases are already folded into the gates by at::linear, so the fused cells
+// (CPU and CUDA) only do the pointwise part, in a single pass.
 struct LSTMCell : Cell<std::tuple<Tensor, Tensor>> {
-  hidden_type operator()(const Tensor& input, const hidden_type& hidden, const CellParams& params) const override {
+  hidden_type step(const Tensor& input_gates, const hidden_type& hidden, const CellParams& params) const override {
     auto hx = std::get<0>(hidden);
     auto cx = std::get<1>(hidden);
-
-    if (input.is_cuda()) {
-      auto igates = at::matmul(input, params.w_ih.t());
-      auto hgates = at::matmul(hx, params.w_hh.t());
-      auto result = at::_thnn_fused_lstm_cell(igates, hgates, cx, params.b_ih, params.b_hh);
-      // Slice off the workspace argument (it's needed only for AD).
-      return std::make_tuple(std::get<0>(result), std::get<1>(result));
-    }
-
-    auto gates = at::linear(input, params.w_ih, params.b_ih) + at::linear(hx, params.w_hh, params.b_hh);
-    auto chunked_gates = gates.chunk(4, 1);
-
-    auto ingate = chunked_gates[0].sigmoid();
-    auto forgetgate = chunked_gates[1].sigmoid();
-    auto cellgate = chunked_gates[2].tanh();
-    auto outgate = chunked_gates[3].sigmoid();
-
-    auto cy = (forgetgate * cx) + (ingate * cellgate);
-    auto hy = outgate * cy.tanh();
-
-    return std::make_tuple(hy, cy);
+    auto hidden_gates = at::linear(hx, params.w_hh, params.b_hh);
+    auto result = at::_thnn_fused_lstm_cell(input_gates, hidden_gates, cx);
+    // Slice off the workspace argument (it's needed only for AD).
+    return std::make_tuple(std::get<0>(result), std::get<1>(result));
   }
 };
 
 struct GRUCell : Cell<Tensor> {
-  hidden_type operator()(const Tensor& input, const hidden_type& hidden, const CellParams& params) const override {
-    if (input.is_cuda()) {
-      auto igates = at::matmul(input, params.w_ih.t());
-      auto hgates = at::matmul(hidden, params.w_hh.t());
-      auto result = at::_thnn_fused_gru_cell(igates, hgates, hidden, params.b_ih, params.b_hh);
-      // Slice off the workspace argument (it's needed only for AD).
-      return std::get<0>(result);
-    }
-
-    auto igates = at::linear(input, params.w_ih, params.b_ih);
-    auto hgates = at::linear(hidden, params.w_hh, params.b_hh);
-    auto chunked_igates = igates.chunk(3, 1);
-    auto chunked_hgates = hgates.chunk(3, 1);
-
-    auto reset_gate = at::sigmoid(chunked_igates[0] + chunked_hgates[0]);
-    auto input_gate = at::sigmoid(chunked_igates[1] + chunked_hgates[1]);
-    auto new_gate = at::tanh(chunked_igates[2] + reset_gate * chunked_hgates[2]);
-
-    return new_gate + input_gate * (hidden - new_gate);
+  hidden_type step(const Tensor& input_gates, const hidden_type& hidden, const CellParams& params) const override {
+    auto hidden_gates = at::linear(hidden, params.w_hh, params.b_hh);
+    auto result = at::_thnn_fused_gru_cell(input_gates, hidden_gates, hidden);
+    // Slice off the workspace argument (it's needed only for AD).
+    return std::get<0>(result);
   }
 };
 
@@ -232,18 +218,20 @@ struct FullLayer : Layer<Tensor, hidden_type, CellParams> {
   FullLayer(Cell<hidden_type>& cell)
     : cell_(cell) {};
 
-  unstacked_output_type operator()(std::vector<Tensor> step_inputs, const hidden_type& input_hidden, const CellParams& params) const {
+  // step_input_gates are the inputs of every step, already projected by project_input.
+  unstacked_output_type operator()(std::vector<Tensor> step_input_gates, const hidden_type& input_hidden, const CellParams& params) const {
     std::vector<Tensor> step_outputs;
+    step_outputs.reserve(step_input_gates.size());
     auto hidden = input_hidden;
-    for (size_t i = 0; i < step_inputs.size(); i++) {
-      hidden = cell_(step_inputs[i], hidden, params);
+    for (size_t i = 0; i < step_input_gates.size(); i++) {
+      hidden = cell_.step(step_input_gates[i], hidden, params);
       step_outputs.push_back(hidden_as_output(hidden));
     }
     return {step_outputs, hidden};
   }
 
   output_type operator()(const Tensor& inputs, const hidden_type& input_hidden, const CellParams& params) const override {
-    auto unstacked_output = (*this)(inputs.unbind(0), input_hidden, params);
+    auto unstacked_output = (*this)(project_input(inputs, params).unbind(0), input_hidden, params);
     return {at::stack(unstacked_output.outputs, 0), unstacked_output.final_hidden};
   }
 
@@ -260,11 +248,10 @@ struct FullBidirectionalLayer : Layer<Tensor, pair_of<dir_hidden_type>, pair_of<
     : layer_(cell) {};
 
   output_type operator()(const Tensor& input, const hidden_type& input_hidden, const param_type& params) const override {
-    auto step_inputs = input.unbind(0);
-    auto fw_result = layer_(step_inputs, input_hidden.first, params.first);
+    auto fw_result = layer_(project_input(input, params.first).unbind(0), input_hidden.first, params.first);
     auto fw_output = at::stack(fw_result.outputs, 0);
 
-    auto rev_step_inputs = reverse(std::move(step_inputs));
+    auto rev_step_inputs = reverse(project_input(input, params.second).unbind(0));
     auto rev_result = layer_(rev_step_inputs, input_hidden.second, params.second);
     std::reverse(rev_result.outputs.begin(), rev_result.outputs.end());
     auto rev_output = at::stack(rev_result.outputs, 0);
@@ -302,10 +289,11 @@ struct PackedLayer : Layer<PackedSequence, hidden_type, CellParams> {
     // which requires us to slice the hidden state (since some sequences
     // are completed now). The sliced parts are also saved, because we will need
     // to return a tensor of final hidden state.
+    auto input_gates = project_input(input.data, params);
     auto hidden = input_hidden;
     for (int64_t i = 0; i < num_steps; ++i) {
       int64_t batch_size = batch_sizes[i];
-      auto step_input = input.data.narrow(0, input_offset, batch_size);
+      auto step_input_gates = input_gates.narrow(0, input_offset, batch_size);
       input_offset += batch_size;
 
       int64_t dec = last_batch_size - batch_size;
@@ -315,7 +303,7 @@ struct PackedLayer : Layer<PackedSequence, hidden_type, CellParams> {
       }
 
       last_batch_size = batch_size;
-      hidden = cell_(step_input, hidden, params);
+      hidden = cell_.step(step_input_gates, hidden, params);
       step_outputs.push_back(hidden_as_output(hidden));
     }
     hiddens.push_back(hidden);
@@ -345,6 +333,7 @@ struct ReversedPackedLayer : Layer<PackedSequence, hidden_type, CellParams> {
     // the smallest batch size (and a small set of hidden states we actually use),
     // and progressively expand the hidden states, as we move backwards over the
     // 1D list of inputs.
+    auto input_gates = project_input(input.data, params);
     auto hidden = hidden_slice(input_hidden, 0, batch_sizes[num_steps - 1]);
     for (int64_t i = num_steps - 1; i >= 0; --i) {
       int64_t batch_size = batch_sizes[i];
@@ -353,11 +342,11 @@ struct ReversedPackedLayer : Layer<PackedSequence, hidden_type, CellParams> {
         hidden = hidden_concat(ArrayRef<hidden_type>{hidden, hidden_slice(input_hidden, last_batch_size, batch_size)});
       }
 
-      auto step_input = input.data.narrow(0, input_offset - batch_size, batch_size);
+      auto step_input_gates = input_gates.narrow(0, input_offset - batch_size, batch_size);
       input_offset -= batch_size;
 
       last_batch_size = batch_size;
-      hidden = cell_(step_input, hidden, params);
+      hidden = cell_.step(step_input_gates, hidden, params);
       step_outputs.push_back(hidden_as_output(hidden));
     }
     std::reverse(step_outputs.begin(), step_outputs.end());
@@ -614,4 +603,201 @@ Tensor rnn_relu_cell(
   return SimpleCell<relu_f>{}(input, hx, CellParams{w_ih, w_hh, b_ih, b_hh});
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// FUSED CPU CELLS
+//
+// CPU versions of the pointwise cell kernels in cuda/RNN.cu, with the same
+// signatures and workspace layouts, so that they share the derivatives.
+////////////////////////////////////////////////////////////////////////////////
+
+DEFINE_DISPATCH(lstm_cell_stub);
+DEFINE_DISPATCH(lstm_cell_backward_stub);
+DEFINE_DISPATCH(gru_cell_stub);
+DEFINE_DISPATCH(gru_cell_backward_stub);
+
+namespace {
+
+static constexpr int64_t GRU_WORKSPACE_MULTIPLIER = 5;
+
+// Factor will be 3 for GRU and 4 for LSTM
+void check_fused_cell_sizes(CheckedFrom c,
+                            const TensorArg& input_gates, const TensorArg& hidden_gates,
+                            const TensorArg& input_bias, const TensorArg& hidden_bias,
+                            int64_t factor, const TensorArg& prev_hidden) {
+  checkDim(c, input_gates, 2);
+  checkSameSize(c, input_gates, hidden_gates);
+  int64_t gates_size = input_gates->size(1);
+
+  if (input_bias->defined()) {
+    checkDim(c, input_bias, 1);
+    checkNumel(c, input_bias, gates_size);
+    checkSameSize(c, input_bias, hidden_bias);
+  }
+
+  checkDim(c, prev_hidden, 2);
+  checkNumel(c, prev_hidden, input_gates->size(0) * gates_size / factor);
+
+  checkAllSameType(c, {input_gates, hidden_gates, input_bias, hidden_bias, prev_hidden});
+}
+
+Tensor contiguous_if_defined(const Tensor& t) {
+  return t.defined() ? t.contiguous() : t;
+}
+
+} // anonymous namespace
+
+std::tuple<Tensor, Tensor, Tensor> _thnn_fused_lstm_cell_cpu(
+      const Tensor& input_gates, const Tensor& hidden_gates,
+      const Tensor& cx,
+      const Tensor& input_bias, const Tensor& hidden_bias) {
+  check_fused_cell_sizes("_thnn_fused_lstm_cell_cpu",
+                         {input_gates, "input_gates", 1}, {hidden_gates, "hidden_gates", 2},
+                         {input_bias, "input_bias", 4}, {hidden_bias, "hidden_bias", 5},
+                         /*factor=*/4, {cx, "prev_hidden", 3});
+
+  auto cx_ = cx.contiguous();
+  auto workspace = at::empty(input_gates.sizes(), input_gates.options());
+  auto hy = at::empty(cx_.sizes(), cx_.options());
+  auto cy = at::empty(cx_.sizes(), cx_.options());
+  lstm_cell_stub(kCPU, hy, cy, workspace, input_gates.contiguous(), hidden_gates.contiguous(),
+                 contiguous_if_defined(input_bias), contiguous_if_defined(hidden_bias), cx_);
+  return std::make_tuple(hy, cy, workspace);
+}
+
+std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _thnn_fused_lstm_cell_backward_cpu(
+      const Tensor& grad_hy, const Tensor& grad_cy,
+      const Tensor& cx, const Tensor& cy,
+      const Tensor& workspace, bool has_bias) {
+  CheckedFrom c = "_thnn_fused_lstm_cell_backward_cpu";
+  TensorArg grad_arg = grad_hy.defined() ? TensorArg(grad_hy, "grad_hy", 1) : TensorArg(grad_cy, "grad_cy", 2);
+  TensorArg cx_arg(cx, "cx", 3), cy_arg(cy, "cy", 4), workspace_arg(workspace, "workspace", 5);
+  checkDim(c, grad_arg, 2);
+  checkSize(c, cx_arg, grad_arg->sizes());
+  checkSize(c, cy_arg, grad_arg->sizes());
+  checkDim(c, workspace_arg, 2);
+  checkNumel(c, workspace_arg, grad_arg->numel() * 4);
+
+  auto grad_gates = at::empty(workspace.sizes(), workspace.options());
+  auto grad_cx = at::empty(cx.sizes(), cx.options());
+  lstm_cell_backward_stub(kCPU, grad_gates, grad_cx, contiguous_if_defined(grad_hy),
+                          contiguous_if_defined(grad_cy), cx.contiguous(), cy.contiguous(),
+                          workspace.contiguous());
+
+  auto grad_bias = has_bias ? grad_gates.sum(0, /*keepdim=*/false) : at::Tensor{};
+  return std::make_tuple(grad_gates, grad_gates, grad_cx, grad_bias, grad_bias);
+}
+
+std::tuple<Tensor, Tensor> _thnn_fused_gru_cell_cpu(
+      const Tensor& input_gates, const Tensor& hidden_gates,
+      const Tensor& hx,
+      const Tensor& input_bias, const Tensor& hidden_bias) {
+  check_fused_cell_sizes("_thnn_fused_gru_cell_cpu",
+                         {input_gates, "input_gates", 1}, {hidden_gates, "hidden_gates", 2},
+                         {input_bias, "input_bias", 4}, {hidden_bias, "hidden_bias", 5},
+                         /*factor=*/3, {hx, "prev_hidden", 3});
+
+  auto hx_ = hx.contiguous();
+  auto workspace = at::empty({hx_.size(0), hx_.size(1) * GRU_WORKSPACE_MULTIPLIER}, hx_.options());
+  auto hy = at::empty(hx_.sizes(), hx_.options());
+  gru_cell_stub(kCPU, hy, workspace, input_gates.contiguous(), hidden_gates.contiguous(),
+                contiguous_if_defined(input_bias), contiguous_if_defined(hidden_bias), hx_);
+  return std::make_tuple(hy, workspace);
+}
+
+std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _thnn_fused_gru_cell_backward_cpu(
+      const Tensor& grad_hy, const Tensor& workspace, bool has_bias) {
+  CheckedFrom c = "_thnn_fused_gru_cell_backward_cpu";
+  TensorArg grad_hy_arg(grad_hy, "grad_hy", 1), workspace_arg(workspace, "workspace", 2);
+  checkDim(c, grad_hy_arg, 2);
+  checkSize(c, workspace_arg, {grad_hy.size(0), grad_hy.size(1) * GRU_WORKSPACE_MULTIPLIER});
+
+  int64_t hidden_size = workspace.size(1) / GRU_WORKSPACE_MULTIPLIER;
+  auto grad_input_gates = at::empty({workspace.size(0), hidden_size * 3}, workspace.options());
+  auto grad_hidden_gates = at::empty({workspace.size(0), hidden_size * 3}, workspace.options());
+  auto grad_hx = at::empty(grad_hy.sizes(), grad_hy.options());
+  gru_cell_backward_stub(kCPU, grad_input_gates, grad_hidden_gates, grad_hx,
+                         grad_hy.contiguous(), workspace.contiguous());
+
+  at::Tensor grad_input_bias, grad_hidden_bias;
+  if (has_bias) {
+    grad_input_bias = grad_input_gates.sum(0, /*keepdim=*/false);
+    grad_hidden_bias = grad_hidden_gates.sum(0, /*keepdim=*/false);
+  }
+  return std::make_tuple(grad_input_gates, grad_hidden_gates, grad_hx, grad_input_bias, grad_hidden_bias);
+}
+
+// Differentiable backward paths, alternatives to the fused cell backwards, to be used
+// when backward is itself creating a graph. They recompute the gates from the inputs
+// of the fused cell instead of reading its workspace, which has no gradient.
+// The GradMode::is_enabled() check must be performed within Functions.cpp.
+std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _thnn_differentiable_lstm_cell_backward(
+      const Tensor& grad_hy, const Tensor& grad_cy,
+      const Tensor& input_gates, const Tensor& hidden_gates,
+      const Tensor& input_bias, const Tensor& hidden_bias,
+      const Tensor& cx) {
+  if (!grad_hy.defined() && !grad_cy.defined()) {
+    return std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor>();
+  }
+  auto gates = input_gates + hidden_gates;
+  if (input_bias.defined()) {
+    gates = gates + input_bias;
+  }
+  if (hidden_bias.defined()) {
+    gates = gates + hidden_bias;
+  }
+  auto chunked_gates = gates.chunk(4, 1);
+  auto ingate = chunked_gates[0].sigmoid();
+  auto forgetgate = chunked_gates[1].sigmoid();
+  auto cellgate = chunked_gates[2].tanh();
+  auto outgate = chunked_gates[3].sigmoid();
+  auto tanh_cy = ((forgetgate * cx) + (ingate * cellgate)).tanh();
+
+  Tensor grad_outgate, grad_cx;
+  if (grad_hy.defined()) {
+    grad_outgate = grad_hy * tanh_cy * outgate * (1 - outgate);
+    grad_cx = grad_hy * outgate * (1 - tanh_cy * tanh_cy);
+    if (grad_cy.defined()) {
+      grad_cx = grad_cx + grad_cy;
+    }
+  } else {
+    grad_outgate = at::zeros_like(cx);
+    grad_cx = grad_cy;
+  }
+  auto grad_ingate = grad_cx * cellgate * ingate * (1 - ingate);
+  auto grad_forgetgate = grad_cx * cx * forgetgate * (1 - forgetgate);
+  auto grad_cellgate = grad_cx * ingate * (1 - cellgate * cellgate);
+  auto grad_gates = at::cat({grad_ingate, grad_forgetgate, grad_cellgate, grad_outgate}, 1);
+
+  auto grad_bias = input_bias.defined() ? grad_gates.sum(0, /*keepdim=*/false) : at::Tensor{};
+  return std::make_tuple(grad_gates, grad_gates, grad_cx * forgetgate, grad_bias, grad_bias);
+}
+
+std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _thnn_differentiable_gru_cell_backward(
+      const Tensor& grad_hy,
+      const Tensor& input_gates, const Tensor& hidden_gates,
+      const Tensor& hx,
+      const Tensor& input_bias, const Tensor& hidden_bias) {
+  auto igates = input_bias.defined() ? input_gates + input_bias : input_gates;
+  auto hgates = hidden_bias.defined() ? hidden_gates + hidden_bias : hidden_gates;
+  auto chunked_igates = igates.chunk(3, 1);
+  auto chunked_hgates = hgates.chunk(3, 1);
+  auto resetgate = (chunked_igates[0] + chunked_hgates[0]).sigmoid();
+  auto inputgate = (chunked_igates[1] + chunked_hgates[1]).sigmoid();
+  auto newgate = (chunked_igates[2] + resetgate * chunked_hgates[2]).tanh();
+
+  auto grad_inputgate = grad_hy * (hx - newgate) * inputgate * (1 - inputgate);
+  auto grad_newgate = grad_hy * (1 - inputgate) * (1 - newgate * newgate);
+  auto grad_resetgate = grad_newgate * chunked_hgates[2] * resetgate * (1 - resetgate);
+  auto grad_input_gates = at::cat({grad_resetgate, grad_inputgate, grad_newgate}, 1);
+  auto grad_hidden_gates = at::cat({grad_resetgate, grad_inputgate, grad_newgate * resetgate}, 1);
+
+  at::Tensor grad_input_bias, grad_hidden_bias;
+  if (input_bias.defined()) {
+    grad_input_bias = grad_input_gates.sum(0, /*keepdim=*/false);
+    grad_hidden_bias = grad_hidden_gates.sum(0, /*keepdim=*/false);
+  }
+  return std::make_tuple(grad_input_gates, grad_hidden_gates, grad_hy * inputgate,
+                         grad_input_bias, grad_hidden_bias);
+}
+
 }}  // namespace at::native
@@ -19,6 +19,30 @@ DECLARE_DISPATCH(rnn_packed_fn, gru_packed_cudnn_stub);
 DECLARE_DISPATCH(rnn_packed_fn, rnn_tanh_packed_cudnn_stub);
 DECLARE_DISPATCH(rnn_packed_fn, rnn_relu_packed_cudnn_stub);
 
+// Pointwise parts of the fused CPU cells. All tensors are contiguous, outputs
+// are allocated by the caller, and workspaces have the layouts of the CUDA
+// kernels (see _thnn_fused_lstm_cell_cpu and _thnn_fused_gru_cell_cpu).
+using lstm_cell_fn = void(*)(Tensor& hy, Tensor& cy, Tensor& workspace,
+                             const Tensor& input_gates, const Tensor& hidden_gates,
+                             const Tensor& input_bias, const Tensor& hidden_bias,
+                             const Tensor& cx);
+using lstm_cell_backward_fn = void(*)(Tensor& grad_gates, Tensor& grad_cx,
+                                      const Tensor& grad_hy, const Tensor& grad_cy,
+                                      const Tensor& cx, const Tensor& cy,
+                                      const Tensor& workspace);
+using gru_cell_fn = void(*)(Tensor& hy, Tensor& workspace,
+                            const Tensor& input_gates, const Tensor& hidden_gates,
+                            const Tensor& input_bias, const Tensor& hidden_bias,
+                            const Tensor& hx);
+using gru_cell_backward_fn = void(*)(Tensor& grad_input_gates, Tensor& grad_hidden_gates,
+                                     Tensor& grad_hx, const Tensor& grad_hy,
+                                     const Tensor& workspace);
+
+DECLARE_DISPATCH(lstm_cell_fn, lstm_cell_stub);
+DECLARE_DISPATCH(lstm_cell_backward_fn, lstm_cell_backward_stub);
+DECLARE_DISPATCH(gru_cell_fn, gru_cell_stub);
+DECLARE_DISPATCH(gru_cell_backward_fn, gru_cell_backward_stub);
+
 inline void check_device(const Tensor& input, const TensorList& params, const TensorList& hiddens) {
   auto input_device = input.device();
 
@@ -212,9 +212,40 @@ static ScalarType get_dtype(Tensor& result, const Tensor& self, optional<ScalarT
   return src_type;
 }
 
+// The CPU has no arithmetic on Half and BFloat16, and rounding every partial
+// result to 16 bits loses most of the precision of a long reduction. Like the
+// CUDA kernels, sum and prod reduce these types in float and round once.
+static bool reduces_in_float(const Tensor& self, ScalarType dtype) {
+  return self.type().device_type() == kCPU &&
+      (dtype == ScalarType::Half || dtype == ScalarType::BFloat16);
+}
+
+static Tensor& copy_reduction_result(const char* name, Tensor& result,
+                                     const Tensor& acc, ScalarType dtype) {
+  AT_CHECK(
+      !result.defined() || result.type().scalarType() == dtype,
+      name, ": provided dtype must match dtype of result. Got ",
+      toString(result.type().scalarType()),
+      " and ",
+      toString(dtype),
+      ".");
+  if (result.defined()) {
+    result.resize_(acc.sizes());
+    result.copy_(acc);
+  } else {
+    result = acc.to(dtype);
+  }
+  return result;
+}
+
 static Tensor& sum_out(Tensor& result, const Tensor& self, IntList dim,
                        bool keepdim, optional<ScalarType> opt_dtype) {
   ScalarType dtype = get_dtype(result, self, opt_dtype, true);
+  if (reduces_in_float(self, dtype)) {
+    Tensor acc;
+    native::sum_out(acc, self, dim, keepdim, optional<ScalarType>(kFloat));
+    return copy_reduction_result("sum", result, acc, dtype);
+  }
   auto iter = make_reduction("sum", result, self, dim, keepdim, dtype);
   if (iter->numel() == 0) {
     result.zero_();
@@ -241,6 +272,11 @@ Tensor sum(const Tensor &self) {
 static Tensor& prod_out(Tensor& result, const Tensor& self, IntList dim,
                         bool keepdim, optional<ScalarType> opt_dtype) {
   ScalarType dtype = get_dtype(result, self, opt_dtype, true);
+  if (reduces_in_float(self, dtype)) {
+    Tensor acc;
+    native::prod_out(acc, self, dim, keepdim, optional<ScalarType>(kFloat));
+    return copy_reduction_result("prod", result, acc, dtype);
+  }
   auto iter = make_reduction("prod", result, self, dim, keepdim, dtype);
   if (iter->numel() == 0) {
     result.fill_(1);
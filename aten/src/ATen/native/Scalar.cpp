@@ -18,6 +18,11 @@ Scalar item(const Tensor& self) {
 
 Scalar _local_scalar_dense_cpu(const Tensor& self) {
   Scalar r;
+  if (self.scalar_type() == kBFloat16) {
+    // Scalar has no bfloat16 payload; the value is exactly representable as a
+    // float.
+    return Scalar(static_cast<float>(*self.data<at::BFloat16>()));
+  }
   AT_DISPATCH_ALL_TYPES_AND_HALF_AND_COMPLEX(
       self.type(), "_local_scalar_dense_cpu", [&] {
         scalar_t value = *self.data<scalar_t>();
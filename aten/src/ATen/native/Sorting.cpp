@@ -0,0 +1,71 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/WrapDimUtils.h"
+#include "ATen/native/cpu/SortingKernel.h"
+
+namespace at { namespace native {
+
+DEFINE_DISPATCH(sort_stub);
+DEFINE_DISPATCH(topk_stub);
+DEFINE_DISPATCH(kthvalue_stub);
+
+static void check_sort_outputs(const Tensor& values, const Tensor& indices,
+                               const Tensor& self, const char* fn_name) {
+  AT_CHECK(values.type() == self.type(), fn_name, "(): expected values to be of type ",
+           self.type().toString(), " but got ", values.type().toString());
+  AT_CHECK(indices.type() == self.type().toScalarType(kLong), fn_name,
+           "(): expected indices to be a Long tensor but got ", indices.type().toString());
+}
+
+std::tuple<Tensor&, Tensor&> sort_out_cpu(Tensor& values, Tensor& indices,
+                                          const Tensor& self, int64_t dim,
+                                          bool descending) {
+  check_sort_outputs(values, indices, self, "sort");
+  dim = maybe_wrap_dim(dim, self.dim());
+  values.resize_(self.sizes());
+  indices.resize_(self.sizes());
+  if (self.dim() == 0) {
+    values.copy_(self);
+    indices.fill_(0);
+  } else if (self.numel() > 0) {
+    sort_stub(kCPU, values, indices, self, dim, descending);
+  }
+  return std::forward_as_tuple(values, indices);
+}
+
+std::tuple<Tensor, Tensor> sort_cpu(const Tensor& self, int64_t dim, bool descending) {
+  Tensor values = at::empty({0}, self.options());
+  Tensor indices = at::empty({0}, self.options().dtype(kLong));
+  return at::native::sort_out_cpu(values, indices, self, dim, descending);
+}
+
+std::tuple<Tensor&, Tensor&> topk_out_cpu(Tensor& values, Tensor& indices,
+                                          const Tensor& self, int64_t k, int64_t dim,
+                                          bool largest, bool sorted) {
+  check_sort_outputs(values, indices, self, "topk");
+  dim = maybe_wrap_dim(dim, self.dim());
+  int64_t slice_size = self.dim() == 0 ? 1 : self.size(dim);
+  AT_CHECK(k >= 0 && k <= slice_size, "selected index k out of range");
+  auto sizes = self.sizes().vec();
+  if (!sizes.empty()) {
+    sizes[dim] = k;
+  }
+  values.resize_(sizes);
+  indices.resize_(sizes);
+  if (self.dim() == 0) {
+    values.copy_(self);
+    indices.fill_(0);
+  } else if (values.numel() > 0) {
+    topk_stub(kCPU, values, indices, self, k, dim, largest, sorted);
+  }
+  return std::forward_as_tuple(values, indices);
+}
+
+std::tuple<Tensor, Tensor> topk_cpu(const Tensor& self, int64_t k, int64_t dim,
+                                    bool largest, bool sorted) {
+  Tensor values = at::empty({0}, self.options());
+  Tensor indices = at::empty({0}, self.options().dtype(kLong));
+  return at::native::topk_out_cpu(values, indices, self, k, dim, largest, sorted);
+}
+
+}} // namespace at::native
@@ -5,6 +5,7 @@
 #include "ATen/NativeFunctions.h"
 #include "ReduceOpsUtils.h"
 #include "c10/util/Exception.h"
+#include "cpu/SortingKernel.h"
 #include "cpu/TensorCompareKernel.h"
 
 namespace {
@@ -92,6 +93,25 @@ Tensor _s_where_cpu(const Tensor& condition, const Tensor& self, const Tensor& o
   return ret;
 }
 
+// Computes values/indices with the reduced dimension kept, like TH did, and
+// squeezes it afterwards unless keepdim.
+static std::tuple<Tensor &,Tensor &> kthvalue_out_cpu(Tensor& values, Tensor& indices,
+                                                      const Tensor& self, int64_t k, int64_t dim, bool keepdim) {
+  AT_CHECK(k >= 1 && k <= self.size(dim), "selected index out of range");
+  auto sizes = self.sizes().vec();
+  sizes[dim] = 1;
+  values.resize_(sizes);
+  indices.resize_(sizes);
+  if (values.numel() > 0) {
+    kthvalue_stub(kCPU, values, indices, self, k, dim);
+  }
+  if (!keepdim) {
+    values.squeeze_(dim);
+    indices.squeeze_(dim);
+  }
+  return std::forward_as_tuple(values, indices);
+}
+
 std::tuple<Tensor, Tensor> kthvalue(const Tensor& self, int64_t k, int64_t dim, bool keepdim) {
   Tensor values = at::empty({0}, self.options());
   Tensor indices = at::empty({0}, self.options().dtype(kLong));
@@ -107,6 +127,8 @@ std::tuple<Tensor &,Tensor &> kthvalue_out(Tensor& values, Tensor& indices,
     AT_ASSERT(values.dim() == 0);
     indices.resize_({}).fill_(0);
     return std::forward_as_tuple(values, indices);
+  } else if (self.type().backend() == Backend::CPU) {
+    return kthvalue_out_cpu(values, indices, self, k, dim, keepdim);
   } else {
     return at::_th_kthvalue_out(values, indices, self, k, dim, keepdim);
   }
@@ -127,6 +149,10 @@ std::tuple<Tensor &,Tensor &> median_out(Tensor& values, Tensor& indices,
     AT_ASSERT(values.dim() == 0);
     indices.resize_({}).fill_(0);
     return std::forward_as_tuple(values, indices);
+  } else if (self.type().backend() == Backend::CPU) {
+    // take the middle or the one-before-middle element
+    int64_t k = (self.size(dim) - 1) / 2 + 1;
+    return kthvalue_out_cpu(values, indices, self, k, dim, keepdim);
   } else {
     return at::_th_median_out(values, indices, self, dim, keepdim);
   }
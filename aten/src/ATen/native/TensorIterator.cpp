@@ -1,6 +1,8 @@
 #include <ATen/native/TensorIterator.h>
 
+#include <algorithm>
 #include <array>
+#include <cstdlib>
 #include <ATen/ExpandUtils.h>
 #include <ATen/Parallel.h>
 
@@ -361,6 +363,19 @@ void TensorIterator::for_each(const loop2d_t& loop) {
   int64_t numel = this->numel();
   if (numel == 0) {
     return;
+  }
+  int64_t tile_size = get_tile_size();
+  if (tile_size > 0) {
+    int64_t tiles0 = (shape_[0] + tile_size - 1) / tile_size;
+    int64_t tiles1 = (shape_[1] + tile_size - 1) / tile_size;
+    int64_t num_tiles = tiles0 * tiles1 * (numel / (shape_[0] * shape_[1]));
+    if (numel < internal::GRAIN_SIZE || at::get_max_threads() == 1) {
+      return serial_for_each_tile(loop, tile_size, {0, num_tiles});
+    }
+    int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / (tile_size * tile_size), 1);
+    at::parallel_for(0, num_tiles, grain_size, [&](int64_t begin, int64_t end) {
+      serial_for_each_tile(loop, tile_size, {begin, end});
+    });
   } else if (numel < internal::GRAIN_SIZE || at::get_max_threads() == 1) {
     return serial_for_each(loop, {0, numel});
   } else {
@@ -405,6 +420,74 @@ void TensorIterator::serial_for_each(const loop2d_t& loop, Range range) const {
   }
 }
 
+// Tiles are sized so that the cache lines touched by one tile of the operand
+// that is walked across its fast dimension stay in L1 while the tile is
+// processed: 64x64 for float, 32x32 for double, 128x128 for uint8.
+static constexpr int64_t TILE_BYTES = 16 * 1024;
+static constexpr int64_t MAX_TILE_SIZE = 128;
+static constexpr int64_t MIN_TILE_SIZE = 16;
+
+int64_t TensorIterator::get_tile_size() const {
+  if (ndim() < 2 || is_reduction_) {
+    return 0;
+  }
+  bool dim0_faster = false;
+  bool dim1_faster = false;
+  int64_t max_element_size = 1;
+  for (int arg = 0; arg < ntensors(); arg++) {
+    auto& op = operands_[arg];
+    int64_t stride0 = std::abs(op.stride_bytes[0]);
+    int64_t stride1 = std::abs(op.stride_bytes[1]);
+    if (stride0 == 0 || stride1 == 0) {
+      if (op.is_output) {
+        // an output written more than once must keep the untiled order
+        return 0;
+      }
+      continue;
+    }
+    dim0_faster |= stride0 < stride1;
+    dim1_faster |= stride1 < stride0;
+    max_element_size = std::max(max_element_size, element_size(arg));
+  }
+  if (!dim0_faster || !dim1_faster) {
+    return 0;
+  }
+  int64_t tile_size = MAX_TILE_SIZE;
+  while (tile_size > MIN_TILE_SIZE && tile_size * tile_size * max_element_size > TILE_BYTES) {
+    tile_size /= 2;
+  }
+  // a single tile would already span the whole fast dimension
+  if (shape_[0] <= tile_size) {
+    return 0;
+  }
+  return tile_size;
+}
+
+void TensorIterator::serial_for_each_tile(const loop2d_t& loop, int64_t tile_size, Range range) const {
+  AT_ASSERT(ndim() >= 2 && tile_size > 0);
+  auto strides = get_strides();
+  auto base_ptrs = get_base_ptrs();
+  int64_t tiles0 = (shape_[0] + tile_size - 1) / tile_size;
+  int64_t tiles1 = (shape_[1] + tile_size - 1) / tile_size;
+
+  auto counter = DimVector(ndim(), 0);
+  for (int64_t tile = range.begin; tile < range.end; tile++) {
+    int64_t linear_offset = tile;
+    counter[0] = (linear_offset % tiles0) * tile_size;
+    linear_offset /= tiles0;
+    counter[1] = (linear_offset % tiles1) * tile_size;
+    linear_offset /= tiles1;
+    for (int dim = 2; dim < ndim(); dim++) {
+      counter[dim] = linear_offset % shape_[dim];
+      linear_offset /= shape_[dim];
+    }
+    auto ptrs = get_data_ptrs(base_ptrs, counter);
+    int64_t size0 = std::min(tile_size, shape_[0] - counter[0]);
+    int64_t size1 = std::min(tile_size, shape_[1] - counter[1]);
+    loop(ntensors(), ptrs.data(), strides.data(), size0, size1);
+  }
+}
+
 bool TensorIterator::is_trivial_1d() const {
   // TODO: check for casting once it's supported
   return ndim() == 1;
@@ -165,6 +165,12 @@ struct CAFFE2_API TensorIterator {
   /// Returns the dimension with the largest extent: (size[dim]-1) * stride[dim]
   int get_dim_to_split() const;
 
+  /// Returns the side length (in elements) of the square tiles that for_each
+  /// uses to block the two innermost dimensions, or 0 if no tiling is needed.
+  /// Tiling is used when the operands disagree on which of the two dimensions
+  /// is the fastest moving one, e.g. `a + b.t()` or an NCHW -> NHWC copy.
+  int64_t get_tile_size() const;
+
   template <typename T>
   T scalar_value(int arg) {
     auto& op = operands_[arg];
@@ -179,6 +185,11 @@ struct CAFFE2_API TensorIterator {
   void serial_for_each(const loop_t& loop, Range range) const;
   void serial_for_each(const loop2d_t& loop, Range range) const;
 
+  /// Calls `loop` once per tile for the tiles with linear index in `range`.
+  /// Tiles are numbered with the tile index along dim 0 moving fastest,
+  /// followed by the tile index along dim 1 and then the outer dimensions.
+  void serial_for_each_tile(const loop2d_t& loop, int64_t tile_size, Range range) const;
+
   /// Create a strides array for a Tensor with shape of this iterator. The
   /// parameter `element_size` specifies the size of Tensor's data type in
   /// bytes (e.g. `4` for `float`)
@@ -16,7 +16,9 @@ static void parallel_dim_reduction(TensorIterator& iter, const loop2d_t& loop);
 void TensorIterator::parallel_reduce(const loop2d_t& loop) {
   AT_CHECK(ntensors() == 2, "parallel_reduce only supports one input and one output");
   int64_t numel = this->numel();
-  if (numel < at::internal::GRAIN_SIZE || at::get_max_threads() == 1 || at::in_parallel_region()) {
+  // The native backend parallelizes nested regions, OpenMP serializes them.
+  bool nested = at::in_parallel_region() && !at::internal::use_native_backend();
+  if (numel < at::internal::GRAIN_SIZE || at::get_max_threads() == 1 || nested) {
     serial_for_each(loop, {0, numel});
   } else if (use_two_pass_reduction(*this)) {
     two_pass_reduction(*this, loop);
@@ -82,11 +82,31 @@ Tensor& _clamp_min_out_cpu(Tensor& result, const Tensor& self, Scalar min) {
   return _th_clamp_min_out(result, self, min);
 }
 
+// TH has no CPU math for the 16-bit floating point types, so filling them
+// (which reductions use to initialize their output) is done here.
+static bool is_cpu_reduced_float(const Tensor& self) {
+  auto scalar_type = self.type().scalarType();
+  return self.type().backend() == Backend::CPU &&
+      (scalar_type == kHalf || scalar_type == kBFloat16);
+}
+
 Tensor& fill_(Tensor& self, Scalar value) {
+  if (is_cpu_reduced_float(self)) {
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF_AND_BFLOAT16(self.type(), "fill_", [&] {
+      auto v = value.to<scalar_t>();
+      CPU_tensor_apply1<scalar_t>(self, [v](scalar_t& x) { x = v; });
+    });
+    return self;
+  }
   return at::_th_fill_(self, value);
 }
 
 Tensor& fill_(Tensor& self, const Tensor& value) {
+  if (is_cpu_reduced_float(self)) {
+    AT_CHECK(value.dim() == 0, "fill_ only supports 0-dimension value tensor but got tensor with ",
+             value.dim(), " dimensions.");
+    return native::fill_(self, value.item());
+  }
   return at::_th_fill_(self, value);
 }
 
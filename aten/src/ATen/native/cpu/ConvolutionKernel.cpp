@@ -0,0 +1,516 @@
+#include "ATen/native/ConvolutionCPU.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ATen/AccumulateType.h"
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec256/vec256.h"
+
+namespace at { namespace native { namespace {
+
+using namespace vec256;
+
+// Output channels computed together by one task of the direct convolution.
+// Every input row is loaded once and accumulated into all of them.
+constexpr int64_t kDirectOutputBlock = 4;
+
+// Number of tasks handed to one thread so that it does about GRAIN_SIZE
+// multiply-adds.
+inline int64_t grain_for(int64_t work_per_task) {
+  return std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(work_per_task, 1), 1);
+}
+
+// The outputs o in [lo, hi) whose input o * stride - pad + offset lies in
+// [0, input_size).
+inline void valid_range(int64_t output_size, int64_t input_size, int64_t stride,
+                        int64_t pad, int64_t offset, int64_t& lo, int64_t& hi) {
+  int64_t shift = pad - offset;
+  lo = shift > 0 ? (shift + stride - 1) / stride : 0;
+  int64_t last = input_size - 1 + shift;
+  hi = last >= 0 ? std::min(output_size, last / stride + 1) : 0;
+  lo = std::min(lo, hi);
+}
+
+// y[0:n] += a * x[0:n:incx]
+template <typename scalar_t>
+inline void axpy(int64_t n, scalar_t a, const scalar_t* x, int64_t incx, scalar_t* y) {
+  using Vec = Vectorized<scalar_t>;
+  if (incx == 1) {
+    Vec a_vec(a);
+    int64_t i = 0;
+    for (; i + Vec::size <= n; i += Vec::size) {
+      fmadd(a_vec, Vec::loadu(x + i), Vec::loadu(y + i)).store(y + i);
+    }
+    for (; i < n; i++) {
+      y[i] += a * x[i];
+    }
+  } else {
+    for (int64_t i = 0; i < n; i++) {
+      y[i] += a * x[i * incx];
+    }
+  }
+}
+
+// y[0:n:incy] += a * x[0:n]
+template <typename scalar_t>
+inline void axpy_scatter(int64_t n, scalar_t a, const scalar_t* x, scalar_t* y, int64_t incy) {
+  if (incy == 1) {
+    axpy<scalar_t>(n, a, x, 1, y);
+  } else {
+    for (int64_t i = 0; i < n; i++) {
+      y[i * incy] += a * x[i];
+    }
+  }
+}
+
+// sum(x[0:n] * y[0:n:incy])
+template <typename scalar_t>
+inline scalar_t dot(int64_t n, const scalar_t* x, const scalar_t* y, int64_t incy) {
+  using Vec = Vectorized<scalar_t>;
+  scalar_t sum = 0;
+  int64_t i = 0;
+  if (incy == 1 && n >= Vec::size) {
+    Vec acc(0);
+    for (; i + Vec::size <= n; i += Vec::size) {
+      acc = fmadd(Vec::loadu(x + i), Vec::loadu(y + i), acc);
+    }
+    scalar_t lanes[Vec::size];
+    acc.store(lanes);
+    for (int64_t j = 0; j < Vec::size; j++) {
+      sum += lanes[j];
+    }
+  }
+  for (; i < n; i++) {
+    sum += x[i] * y[i * incy];
+  }
+  return sum;
+}
+
+template <typename scalar_t>
+void conv2d_direct_kernel_impl(Tensor& output, const Tensor& input, const Tensor& weight,
+                               const Tensor& bias, const Conv2dCPUParams& p) {
+  int64_t batch = input.size(0), channels = input.size(1);
+  int64_t input_h = input.size(2), input_w = input.size(3);
+  int64_t output_channels = weight.size(0), group_channels = weight.size(1);
+  int64_t kernel_h = weight.size(2), kernel_w = weight.size(3);
+  int64_t output_h = output.size(2), output_w = output.size(3);
+  int64_t groups = p.groups;
+  int64_t group_output_channels = output_channels / groups;
+  int64_t blocks = (group_output_channels + kDirectOutputBlock - 1) / kDirectOutputBlock;
+  const scalar_t* input_data = input.data<scalar_t>();
+  const scalar_t* weight_data = weight.data<scalar_t>();
+  const scalar_t* bias_data = bias.defined() ? bias.data<scalar_t>() : nullptr;
+  scalar_t* output_data = output.data<scalar_t>();
+
+  int64_t work = kDirectOutputBlock * group_channels * kernel_h * kernel_w * output_h * output_w;
+  parallel_for(0, batch * groups * blocks, grain_for(work), [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      int64_t n = task / (groups * blocks);
+      int64_t g = task / blocks % groups;
+      int64_t oc_begin = g * group_output_channels + task % blocks * kDirectOutputBlock;
+      int64_t block = std::min(kDirectOutputBlock, (g + 1) * group_output_channels - oc_begin);
+      scalar_t* out[kDirectOutputBlock];
+      for (int64_t j = 0; j < block; j++) {
+        out[j] = output_data + ((n * output_channels + oc_begin + j) * output_h * output_w);
+        std::fill(out[j], out[j] + output_h * output_w,
+                  bias_data ? bias_data[oc_begin + j] : scalar_t(0));
+      }
+      for (int64_t ic = 0; ic < group_channels; ic++) {
+        const scalar_t* in = input_data +
+            (n * channels + g * group_channels + ic) * input_h * input_w;
+        for (int64_t kh = 0; kh < kernel_h; kh++) {
+          int64_t oh_lo, oh_hi;
+          valid_range(output_h, input_h, p.stride[0], p.padding[0], kh * p.dilation[0], oh_lo, oh_hi);
+          for (int64_t kw = 0; kw < kernel_w; kw++) {
+            int64_t ow_lo, ow_hi;
+            valid_range(output_w, input_w, p.stride[1], p.padding[1], kw * p.dilation[1], ow_lo, ow_hi);
+            if (ow_lo == ow_hi) {
+              continue;
+            }
+            scalar_t w[kDirectOutputBlock];
+            for (int64_t j = 0; j < block; j++) {
+              w[j] = weight_data[(((oc_begin + j) * group_channels + ic) * kernel_h + kh) * kernel_w + kw];
+            }
+            int64_t iw_lo = ow_lo * p.stride[1] - p.padding[1] + kw * p.dilation[1];
+            for (int64_t oh = oh_lo; oh < oh_hi; oh++) {
+              int64_t ih = oh * p.stride[0] - p.padding[0] + kh * p.dilation[0];
+              const scalar_t* in_row = in + ih * input_w + iw_lo;
+              for (int64_t j = 0; j < block; j++) {
+                axpy<scalar_t>(ow_hi - ow_lo, w[j], in_row, p.stride[1],
+                               out[j] + oh * output_w + ow_lo);
+              }
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+void conv2d_direct_kernel(Tensor& output, const Tensor& input, const Tensor& weight,
+                          const Tensor& bias, const Conv2dCPUParams& params) {
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "conv2d_direct", [&] {
+    conv2d_direct_kernel_impl<scalar_t>(output, input, weight, bias, params);
+  });
+}
+
+// Every task owns one plane of grad_input and scatters the output gradients
+// of the channels that read it.
+template <typename scalar_t>
+void conv2d_backward_input_kernel_impl(Tensor& grad_input, const Tensor& grad_output,
+                                       const Tensor& weight, const Conv2dCPUParams& p) {
+  int64_t batch = grad_input.size(0), channels = grad_input.size(1);
+  int64_t input_h = grad_input.size(2), input_w = grad_input.size(3);
+  int64_t output_channels = weight.size(0), group_channels = weight.size(1);
+  int64_t kernel_h = weight.size(2), kernel_w = weight.size(3);
+  int64_t output_h = grad_output.size(2), output_w = grad_output.size(3);
+  int64_t group_output_channels = output_channels / p.groups;
+  const scalar_t* grad_output_data = grad_output.data<scalar_t>();
+  const scalar_t* weight_data = weight.data<scalar_t>();
+  scalar_t* grad_input_data = grad_input.data<scalar_t>();
+
+  int64_t work = group_output_channels * kernel_h * kernel_w * output_h * output_w;
+  parallel_for(0, batch * channels, grain_for(work), [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      int64_t n = task / channels;
+      int64_t c = task % channels;
+      int64_t g = c / group_channels;
+      int64_t ic = c % group_channels;
+      scalar_t* grad_in = grad_input_data + task * input_h * input_w;
+      for (int64_t oc = g * group_output_channels; oc < (g + 1) * group_output_channels; oc++) {
+        const scalar_t* grad_out = grad_output_data + (n * output_channels + oc) * output_h * output_w;
+        for (int64_t kh = 0; kh < kernel_h; kh++) {
+          int64_t oh_lo, oh_hi;
+          valid_range(output_h, input_h, p.stride[0], p.padding[0], kh * p.dilation[0], oh_lo, oh_hi);
+          for (int64_t kw = 0; kw < kernel_w; kw++) {
+            int64_t ow_lo, ow_hi;
+            valid_range(output_w, input_w, p.stride[1], p.padding[1], kw * p.dilation[1], ow_lo, ow_hi);
+            if (ow_lo == ow_hi) {
+              continue;
+            }
+            scalar_t w = weight_data[((oc * group_channels + ic) * kernel_h + kh) * kernel_w + kw];
+            int64_t iw_lo = ow_lo * p.stride[1] - p.padding[1] + kw * p.dilation[1];
+            for (int64_t oh = oh_lo; oh < oh_hi; oh++) {
+              int64_t ih = oh * p.stride[0] - p.padding[0] + kh * p.dilation[0];
+              axpy_scatter<scalar_t>(ow_hi - ow_lo, w, grad_out + oh * output_w + ow_lo,
+                                     grad_in + ih * input_w + iw_lo, p.stride[1]);
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+void conv2d_backward_input_kernel(Tensor& grad_input, const Tensor& grad_output,
+                                  const Tensor& weight, const Conv2dCPUParams& params) {
+  AT_DISPATCH_FLOATING_TYPES(grad_output.type(), "conv2d_backward_input", [&] {
+    conv2d_backward_input_kernel_impl<scalar_t>(grad_input, grad_output, weight, params);
+  });
+}
+
+// Every task computes the kernel_h * kernel_w weights connecting one input
+// channel to one output channel, accumulating over the batch.
+template <typename scalar_t>
+void conv2d_backward_weight_kernel_impl(Tensor& grad_weight, const Tensor& grad_output,
+                                        const Tensor& input, const Conv2dCPUParams& p) {
+  using acc_t = acc_type<scalar_t, false>;
+  int64_t batch = input.size(0), channels = input.size(1);
+  int64_t input_h = input.size(2), input_w = input.size(3);
+  int64_t output_channels = grad_weight.size(0), group_channels = grad_weight.size(1);
+  int64_t kernel_h = grad_weight.size(2), kernel_w = grad_weight.size(3);
+  int64_t output_h = grad_output.size(2), output_w = grad_output.size(3);
+  int64_t group_output_channels = output_channels / p.groups;
+  const scalar_t* grad_output_data = grad_output.data<scalar_t>();
+  const scalar_t* input_data = input.data<scalar_t>();
+  scalar_t* grad_weight_data = grad_weight.data<scalar_t>();
+
+  int64_t work = batch * kernel_h * kernel_w * output_h * output_w;
+  parallel_for(0, output_channels * group_channels, grain_for(work), [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      int64_t oc = task / group_channels;
+      int64_t c = oc / group_output_channels * group_channels + task % group_channels;
+      for (int64_t kh = 0; kh < kernel_h; kh++) {
+        int64_t oh_lo, oh_hi;
+        valid_range(output_h, input_h, p.stride[0], p.padding[0], kh * p.dilation[0], oh_lo, oh_hi);
+        for (int64_t kw = 0; kw < kernel_w; kw++) {
+          int64_t ow_lo, ow_hi;
+          valid_range(output_w, input_w, p.stride[1], p.padding[1], kw * p.dilation[1], ow_lo, ow_hi);
+          int64_t iw_lo = ow_lo * p.stride[1] - p.padding[1] + kw * p.dilation[1];
+          acc_t sum = 0;
+          for (int64_t n = 0; n < batch && ow_lo < ow_hi; n++) {
+            const scalar_t* grad_out = grad_output_data + (n * output_channels + oc) * output_h * output_w;
+            const scalar_t* in = input_data + (n * channels + c) * input_h * input_w;
+            for (int64_t oh = oh_lo; oh < oh_hi; oh++) {
+              int64_t ih = oh * p.stride[0] - p.padding[0] + kh * p.dilation[0];
+              sum += dot<scalar_t>(ow_hi - ow_lo, grad_out + oh * output_w + ow_lo,
+                                   in + ih * input_w + iw_lo, p.stride[1]);
+            }
+          }
+          grad_weight_data[(task * kernel_h + kh) * kernel_w + kw] = sum;
+        }
+      }
+    }
+  });
+}
+
+void conv2d_backward_weight_kernel(Tensor& grad_weight, const Tensor& grad_output,
+                                   const Tensor& input, const Conv2dCPUParams& params) {
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "conv2d_backward_weight", [&] {
+    conv2d_backward_weight_kernel_impl<scalar_t>(grad_weight, grad_output, input, params);
+  });
+}
+
+// Transform matrices of Winograd F(m x m, 3 x 3): the output tile Y of an
+// input tile d and a kernel g is A^T [(G g G^T) * (B^T d B)] A.
+template <int m>
+struct WinogradMatrices;
+
+template <>
+struct WinogradMatrices<2> {
+  static constexpr int alpha = 4;
+  static constexpr double BT[4][4] = {
+      {1, 0, -1, 0},
+      {0, 1, 1, 0},
+      {0, -1, 1, 0},
+      {0, 1, 0, -1}};
+  static constexpr double G[4][3] = {
+      {1, 0, 0},
+      {0.5, 0.5, 0.5},
+      {0.5, -0.5, 0.5},
+      {0, 0, 1}};
+  static constexpr double AT[2][4] = {
+      {1, 1, 1, 0},
+      {0, 1, -1, -1}};
+};
+
+template <>
+struct WinogradMatrices<4> {
+  static constexpr int alpha = 6;
+  static constexpr double BT[6][6] = {
+      {4, 0, -5, 0, 1, 0},
+      {0, -4, -4, 1, 1, 0},
+      {0, 4, -4, -1, 1, 0},
+      {0, -2, -1, 2, 1, 0},
+      {0, 2, -1, -2, 1, 0},
+      {0, 4, 0, -5, 0, 1}};
+  static constexpr double G[6][3] = {
+      {1. / 4, 0, 0},
+      {-1. / 6, -1. / 6, -1. / 6},
+      {-1. / 6, 1. / 6, -1. / 6},
+      {1. / 24, 1. / 12, 1. / 6},
+      {1. / 24, -1. / 12, 1. / 6},
+      {0, 0, 1}};
+  static constexpr double AT[4][6] = {
+      {1, 1, 1, 1, 1, 0},
+      {0, 1, -1, 2, -2, 0},
+      {0, 1, 1, 4, 4, 0},
+      {0, 1, -1, 8, -8, 1}};
+};
+
+constexpr double WinogradMatrices<2>::BT[4][4];
+constexpr double WinogradMatrices<2>::G[4][3];
+constexpr double WinogradMatrices<2>::AT[2][4];
+constexpr double WinogradMatrices<4>::BT[6][6];
+constexpr double WinogradMatrices<4>::G[6][3];
+constexpr double WinogradMatrices<4>::AT[4][6];
+
+// out = left * in * right^T, for a rows x inner left, an inner x inner in
+// and a cols x inner right.
+template <typename scalar_t, int rows, int inner, int cols>
+inline void sandwich(const double (&left)[rows][inner], const scalar_t (&in)[inner][inner],
+                     const double (&right)[cols][inner], scalar_t (&out)[rows][cols]) {
+  scalar_t tmp[rows][inner];
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < inner; j++) {
+      scalar_t sum = 0;
+      for (int k = 0; k < inner; k++) {
+        sum += static_cast<scalar_t>(left[i][k]) * in[k][j];
+      }
+      tmp[i][j] = sum;
+    }
+  }
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      scalar_t sum = 0;
+      for (int k = 0; k < inner; k++) {
+        sum += tmp[i][k] * static_cast<scalar_t>(right[j][k]);
+      }
+      out[i][j] = sum;
+    }
+  }
+}
+
+template <typename scalar_t, int m>
+void winograd_weight_transform_impl(Tensor& transformed, const Tensor& weight, int64_t groups) {
+  using W = WinogradMatrices<m>;
+  constexpr int alpha = W::alpha;
+  int64_t output_channels = weight.size(0), group_channels = weight.size(1);
+  int64_t group_output_channels = output_channels / groups;
+  const scalar_t* weight_data = weight.data<scalar_t>();
+  scalar_t* transformed_data = transformed.data<scalar_t>();
+
+  parallel_for(0, output_channels * group_channels, grain_for(alpha * alpha * 9), [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      int64_t oc = task / group_channels;
+      int64_t ic = task % group_channels;
+      int64_t g = oc / group_output_channels;
+      int64_t ocl = oc % group_output_channels;
+      const scalar_t* kernel = weight_data + task * 9;
+      // G g G^T
+      scalar_t tmp[alpha][3];
+      for (int i = 0; i < alpha; i++) {
+        for (int j = 0; j < 3; j++) {
+          tmp[i][j] = static_cast<scalar_t>(W::G[i][0]) * kernel[j] +
+                      static_cast<scalar_t>(W::G[i][1]) * kernel[3 + j] +
+                      static_cast<scalar_t>(W::G[i][2]) * kernel[6 + j];
+        }
+      }
+      for (int i = 0; i < alpha; i++) {
+        for (int j = 0; j < alpha; j++) {
+          scalar_t value = tmp[i][0] * static_cast<scalar_t>(W::G[j][0]) +
+                           tmp[i][1] * static_cast<scalar_t>(W::G[j][1]) +
+                           tmp[i][2] * static_cast<scalar_t>(W::G[j][2]);
+          int64_t pos = i * alpha + j;
+          transformed_data[((g * alpha * alpha + pos) * group_output_channels + ocl) * group_channels + ic] = value;
+        }
+      }
+    }
+  });
+}
+
+template <typename scalar_t, int m>
+void winograd_input_transform_impl(Tensor& transformed, const Tensor& input, int64_t groups,
+                                   int64_t pad_h, int64_t pad_w, int64_t tiles_h, int64_t tiles_w,
+                                   int64_t tile_begin, int64_t tile_end) {
+  using W = WinogradMatrices<m>;
+  constexpr int alpha = W::alpha;
+  int64_t channels = input.size(1), input_h = input.size(2), input_w = input.size(3);
+  int64_t group_channels = channels / groups;
+  int64_t tiles = tile_end - tile_begin;
+  const scalar_t* input_data = input.data<scalar_t>();
+  scalar_t* transformed_data = transformed.data<scalar_t>();
+
+  parallel_for(0, channels * tiles, grain_for(alpha * alpha * alpha * 2), [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      int64_t c = task / tiles;
+      int64_t t = task % tiles;
+      int64_t tile = tile_begin + t;
+      int64_t n = tile / (tiles_h * tiles_w);
+      int64_t y0 = tile / tiles_w % tiles_h * m - pad_h;
+      int64_t x0 = tile % tiles_w * m - pad_w;
+      const scalar_t* in = input_data + (n * channels + c) * input_h * input_w;
+      scalar_t d[alpha][alpha];
+      for (int i = 0; i < alpha; i++) {
+        int64_t y = y0 + i;
+        for (int j = 0; j < alpha; j++) {
+          int64_t x = x0 + j;
+          d[i][j] = (y >= 0 && y < input_h && x >= 0 && x < input_w) ? in[y * input_w + x] : scalar_t(0);
+        }
+      }
+      scalar_t v[alpha][alpha];
+      sandwich<scalar_t, alpha, alpha, alpha>(W::BT, d, W::BT, v);
+      int64_t g = c / group_channels;
+      int64_t ic = c % group_channels;
+      for (int pos = 0; pos < alpha * alpha; pos++) {
+        transformed_data[((g * alpha * alpha + pos) * group_channels + ic) * tiles + t] =
+            v[pos / alpha][pos % alpha];
+      }
+    }
+  });
+}
+
+template <typename scalar_t, int m>
+void winograd_output_transform_impl(Tensor& output, const Tensor& products, const Tensor& bias,
+                                    int64_t groups, int64_t tiles_h, int64_t tiles_w,
+                                    int64_t tile_begin, int64_t tile_end) {
+  using W = WinogradMatrices<m>;
+  constexpr int alpha = W::alpha;
+  int64_t output_channels = output.size(1), output_h = output.size(2), output_w = output.size(3);
+  int64_t group_output_channels = output_channels / groups;
+  int64_t tiles = tile_end - tile_begin;
+  const scalar_t* products_data = products.data<scalar_t>();
+  const scalar_t* bias_data = bias.defined() ? bias.data<scalar_t>() : nullptr;
+  scalar_t* output_data = output.data<scalar_t>();
+
+  parallel_for(0, output_channels * tiles, grain_for(alpha * alpha * m * 2), [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      int64_t oc = task / tiles;
+      int64_t t = task % tiles;
+      int64_t g = oc / group_output_channels;
+      int64_t ocl = oc % group_output_channels;
+      scalar_t prod[alpha][alpha];
+      for (int pos = 0; pos < alpha * alpha; pos++) {
+        prod[pos / alpha][pos % alpha] =
+            products_data[((g * alpha * alpha + pos) * group_output_channels + ocl) * tiles + t];
+      }
+      scalar_t y[m][m];
+      sandwich<scalar_t, m, alpha, m>(W::AT, prod, W::AT, y);
+      int64_t tile = tile_begin + t;
+      int64_t n = tile / (tiles_h * tiles_w);
+      int64_t y0 = tile / tiles_w % tiles_h * m;
+      int64_t x0 = tile % tiles_w * m;
+      scalar_t b = bias_data ? bias_data[oc] : scalar_t(0);
+      scalar_t* out = output_data + (n * output_channels + oc) * output_h * output_w;
+      for (int i = 0; i < m && y0 + i < output_h; i++) {
+        for (int j = 0; j < m && x0 + j < output_w; j++) {
+          out[(y0 + i) * output_w + x0 + j] = y[i][j] + b;
+        }
+      }
+    }
+  });
+}
+
+void winograd_weight_transform_kernel(Tensor& transformed, const Tensor& weight,
+                                      int64_t m, int64_t groups) {
+  AT_DISPATCH_FLOATING_TYPES(weight.type(), "winograd_weight_transform", [&] {
+    if (m == 2) {
+      winograd_weight_transform_impl<scalar_t, 2>(transformed, weight, groups);
+    } else {
+      winograd_weight_transform_impl<scalar_t, 4>(transformed, weight, groups);
+    }
+  });
+}
+
+void winograd_input_transform_kernel(Tensor& transformed, const Tensor& input,
+                                     int64_t m, int64_t groups, int64_t pad_h, int64_t pad_w,
+                                     int64_t tiles_h, int64_t tiles_w,
+                                     int64_t tile_begin, int64_t tile_end) {
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "winograd_input_transform", [&] {
+    if (m == 2) {
+      winograd_input_transform_impl<scalar_t, 2>(transformed, input, groups, pad_h, pad_w,
+                                                 tiles_h, tiles_w, tile_begin, tile_end);
+    } else {
+      winograd_input_transform_impl<scalar_t, 4>(transformed, input, groups, pad_h, pad_w,
+                                                 tiles_h, tiles_w, tile_begin, tile_end);
+    }
+  });
+}
+
+void winograd_output_transform_kernel(Tensor& output, const Tensor& products,
+                                      const Tensor& bias, int64_t m, int64_t groups,
+                                      int64_t tiles_h, int64_t tiles_w,
+                                      int64_t tile_begin, int64_t tile_end) {
+  AT_DISPATCH_FLOATING_TYPES(output.type(), "winograd_output_transform", [&] {
+    if (m == 2) {
+      winograd_output_transform_impl<scalar_t, 2>(output, products, bias, groups,
+                                                  tiles_h, tiles_w, tile_begin, tile_end);
+    } else {
+      winograd_output_transform_impl<scalar_t, 4>(output, products, bias, groups,
+                                                  tiles_h, tiles_w, tile_begin, tile_end);
+    }
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(conv2d_direct_stub, &conv2d_direct_kernel);
+REGISTER_DISPATCH(conv2d_backward_input_stub, &conv2d_backward_input_kernel);
+REGISTER_DISPATCH(conv2d_backward_weight_stub, &conv2d_backward_weight_kernel);
+REGISTER_DISPATCH(winograd_weight_transform_stub, &winograd_weight_transform_kernel);
+REGISTER_DISPATCH(winograd_input_transform_stub, &winograd_input_transform_kernel);
+REGISTER_DISPATCH(winograd_output_transform_stub, &winograd_output_transform_kernel);
+
+}} // namespace at::native
@@ -14,7 +14,7 @@ namespace {
 constexpr int64_t COPY_GRAIN_SIZE = 20000;
 
 static void copy_kernel_impl(Tensor& dst, const Tensor& src) {
-  AT_DISPATCH_ALL_TYPES_AND_HALF(dst.type(), "copy_kernel_impl", [&]() {
+  AT_DISPATCH_ALL_TYPES_AND_HALF_AND_BFLOAT16(dst.type(), "copy_kernel_impl", [&]() {
     scalar_t* self_ptr = dst.data<scalar_t>();
     scalar_t* src_ptr = src.data<scalar_t>();
 
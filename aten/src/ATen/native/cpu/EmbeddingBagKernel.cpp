@@ -0,0 +1,413 @@
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec256/vec256.h"
+
+namespace at { namespace native { namespace {
+
+using namespace vec256;
+
+// Number of rows (bags, or groups of equal indices) handed to one task, so
+// that a task touches about GRAIN_SIZE elements.
+inline int64_t grain_for(int64_t rows, int64_t elements) {
+  int64_t per_row = std::max<int64_t>(elements / std::max<int64_t>(rows, 1), 1);
+  return std::max<int64_t>(internal::GRAIN_SIZE / per_row, 1);
+}
+
+inline void check_index(int64_t index, int64_t num_weights) {
+  AT_CHECK(index >= 0 && index < num_weights, "embedding_bag: index ", index,
+           " is out of range for a table of ", num_weights, " rows");
+}
+
+// y[0:n] += a * x[0:n:incx]. y is always a contiguous output row.
+template <typename scalar_t>
+inline void axpy(int64_t n, scalar_t a, const scalar_t* x, int64_t incx, scalar_t* y) {
+  using Vec = Vectorized<scalar_t>;
+  if (incx == 1) {
+    Vec a_vec(a);
+    int64_t d = 0;
+    for (; d + Vec::size <= n; d += Vec::size) {
+      fmadd(a_vec, Vec::loadu(x + d), Vec::loadu(y + d)).store(y + d);
+    }
+    for (; d < n; d++) {
+      y[d] += a * x[d];
+    }
+  } else {
+    for (int64_t d = 0; d < n; d++) {
+      y[d] += a * x[d * incx];
+    }
+  }
+}
+
+template <typename scalar_t>
+inline void scale_row(int64_t n, scalar_t a, scalar_t* y) {
+  using Vec = Vectorized<scalar_t>;
+  Vec a_vec(a);
+  int64_t d = 0;
+  for (; d + Vec::size <= n; d += Vec::size) {
+    (Vec::loadu(y + d) * a_vec).store(y + d);
+  }
+  for (; d < n; d++) {
+    y[d] *= a;
+  }
+}
+
+// Bags are independent, so every task owns a disjoint set of output rows.
+template <typename scalar_t>
+void embedding_bag_sum_kernel_impl(Tensor& output, const Tensor& weight,
+                                   const Tensor& indices, const Tensor& offsets,
+                                   const Tensor& per_sample_weights, bool mean) {
+  int64_t num_bags = offsets.size(0);
+  int64_t numel = indices.numel();
+  int64_t num_weights = weight.size(0);
+  int64_t dim = weight.size(1);
+  int64_t weight_stride0 = weight.stride(0);
+  int64_t weight_stride1 = weight.stride(1);
+  const int64_t* indices_data = indices.data<int64_t>();
+  const int64_t* offsets_data = offsets.data<int64_t>();
+  const scalar_t* weight_data = weight.data<scalar_t>();
+  const scalar_t* psw_data =
+      per_sample_weights.defined() ? per_sample_weights.data<scalar_t>() : nullptr;
+  scalar_t* output_data = output.data<scalar_t>();
+
+  parallel_for(0, num_bags, grain_for(num_bags, numel * dim), [&](int64_t begin, int64_t end) {
+    for (int64_t bag = begin; bag < end; bag++) {
+      int64_t first = offsets_data[bag];
+      int64_t last = bag + 1 < num_bags ? offsets_data[bag + 1] : numel;
+      scalar_t* out = output_data + bag * dim;
+      for (int64_t i = first; i < last; i++) {
+        int64_t index = indices_data[i];
+        check_index(index, num_weights);
+        scalar_t w = psw_data ? psw_data[i] : scalar_t(1);
+        axpy<scalar_t>(dim, w, weight_data + index * weight_stride0, weight_stride1, out);
+      }
+      // empty bags are left as zeros
+      if (mean && last - first > 1) {
+        scale_row<scalar_t>(dim, scalar_t(1) / (last - first), out);
+      }
+    }
+  });
+}
+
+void embedding_bag_sum_kernel(Tensor& output, const Tensor& weight,
+                              const Tensor& indices, const Tensor& offsets,
+                              const Tensor& per_sample_weights, bool mean) {
+  AT_DISPATCH_FLOATING_TYPES(weight.type(), "embedding_bag_sum", [&] {
+    embedding_bag_sum_kernel_impl<scalar_t>(output, weight, indices, offsets,
+                                            per_sample_weights, mean);
+  });
+}
+
+template <typename scalar_t>
+void embedding_bag_max_kernel_impl(Tensor& output, Tensor& max_indices,
+                                   const Tensor& weight, const Tensor& indices,
+                                   const Tensor& offsets) {
+  int64_t num_bags = offsets.size(0);
+  int64_t numel = indices.numel();
+  int64_t num_weights = weight.size(0);
+  int64_t dim = weight.size(1);
+  int64_t weight_stride0 = weight.stride(0);
+  int64_t weight_stride1 = weight.stride(1);
+  const int64_t* indices_data = indices.data<int64_t>();
+  const int64_t* offsets_data = offsets.data<int64_t>();
+  const scalar_t* weight_data = weight.data<scalar_t>();
+  scalar_t* output_data = output.data<scalar_t>();
+  int64_t* max_indices_data = max_indices.data<int64_t>();
+
+  parallel_for(0, num_bags, grain_for(num_bags, numel * dim), [&](int64_t begin, int64_t end) {
+    for (int64_t bag = begin; bag < end; bag++) {
+      int64_t first = offsets_data[bag];
+      int64_t last = bag + 1 < num_bags ? offsets_data[bag + 1] : numel;
+      scalar_t* out = output_data + bag * dim;
+      int64_t* out_indices = max_indices_data + bag * dim;
+      // empty bags are left as zeros, with zero max indices
+      for (int64_t i = first; i < last; i++) {
+        int64_t index = indices_data[i];
+        check_index(index, num_weights);
+        const scalar_t* row = weight_data + index * weight_stride0;
+        for (int64_t d = 0; d < dim; d++) {
+          scalar_t value = row[d * weight_stride1];
+          if (i == first || value > out[d]) {
+            out[d] = value;
+            out_indices[d] = index;
+          }
+        }
+      }
+    }
+  });
+}
+
+void embedding_bag_max_kernel(Tensor& output, Tensor& max_indices,
+                              const Tensor& weight, const Tensor& indices,
+                              const Tensor& offsets) {
+  AT_DISPATCH_FLOATING_TYPES(weight.type(), "embedding_bag_max", [&] {
+    embedding_bag_max_kernel_impl<scalar_t>(output, max_indices, weight, indices, offsets);
+  });
+}
+
+// Every run of equal sorted indices accumulates into one row of grad_weight,
+// so the runs are distributed over tasks without any synchronization.
+template <typename scalar_t>
+void embedding_bag_backward_sum_kernel_impl(Tensor& grad_weight, const Tensor& grad,
+                                            const Tensor& sorted_indices, const Tensor& order,
+                                            const Tensor& offset2bag, const Tensor& bag_size,
+                                            const Tensor& per_sample_weights,
+                                            bool mean, bool scale_grad_by_freq) {
+  int64_t numel = sorted_indices.numel();
+  int64_t dim = grad.size(1);
+  const int64_t* indices_data = sorted_indices.data<int64_t>();
+  const int64_t* order_data = order.data<int64_t>();
+  const int64_t* offset2bag_data = offset2bag.data<int64_t>();
+  const int64_t* bag_size_data = bag_size.data<int64_t>();
+  const scalar_t* psw_data =
+      per_sample_weights.defined() ? per_sample_weights.data<scalar_t>() : nullptr;
+  const scalar_t* grad_data = grad.data<scalar_t>();
+  scalar_t* grad_weight_data = grad_weight.data<scalar_t>();
+
+  std::vector<int64_t> run_starts;
+  for (int64_t i = 0; i < numel; i++) {
+    if (i == 0 || indices_data[i] != indices_data[i - 1]) {
+      run_starts.push_back(i);
+    }
+  }
+  int64_t num_runs = run_starts.size();
+  run_starts.push_back(numel);
+
+  parallel_for(0, num_runs, grain_for(num_runs, numel * dim), [&](int64_t begin, int64_t end) {
+    for (int64_t run = begin; run < end; run++) {
+      int64_t first = run_starts[run];
+      int64_t last = run_starts[run + 1];
+      scalar_t* out = grad_weight_data + indices_data[first] * dim;
+      for (int64_t i = first; i < last; i++) {
+        int64_t source = order_data[i];
+        int64_t bag = offset2bag_data[source];
+        scalar_t scale = 1;
+        if (scale_grad_by_freq) {
+          scale /= last - first;
+        }
+        if (mean) {
+          scale /= bag_size_data[bag];
+        }
+        if (psw_data) {
+          scale *= psw_data[source];
+        }
+        axpy<scalar_t>(dim, scale, grad_data + bag * dim, 1, out);
+      }
+    }
+  });
+}
+
+void embedding_bag_backward_sum_kernel(Tensor& grad_weight, const Tensor& grad,
+                                       const Tensor& sorted_indices, const Tensor& order,
+                                       const Tensor& offset2bag, const Tensor& bag_size,
+                                       const Tensor& per_sample_weights,
+                                       bool mean, bool scale_grad_by_freq) {
+  AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_bag_backward_sum", [&] {
+    embedding_bag_backward_sum_kernel_impl<scalar_t>(
+        grad_weight, grad, sorted_indices, order, offset2bag, bag_size,
+        per_sample_weights, mean, scale_grad_by_freq);
+  });
+}
+
+// Each task owns a range of columns of grad_weight and walks all bags for it.
+template <typename scalar_t>
+void embedding_bag_backward_max_kernel_impl(Tensor& grad_weight, const Tensor& grad,
+                                            const Tensor& max_indices, const Tensor& bag_size) {
+  int64_t num_bags = grad.size(0);
+  int64_t dim = grad.size(1);
+  const int64_t* max_indices_data = max_indices.data<int64_t>();
+  const int64_t* bag_size_data = bag_size.data<int64_t>();
+  const scalar_t* grad_data = grad.data<scalar_t>();
+  scalar_t* grad_weight_data = grad_weight.data<scalar_t>();
+
+  parallel_for(0, dim, grain_for(dim, num_bags * dim), [&](int64_t begin, int64_t end) {
+    for (int64_t bag = 0; bag < num_bags; bag++) {
+      if (bag_size_data[bag] == 0) {
+        continue;
+      }
+      const int64_t* bag_indices = max_indices_data + bag * dim;
+      const scalar_t* bag_grad = grad_data + bag * dim;
+      for (int64_t d = begin; d < end; d++) {
+        grad_weight_data[bag_indices[d] * dim + d] += bag_grad[d];
+      }
+    }
+  });
+}
+
+void embedding_bag_backward_max_kernel(Tensor& grad_weight, const Tensor& grad,
+                                       const Tensor& max_indices, const Tensor& bag_size) {
+  AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_bag_backward_max", [&] {
+    embedding_bag_backward_max_kernel_impl<scalar_t>(grad_weight, grad, max_indices, bag_size);
+  });
+}
+
+// Width in bytes of the quantized values of a row, without the scale and bias.
+inline int64_t quantized_row_bytes(int64_t dim, int64_t bits) {
+  return bits == 8 ? dim : (dim + 1) / 2;
+}
+
+inline void read_scale_bias(const uint8_t* params, int64_t bits, float& scale, float& bias) {
+  if (bits == 8) {
+    std::memcpy(&scale, params, sizeof(float));
+    std::memcpy(&bias, params + sizeof(float), sizeof(float));
+  } else {
+    Half half_scale, half_bias;
+    std::memcpy(&half_scale, params, sizeof(Half));
+    std::memcpy(&half_bias, params + sizeof(Half), sizeof(Half));
+    scale = half_scale;
+    bias = half_bias;
+  }
+}
+
+void fused_rowwise_quantize_kernel(Tensor& packed, const Tensor& weight, int64_t bits) {
+  int64_t rows = weight.size(0);
+  int64_t dim = weight.size(1);
+  int64_t row_bytes = quantized_row_bytes(dim, bits);
+  int64_t packed_stride = packed.size(1);
+  const float* weight_data = weight.data<float>();
+  uint8_t* packed_data = packed.data<uint8_t>();
+
+  parallel_for(0, rows, grain_for(rows, rows * dim), [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; r++) {
+      const float* in = weight_data + r * dim;
+      uint8_t* out = packed_data + r * packed_stride;
+      float minimum = dim > 0 ? in[0] : 0;
+      float maximum = minimum;
+      for (int64_t d = 1; d < dim; d++) {
+        minimum = std::min(minimum, in[d]);
+        maximum = std::max(maximum, in[d]);
+      }
+      if (bits == 8) {
+        float range = maximum - minimum;
+        float scale = range / 255.0f;
+        float inverse_scale = 255.0f / (range + 1e-8f);
+        for (int64_t d = 0; d < dim; d++) {
+          out[d] = static_cast<uint8_t>(std::lrintf((in[d] - minimum) * inverse_scale));
+        }
+        std::memcpy(out + row_bytes, &scale, sizeof(float));
+        std::memcpy(out + row_bytes + sizeof(float), &minimum, sizeof(float));
+      } else {
+        // The bias is stored as Half, so quantize against the rounded bias.
+        Half bias = minimum;
+        minimum = bias;
+        Half scale = (maximum - minimum) / 15.0f;
+        if (static_cast<float>(scale) == 0 || std::isinf(static_cast<float>(scale))) {
+          scale = 1.0f;
+        }
+        float inverse_scale = 1.0f / static_cast<float>(scale);
+        std::memset(out, 0, row_bytes);
+        for (int64_t d = 0; d < dim; d++) {
+          long q = std::lrintf((in[d] - minimum) * inverse_scale);
+          q = std::max(0L, std::min(q, 15L));
+          out[d / 2] |= static_cast<uint8_t>(q << ((d % 2) * 4));
+        }
+        std::memcpy(out + row_bytes, &scale, sizeof(Half));
+        std::memcpy(out + row_bytes + sizeof(Half), &bias, sizeof(Half));
+      }
+    }
+  });
+}
+
+void fused_rowwise_dequantize_kernel(Tensor& weight, const Tensor& packed, int64_t bits) {
+  int64_t rows = weight.size(0);
+  int64_t dim = weight.size(1);
+  int64_t row_bytes = quantized_row_bytes(dim, bits);
+  int64_t packed_stride = packed.size(1);
+  const uint8_t* packed_data = packed.data<uint8_t>();
+  float* weight_data = weight.data<float>();
+
+  parallel_for(0, rows, grain_for(rows, rows * dim), [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; r++) {
+      const uint8_t* in = packed_data + r * packed_stride;
+      float* out = weight_data + r * dim;
+      float scale, bias;
+      read_scale_bias(in + row_bytes, bits, scale, bias);
+      if (bits == 8) {
+        for (int64_t d = 0; d < dim; d++) {
+          out[d] = scale * in[d] + bias;
+        }
+      } else {
+        for (int64_t d = 0; d < dim; d++) {
+          out[d] = scale * ((in[d / 2] >> ((d % 2) * 4)) & 0xF) + bias;
+        }
+      }
+    }
+  });
+}
+
+// The rows are dequantized on the fly: a weighted row contributes
+// (w * scale) * q + w * bias, so the inner loops are a single multiply-add
+// over the quantized values and vectorize.
+void fused_rowwise_embedding_bag_kernel(Tensor& output, const Tensor& packed,
+                                        const Tensor& indices, const Tensor& offsets,
+                                        const Tensor& per_sample_weights,
+                                        int64_t bits, bool mean) {
+  int64_t num_bags = offsets.size(0);
+  int64_t numel = indices.numel();
+  int64_t num_weights = packed.size(0);
+  int64_t packed_stride = packed.size(1);
+  int64_t dim = output.size(1);
+  int64_t row_bytes = quantized_row_bytes(dim, bits);
+  const int64_t* indices_data = indices.data<int64_t>();
+  const int64_t* offsets_data = offsets.data<int64_t>();
+  const uint8_t* packed_data = packed.data<uint8_t>();
+  const float* psw_data =
+      per_sample_weights.defined() ? per_sample_weights.data<float>() : nullptr;
+  float* output_data = output.data<float>();
+
+  parallel_for(0, num_bags, grain_for(num_bags, numel * dim), [&](int64_t begin, int64_t end) {
+    for (int64_t bag = begin; bag < end; bag++) {
+      int64_t first = offsets_data[bag];
+      int64_t last = bag + 1 < num_bags ? offsets_data[bag + 1] : numel;
+      float* out = output_data + bag * dim;
+      for (int64_t i = first; i < last; i++) {
+        int64_t index = indices_data[i];
+        check_index(index, num_weights);
+        const uint8_t* row = packed_data + index * packed_stride;
+        float scale, bias;
+        read_scale_bias(row + row_bytes, bits, scale, bias);
+        float w = psw_data ? psw_data[i] : 1.0f;
+        scale *= w;
+        bias *= w;
+        if (bits == 8) {
+          for (int64_t d = 0; d < dim; d++) {
+            out[d] += scale * row[d] + bias;
+          }
+        } else {
+          int64_t d = 0;
+          for (; d + 1 < dim; d += 2) {
+            uint8_t byte = row[d / 2];
+            out[d] += scale * (byte & 0xF) + bias;
+            out[d + 1] += scale * (byte >> 4) + bias;
+          }
+          if (d < dim) {
+            out[d] += scale * (row[d / 2] & 0xF) + bias;
+          }
+        }
+      }
+      if (mean && last - first > 1) {
+        scale_row<float>(dim, 1.0f / (last - first), out);
+      }
+    }
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(embedding_bag_sum_stub, &embedding_bag_sum_kernel);
+REGISTER_DISPATCH(embedding_bag_max_stub, &embedding_bag_max_kernel);
+REGISTER_DISPATCH(embedding_bag_backward_sum_stub, &embedding_bag_backward_sum_kernel);
+REGISTER_DISPATCH(embedding_bag_backward_max_stub, &embedding_bag_backward_max_kernel);
+REGISTER_DISPATCH(fused_rowwise_quantize_stub, &fused_rowwise_quantize_kernel);
+REGISTER_DISPATCH(fused_rowwise_dequantize_stub, &fused_rowwise_dequantize_kernel);
+REGISTER_DISPATCH(fused_rowwise_embedding_bag_stub, &fused_rowwise_embedding_bag_kernel);
+
+}} // namespace at::native
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// Bag b reduces indices[offsets[b], offsets[b + 1]); the last bag runs to the
+// end of `indices`. `per_sample_weights` may be undefined. `output` and
+// `max_indices` are contiguous (num_bags, embedding_dim) tensors.
+using embedding_bag_sum_fn = void (*)(Tensor& output, const Tensor& weight,
+                                      const Tensor& indices, const Tensor& offsets,
+                                      const Tensor& per_sample_weights, bool mean);
+using embedding_bag_max_fn = void (*)(Tensor& output, Tensor& max_indices,
+                                      const Tensor& weight, const Tensor& indices,
+                                      const Tensor& offsets);
+
+// `sorted_indices` are the indices sorted stably and `order` the positions
+// they came from. `grad_weight` is a zero-filled contiguous tensor.
+using embedding_bag_backward_sum_fn = void (*)(Tensor& grad_weight, const Tensor& grad,
+                                               const Tensor& sorted_indices, const Tensor& order,
+                                               const Tensor& offset2bag, const Tensor& bag_size,
+                                               const Tensor& per_sample_weights,
+                                               bool mean, bool scale_grad_by_freq);
+using embedding_bag_backward_max_fn = void (*)(Tensor& grad_weight, const Tensor& grad,
+                                               const Tensor& max_indices, const Tensor& bag_size);
+
+// Rowwise quantized tables, one row per embedding with the quantization
+// parameters appended to the quantized values:
+//   8 bits: embedding_dim uint8 values, then float scale and float bias
+//   4 bits: ceil(embedding_dim / 2) bytes holding two values each, low nibble
+//           first, then Half scale and Half bias
+// A value is dequantized as scale * q + bias.
+using fused_rowwise_quantize_fn = void (*)(Tensor& packed, const Tensor& weight, int64_t bits);
+using fused_rowwise_dequantize_fn = void (*)(Tensor& weight, const Tensor& packed, int64_t bits);
+using fused_rowwise_embedding_bag_fn = void (*)(Tensor& output, const Tensor& packed,
+                                                const Tensor& indices, const Tensor& offsets,
+                                                const Tensor& per_sample_weights,
+                                                int64_t bits, bool mean);
+
+DECLARE_DISPATCH(embedding_bag_sum_fn, embedding_bag_sum_stub);
+DECLARE_DISPATCH(embedding_bag_max_fn, embedding_bag_max_stub);
+DECLARE_DISPATCH(embedding_bag_backward_sum_fn, embedding_bag_backward_sum_stub);
+DECLARE_DISPATCH(embedding_bag_backward_max_fn, embedding_bag_backward_max_stub);
+DECLARE_DISPATCH(fused_rowwise_quantize_fn, fused_rowwise_quantize_stub);
+DECLARE_DISPATCH(fused_rowwise_dequantize_fn, fused_rowwise_dequantize_stub);
+DECLARE_DISPATCH(fused_rowwise_embedding_bag_fn, fused_rowwise_embedding_bag_stub);
+
+}} // namespace at::native
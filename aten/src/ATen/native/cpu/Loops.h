@@ -192,8 +192,9 @@ template <typename func_t, typename vec_func_t>
 static inline void vectorized_outer_reduction(char** data, int64_t inner_stride, int64_t size0, int64_t size1, func_t op, vec_func_t vop) {
   VEC_HEADER(func_t)
 
-  // reduce down each column of 4 * Vec::size elements (128 bytes)
-  int64_t outer_stride[2] = { 128, 128 };
+  // reduce down each column of 4 * Vec::size elements (128 bytes, or 256
+  // bytes with AVX512)
+  int64_t outer_stride[2] = { 4 * Vec::size * sizeof(scalar_t), 4 * Vec::size * sizeof(scalar_t) };
   UNARY_OUTER_LOOP(data, outer_stride, size1 / (4 * Vec::size), [&] {
     reduction128(data, size0, inner_stride, op, vop, /*reduce=*/false);
   });
@@ -0,0 +1,285 @@
+#include "ATen/native/RNN.h"
+
+#include <algorithm>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec256/vec256.h"
+
+// Fused pointwise parts of the LSTM and GRU cells, matching the CUDA kernels
+// in native/cuda/RNN.cu, including the workspace layouts their backward
+// passes read. Every task handles a block of batch rows and walks the hidden
+// units one vector at a time; the tail of a row is loaded and stored partially
+// instead of going through cmath (see [Note AVX-SSE transitions]).
+//
+// On grainsize: counting exp and tanh as 4, a hidden unit costs about 32
+// operations in the forward cells and 16 in the backward ones.
+
+namespace at { namespace native { namespace {
+
+using namespace vec256;
+
+constexpr int64_t kLSTMGates = 4;
+constexpr int64_t kGRUGates = 3;
+constexpr int64_t kGRUWorkspaceMultiplier = 5;
+
+template <typename scalar_t>
+inline Vectorized<scalar_t> load(const scalar_t* ptr, int64_t count) {
+  return Vectorized<scalar_t>::loadu(ptr, count);
+}
+
+template <typename scalar_t>
+inline void store(const Vectorized<scalar_t>& value, scalar_t* ptr, int64_t count) {
+  value.store(ptr, count);
+}
+
+template <typename scalar_t>
+inline Vectorized<scalar_t> sigmoid(const Vectorized<scalar_t>& x) {
+  return (Vectorized<scalar_t>(1) + x.neg().exp()).reciprocal();
+}
+
+// input_gates + hidden_gates (+ both biases) of one gate, for hidden units
+// [j, j + count) of a row.
+template <typename scalar_t>
+inline Vectorized<scalar_t> gate_input(const scalar_t* input_gates, const scalar_t* hidden_gates,
+                                   const scalar_t* input_bias, const scalar_t* hidden_bias,
+                                   int64_t offset, int64_t count) {
+  auto sum = load(input_gates + offset, count) + load(hidden_gates + offset, count);
+  if (input_bias) {
+    sum = sum + load(input_bias + offset, count) + load(hidden_bias + offset, count);
+  }
+  return sum;
+}
+
+inline int64_t grain_for_rows(int64_t hidden_size, int64_t ops_per_unit) {
+  return std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(hidden_size * ops_per_unit, 1), 1);
+}
+
+template <typename scalar_t>
+void lstm_cell_kernel_impl(Tensor& hy, Tensor& cy, Tensor& workspace,
+                           const Tensor& input_gates, const Tensor& hidden_gates,
+                           const Tensor& input_bias, const Tensor& hidden_bias,
+                           const Tensor& cx) {
+  using Vec = Vectorized<scalar_t>;
+  int64_t batch = cx.size(0), hidden_size = cx.size(1);
+  const scalar_t* input_gates_data = input_gates.data<scalar_t>();
+  const scalar_t* hidden_gates_data = hidden_gates.data<scalar_t>();
+  const scalar_t* input_bias_data = input_bias.defined() ? input_bias.data<scalar_t>() : nullptr;
+  const scalar_t* hidden_bias_data = hidden_bias.defined() ? hidden_bias.data<scalar_t>() : nullptr;
+  const scalar_t* cx_data = cx.data<scalar_t>();
+  scalar_t* hy_data = hy.data<scalar_t>();
+  scalar_t* cy_data = cy.data<scalar_t>();
+  scalar_t* workspace_data = workspace.data<scalar_t>();
+
+  parallel_for(0, batch, grain_for_rows(hidden_size, 32), [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      const scalar_t* ig_row = input_gates_data + b * kLSTMGates * hidden_size;
+      const scalar_t* hg_row = hidden_gates_data + b * kLSTMGates * hidden_size;
+      scalar_t* ws_row = workspace_data + b * kLSTMGates * hidden_size;
+      int64_t row = b * hidden_size;
+      for (int64_t j = 0; j < hidden_size; j += Vec::size) {
+        int64_t count = std::min<int64_t>(Vec::size, hidden_size - j);
+        auto ig = sigmoid(gate_input(ig_row, hg_row, input_bias_data, hidden_bias_data, j, count));
+        auto fg = sigmoid(gate_input(ig_row, hg_row, input_bias_data, hidden_bias_data,
+                                     hidden_size + j, count));
+        auto cg = gate_input(ig_row, hg_row, input_bias_data, hidden_bias_data,
+                             2 * hidden_size + j, count).tanh();
+        auto og = sigmoid(gate_input(ig_row, hg_row, input_bias_data, hidden_bias_data,
+                                     3 * hidden_size + j, count));
+        auto c = fg * load(cx_data + row + j, count) + ig * cg;
+        store(og * c.tanh(), hy_data + row + j, count);
+        store(c, cy_data + row + j, count);
+        store(ig, ws_row + j, count);
+        store(fg, ws_row + hidden_size + j, count);
+        store(cg, ws_row + 2 * hidden_size + j, count);
+        store(og, ws_row + 3 * hidden_size + j, count);
+      }
+    }
+  });
+}
+
+void lstm_cell_kernel(Tensor& hy, Tensor& cy, Tensor& workspace,
+                      const Tensor& input_gates, const Tensor& hidden_gates,
+                      const Tensor& input_bias, const Tensor& hidden_bias,
+                      const Tensor& cx) {
+  AT_DISPATCH_FLOATING_TYPES(input_gates.type(), "lstm_cell", [&] {
+    lstm_cell_kernel_impl<scalar_t>(hy, cy, workspace, input_gates, hidden_gates,
+                                    input_bias, hidden_bias, cx);
+  });
+}
+
+template <typename scalar_t>
+void lstm_cell_backward_kernel_impl(Tensor& grad_gates, Tensor& grad_cx,
+                                    const Tensor& grad_hy, const Tensor& grad_cy,
+                                    const Tensor& cx, const Tensor& cy,
+                                    const Tensor& workspace) {
+  using Vec = Vectorized<scalar_t>;
+  int64_t batch = cx.size(0), hidden_size = cx.size(1);
+  const scalar_t* grad_hy_data = grad_hy.defined() ? grad_hy.data<scalar_t>() : nullptr;
+  const scalar_t* grad_cy_data = grad_cy.defined() ? grad_cy.data<scalar_t>() : nullptr;
+  const scalar_t* cx_data = cx.data<scalar_t>();
+  const scalar_t* cy_data = cy.data<scalar_t>();
+  const scalar_t* workspace_data = workspace.data<scalar_t>();
+  scalar_t* grad_gates_data = grad_gates.data<scalar_t>();
+  scalar_t* grad_cx_data = grad_cx.data<scalar_t>();
+
+  parallel_for(0, batch, grain_for_rows(hidden_size, 16), [&](int64_t begin, int64_t end) {
+    Vec one(1);
+    for (int64_t b = begin; b < end; b++) {
+      const scalar_t* ws_row = workspace_data + b * kLSTMGates * hidden_size;
+      scalar_t* grad_gates_row = grad_gates_data + b * kLSTMGates * hidden_size;
+      int64_t row = b * hidden_size;
+      for (int64_t j = 0; j < hidden_size; j += Vec::size) {
+        int64_t count = std::min<int64_t>(Vec::size, hidden_size - j);
+        auto ig = load(ws_row + j, count);
+        auto fg = load(ws_row + hidden_size + j, count);
+        auto cg = load(ws_row + 2 * hidden_size + j, count);
+        auto og = load(ws_row + 3 * hidden_size + j, count);
+        auto go = grad_hy_data ? load(grad_hy_data + row + j, count) : Vec(0);
+        auto goc = grad_cy_data ? load(grad_cy_data + row + j, count) : Vec(0);
+
+        auto tanh_cy = load(cy_data + row + j, count).tanh();
+        auto gog = go * tanh_cy;
+        auto gcx = go * og * (one - tanh_cy * tanh_cy) + goc;
+        auto gig = gcx * cg * (one - ig) * ig;
+        auto gfg = gcx * load(cx_data + row + j, count) * (one - fg) * fg;
+        auto gcg = gcx * ig * (one - cg * cg);
+        gog = gog * (one - og) * og;
+
+        store(gig, grad_gates_row + j, count);
+        store(gfg, grad_gates_row + hidden_size + j, count);
+        store(gcg, grad_gates_row + 2 * hidden_size + j, count);
+        store(gog, grad_gates_row + 3 * hidden_size + j, count);
+        store(gcx * fg, grad_cx_data + row + j, count);
+      }
+    }
+  });
+}
+
+void lstm_cell_backward_kernel(Tensor& grad_gates, Tensor& grad_cx,
+                               const Tensor& grad_hy, const Tensor& grad_cy,
+                               const Tensor& cx, const Tensor& cy,
+                               const Tensor& workspace) {
+  AT_DISPATCH_FLOATING_TYPES(workspace.type(), "lstm_cell_backward", [&] {
+    lstm_cell_backward_kernel_impl<scalar_t>(grad_gates, grad_cx, grad_hy, grad_cy,
+                                             cx, cy, workspace);
+  });
+}
+
+template <typename scalar_t>
+void gru_cell_kernel_impl(Tensor& hy, Tensor& workspace,
+                          const Tensor& input_gates, const Tensor& hidden_gates,
+                          const Tensor& input_bias, const Tensor& hidden_bias,
+                          const Tensor& hx) {
+  using Vec = Vectorized<scalar_t>;
+  int64_t batch = hx.size(0), hidden_size = hx.size(1);
+  const scalar_t* input_gates_data = input_gates.data<scalar_t>();
+  const scalar_t* hidden_gates_data = hidden_gates.data<scalar_t>();
+  const scalar_t* input_bias_data = input_bias.defined() ? input_bias.data<scalar_t>() : nullptr;
+  const scalar_t* hidden_bias_data = hidden_bias.defined() ? hidden_bias.data<scalar_t>() : nullptr;
+  const scalar_t* hx_data = hx.data<scalar_t>();
+  scalar_t* hy_data = hy.data<scalar_t>();
+  scalar_t* workspace_data = workspace.data<scalar_t>();
+
+  parallel_for(0, batch, grain_for_rows(hidden_size, 32), [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      const scalar_t* ig_row = input_gates_data + b * kGRUGates * hidden_size;
+      const scalar_t* hg_row = hidden_gates_data + b * kGRUGates * hidden_size;
+      scalar_t* ws_row = workspace_data + b * kGRUWorkspaceMultiplier * hidden_size;
+      int64_t row = b * hidden_size;
+      for (int64_t j = 0; j < hidden_size; j += Vec::size) {
+        int64_t count = std::min<int64_t>(Vec::size, hidden_size - j);
+        int64_t n = 2 * hidden_size + j;
+        auto rg = sigmoid(gate_input(ig_row, hg_row, input_bias_data, hidden_bias_data, j, count));
+        auto ig = sigmoid(gate_input(ig_row, hg_row, input_bias_data, hidden_bias_data,
+                                     hidden_size + j, count));
+        auto in = load(ig_row + n, count);
+        auto hn = load(hg_row + n, count);
+        if (input_bias_data) {
+          in = in + load(input_bias_data + n, count);
+          hn = hn + load(hidden_bias_data + n, count);
+        }
+        auto ng = (in + rg * hn).tanh();
+        auto h = load(hx_data + row + j, count);
+        store(ng + ig * (h - ng), hy_data + row + j, count);
+        store(rg, ws_row + j, count);
+        store(ig, ws_row + hidden_size + j, count);
+        store(ng, ws_row + 2 * hidden_size + j, count);
+        store(h, ws_row + 3 * hidden_size + j, count);
+        store(hn, ws_row + 4 * hidden_size + j, count);
+      }
+    }
+  });
+}
+
+void gru_cell_kernel(Tensor& hy, Tensor& workspace,
+                     const Tensor& input_gates, const Tensor& hidden_gates,
+                     const Tensor& input_bias, const Tensor& hidden_bias,
+                     const Tensor& hx) {
+  AT_DISPATCH_FLOATING_TYPES(input_gates.type(), "gru_cell", [&] {
+    gru_cell_kernel_impl<scalar_t>(hy, workspace, input_gates, hidden_gates,
+                                   input_bias, hidden_bias, hx);
+  });
+}
+
+template <typename scalar_t>
+void gru_cell_backward_kernel_impl(Tensor& grad_input_gates, Tensor& grad_hidden_gates,
+                                   Tensor& grad_hx, const Tensor& grad_hy,
+                                   const Tensor& workspace) {
+  using Vec = Vectorized<scalar_t>;
+  int64_t batch = grad_hy.size(0), hidden_size = grad_hy.size(1);
+  const scalar_t* grad_hy_data = grad_hy.data<scalar_t>();
+  const scalar_t* workspace_data = workspace.data<scalar_t>();
+  scalar_t* grad_input_gates_data = grad_input_gates.data<scalar_t>();
+  scalar_t* grad_hidden_gates_data = grad_hidden_gates.data<scalar_t>();
+  scalar_t* grad_hx_data = grad_hx.data<scalar_t>();
+
+  parallel_for(0, batch, grain_for_rows(hidden_size, 16), [&](int64_t begin, int64_t end) {
+    Vec one(1);
+    for (int64_t b = begin; b < end; b++) {
+      const scalar_t* ws_row = workspace_data + b * kGRUWorkspaceMultiplier * hidden_size;
+      scalar_t* grad_ig_row = grad_input_gates_data + b * kGRUGates * hidden_size;
+      scalar_t* grad_hg_row = grad_hidden_gates_data + b * kGRUGates * hidden_size;
+      int64_t row = b * hidden_size;
+      for (int64_t j = 0; j < hidden_size; j += Vec::size) {
+        int64_t count = std::min<int64_t>(Vec::size, hidden_size - j);
+        auto rg = load(ws_row + j, count);
+        auto ig = load(ws_row + hidden_size + j, count);
+        auto ng = load(ws_row + 2 * hidden_size + j, count);
+        auto hx = load(ws_row + 3 * hidden_size + j, count);
+        auto hn = load(ws_row + 4 * hidden_size + j, count);
+        auto go = load(grad_hy_data + row + j, count);
+
+        auto gig = go * (hx - ng) * (one - ig) * ig;
+        auto gin = go * (one - ig) * (one - ng * ng);
+        auto grg = gin * hn * (one - rg) * rg;
+
+        store(grg, grad_ig_row + j, count);
+        store(gig, grad_ig_row + hidden_size + j, count);
+        store(gin, grad_ig_row + 2 * hidden_size + j, count);
+        store(grg, grad_hg_row + j, count);
+        store(gig, grad_hg_row + hidden_size + j, count);
+        store(gin * rg, grad_hg_row + 2 * hidden_size + j, count);
+        store(go * ig, grad_hx_data + row + j, count);
+      }
+    }
+  });
+}
+
+void gru_cell_backward_kernel(Tensor& grad_input_gates, Tensor& grad_hidden_gates,
+                              Tensor& grad_hx, const Tensor& grad_hy,
+                              const Tensor& workspace) {
+  AT_DISPATCH_FLOATING_TYPES(grad_hy.type(), "gru_cell_backward", [&] {
+    gru_cell_backward_kernel_impl<scalar_t>(grad_input_gates, grad_hidden_gates, grad_hx,
+                                            grad_hy, workspace);
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(lstm_cell_stub, &lstm_cell_kernel);
+REGISTER_DISPATCH(lstm_cell_backward_stub, &lstm_cell_backward_kernel);
+REGISTER_DISPATCH(gru_cell_stub, &gru_cell_kernel);
+REGISTER_DISPATCH(gru_cell_backward_stub, &gru_cell_backward_kernel);
+
+}} // namespace at::native
@@ -38,9 +38,9 @@ static inline int64_t round_down(int64_t a, int64_t m) {
 
 template<typename scalar_t>
 struct NormReduction {
-  // reduction width in number of scalar elements
-  static constexpr int WIDTH = 128 / sizeof(scalar_t);
   using Vec = Vec256<scalar_t>;
+  // reduction width in number of scalar elements
+  static constexpr int WIDTH = 4 * Vec::size;
 
   static void apply(
       Tensor& res,
@@ -148,12 +148,12 @@ struct NormReduction {
     return result;
   }
 
-  // Reduce down a column of WIDTH elements (128 bytes) with the given number n
-  // n is already rounded by 128
+  // Reduce down a column of WIDTH elements (four vectors) with the given
+  // number n; n is already rounded by WIDTH
   static scalar_t norm_reduce128(const scalar_t* data, int64_t n, float pval) {
     scalar_t result = 0.0;
-    Vec acc[4] = {0.0, 0.0, 0.0, 0.0};  // 128 bytes (two cache lines)
-    static_assert(sizeof(acc) == 128, "accumulator should be 128 bytes");
+    Vec acc[4] = {0.0, 0.0, 0.0, 0.0};  // two cache lines (four with AVX512)
+    static_assert(sizeof(acc) == WIDTH * sizeof(scalar_t), "accumulator should be WIDTH elements");
     int64_t rows = n / WIDTH;
     if (pval == 1){
       for (int row = 0; row < rows; row ++) {
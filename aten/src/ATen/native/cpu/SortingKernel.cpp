@@ -0,0 +1,446 @@
+#include "ATen/native/cpu/SortingKernel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+
+namespace at { namespace native { namespace {
+
+// Slices shorter than this are insertion sorted; the radix sort pays for a
+// 256-entry histogram per key byte, which only amortizes on longer slices.
+constexpr int64_t kRadixSortMinSize = 64;
+// topk and kthvalue keep a heap of the k best elements seen so far when k is
+// at least this many times smaller than the slice. Most elements are then
+// rejected by a single comparison against the top of the heap.
+constexpr int64_t kHeapSelectRatio = 64;
+
+// Maps values to unsigned keys whose unsigned order is the order of the
+// values. NaN maps to the largest key, so it compares greater than +inf.
+// Descending order complements the keys, so every sort is an ascending sort
+// on keys, and ties keep the order of their indices.
+template <typename scalar_t, typename Enable = void>
+struct SortKey;
+
+template <typename scalar_t>
+struct SortKey<scalar_t, typename std::enable_if<std::is_integral<scalar_t>::value>::type> {
+  using type = typename std::make_unsigned<scalar_t>::type;
+  static type flip() {
+    return std::is_signed<scalar_t>::value
+        ? static_cast<type>(type(1) << (sizeof(type) * 8 - 1))
+        : type(0);
+  }
+  static type encode(scalar_t value) {
+    return static_cast<type>(static_cast<type>(value) ^ flip());
+  }
+  static scalar_t decode(type key) {
+    return static_cast<scalar_t>(static_cast<type>(key ^ flip()));
+  }
+};
+
+template <typename scalar_t>
+struct SortKey<scalar_t, typename std::enable_if<std::is_floating_point<scalar_t>::value>::type> {
+  using type = typename std::conditional<sizeof(scalar_t) == 4, uint32_t, uint64_t>::type;
+  static type sign_bit() {
+    return type(1) << (sizeof(type) * 8 - 1);
+  }
+  static type encode(scalar_t value) {
+    if (std::isnan(value)) {
+      return std::numeric_limits<type>::max();
+    }
+    type bits;
+    std::memcpy(&bits, &value, sizeof(value));
+    return (bits & sign_bit()) ? ~bits : (bits | sign_bit());
+  }
+  static scalar_t decode(type key) {
+    type bits = (key & sign_bit()) ? (key ^ sign_bit()) : ~key;
+    scalar_t value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+};
+
+template <typename scalar_t>
+using key_type = typename SortKey<scalar_t>::type;
+
+template <typename scalar_t>
+inline key_type<scalar_t> encode(scalar_t value, key_type<scalar_t> mask) {
+  return static_cast<key_type<scalar_t>>(SortKey<scalar_t>::encode(value) ^ mask);
+}
+
+template <typename scalar_t>
+inline scalar_t decode(key_type<scalar_t> key, key_type<scalar_t> mask) {
+  return SortKey<scalar_t>::decode(static_cast<key_type<scalar_t>>(key ^ mask));
+}
+
+template <typename scalar_t>
+inline key_type<scalar_t> order_mask(bool descending) {
+  return descending ? std::numeric_limits<key_type<scalar_t>>::max() : 0;
+}
+
+// The contiguous variants of the loops below are separate instantiations so
+// that the compiler sees unit strides and can vectorize them.
+template <bool contiguous, typename scalar_t>
+void load_keys_impl(const scalar_t* data, int64_t stride, int64_t n,
+                    key_type<scalar_t> mask, key_type<scalar_t>* keys) {
+  for (int64_t i = 0; i < n; i++) {
+    keys[i] = encode<scalar_t>(data[contiguous ? i : i * stride], mask);
+  }
+}
+
+template <typename scalar_t>
+void load_keys(const scalar_t* data, int64_t stride, int64_t n,
+               key_type<scalar_t> mask, key_type<scalar_t>* keys) {
+  if (stride == 1) {
+    load_keys_impl<true>(data, stride, n, mask, keys);
+  } else {
+    load_keys_impl<false>(data, stride, n, mask, keys);
+  }
+}
+
+template <bool contiguous, typename scalar_t>
+void store_sorted_impl(scalar_t* values, int64_t values_stride,
+                       int64_t* indices, int64_t indices_stride,
+                       const key_type<scalar_t>* keys, const int64_t* idx,
+                       int64_t n, key_type<scalar_t> mask) {
+  for (int64_t i = 0; i < n; i++) {
+    values[contiguous ? i : i * values_stride] = decode<scalar_t>(keys[i], mask);
+    indices[contiguous ? i : i * indices_stride] = idx[i];
+  }
+}
+
+template <typename scalar_t>
+void store_sorted(scalar_t* values, int64_t values_stride,
+                  int64_t* indices, int64_t indices_stride,
+                  const key_type<scalar_t>* keys, const int64_t* idx,
+                  int64_t n, key_type<scalar_t> mask) {
+  if (values_stride == 1 && indices_stride == 1) {
+    store_sorted_impl<true>(values, 1, indices, 1, keys, idx, n, mask);
+  } else {
+    store_sorted_impl<false>(values, values_stride, indices, indices_stride,
+                             keys, idx, n, mask);
+  }
+}
+
+// Stable insertion sort of keys[0, n), carrying the indices along.
+template <typename key_t>
+void insertion_sort(key_t* keys, int64_t* indices, int64_t n) {
+  for (int64_t i = 1; i < n; i++) {
+    key_t key = keys[i];
+    int64_t index = indices[i];
+    int64_t j = i;
+    for (; j > 0 && keys[j - 1] > key; j--) {
+      keys[j] = keys[j - 1];
+      indices[j] = indices[j - 1];
+    }
+    keys[j] = key;
+    indices[j] = index;
+  }
+}
+
+// Stable LSD radix sort of keys[0, n) on 8-bit digits, carrying the indices
+// along. key_buf and index_buf are scratch space of n elements. A pass is
+// skipped when all keys share its digit, so integer keys with a small range
+// take one or two passes.
+template <typename key_t>
+void radix_sort(key_t* keys, int64_t* indices, key_t* key_buf,
+                int64_t* index_buf, int64_t n) {
+  constexpr int kPasses = sizeof(key_t);
+  std::array<std::array<int64_t, 256>, kPasses> counts;
+  for (auto& count : counts) {
+    count.fill(0);
+  }
+  for (int64_t i = 0; i < n; i++) {
+    key_t key = keys[i];
+    for (int pass = 0; pass < kPasses; pass++) {
+      counts[pass][(key >> (8 * pass)) & 0xFF]++;
+    }
+  }
+
+  key_t* src_keys = keys;
+  int64_t* src_indices = indices;
+  key_t* dst_keys = key_buf;
+  int64_t* dst_indices = index_buf;
+  for (int pass = 0; pass < kPasses; pass++) {
+    auto& offsets = counts[pass];
+    int shift = 8 * pass;
+    if (offsets[(src_keys[0] >> shift) & 0xFF] == n) {
+      continue;
+    }
+    int64_t offset = 0;
+    for (auto& bucket : offsets) {
+      int64_t count = bucket;
+      bucket = offset;
+      offset += count;
+    }
+    for (int64_t i = 0; i < n; i++) {
+      key_t key = src_keys[i];
+      int64_t pos = offsets[(key >> shift) & 0xFF]++;
+      dst_keys[pos] = key;
+      dst_indices[pos] = src_indices[i];
+    }
+    std::swap(src_keys, dst_keys);
+    std::swap(src_indices, dst_indices);
+  }
+  if (src_keys != keys) {
+    std::copy(src_keys, src_keys + n, keys);
+    std::copy(src_indices, src_indices + n, indices);
+  }
+}
+
+template <typename key_t>
+void sort_keys(key_t* keys, int64_t* indices, key_t* key_buf,
+               int64_t* index_buf, int64_t n) {
+  std::iota(indices, indices + n, 0);
+  if (n < kRadixSortMinSize) {
+    insertion_sort(keys, indices, n);
+  } else {
+    radix_sort(keys, indices, key_buf, index_buf, n);
+  }
+}
+
+// Leaves the k smallest (key, index) pairs of the slice in `heap`, sorted.
+// A later element only replaces the top of the heap if its key is strictly
+// smaller, so among equal keys the lowest indices are kept.
+template <bool contiguous, typename scalar_t>
+void heap_select_impl(const scalar_t* data, int64_t stride, int64_t n,
+                      int64_t k, key_type<scalar_t> mask,
+                      std::vector<std::pair<key_type<scalar_t>, int64_t>>& heap) {
+  heap.clear();
+  for (int64_t i = 0; i < k; i++) {
+    heap.emplace_back(encode<scalar_t>(data[contiguous ? i : i * stride], mask), i);
+  }
+  std::make_heap(heap.begin(), heap.end());
+  for (int64_t i = k; i < n; i++) {
+    auto key = encode<scalar_t>(data[contiguous ? i : i * stride], mask);
+    if (key < heap.front().first) {
+      std::pop_heap(heap.begin(), heap.end());
+      heap.back() = std::make_pair(key, i);
+      std::push_heap(heap.begin(), heap.end());
+    }
+  }
+  std::sort_heap(heap.begin(), heap.end());
+}
+
+template <typename scalar_t>
+void heap_select(const scalar_t* data, int64_t stride, int64_t n, int64_t k,
+                 key_type<scalar_t> mask,
+                 std::vector<std::pair<key_type<scalar_t>, int64_t>>& heap) {
+  if (stride == 1) {
+    heap_select_impl<true>(data, stride, n, k, mask, heap);
+  } else {
+    heap_select_impl<false>(data, stride, n, k, mask, heap);
+  }
+}
+
+// Loads the slice as (key, index) pairs and moves the k smallest to the
+// front, the k-th smallest at position k - 1.
+template <typename scalar_t>
+void partition_select(const scalar_t* data, int64_t stride, int64_t n,
+                      int64_t k, key_type<scalar_t> mask,
+                      std::vector<std::pair<key_type<scalar_t>, int64_t>>& pairs) {
+  pairs.resize(n);
+  for (int64_t i = 0; i < n; i++) {
+    pairs[i] = std::make_pair(encode<scalar_t>(data[i * stride], mask), i);
+  }
+  std::nth_element(pairs.begin(), pairs.begin() + (k - 1), pairs.end());
+}
+
+// Calls fn(self_offset, values_offset, indices_offset) for the slices along
+// `dim` numbered [begin, end), counting through the other dimensions in
+// row-major order.
+template <typename Fn>
+void for_each_slice(const Tensor& self, const Tensor& values,
+                    const Tensor& indices, int64_t dim,
+                    int64_t begin, int64_t end, const Fn& fn) {
+  int64_t ndim = self.dim();
+  auto sizes = self.sizes();
+  std::vector<int64_t> counter(ndim, 0);
+  int64_t linear = begin;
+  for (int64_t d = ndim - 1; d >= 0; d--) {
+    if (d != dim) {
+      counter[d] = linear % sizes[d];
+      linear /= sizes[d];
+    }
+  }
+  for (int64_t slice = begin; slice < end; slice++) {
+    int64_t self_offset = 0;
+    int64_t values_offset = 0;
+    int64_t indices_offset = 0;
+    for (int64_t d = 0; d < ndim; d++) {
+      self_offset += counter[d] * self.stride(d);
+      values_offset += counter[d] * values.stride(d);
+      indices_offset += counter[d] * indices.stride(d);
+    }
+    fn(self_offset, values_offset, indices_offset);
+    for (int64_t d = ndim - 1; d >= 0; d--) {
+      if (d != dim) {
+        if (++counter[d] < sizes[d]) {
+          break;
+        }
+        counter[d] = 0;
+      }
+    }
+  }
+}
+
+// Slices are independent, so they are spread over threads; each task gets
+// slices worth at least GRAIN_SIZE elements.
+template <typename Fn>
+void parallel_for_slices(const Tensor& self, int64_t dim, const Fn& fn) {
+  int64_t n = self.size(dim);
+  int64_t num_slices = self.numel() / n;
+  int64_t grain_size = std::max(internal::GRAIN_SIZE / n, (int64_t)1);
+  parallel_for(0, num_slices, grain_size, fn);
+}
+
+template <typename scalar_t>
+void sort_cpu_impl(Tensor& values, Tensor& indices, const Tensor& self,
+                   int64_t dim, bool descending) {
+  using key_t = key_type<scalar_t>;
+  const key_t mask = order_mask<scalar_t>(descending);
+  const int64_t n = self.size(dim);
+  const int64_t self_stride = self.stride(dim);
+  const int64_t values_stride = values.stride(dim);
+  const int64_t indices_stride = indices.stride(dim);
+  const scalar_t* self_data = self.data<scalar_t>();
+  scalar_t* values_data = values.data<scalar_t>();
+  int64_t* indices_data = indices.data<int64_t>();
+
+  parallel_for_slices(self, dim, [&](int64_t begin, int64_t end) {
+    std::vector<key_t> keys(2 * n);
+    std::vector<int64_t> idx(2 * n);
+    for_each_slice(self, values, indices, dim, begin, end,
+                   [&](int64_t self_offset, int64_t values_offset, int64_t indices_offset) {
+      load_keys(self_data + self_offset, self_stride, n, mask, keys.data());
+      sort_keys(keys.data(), idx.data(), keys.data() + n, idx.data() + n, n);
+      store_sorted(values_data + values_offset, values_stride,
+                   indices_data + indices_offset, indices_stride,
+                   keys.data(), idx.data(), n, mask);
+    });
+  });
+}
+
+template <typename scalar_t>
+void topk_cpu_impl(Tensor& values, Tensor& indices, const Tensor& self,
+                   int64_t k, int64_t dim, bool largest, bool sorted) {
+  using key_t = key_type<scalar_t>;
+  // the k largest values have the k smallest complemented keys
+  const key_t mask = order_mask<scalar_t>(largest);
+  const int64_t n = self.size(dim);
+  const int64_t self_stride = self.stride(dim);
+  const int64_t values_stride = values.stride(dim);
+  const int64_t indices_stride = indices.stride(dim);
+  const scalar_t* self_data = self.data<scalar_t>();
+  scalar_t* values_data = values.data<scalar_t>();
+  int64_t* indices_data = indices.data<int64_t>();
+  // Small k: select with a heap, which also sorts the result for free.
+  // Sorted output with k close to n: sort the whole slice.
+  // Otherwise: partition around the k-th element and sort the first k.
+  const bool use_heap = k * kHeapSelectRatio <= n;
+  const bool use_sort = !use_heap && sorted && k * 4 >= n;
+
+  parallel_for_slices(self, dim, [&](int64_t begin, int64_t end) {
+    std::vector<key_t> keys;
+    std::vector<int64_t> idx;
+    std::vector<std::pair<key_t, int64_t>> pairs;
+    if (use_sort) {
+      keys.resize(2 * n);
+      idx.resize(2 * n);
+    }
+    for_each_slice(self, values, indices, dim, begin, end,
+                   [&](int64_t self_offset, int64_t values_offset, int64_t indices_offset) {
+      const scalar_t* data = self_data + self_offset;
+      scalar_t* values_ptr = values_data + values_offset;
+      int64_t* indices_ptr = indices_data + indices_offset;
+      if (use_sort) {
+        load_keys(data, self_stride, n, mask, keys.data());
+        sort_keys(keys.data(), idx.data(), keys.data() + n, idx.data() + n, n);
+        store_sorted(values_ptr, values_stride, indices_ptr, indices_stride,
+                     keys.data(), idx.data(), k, mask);
+        return;
+      }
+      if (use_heap) {
+        heap_select(data, self_stride, n, k, mask, pairs);
+      } else {
+        partition_select(data, self_stride, n, k, mask, pairs);
+        if (sorted) {
+          std::sort(pairs.begin(), pairs.begin() + k);
+        }
+      }
+      for (int64_t i = 0; i < k; i++) {
+        values_ptr[i * values_stride] = decode<scalar_t>(pairs[i].first, mask);
+        indices_ptr[i * indices_stride] = pairs[i].second;
+      }
+    });
+  });
+}
+
+template <typename scalar_t>
+void kthvalue_cpu_impl(Tensor& values, Tensor& indices, const Tensor& self,
+                       int64_t k, int64_t dim) {
+  using key_t = key_type<scalar_t>;
+  const int64_t n = self.size(dim);
+  const int64_t self_stride = self.stride(dim);
+  const scalar_t* self_data = self.data<scalar_t>();
+  scalar_t* values_data = values.data<scalar_t>();
+  int64_t* indices_data = indices.data<int64_t>();
+  // The k-th smallest is also the (n - k + 1)-th largest; the heap works
+  // from whichever end is closer.
+  const bool from_top = (n - k + 1) < k;
+  const int64_t rank = from_top ? n - k + 1 : k;
+  const key_t mask = order_mask<scalar_t>(from_top);
+  const bool use_heap = rank * kHeapSelectRatio <= n;
+
+  parallel_for_slices(self, dim, [&](int64_t begin, int64_t end) {
+    std::vector<std::pair<key_t, int64_t>> pairs;
+    for_each_slice(self, values, indices, dim, begin, end,
+                   [&](int64_t self_offset, int64_t values_offset, int64_t indices_offset) {
+      const scalar_t* data = self_data + self_offset;
+      if (use_heap) {
+        heap_select(data, self_stride, n, rank, mask, pairs);
+      } else {
+        partition_select(data, self_stride, n, rank, mask, pairs);
+      }
+      values_data[values_offset] = decode<scalar_t>(pairs[rank - 1].first, mask);
+      indices_data[indices_offset] = pairs[rank - 1].second;
+    });
+  });
+}
+
+static void sort_kernel_impl(Tensor& values, Tensor& indices, const Tensor& self,
+                             int64_t dim, bool descending) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "sort", [&] {
+    sort_cpu_impl<scalar_t>(values, indices, self, dim, descending);
+  });
+}
+
+static void topk_kernel_impl(Tensor& values, Tensor& indices, const Tensor& self,
+                             int64_t k, int64_t dim, bool largest, bool sorted) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "topk", [&] {
+    topk_cpu_impl<scalar_t>(values, indices, self, k, dim, largest, sorted);
+  });
+}
+
+static void kthvalue_kernel_impl(Tensor& values, Tensor& indices, const Tensor& self,
+                                 int64_t k, int64_t dim) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "kthvalue", [&] {
+    kthvalue_cpu_impl<scalar_t>(values, indices, self, k, dim);
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(sort_stub, &sort_kernel_impl);
+REGISTER_DISPATCH(topk_stub, &topk_kernel_impl);
+REGISTER_DISPATCH(kthvalue_stub, &kthvalue_kernel_impl);
+
+}} // namespace at::native
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// The output tensors are resized by the caller and have the shape of `self`
+// except along `dim`, where sort has size(dim), topk has k and kthvalue has 1.
+using sort_fn = void (*)(Tensor& values, Tensor& indices, const Tensor& self,
+                         int64_t dim, bool descending);
+using topk_fn = void (*)(Tensor& values, Tensor& indices, const Tensor& self,
+                         int64_t k, int64_t dim, bool largest, bool sorted);
+using kthvalue_fn = void (*)(Tensor& values, Tensor& indices, const Tensor& self,
+                             int64_t k, int64_t dim);
+
+DECLARE_DISPATCH(sort_fn, sort_stub);
+DECLARE_DISPATCH(topk_fn, topk_stub);
+DECLARE_DISPATCH(kthvalue_fn, kthvalue_stub);
+
+}} // namespace at::native
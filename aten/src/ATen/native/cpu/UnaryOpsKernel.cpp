@@ -11,7 +11,7 @@
 #include "ATen/CPUApplyUtils.h"
 #include "ATen/native/DispatchStub.h"
 #include "ATen/native/Distributions.h"
-#ifdef __AVX2__
+#if defined(__AVX2__) && !defined(__AVX512F__)
 #include "ATen/native/cpu/avx_mathfun.h"
 #endif
 
@@ -28,29 +28,18 @@ namespace {
 using namespace vec256;
 
 template <typename scalar_t>
-static int64_t _sigmoid(scalar_t* x, scalar_t* y, int64_t size);
-
-// This should be a temporary solution until we understand why SLEEF is slower
-// for sigmoid
-
-template <>
-int64_t _sigmoid(float* x, float* y, int64_t size) {
-  using Vec = Vec256<float>;
+static int64_t _sigmoid(scalar_t* x, scalar_t* y, int64_t size) {
+  using Vec = Vec256<scalar_t>;
   int64_t i = 0;
   for (; i < size - (size % (2 * Vec::size)); i += 2 * Vec::size) {
     Vec ret = Vec::loadu(y + i);
     Vec ret2 = Vec::loadu(y + i + Vec::size);
     ret = ret.neg();
     ret2 = ret2.neg();
-#if defined(__AVX2__) && !defined(_MSC_VER)
-    ret = exp256_ps(ret);
-    ret2 = exp256_ps(ret2);
-#else
     ret = ret.exp();
     ret2 = ret2.exp();
-#endif
-    ret = Vec((float)(1)) + ret;
-    ret2 = Vec((float)(1)) + ret2;
+    ret = Vec((scalar_t)(1)) + ret;
+    ret2 = Vec((scalar_t)(1)) + ret2;
     ret = ret.reciprocal();
     ret2 = ret2.reciprocal();
     ret.store(x + i);
@@ -59,19 +48,27 @@ int64_t _sigmoid(float* x, float* y, int64_t size) {
   return i;
 }
 
+// This should be a temporary solution until we understand why SLEEF is slower
+// for sigmoid
+
 template <>
-int64_t _sigmoid(double* x, double* y, int64_t size) {
-  using Vec = Vec256<double>;
+int64_t _sigmoid(float* x, float* y, int64_t size) {
+  using Vec = Vec256<float>;
   int64_t i = 0;
   for (; i < size - (size % (2 * Vec::size)); i += 2 * Vec::size) {
     Vec ret = Vec::loadu(y + i);
     Vec ret2 = Vec::loadu(y + i + Vec::size);
     ret = ret.neg();
     ret2 = ret2.neg();
+#if defined(__AVX2__) && !defined(__AVX512F__) && !defined(_MSC_VER)
+    ret = exp256_ps(ret);
+    ret2 = exp256_ps(ret2);
+#else
     ret = ret.exp();
     ret2 = ret2.exp();
-    ret = Vec((double)(1)) + ret;
-    ret2 = Vec((double)(1)) + ret2;
+#endif
+    ret = Vec((float)(1)) + ret;
+    ret2 = Vec((float)(1)) + ret2;
     ret = ret.reciprocal();
     ret2 = ret2.reciprocal();
     ret.store(x + i);
@@ -81,7 +78,7 @@ int64_t _sigmoid(double* x, double* y, int64_t size) {
 }
 
 static void sigmoid_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "sigmoid", [&] {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF_AND_BFLOAT16(self.type(), "sigmoid", [&] {
     using Vec = Vec256<scalar_t>;
     CPU_tensor_parallel_kernel_apply2<scalar_t, scalar_t>(
         result,
@@ -177,7 +174,7 @@ void bernoulli_mkl_kernel(Tensor &self, const double p, Generator* gen) {
 #define IMPLEMENT_FLOAT_KERNEL(dispatchtypes, op)                          \
   static void op##_kernel(Tensor& result, const Tensor& self) {            \
     checkBackend(#op, {result}, Backend::CPU);                             \
-    AT_DISPATCH_##dispatchtypes##_TYPES(self.type(), #op, [&] {            \
+    AT_DISPATCH_##dispatchtypes(self.type(), #op, [&] {                   \
       if (self.is_contiguous() && result.is_contiguous()) {                \
         vml::v##op(                                                        \
             result.data<scalar_t>(), self.data<scalar_t>(), self.numel()); \
@@ -217,29 +214,29 @@ void bernoulli_mkl_kernel(Tensor &self, const double p, Generator* gen) {
 REGISTER_DISPATCH(sigmoidImpl, &sigmoid_kernel)
 REGISTER_DISPATCH(bernoulli_mkl_stub, &bernoulli_mkl_kernel);
 
-// IMPLEMENT_FLOAT_KERNEL(ALL, abs)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, acos)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, asin)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, atan)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, ceil)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, cos)
-// IMPLEMENT_FLOAT_KERNEL(FLOATING, cosh)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, erf)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, erfc)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, exp)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, expm1)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, floor)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, log)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, log10)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, log1p)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, log2)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, round)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, rsqrt)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, sin)
-// IMPLEMENT_FLOAT_KERNEL(FLOATING, sinh)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, sqrt)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, tan)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, tanh)
-IMPLEMENT_FLOAT_KERNEL(FLOATING, trunc)
+// IMPLEMENT_FLOAT_KERNEL(ALL_TYPES, abs)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, acos)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, asin)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, atan)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, ceil)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, cos)
+// IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, cosh)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, erf)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, erfc)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, exp)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, expm1)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, floor)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, log)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, log10)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, log1p)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, log2)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, round)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, rsqrt)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, sin)
+// IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, sinh)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, sqrt)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, tan)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, tanh)
+IMPLEMENT_FLOAT_KERNEL(FLOATING_TYPES_AND_HALF_AND_BFLOAT16, trunc)
 
 }} // namespace at::native
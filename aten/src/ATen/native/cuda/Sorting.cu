@@ -0,0 +1,21 @@
+#include "ATen/ATen.h"
+
+namespace at { namespace native {
+
+std::tuple<Tensor&, Tensor&> sort_out_cuda(Tensor& values, Tensor& indices, const Tensor& self, int64_t dim, bool descending) {
+  return _th_sort_out(values, indices, self, dim, descending);
+}
+
+std::tuple<Tensor, Tensor> sort_cuda(const Tensor& self, int64_t dim, bool descending) {
+  return _th_sort(self, dim, descending);
+}
+
+std::tuple<Tensor&, Tensor&> topk_out_cuda(Tensor& values, Tensor& indices, const Tensor& self, int64_t k, int64_t dim, bool largest, bool sorted) {
+  return _th_topk_out(values, indices, self, k, dim, largest, sorted);
+}
+
+std::tuple<Tensor, Tensor> topk_cuda(const Tensor& self, int64_t k, int64_t dim, bool largest, bool sorted) {
+  return _th_topk(self, k, dim, largest, sorted);
+}
+
+}} // namespace at::native
@@ -8,6 +8,7 @@ type_map = {
         'Float',
         'Double',
         'Half',
+        'BFloat16',
     ],
     'integral': [
         'Byte',
@@ -62,8 +63,12 @@ def process_types_and_backends(option):
             pairs.discard(('CUDA', 'Half'))
 
     # special case remove Half for cpu unless it is explicitly enabled,
+    # cpu_half covers both 16-bit floating point types, BFloat16 only
+    # exists on CPU.
     if not option.get('cpu_half', False):
         pairs.discard(('CPU', 'Half'))
+        pairs.discard(('CPU', 'BFloat16'))
+    pairs.discard(('CUDA', 'BFloat16'))
 
     # sort the result for easy reading
     option['backend_type_pairs'] = sorted([p for p in pairs])
@@ -0,0 +1,105 @@
+#include "gtest/gtest.h"
+
+#include <ATen/ATen.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include "test_assert.h"
+
+using namespace at;
+
+static uint16_t bits(BFloat16 value) {
+  return value.x;
+}
+
+TEST(TestBFloat16, Arithmetic) {
+  BFloat16 zero = 0;
+  BFloat16 one = 1;
+  ASSERT_EQ(zero + one, one);
+  ASSERT_EQ(zero * one, zero);
+  ASSERT_EQ(one / one, one);
+  ASSERT_EQ(zero - one, -one);
+  ASSERT_EQ(one + one, BFloat16(2));
+  ASSERT_EQ(one + one, 2);
+}
+
+TEST(TestBFloat16, Rounding) {
+  // bfloat16 keeps the upper 16 bits of a float; anything below rounds to
+  // nearest, ties to even.
+  ASSERT_EQ(bits(BFloat16(1.0f)), 0x3F80);
+  ASSERT_EQ(bits(BFloat16(1.00390625f)), 0x3F80);    // tie, rounds down
+  ASSERT_EQ(bits(BFloat16(1.01171875f)), 0x3F82);    // tie, rounds up
+  ASSERT_EQ(bits(BFloat16(1.0078125f)), 0x3F81);     // exact
+  ASSERT_EQ(static_cast<float>(BFloat16(3.140625f)), 3.140625f);
+  ASSERT_EQ(bits(BFloat16(-0.0f)), 0x8000);
+  ASSERT_TRUE(std::isinf(static_cast<float>(BFloat16(INFINITY))));
+  ASSERT_TRUE(std::isnan(static_cast<float>(BFloat16(NAN))));
+  // a NaN whose payload lives in the truncated bits must stay a NaN
+  float nan_low_payload;
+  uint32_t nan_bits = 0x7F800001;
+  std::memcpy(&nan_low_payload, &nan_bits, sizeof(nan_bits));
+  ASSERT_TRUE(std::isnan(static_cast<float>(BFloat16(nan_low_payload))));
+}
+
+TEST(TestBFloat16, NumericLimits) {
+  using limits = std::numeric_limits<BFloat16>;
+  ASSERT_EQ(static_cast<float>(limits::max()), 3.38953139e38f);
+  ASSERT_EQ(static_cast<float>(limits::lowest()), -3.38953139e38f);
+  ASSERT_EQ(static_cast<float>(limits::min()), std::numeric_limits<float>::min());
+  ASSERT_EQ(static_cast<float>(limits::epsilon()), 0.0078125f);
+  ASSERT_EQ(limits::infinity(), std::numeric_limits<float>::infinity());
+  ASSERT_NE(limits::quiet_NaN(), limits::quiet_NaN());
+}
+
+TEST(TestBFloat16, ToString) {
+  std::stringstream ss;
+  ss << BFloat16(-2.5f);
+  ASSERT_EQ(ss.str(), "-2.5");
+}
+
+TEST(TestBFloat16, Promotion) {
+  ASSERT_EQ(promoteTypes(kBFloat16, kBFloat16), kBFloat16);
+  ASSERT_EQ(promoteTypes(kBFloat16, kHalf), kFloat);
+  ASSERT_EQ(promoteTypes(kBFloat16, kDouble), kDouble);
+  ASSERT_EQ(promoteTypes(kLong, kBFloat16), kBFloat16);
+}
+
+// The CPU kernels compute in float and round once on store, so they must
+// agree with a float reference rounded to the 16-bit type.
+static void test_reduced_float_kernels(ScalarType dtype) {
+  auto x_float = at::rand({1000}, kFloat) + 0.5;
+  auto y_float = at::rand({1000}, kFloat) + 0.5;
+  auto x = x_float.to(dtype);
+  auto y = y_float.to(dtype);
+  x_float = x.to(kFloat);
+  y_float = y.to(kFloat);
+
+  auto rounded = [dtype](const Tensor& t) { return t.to(dtype).to(kFloat); };
+  ASSERT_TRUE(x.add(y).to(kFloat).equal(rounded(x_float.add(y_float))));
+  ASSERT_TRUE(x.mul(y).to(kFloat).equal(rounded(x_float.mul(y_float))));
+  ASSERT_TRUE(x.div(y).to(kFloat).equal(rounded(x_float.div(y_float))));
+  ASSERT_TRUE(x.exp().to(kFloat).allclose(x_float.exp(), 1e-2, 1e-2));
+  ASSERT_TRUE(x.sigmoid().to(kFloat).allclose(x_float.sigmoid(), 1e-2, 1e-2));
+  // non-contiguous input goes through the strided path
+  auto xt = x.view({20, 50}).t();
+  ASSERT_TRUE(xt.sqrt().to(kFloat).allclose(xt.to(kFloat).sqrt(), 1e-2, 1e-2));
+  // sum and prod accumulate in float and round once
+  ASSERT_TRUE(x.sum().to(kFloat).equal(rounded(x_float.sum())));
+  ASSERT_TRUE(x.view({20, 50}).sum(1).to(kFloat).equal(
+      rounded(x_float.view({20, 50}).sum(1))));
+  ASSERT_TRUE(x.view({20, 50}).sum(0).to(kFloat).equal(
+      rounded(x_float.view({20, 50}).sum(0))));
+  ASSERT_TRUE(x.view({100, 10}).prod(1).to(kFloat).equal(
+      rounded(x_float.view({100, 10}).prod(1))));
+  // 16-bit partial sums would stop growing at 2048 (Half) or 256 (BFloat16)
+  ASSERT_EQ(at::ones({4096}, dtype).sum().item<float>(), 4096);
+}
+
+TEST(TestBFloat16, CPUKernels) {
+  test_reduced_float_kernels(kBFloat16);
+}
+
+TEST(TestBFloat16, HalfCPUKernels) {
+  test_reduced_float_kernels(kHalf);
+}
@@ -7,6 +7,9 @@
 #include <iostream>
 #include <string.h>
 #include <sstream>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
 
 using namespace at;
 
@@ -51,3 +54,77 @@ TEST(TestParallel, Exceptions) {
     }),
     std::runtime_error);
 }
+
+TEST(TestParallel, NativeBackend) {
+  auto prev_backend = at::get_parallel_backend();
+  at::set_parallel_backend(at::ParallelBackend::Native);
+
+  // every index is visited exactly once, whatever the chunking
+  std::vector<int> visits(100000, 0);
+  at::parallel_for(0, visits.size(), 1000, [&](int64_t begin, int64_t end) {
+    ASSERT_TRUE(at::in_parallel_region());
+    ASSERT_LT(at::get_thread_num(), at::get_max_threads());
+    for (int64_t i = begin; i < end; i++) {
+      visits[i]++;
+    }
+  });
+  for (auto v : visits) {
+    ASSERT_EQ(v, 1);
+  }
+  ASSERT_FALSE(at::in_parallel_region());
+
+  // nested regions produce the same result as the serial computation
+  Tensor a = ones({1024, 1024});
+  auto expected = a.sum();
+  at::parallel_for(0, 10, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      ASSERT_TRUE(a.sum().equal(expected));
+    }
+  });
+
+  int64_t sum = at::parallel_reduce(
+      0, 100000, 1000, (int64_t)0,
+      [](int64_t begin, int64_t end, int64_t ident) {
+        int64_t partial = ident;
+        for (int64_t i = begin; i < end; i++) {
+          partial += i;
+        }
+        return partial;
+      },
+      std::plus<int64_t>());
+  ASSERT_EQ(sum, (int64_t)100000 * 99999 / 2);
+
+  ASSERT_THROW(
+    at::parallel_for(0, 10, 1, [&](int64_t begin, int64_t end) {
+      throw std::runtime_error("exception");
+    }),
+    std::runtime_error);
+
+  at::set_parallel_backend(prev_backend);
+}
+
+TEST(TestParallel, InteropPool) {
+  ASSERT_GT(at::get_num_interop_threads(), 0);
+  ASSERT_GT(at::get_num_intraop_threads(), 0);
+  if (!std::getenv("ATEN_NUM_INTEROP_THREADS")) {
+    // a single thread by default, like the old global work queue
+    ASSERT_EQ(at::get_num_interop_threads(), 1);
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  at::launch([&]() {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    cv.notify_one();
+  });
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&]() { return done; });
+  ASSERT_TRUE(done);
+
+  // the inter-op pool is running now, so it can't be resized
+  ASSERT_THROW(
+      at::set_num_interop_threads(at::get_num_interop_threads() + 1),
+      c10::Error);
+}
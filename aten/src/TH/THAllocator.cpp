@@ -1,5 +1,7 @@
 #include "THAllocator.h"
 
+#include <c10/core/CPUCachingAllocator.h>
+
 /* stuff for mapped files */
 #ifdef _WIN32
 #include <windows.h>
@@ -19,18 +21,31 @@
 #endif
 /* end of stuff for mapped files */
 
+static void THDefaultAllocatorFree(void* ptr) {
+  if (ptr) {
+    c10::reportFree(ptr, at::DeviceType::CPU);
+  }
+  THFree(ptr);
+}
+
 struct THDefaultAllocator final : public at::Allocator {
   at::DataPtr allocate(size_t size) const override {
     auto* ptr = THAlloc(size);
-    return {ptr, ptr, &THFree, at::DeviceType::CPU};
+    if (ptr) {
+      c10::reportAllocation(ptr, size, at::DeviceType::CPU);
+    }
+    return {ptr, ptr, &THDefaultAllocatorFree, at::DeviceType::CPU};
   }
   at::DeleterFnPtr raw_deleter() const override {
-    return &THFree;
+    return &THDefaultAllocatorFree;
   }
 };
 
 static THDefaultAllocator th_default_allocator;
 at::Allocator* getTHDefaultAllocator() {
+  if (c10::CPUCachingAllocator::enabled()) {
+    return c10::GetCPUCachingAllocator();
+  }
   return &th_default_allocator;
 }
 
@@ -0,0 +1,15 @@
+#ifndef TH_BFLOAT16_H
+#define TH_BFLOAT16_H
+
+#ifdef __cplusplus
+#include <ATen/core/BFloat16.h>
+#endif
+
+#ifdef __cplusplus
+#define THBFloat16 at::BFloat16
+#else
+typedef struct at_BFloat16 at_BFloat16;
+#define THBFloat16 at_BFloat16
+#endif
+
+#endif
@@ -9,12 +9,18 @@
 #include "generic/THStorage.cpp"
 #include "THGenerateHalfType.h"
 
+#include "generic/THStorage.cpp"
+#include "THGenerateBFloat16Type.h"
+
 #include "generic/THStorageCopy.cpp"
 #include "THGenerateAllTypes.h"
 
 #include "generic/THStorageCopy.cpp"
 #include "THGenerateHalfType.h"
 
+#include "generic/THStorageCopy.cpp"
+#include "THGenerateBFloat16Type.h"
+
 THStorage* THStorage_new(caffe2::TypeMeta data_type) {
   THStorage* storage = c10::make_intrusive<at::StorageImpl>(
       data_type,
@@ -11,11 +11,17 @@
 #include "generic/THStorage.h"
 #include "THGenerateHalfType.h"
 
+#include "generic/THStorage.h"
+#include "THGenerateBFloat16Type.h"
+
 #include "generic/THStorageCopy.h"
 #include "THGenerateAllTypes.h"
 
 #include "generic/THStorageCopy.h"
 #include "THGenerateHalfType.h"
 
+#include "generic/THStorageCopy.h"
+#include "THGenerateBFloat16Type.h"
+
 // This exists to have a data-type independent way of freeing (necessary for THPPointer).
 TH_API void THStorage_free(THStorage *storage);
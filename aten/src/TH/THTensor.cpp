@@ -6,6 +6,9 @@
 #include "generic/THTensor.cpp"
 #include "THGenerateHalfType.h"
 
+#include "generic/THTensor.cpp"
+#include "THGenerateBFloat16Type.h"
+
 #include "ATen/native/Resize.h"
 
 #include <numeric>
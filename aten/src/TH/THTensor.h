@@ -13,6 +13,9 @@
 #include "generic/THTensor.h"
 #include "THGenerateHalfType.h"
 
+#include "generic/THTensor.h"
+#include "THGenerateBFloat16Type.h"
+
 /* random numbers */
 #include "THRandom.h"
 #include "generic/THTensorRandom.h"
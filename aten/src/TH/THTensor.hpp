@@ -127,3 +127,6 @@ TH_CPP_API c10::optional<std::vector<int64_t>> THTensor_compute_stride(
 
 #include "generic/THTensor.hpp"
 #include "THGenerateHalfType.h"
+
+#include "generic/THTensor.hpp"
+#include "THGenerateBFloat16Type.h"
@@ -35,6 +35,7 @@ typedef struct at_Storage_Impl at_Storage_Impl;
 #define THFloatStorage THStorage
 #define THDoubleStorage THStorage
 #define THHalfStorage THStorage
+#define THBFloat16Storage THStorage
 #define THByteStorage THStorage
 #define THCharStorage THStorage
 #define THShortStorage THStorage
@@ -37,5 +37,6 @@ IMPLEMENT_THStorage_COPY(Long)
 IMPLEMENT_THStorage_COPY(Float)
 IMPLEMENT_THStorage_COPY(Double)
 IMPLEMENT_THStorage_COPY(Half)
+IMPLEMENT_THStorage_COPY(BFloat16)
 
 #endif
@@ -20,6 +20,7 @@ typedef struct at_Tensor_Impl at_Tensor_Impl;
 #define THFloatTensor THTensor
 #define THDoubleTensor THTensor
 #define THHalfTensor THTensor
+#define THBFloat16Tensor THTensor
 #define THByteTensor THTensor
 #define THCharTensor THTensor
 #define THShortTensor THTensor
@@ -0,0 +1,103 @@
+"""Compare the memory saved for backward with checkpointing and offloading.
+
+Trains a deep MLP for a few steps in every mode and reports the peak bytes
+of the tensors saved for backward (see
+torch.utils.checkpoint.saved_tensors_memory_stats), the device memory the
+forward pass keeps allocated on CUDA, and the time per step:
+
+    plain        no checkpointing
+    python       torch.utils.checkpoint.checkpoint on every segment
+    native       the same in the C++ autograd (native=True)
+    offload      saved CUDA tensors moved to pinned host memory (CUDA only)
+
+    python benchmarks/autograd_checkpoint_memory.py --layers 32 --segments 4
+    python benchmarks/autograd_checkpoint_memory.py --device cuda --batch 256
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import time
+
+import torch
+import torch.nn as nn
+from torch.utils.checkpoint import (checkpoint, offload_saved_tensors, record_saved_tensors_memory,
+                                   saved_tensors_memory_stats)
+
+
+def make_model(layers, hidden):
+    blocks = []
+    for _ in range(layers):
+        blocks += [nn.Linear(hidden, hidden), nn.Tanh()]
+    return nn.Sequential(*blocks)
+
+
+def segments_of(model, segments):
+    modules = list(model.children())
+    size = (len(modules) + segments - 1) // segments
+    return [nn.Sequential(*modules[i:i + size]) for i in range(0, len(modules), size)]
+
+
+def forward(mode, model, segments, x):
+    if mode == 'plain' or mode == 'offload':
+        return model(x)
+    for segment in segments:
+        x = checkpoint(segment, x, native=(mode == 'native'))
+    return x
+
+
+def run(mode, model, segments, x, steps):
+    cuda = x.device.type == 'cuda'
+    saved_tensors_memory_stats(reset_peak=True)
+    device_bytes = 0
+    seconds = 0.0
+    for _ in range(steps):
+        if cuda:
+            torch.cuda.synchronize()
+            allocated = torch.cuda.memory_allocated()
+        start = time.time()
+        with offload_saved_tensors(enabled=(mode == 'offload')), record_saved_tensors_memory():
+            loss = forward(mode, model, segments, x).sum()
+        if cuda:
+            # what the forward pass keeps alive for backward
+            device_bytes = max(device_bytes, torch.cuda.memory_allocated() - allocated)
+        loss.backward()
+        if cuda:
+            torch.cuda.synchronize()
+        seconds += time.time() - start
+    stats = saved_tensors_memory_stats()
+    return (stats['peak_resident_bytes'], stats['peak_offloaded_bytes'],
+            device_bytes if cuda else None, seconds / steps)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--device', default='cpu')
+    parser.add_argument('--layers', type=int, default=32)
+    parser.add_argument('--segments', type=int, default=4)
+    parser.add_argument('--hidden', type=int, default=512)
+    parser.add_argument('--batch', type=int, default=128)
+    parser.add_argument('--steps', type=int, default=5)
+    args = parser.parse_args()
+
+    device = torch.device(args.device)
+    model = make_model(args.layers, args.hidden).to(device)
+    segments = segments_of(model, args.segments)
+    x = torch.randn(args.batch, args.hidden, device=device, requires_grad=True)
+    modes = ['plain', 'python', 'native'] + (['offload'] if device.type == 'cuda' else [])
+
+    print('{:<10}{:>16}{:>18}{:>16}{:>12}'.format(
+        'mode', 'saved MB', 'offloaded MB', 'device MB', 'step (ms)'))
+    for mode in modes:
+        run(mode, model, segments, x, 1)
+        saved, offloaded, device_peak, seconds = run(mode, model, segments, x, args.steps)
+        print('{:<10}{:>16.1f}{:>18.1f}{:>16}{:>12.2f}'.format(
+            mode, saved / 2 ** 20, offloaded / 2 ** 20,
+            '-' if device_peak is None else '{:.1f}'.format(device_peak / 2 ** 20),
+            seconds * 1e3))
+
+
+if __name__ == '__main__':
+    main()
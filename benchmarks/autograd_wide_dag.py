@@ -0,0 +1,77 @@
+"""Measure how the backward pass of a wide graph scales with CPU threads.
+
+Builds a graph of many independent towers of small matrix products that are
+summed at the end, the shape of a multi-branch model, and times its backward
+pass with 1, 2, 4, ... autograd CPU worker threads (see
+Engine::set_num_cpu_threads). Intra-op parallelism is disabled, so the
+speedup comes from running the functions of different towers at the same
+time. The engine can't stop its worker threads, so the thread counts are
+measured in increasing order.
+
+    python benchmarks/autograd_wide_dag.py --threads 1 2 4 8
+    python benchmarks/autograd_wide_dag.py --towers 64 --depth 8 --hidden 128
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import time
+
+import torch
+from torch.autograd import Variable
+
+
+def wide_dag(x, weights, depth):
+    outputs = []
+    for w in weights:
+        y = x
+        for _ in range(depth):
+            y = torch.tanh(y.mm(w))
+        outputs.append(y.sum())
+    return sum(outputs)
+
+
+def measure(x, weights, depth, iters, repeat):
+    wide_dag(x, weights, depth).backward()
+    best = float('inf')
+    for _ in range(repeat):
+        seconds = 0.0
+        for _ in range(iters):
+            out = wide_dag(x, weights, depth)
+            start = time.time()
+            out.backward()
+            seconds += time.time() - start
+        best = min(best, seconds / iters)
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--threads', type=int, nargs='+', default=[1, 2, 4, 8])
+    parser.add_argument('--towers', type=int, default=32)
+    parser.add_argument('--depth', type=int, default=4)
+    parser.add_argument('--hidden', type=int, default=64)
+    parser.add_argument('--batch', type=int, default=32)
+    parser.add_argument('--iters', type=int, default=20)
+    parser.add_argument('--repeat', type=int, default=3)
+    args = parser.parse_args()
+
+    torch.set_num_threads(1)
+    engine = Variable._execution_engine
+    x = torch.randn(args.batch, args.hidden, requires_grad=True)
+    weights = [(torch.randn(args.hidden, args.hidden) / args.hidden ** 0.5).requires_grad_()
+               for _ in range(args.towers)]
+
+    print('{:>8}{:>16}{:>10}'.format('threads', 'backward (ms)', 'speedup'))
+    base = None
+    for threads in sorted(args.threads):
+        engine.set_num_cpu_threads(threads)
+        seconds = measure(x, weights, args.depth, args.iters, args.repeat)
+        base = base or seconds
+        print('{:>8}{:>16.3f}{:>10.2f}'.format(threads, seconds * 1e3, base / seconds))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,99 @@
+"""Time the native CPU convolution algorithms against thnn_conv2d.
+
+Every row is one layer shape taken from ResNet-50 or MobileNetV2. The auto
+column is what F.conv2d picks; the remaining columns force one algorithm of
+torch._cpu_conv2d (nan where it doesn't apply) or run the im2col + GEMM
+implementation group by group.
+
+    python benchmarks/conv2d.py --batch 1 --threads 1
+    python benchmarks/conv2d.py --backward --layers resnet
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import timeit
+
+import torch
+import torch.nn.functional as F
+
+# (name, channels, out_channels, size, kernel, stride, padding, groups)
+LAYERS = {
+    'resnet': [
+        ('res2_1x1a', 256, 64, 56, 1, 1, 0, 1),
+        ('res2_3x3', 64, 64, 56, 3, 1, 1, 1),
+        ('res3_3x3', 128, 128, 28, 3, 1, 1, 1),
+        ('res4_3x3', 256, 256, 14, 3, 1, 1, 1),
+        ('res5_3x3', 512, 512, 7, 3, 1, 1, 1),
+        ('res3_1x1s2', 256, 512, 56, 1, 2, 0, 1),
+    ],
+    'mobilenet': [
+        ('dw_112', 96, 96, 112, 3, 2, 1, 96),
+        ('dw_56', 144, 144, 56, 3, 1, 1, 144),
+        ('dw_14', 384, 384, 14, 3, 1, 1, 384),
+        ('dw_7', 960, 960, 7, 3, 1, 1, 960),
+        ('pw_expand', 24, 144, 56, 1, 1, 0, 1),
+        ('pw_project', 576, 96, 14, 1, 1, 0, 1),
+    ],
+}
+
+ALGORITHMS = ['direct', 'pointwise', 'wino2x2', 'wino4x4']
+
+
+def measure(stmt, env, iters, repeat):
+    timer = timeit.Timer(stmt, globals=env)
+    timer.timeit(1)
+    return min(timer.repeat(repeat=repeat, number=iters)) / iters * 1e3
+
+
+def thnn_grouped(input, weight, bias, stride, padding, groups):
+    outputs = [torch._convolution_nogroup(i, w, b, [stride] * 2, [padding] * 2, [1, 1], False, [0, 0])
+               for i, w, b in zip(input.chunk(groups, 1), weight.chunk(groups, 0), bias.chunk(groups))]
+    return torch.cat(outputs, 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--layers', nargs='+', default=sorted(LAYERS), choices=sorted(LAYERS))
+    parser.add_argument('--batch', type=int, default=8)
+    parser.add_argument('--backward', action='store_true',
+                        help='time forward + backward instead of forward only')
+    parser.add_argument('--threads', type=int, default=None)
+    parser.add_argument('--iters', type=int, default=5)
+    parser.add_argument('--repeat', type=int, default=3)
+    args = parser.parse_args()
+
+    if args.threads is not None:
+        torch.set_num_threads(args.threads)
+
+    columns = ['auto'] + ALGORITHMS + ['thnn']
+    print(('{:<14}' + '{:>11}' * len(columns)).format('layer (ms)', *columns))
+    for group in args.layers:
+        for name, c, oc, size, k, stride, padding, groups in LAYERS[group]:
+            input = torch.randn(args.batch, c, size, size, requires_grad=args.backward)
+            weight = torch.randn(oc, c // groups, k, k, requires_grad=args.backward)
+            bias = torch.randn(oc, requires_grad=args.backward)
+            env = {'F': F, 'torch': torch, 'thnn_grouped': thnn_grouped, 'input': input,
+                   'weight': weight, 'bias': bias, 'stride': stride, 'padding': padding,
+                   'groups': groups}
+            stmts = ['F.conv2d(input, weight, bias, stride, padding, 1, groups)']
+            stmts += ['torch._cpu_conv2d(input, weight, bias, [padding] * 2, [stride] * 2, '
+                      '[1, 1], groups, {})'.format(algorithm)
+                      for algorithm in range(1, len(ALGORITHMS) + 1)]
+            stmts += ['thnn_grouped(input, weight, bias, stride, padding, groups)']
+            if args.backward:
+                stmts = ['{}.sum().backward()'.format(stmt) for stmt in stmts]
+            times = []
+            for stmt in stmts:
+                try:
+                    with torch.autograd.set_grad_enabled(args.backward):
+                        times.append(measure(stmt, env, args.iters, args.repeat))
+                except RuntimeError:
+                    times.append(float('nan'))
+            print(('{:<14}' + '{:>11.3f}' * len(times)).format(name, *times))
+
+
+if __name__ == '__main__':
+    main()
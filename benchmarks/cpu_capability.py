@@ -0,0 +1,101 @@
+"""Compare the ATen CPU kernels built for each CPU capability.
+
+The dispatch capability is chosen once per process, so every capability is
+measured in a fresh interpreter with ATEN_CPU_CAPABILITY set. Capabilities the
+machine does not support fall back to the best supported one, with a warning,
+so compare the rows for the capabilities your CPU actually has.
+
+    python benchmarks/cpu_capability.py --numel 1000000 --threads 1
+    python benchmarks/cpu_capability.py --dtypes float32 float16 bfloat16 \
+        --ops add mul sum exp sigmoid
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import timeit
+
+CAPABILITIES = ['default', 'avx', 'avx2', 'avx512']
+
+OPS = {
+    'add': 'x.add(y)',
+    'mul': 'x.mul(y)',
+    'sum': 'x.sum()',
+    'sum_dim': 'x.view(-1, 1000).sum(1)',
+    'norm': 'x.norm()',
+    'exp': 'x.exp()',
+    'log': 'x.log()',
+    'sigmoid': 'x.sigmoid()',
+    'tanh': 'x.tanh()',
+    'sqrt': 'x.sqrt()',
+    'softmax': 'x.view(-1, 1000).softmax(1)',
+}
+
+
+def run_worker(args):
+    import torch
+    torch.set_num_threads(args.threads)
+    results = {}
+    for dtype in args.dtypes:
+        # CPU float16/bfloat16 have no random number kernels, so convert
+        x = (torch.rand(args.numel) + 0.5).to(getattr(torch, dtype))
+        y = (torch.rand(args.numel) + 0.5).to(getattr(torch, dtype))
+        env = {'torch': torch, 'x': x, 'y': y}
+        for name in args.ops:
+            stmt = OPS[name]
+            timer = timeit.Timer(stmt, globals=env)
+            timer.timeit(args.warmup)
+            best = min(timer.repeat(repeat=args.repeat, number=args.iters))
+            results['{}/{}'.format(name, dtype)] = best / args.iters * 1e6
+    print(json.dumps(results))
+
+
+def run_capability(capability, argv):
+    env = dict(os.environ)
+    env['ATEN_CPU_CAPABILITY'] = capability
+    out = subprocess.check_output(
+        [sys.executable, __file__, '--worker'] + argv, env=env)
+    return json.loads(out.decode('utf-8').strip().splitlines()[-1])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--numel', type=int, default=1000000)
+    parser.add_argument('--threads', type=int, default=1)
+    parser.add_argument('--iters', type=int, default=20)
+    parser.add_argument('--repeat', type=int, default=5)
+    parser.add_argument('--warmup', type=int, default=5)
+    parser.add_argument('--ops', nargs='+', default=sorted(OPS),
+                        choices=sorted(OPS))
+    parser.add_argument('--dtypes', nargs='+', default=['float32', 'float64'])
+    parser.add_argument('--capabilities', nargs='+', default=CAPABILITIES,
+                        choices=CAPABILITIES)
+    parser.add_argument('--worker', action='store_true',
+                        help=argparse.SUPPRESS)
+    args, _ = parser.parse_known_args()
+
+    if args.worker:
+        run_worker(args)
+        return
+
+    argv = [a for a in sys.argv[1:] if a != '--worker']
+    results = {c: run_capability(c, argv) for c in args.capabilities}
+
+    keys = sorted(results[args.capabilities[0]])
+    header = '{:<20}'.format('op (us)') + ''.join(
+        '{:>12}'.format(c) for c in args.capabilities)
+    print(header)
+    print('-' * len(header))
+    for key in keys:
+        print('{:<20}'.format(key) + ''.join(
+            '{:>12.1f}'.format(results[c][key]) for c in args.capabilities))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,117 @@
+"""Time fused CPU kernels against the same graphs run op by op.
+
+Every row is a pointwise chain taken from a model tail (GELU, the affine
+part of LayerNorm, a LSTM-style gate, a clamped residual) or a normalization
+over rows of 1024 elements (softmax, log_softmax, layer_norm, a centered sum
+of squares). The fused column runs the scripted function with the CPU fuser
+enabled; the unfused column disables CPU fusion, so each fusion group falls
+back to running op by op. The eager column runs the function unscripted,
+which uses the native kernels of softmax, log_softmax and layer_norm.
+
+    python benchmarks/cpu_fuser.py --threads 1
+    python benchmarks/cpu_fuser.py --numel 65536 --transposed
+    python benchmarks/cpu_fuser.py --cases softmax layer_norm
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import timeit
+
+import torch
+
+
+ROW_SIZE = 1024
+
+
+def gelu(x):
+    return x * 0.5 * (1.0 + torch.tanh(0.7978845608 * (x + 0.044715 * x * x * x)))
+
+
+def layer_norm_tail(x, mean, rstd, weight):
+    return (x - mean) * rstd * weight + weight
+
+
+def gate(x, h):
+    return torch.sigmoid(x) * torch.tanh(h) + x
+
+
+def clamped_residual(x, h):
+    return torch.clamp(x + 2.0 * h, -1.0, 1.0) * x
+
+
+def softmax(x, mask):
+    return torch.softmax(x * 0.125 + mask, -1)
+
+
+def log_softmax(x):
+    return torch.log_softmax(x, -1)
+
+
+def layer_norm(x, weight, bias):
+    return torch.layer_norm(x, [1024], weight, bias, 1e-5, False)
+
+
+def centered_sum_of_squares(x):
+    centered = x - x.mean(-1, keepdim=True)
+    return (centered * centered).sum(-1)
+
+
+# name: (function, number of inputs of numel elements, number of inputs of
+# ROW_SIZE elements)
+CASES = {
+    'gelu': (gelu, 1, 0),
+    'layer_norm_tail': (layer_norm_tail, 4, 0),
+    'gate': (gate, 2, 0),
+    'clamped_residual': (clamped_residual, 2, 0),
+    'softmax': (softmax, 2, 0),
+    'log_softmax': (log_softmax, 1, 0),
+    'layer_norm': (layer_norm, 1, 2),
+    'centered_sum_of_squares': (centered_sum_of_squares, 1, 0),
+}
+
+
+def measure(stmt, env, iters, repeat):
+    timer = timeit.Timer(stmt, globals=env)
+    timer.timeit(1)
+    return min(timer.repeat(repeat=repeat, number=iters)) / iters * 1e3
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--cases', nargs='+', default=sorted(CASES), choices=sorted(CASES))
+    parser.add_argument('--numel', type=int, default=1 << 22)
+    parser.add_argument('--transposed', action='store_true',
+                        help='use transposed inputs (the strided code path)')
+    parser.add_argument('--threads', type=int, default=None)
+    parser.add_argument('--iters', type=int, default=20)
+    parser.add_argument('--repeat', type=int, default=3)
+    args = parser.parse_args()
+
+    if args.threads is not None:
+        torch.set_num_threads(args.threads)
+
+    rows = args.numel // ROW_SIZE
+    print('{:<26}{:>14}{:>14}{:>14}{:>10}'.format('case', 'fused (ms)', 'unfused (ms)', 'eager (ms)', 'speedup'))
+    for name in args.cases:
+        fn, nargs, nvectors = CASES[name]
+        inputs = [torch.randn(rows, ROW_SIZE) for _ in range(nargs)]
+        if args.transposed:
+            # same sizes, transposed layout
+            inputs = [t.t().contiguous().t() for t in inputs]
+        inputs += [torch.randn(ROW_SIZE) for _ in range(nvectors)]
+        env = {'fn': fn, 'script_fn': torch.jit.script(fn), 'inputs': inputs}
+        times = []
+        for fuse in (True, False):
+            torch._C._jit_override_can_fuse_on_cpu(fuse)
+            times.append(measure('script_fn(*inputs)', env, args.iters, args.repeat))
+        torch._C._jit_override_can_fuse_on_cpu(False)
+        times.append(measure('fn(*inputs)', env, args.iters, args.repeat))
+        print('{:<26}{:>14.3f}{:>14.3f}{:>14.3f}{:>10.2f}'.format(
+            name, times[0], times[1], times[2], min(times[1:]) / times[0]))
+
+
+if __name__ == '__main__':
+    main()
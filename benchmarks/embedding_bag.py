@@ -0,0 +1,82 @@
+"""Time CPU EmbeddingBag forward and backward, and rowwise quantized lookups.
+
+Every configuration looks up --batch bags of --bag-size random indices in a
+(num_embeddings, dim) table. The quantized columns time
+torch.fused_rowwise_embedding_bag on 8-bit and 4-bit copies of the table.
+
+    python benchmarks/embedding_bag.py --num-embeddings 1000000 \
+        --dims 32 64 128 --bag-sizes 20 80
+    python benchmarks/embedding_bag.py --modes sum --per-sample-weights --threads 1
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import timeit
+
+import torch
+import torch.nn.functional as F
+
+
+def measure(stmt, env, iters, repeat):
+    timer = timeit.Timer(stmt, globals=env)
+    timer.timeit(1)
+    return min(timer.repeat(repeat=repeat, number=iters)) / iters * 1e3
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--num-embeddings', type=int, default=100000)
+    parser.add_argument('--dims', type=int, nargs='+', default=[16, 64, 256])
+    parser.add_argument('--batch', type=int, default=512)
+    parser.add_argument('--bag-sizes', type=int, nargs='+', default=[1, 20, 100])
+    parser.add_argument('--modes', nargs='+', default=['sum', 'mean', 'max'])
+    parser.add_argument('--per-sample-weights', action='store_true')
+    parser.add_argument('--threads', type=int, default=None)
+    parser.add_argument('--iters', type=int, default=10)
+    parser.add_argument('--repeat', type=int, default=3)
+    args = parser.parse_args()
+
+    if args.threads is not None:
+        torch.set_num_threads(args.threads)
+
+    print('{:<6}{:>6}{:>6}{:>14}{:>14}{:>14}{:>14}'.format(
+        'mode', 'dim', 'bag', 'fwd (ms)', 'bwd (ms)', '8-bit (ms)', '4-bit (ms)'))
+    for dim in args.dims:
+        weight = torch.randn(args.num_embeddings, dim, requires_grad=True)
+        packed8 = torch.fused_rowwise_quantize(weight.detach(), 8)
+        packed4 = torch.fused_rowwise_quantize(weight.detach(), 4)
+        for bag_size in args.bag_sizes:
+            input = torch.randint(args.num_embeddings, (args.batch * bag_size,), dtype=torch.long)
+            offsets = torch.arange(0, input.numel(), bag_size, dtype=torch.long)
+            for mode in args.modes:
+                psw = None
+                if args.per_sample_weights and mode == 'sum':
+                    psw = torch.rand(input.numel())
+                env = {'F': F, 'torch': torch, 'weight': weight, 'input': input,
+                       'offsets': offsets, 'mode': mode, 'psw': psw,
+                       'packed8': packed8, 'packed4': packed4,
+                       'mode_enum': ['sum', 'mean', 'max'].index(mode)}
+                with torch.no_grad():
+                    fwd_ms = measure('F.embedding_bag(input, weight, offsets, mode=mode, '
+                                     'per_sample_weights=psw)', env, args.iters, args.repeat)
+                env['out'] = F.embedding_bag(input, weight, offsets, mode=mode,
+                                             per_sample_weights=psw)
+                env['grad'] = torch.randn_like(env['out'])
+                bwd_ms = measure('out.backward(grad, retain_graph=True)',
+                                 env, args.iters, args.repeat)
+                weight.grad = None
+                q8_ms = q4_ms = float('nan')
+                if mode != 'max':
+                    q8_ms = measure('torch.fused_rowwise_embedding_bag(packed8, input, offsets, '
+                                    '8, mode_enum, psw)', env, args.iters, args.repeat)
+                    q4_ms = measure('torch.fused_rowwise_embedding_bag(packed4, input, offsets, '
+                                    '4, mode_enum, psw)', env, args.iters, args.repeat)
+                print('{:<6}{:>6}{:>6}{:>14.3f}{:>14.3f}{:>14.3f}{:>14.3f}'.format(
+                    mode, dim, bag_size, fwd_ms, bwd_ms, q8_ms, q4_ms))
+
+
+if __name__ == '__main__':
+    main()
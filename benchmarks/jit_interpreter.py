@@ -0,0 +1,110 @@
+"""Time the per-instruction overhead of the JIT interpreter.
+
+Runs script functions whose loop bodies are made of scalar math, list
+construction and small tensor ops, and reports the time per node executed,
+which for the scalar ones is almost all interpreter overhead.
+
+    python benchmarks/jit_interpreter.py --trip-count 10000
+    python benchmarks/jit_interpreter.py --cases int_math tensor_math
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import timeit
+
+import torch
+
+
+@torch.jit.script
+def int_math(n):
+    # type: (int) -> int
+    a = 0
+    b = 1
+    for i in range(n):
+        c = a + b * 2 - i
+        if c > 1000:
+            c = c - 1000
+        a = b
+        b = c
+    return a
+
+
+@torch.jit.script
+def float_math(n):
+    # type: (int) -> float
+    x = 0.0
+    y = 1.5
+    for _ in range(n):
+        x = x * 0.5 + y
+        if x > y:
+            y = y - 0.25
+        else:
+            y = y + 0.25
+    return x
+
+
+@torch.jit.script
+def list_construct(n):
+    # type: (int) -> int
+    total = 0
+    for i in range(n):
+        sizes = [i, i + 1, i + 2]
+        total = total + len(sizes)
+    return total
+
+
+@torch.jit.script
+def tensor_math(x, n):
+    # type: (Tensor, int) -> Tensor
+    for _ in range(n):
+        x = x * 0.5 + 1
+    return x
+
+
+CASES = {
+    'int_math': lambda n: (int_math, (n,)),
+    'float_math': lambda n: (float_math, (n,)),
+    'list_construct': lambda n: (list_construct, (n,)),
+    'tensor_math': lambda n: (tensor_math, (torch.ones(1), n)),
+}
+
+
+def count_nodes(block):
+    return sum(1 + sum(count_nodes(b) for b in node.blocks()) for node in block.nodes())
+
+
+def loop_body_nodes(fn):
+    loops = [node for node in fn.graph.nodes() if node.kind() == 'prim::Loop']
+    assert len(loops) == 1
+    return count_nodes(next(loops[0].blocks()))
+
+
+def measure(fn, args, iters, repeat):
+    timer = timeit.Timer(lambda: fn(*args))
+    timer.timeit(1)
+    return min(timer.repeat(repeat=repeat, number=iters)) / iters
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--cases', nargs='+', default=sorted(CASES), choices=sorted(CASES))
+    parser.add_argument('--trip-count', type=int, default=10000)
+    parser.add_argument('--iters', type=int, default=10)
+    parser.add_argument('--repeat', type=int, default=3)
+    args = parser.parse_args()
+
+    print('{:<16}{:>12}{:>14}{:>14}'.format('case', 'body nodes', 'run (ms)', 'ns / node'))
+    with torch.no_grad():
+        for name in args.cases:
+            fn, fn_args = CASES[name](args.trip_count)
+            seconds = measure(fn, fn_args, args.iters, args.repeat)
+            nodes = loop_body_nodes(fn) * args.trip_count
+            print('{:<16}{:>12}{:>14.3f}{:>14.1f}'.format(
+                name, loop_body_nodes(fn), seconds * 1e3, seconds / nodes * 1e9))
+
+
+if __name__ == '__main__':
+    main()
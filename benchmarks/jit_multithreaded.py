@@ -0,0 +1,86 @@
+"""Measure how the throughput of one script module scales with threads.
+
+Serves a small scripted MLP from 1, 2, 4, ... threads that all call the same
+module, the way a server runs requests, and reports the calls per second and
+the speedup over one thread. Intra-op parallelism is disabled, so the
+speedup shows how much the threads wait for each other in the graph
+executor and the interpreter. The GIL is released while the graph runs, but
+the per-call Python overhead still bounds the scaling of tiny models; use
+--hidden to make each call do more work.
+
+    python benchmarks/jit_multithreaded.py --threads 1 2 4 8 16 32
+    python benchmarks/jit_multithreaded.py --hidden 1024 --batch 8
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import threading
+import time
+
+import torch
+
+
+class MLP(torch.jit.ScriptModule):
+    def __init__(self, hidden):
+        super(MLP, self).__init__()
+        self.w0 = torch.nn.Parameter(torch.randn(hidden, hidden) / hidden ** 0.5)
+        self.w1 = torch.nn.Parameter(torch.randn(hidden, hidden) / hidden ** 0.5)
+        self.w2 = torch.nn.Parameter(torch.randn(hidden, hidden) / hidden ** 0.5)
+
+    @torch.jit.script_method
+    def forward(self, x):
+        x = torch.relu(torch.mm(x, self.w0))
+        x = torch.relu(torch.mm(x, self.w1))
+        return torch.sigmoid(torch.mm(x, self.w2))
+
+
+def worker(module, x, calls, go, times, index):
+    with torch.no_grad():
+        go.wait()
+        start = time.time()
+        for _ in range(calls):
+            module(x)
+        times[index] = time.time() - start
+
+
+def throughput(module, x, threads, calls):
+    go = threading.Event()
+    times = [0.0] * threads
+    workers = [threading.Thread(target=worker, args=(module, x, calls, go, times, i))
+               for i in range(threads)]
+    for w in workers:
+        w.start()
+    go.set()
+    for w in workers:
+        w.join()
+    return threads * calls / max(times)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--threads', type=int, nargs='+', default=[1, 2, 4, 8, 16, 32])
+    parser.add_argument('--hidden', type=int, default=256)
+    parser.add_argument('--batch', type=int, default=1)
+    parser.add_argument('--calls', type=int, default=2000)
+    args = parser.parse_args()
+
+    torch.set_num_threads(1)
+    module = MLP(args.hidden)
+    x = torch.randn(args.batch, args.hidden)
+    # compile the plan before timing
+    with torch.no_grad():
+        module(x)
+
+    print('{:>8}{:>14}{:>10}'.format('threads', 'calls / s', 'speedup'))
+    base = None
+    for threads in args.threads:
+        rate = throughput(module, x, threads, args.calls)
+        base = base or rate
+        print('{:>8}{:>14.0f}{:>10.2f}'.format(threads, rate, rate / base))
+
+
+if __name__ == '__main__':
+    main()
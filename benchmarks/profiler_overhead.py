@@ -0,0 +1,71 @@
+"""Measure the overhead of the sampling profiler on small operations.
+
+Times a loop of small CPU ops, the worst case for a profiler since every op
+does little work, with the sampling profiler off and with it recording one
+in N top-level ops (see torch.autograd.profiler.sampling_profile), with and
+without input shapes and memory events, and reports the time per op and the
+overhead over the run without the profiler. The "never" row records memory
+events with a period longer than the run, so it measures what the memory
+observer costs the allocations and frees of ops that are not sampled.
+
+    python benchmarks/profiler_overhead.py --periods 1 10 100 1000
+    python benchmarks/profiler_overhead.py --size 64 --ops 20000
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import time
+
+import torch
+from torch.autograd.profiler import sampling_profile
+
+
+def measure(x, ops, repeat):
+    best = float('inf')
+    for _ in range(repeat):
+        start = time.time()
+        for _ in range(ops // 2):
+            y = x.add(1)
+            y.mul_(2)
+        best = min(best, (time.time() - start) / ops)
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--periods', type=int, nargs='+', default=[1, 10, 100, 1000])
+    parser.add_argument('--size', type=int, default=16)
+    parser.add_argument('--ops', type=int, default=100000)
+    parser.add_argument('--repeat', type=int, default=5)
+    args = parser.parse_args()
+
+    torch.set_num_threads(1)
+    x = torch.randn(args.size, args.size)
+    measure(x, args.ops, 1)
+
+    print('{:<10}{:>8}{:>8}{:>10}{:>14}{:>12}'.format(
+        'period', 'shapes', 'memory', 'ops', 'op (us)', 'overhead'))
+    base = measure(x, args.ops, args.repeat)
+    print('{:<10}{:>8}{:>8}{:>10}{:>14.3f}{:>12}'.format('off', '-', '-', args.ops, base * 1e6, '-'))
+    for period in args.periods:
+        for shapes, memory in [(False, False), (True, False), (True, True)]:
+            sampling_profile.reset()
+            with sampling_profile(sample_period=period, record_shapes=shapes, record_memory=memory):
+                seconds = measure(x, args.ops, args.repeat)
+            print('{:<10}{:>8}{:>8}{:>10}{:>14.3f}{:>11.1f}%'.format(
+                period, 'yes' if shapes else 'no', 'yes' if memory else 'no', args.ops,
+                seconds * 1e6, (seconds / base - 1) * 100))
+    sampling_profile.reset()
+    with sampling_profile(sample_period=args.ops * args.repeat + 1, record_shapes=False,
+                          record_memory=True):
+        seconds = measure(x, args.ops, args.repeat)
+    print('{:<10}{:>8}{:>8}{:>10}{:>14.3f}{:>11.1f}%'.format(
+        'never', 'no', 'yes', args.ops, seconds * 1e6, (seconds / base - 1) * 100))
+    sampling_profile.reset()
+
+
+if __name__ == '__main__':
+    main()
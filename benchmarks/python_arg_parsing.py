@@ -0,0 +1,76 @@
+"""Measure the per-call overhead of common torch functions and Tensor methods.
+
+Calls each op on tensors of a few elements in a loop, so that the time is
+spent parsing the Python arguments, picking the signature among the
+overloads (see PythonArgParser in torch/csrc/utils/python_arg_parser.cpp),
+and dispatching, rather than computing, and reports the best time per call
+of several runs. Run it before and after a change to the binding code to
+see its effect on eager-mode models made of many small ops.
+
+    python benchmarks/python_arg_parsing.py
+    python benchmarks/python_arg_parsing.py --calls 100000 --ops add view
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import time
+from collections import OrderedDict
+
+import torch
+
+
+def make_ops():
+    x = torch.randn(2, 3)
+    y = torch.randn(2, 3)
+    index = torch.tensor([1, 0])
+    zero_dim = torch.tensor(2.)
+    return OrderedDict([
+        ('add', lambda: torch.add(x, y)),
+        ('add_method', lambda: x.add(y)),
+        ('add_scalar', lambda: x.add(1)),
+        ('add_alpha', lambda: x.add(y, alpha=2)),
+        ('add_deprecated', lambda: x.add(zero_dim, y)),
+        ('max_dim', lambda: torch.max(x, 1)),
+        ('max_other', lambda: torch.max(x, y)),
+        ('view', lambda: x.view(3, 2)),
+        ('view_tuple', lambda: x.view((3, 2))),
+        ('index_int', lambda: x[1]),
+        ('index_slice', lambda: x[:, 1:]),
+        ('index_tensor', lambda: x[index]),
+        ('cat', lambda: torch.cat([x, y])),
+        ('cat_dim', lambda: torch.cat((x, y), dim=1)),
+    ])
+
+
+def measure(op, calls, repeat):
+    best = float('inf')
+    for _ in range(repeat):
+        start = time.time()
+        for _ in range(calls):
+            op()
+        best = min(best, (time.time() - start) / calls)
+    return best
+
+
+def main():
+    ops = make_ops()
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--ops', nargs='+', choices=list(ops.keys()), default=list(ops.keys()))
+    parser.add_argument('--calls', type=int, default=20000)
+    parser.add_argument('--repeat', type=int, default=5)
+    args = parser.parse_args()
+
+    torch.set_num_threads(1)
+    print('{:<16}{:>12}'.format('op', 'call (us)'))
+    for name in args.ops:
+        op = ops[name]
+        measure(op, args.calls // 10 or 1, 1)
+        seconds = measure(op, args.calls, args.repeat)
+        print('{:<16}{:>12.3f}'.format(name, seconds * 1e6))
+
+
+if __name__ == '__main__':
+    main()
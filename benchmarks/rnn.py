@@ -0,0 +1,57 @@
+"""Time CPU LSTM and GRU layers, forward and forward + backward.
+
+    python benchmarks/rnn.py --seq-len 100 --batch 1 --hidden 512 --threads 1
+    python benchmarks/rnn.py --modules lstm --layers 2 --bidirectional
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import timeit
+
+import torch
+import torch.nn as nn
+
+MODULES = {'lstm': nn.LSTM, 'gru': nn.GRU}
+
+
+def measure(stmt, env, iters, repeat):
+    timer = timeit.Timer(stmt, globals=env)
+    timer.timeit(1)
+    return min(timer.repeat(repeat=repeat, number=iters)) / iters * 1e3
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--modules', nargs='+', default=sorted(MODULES), choices=sorted(MODULES))
+    parser.add_argument('--seq-len', type=int, default=50)
+    parser.add_argument('--batches', type=int, nargs='+', default=[1, 16, 64])
+    parser.add_argument('--input', type=int, default=256)
+    parser.add_argument('--hidden', type=int, default=256)
+    parser.add_argument('--layers', type=int, default=1)
+    parser.add_argument('--bidirectional', action='store_true')
+    parser.add_argument('--threads', type=int, default=None)
+    parser.add_argument('--iters', type=int, default=10)
+    parser.add_argument('--repeat', type=int, default=3)
+    args = parser.parse_args()
+
+    if args.threads is not None:
+        torch.set_num_threads(args.threads)
+
+    print('{:<6}{:>8}{:>14}{:>14}'.format('module', 'batch', 'fwd (ms)', 'fwd+bwd (ms)'))
+    for name in args.modules:
+        rnn = MODULES[name](args.input, args.hidden, num_layers=args.layers,
+                            bidirectional=args.bidirectional)
+        for batch in args.batches:
+            input = torch.randn(args.seq_len, batch, args.input, requires_grad=True)
+            env = {'torch': torch, 'rnn': rnn, 'input': input}
+            with torch.no_grad():
+                fwd_ms = measure('rnn(input)', env, args.iters, args.repeat)
+            bwd_ms = measure('rnn(input)[0].sum().backward()', env, args.iters, args.repeat)
+            print('{:<6}{:>8}{:>14.3f}{:>14.3f}'.format(name, batch, fwd_ms, bwd_ms))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,73 @@
+"""Time CPU sort, topk and kthvalue over a sweep of slice sizes and k.
+
+Each configuration sorts or selects along the last dimension of a
+(batch, size) tensor, or along the first dimension with --transposed, which
+exercises the strided path.
+
+    python benchmarks/sort_topk.py --batch 256 --sizes 1000 100000 1000000 \
+        --ks 1 10 100 1000
+    python benchmarks/sort_topk.py --dtypes float32 int64 --threads 1
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import timeit
+
+import torch
+
+
+def make_input(batch, size, dtype, transposed):
+    if dtype.is_floating_point:
+        x = torch.randn(batch, size, dtype=dtype)
+    else:
+        x = torch.randint(-2 ** 20, 2 ** 20, (batch, size), dtype=dtype)
+    if transposed:
+        x = x.t().contiguous().t()
+    return x
+
+
+def measure(stmt, env, iters, repeat):
+    timer = timeit.Timer(stmt, globals=env)
+    timer.timeit(1)
+    return min(timer.repeat(repeat=repeat, number=iters)) / iters * 1e3
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--batch', type=int, default=64)
+    parser.add_argument('--sizes', type=int, nargs='+',
+                        default=[100, 10000, 1000000])
+    parser.add_argument('--ks', type=int, nargs='+', default=[1, 10, 100, 1000])
+    parser.add_argument('--dtypes', nargs='+', default=['float32'])
+    parser.add_argument('--threads', type=int, default=None)
+    parser.add_argument('--transposed', action='store_true')
+    parser.add_argument('--iters', type=int, default=3)
+    parser.add_argument('--repeat', type=int, default=3)
+    args = parser.parse_args()
+
+    if args.threads is not None:
+        torch.set_num_threads(args.threads)
+
+    print('{:<10}{:>10}{:>8}{:>14}{:>14}{:>14}'.format(
+        'dtype', 'size', 'k', 'sort (ms)', 'topk (ms)', 'kthvalue (ms)'))
+    for dtype_name in args.dtypes:
+        dtype = getattr(torch, dtype_name)
+        for size in args.sizes:
+            x = make_input(args.batch, size, dtype, args.transposed)
+            env = {'x': x}
+            sort_ms = measure('x.sort(1)', env, args.iters, args.repeat)
+            for k in args.ks:
+                if k > size:
+                    continue
+                env['k'] = k
+                topk_ms = measure('x.topk(k, 1)', env, args.iters, args.repeat)
+                kth_ms = measure('x.kthvalue(k, 1)', env, args.iters, args.repeat)
+                print('{:<10}{:>10}{:>8}{:>14.3f}{:>14.3f}{:>14.3f}'.format(
+                    dtype_name, size, k, sort_ms, topk_ms, kth_ms))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,75 @@
+"""Time element-wise ops and copies between tensors with different layouts.
+
+Every row compares an op on operands that disagree on their fastest moving
+dimension (which TensorIterator iterates in tiles) with the same op on
+contiguous operands, and reports the effective bandwidth of both.
+
+    python benchmarks/tensor_iterator_tiling.py --threads 1
+    python benchmarks/tensor_iterator_tiling.py --size 4096 --dtype double
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import timeit
+
+import torch
+
+DTYPES = {'float': torch.float, 'double': torch.double, 'uint8': torch.uint8}
+
+
+def measure(stmt, env, iters, repeat):
+    timer = timeit.Timer(stmt, globals=env)
+    timer.timeit(1)
+    return min(timer.repeat(repeat=repeat, number=iters)) / iters * 1e3
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--size', type=int, default=2048)
+    parser.add_argument('--channels', type=int, default=64)
+    parser.add_argument('--batch', type=int, default=8)
+    parser.add_argument('--dtype', default='float', choices=sorted(DTYPES))
+    parser.add_argument('--threads', type=int, default=None)
+    parser.add_argument('--iters', type=int, default=10)
+    parser.add_argument('--repeat', type=int, default=3)
+    args = parser.parse_args()
+
+    if args.threads is not None:
+        torch.set_num_threads(args.threads)
+
+    dtype = DTYPES[args.dtype]
+    n = args.size
+    a = torch.ones(n, n, dtype=dtype)
+    b = torch.ones(n, n, dtype=dtype)
+    out = torch.empty(n, n, dtype=dtype)
+    x = torch.ones(args.batch, args.channels, 56, 56, dtype=dtype)
+    nhwc = torch.empty(args.batch, 56, 56, args.channels, dtype=dtype).permute(0, 3, 1, 2)
+    nchw = torch.empty_like(x)
+    env = {'torch': torch, 'a': a, 'b': b, 'out': out, 'x': x, 'nhwc': nhwc, 'nchw': nchw}
+
+    # (name, mixed-layout statement, contiguous statement, bytes moved)
+    cases = [
+        ('add a + b.t()', 'torch.add(a, b.t(), out=out)', 'torch.add(a, b, out=out)',
+         3 * a.numel() * a.element_size()),
+        ('copy a.t()', 'out.copy_(a.t())', 'out.copy_(a)',
+         2 * a.numel() * a.element_size()),
+        ('copy NCHW->NHWC', 'nhwc.copy_(x)', 'nchw.copy_(x)',
+         2 * x.numel() * x.element_size()),
+        ('copy NHWC->NCHW', 'nchw.copy_(nhwc)', 'nchw.copy_(x)',
+         2 * x.numel() * x.element_size()),
+    ]
+
+    print('{:<18}{:>12}{:>12}{:>12}{:>12}'.format(
+        'op', 'mixed (ms)', 'GB/s', 'contig (ms)', 'GB/s'))
+    for name, mixed, contig, nbytes in cases:
+        mixed_ms = measure(mixed, env, args.iters, args.repeat)
+        contig_ms = measure(contig, env, args.iters, args.repeat)
+        print('{:<18}{:>12.3f}{:>12.2f}{:>12.3f}{:>12.2f}'.format(
+            name, mixed_ms, nbytes / mixed_ms / 1e6, contig_ms, nbytes / contig_ms / 1e6))
+
+
+if __name__ == '__main__':
+    main()
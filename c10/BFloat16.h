@@ -0,0 +1,65 @@
+#pragma once
+
+/// Defines the BFloat16 type (brain floating-point). It has the same exponent
+/// range as float32 with only 8 bits of precision, which makes it a cheap
+/// storage format for activations and weights: converting to and from float
+/// is a 16-bit shift. As with Half, arithmetic is implemented by converting to
+/// float32, performing the operation there and rounding the result back to
+/// nearest even.
+
+#include <c10/Half.h>
+#include <c10/core/bitcasts.h>
+#include <c10/macros/Macros.h>
+
+#include <cmath>
+#include <cstdint>
+#include <iosfwd>
+#include <limits>
+
+namespace c10 {
+
+namespace detail {
+
+  /*
+   * Convert a 32-bit floating-point number in IEEE single-precision format to
+   * a bfloat16 number, in bit representation, rounding to nearest even. NaNs
+   * are kept quiet (the truncated payload could otherwise turn into an
+   * infinity).
+   */
+  static inline uint16_t bf16_from_fp32_value(float f) {
+    const uint32_t w = fp32_to_bits(f);
+    if ((w & UINT32_C(0x7FFFFFFF)) > UINT32_C(0x7F800000)) {
+      return static_cast<uint16_t>((w >> 16) | UINT32_C(0x0040));
+    }
+    const uint32_t rounding_bias = UINT32_C(0x7FFF) + ((w >> 16) & 1);
+    return static_cast<uint16_t>((w + rounding_bias) >> 16);
+  }
+
+  /*
+   * Convert a bfloat16 number, in bit representation, to a 32-bit
+   * floating-point number in IEEE single-precision format. This is exact.
+   */
+  static inline float bf16_to_fp32_value(uint16_t b) {
+    return fp32_from_bits(static_cast<uint32_t>(b) << 16);
+  }
+
+} // namespace detail
+
+struct alignas(2) BFloat16 {
+  uint16_t x;
+
+  struct from_bits_t {};
+  static constexpr from_bits_t from_bits = from_bits_t();
+
+  BFloat16() = default;
+
+  constexpr BFloat16(uint16_t bits, from_bits_t) : x(bits){};
+  inline BFloat16(float value);
+  inline operator float() const;
+};
+
+C10_API std::ostream& operator<<(std::ostream& out, const BFloat16& value);
+
+} // namespace c10
+
+#include "c10/BFloat16-inl.h"
@@ -1,7 +1,19 @@
 #include <c10/core/Allocator.h>
 
+#include <atomic>
+
 namespace c10 {
 
+static std::atomic<MemoryObserver*> memory_observer{nullptr};
+
+void setMemoryObserver(MemoryObserver* observer) {
+  memory_observer.store(observer);
+}
+
+MemoryObserver* getMemoryObserver() {
+  return memory_observer.load(std::memory_order_acquire);
+}
+
 static void deleteInefficientStdFunctionContext(void* ptr) {
   delete static_cast<InefficientStdFunctionContext*>(ptr);
 }
@@ -121,6 +121,33 @@ struct Allocator {
   }
 };
 
+// Receives the allocations and frees of the CPU allocators of ATen, e.g. so
+// that the profiler can tie memory to the op that is running. It is called on
+// the thread that allocates or frees, for every block, so it must be cheap.
+struct C10_API MemoryObserver {
+  virtual ~MemoryObserver() = default;
+  virtual void allocated(void* ptr, size_t nbytes, Device device) = 0;
+  virtual void freed(void* ptr, Device device) = 0;
+};
+
+// Sets the observer, or removes it if observer is nullptr. An observer that
+// was set can still be called by allocators racing with its removal, so it
+// must live as long as the process.
+C10_API void setMemoryObserver(MemoryObserver* observer);
+C10_API MemoryObserver* getMemoryObserver();
+
+inline void reportAllocation(void* ptr, size_t nbytes, Device device) {
+  if (auto* observer = getMemoryObserver()) {
+    observer->allocated(ptr, nbytes, device);
+  }
+}
+
+inline void reportFree(void* ptr, Device device) {
+  if (auto* observer = getMemoryObserver()) {
+    observer->freed(ptr, device);
+  }
+}
+
 // Question: is this still needed?
 struct C10_API InefficientStdFunctionContext {
   std::unique_ptr<void, std::function<void(void*)>> ptr_;
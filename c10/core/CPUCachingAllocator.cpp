@@ -0,0 +1,592 @@
+#include <c10/core/CPUCachingAllocator.h>
+
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace c10 {
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+// Every block starts with a header describing it, so the data pointer doubles
+// as the deleter context and freeing needs no lookup table.
+constexpr size_t kHeaderSize = kAlignment;
+constexpr size_t kMinBlockSize = 64;
+constexpr size_t kHugePageSize = 2 << 20;
+// Upper bound on the bytes cached by a single thread.
+constexpr size_t kThreadCacheMaxBytes = 64 << 20;
+// Room under the cap on cached bytes that a thread cache reserves at a time.
+constexpr size_t kReserveChunk = 4 << 20;
+// Change in a thread's allocated bytes after which it is published to the
+// global count.
+constexpr int64_t kAllocatedPublishBytes = 64 << 10;
+
+struct Block {
+  size_t size;  // size class, excluding the header
+  bool mapped;  // obtained from mmap rather than posix_memalign
+};
+static_assert(sizeof(Block) <= kHeaderSize, "block header does not fit");
+
+// Whether a block of `total` bytes, header included, gets its own huge pages.
+inline bool is_huge(size_t total) {
+  return total >= kHugePageSize;
+}
+
+// Length of the mapping backing a huge block of `total` bytes.
+inline size_t huge_mapping_size(size_t total) {
+  return (total + kHugePageSize - 1) & ~(kHugePageSize - 1);
+}
+
+inline void* block_data(Block* block) {
+  return reinterpret_cast<char*>(block) + kHeaderSize;
+}
+
+inline Block* data_block(void* ptr) {
+  return reinterpret_cast<Block*>(static_cast<char*>(ptr) - kHeaderSize);
+}
+
+inline size_t highest_bit(size_t n) {
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll(static_cast<unsigned long long>(n));
+#else
+  size_t bit = 0;
+  while (n >>= 1) {
+    ++bit;
+  }
+  return bit;
+#endif
+}
+
+#ifndef _WIN32
+// Maps `size` bytes (a multiple of kHugePageSize) starting on a huge page
+// boundary, so that transparent huge pages can back the whole block.
+void* map_huge_pages(size_t size) {
+  size_t length = size + kHugePageSize;
+  void* raw = mmap(
+      nullptr,
+      length,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+  uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+  uintptr_t aligned = (begin + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  size_t head = aligned - begin;
+  if (head > 0) {
+    munmap(raw, head);
+  }
+  if (kHugePageSize - head > 0) {
+    munmap(reinterpret_cast<void*>(aligned + size), kHugePageSize - head);
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+#endif
+  return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+Block* system_alloc(size_t size) {
+  size_t total = size + kHeaderSize;
+  void* base = nullptr;
+  bool mapped = false;
+#ifdef _WIN32
+  base = _aligned_malloc(total, kAlignment);
+#else
+  if (is_huge(total)) {
+    base = map_huge_pages(huge_mapping_size(total));
+    mapped = base != nullptr;
+  }
+  if (!base && posix_memalign(&base, kAlignment, total) != 0) {
+    base = nullptr;
+  }
+#endif
+  if (!base) {
+    return nullptr;
+  }
+  Block* block = static_cast<Block*>(base);
+  block->size = size;
+  block->mapped = mapped;
+  return block;
+}
+
+void system_free(Block* block) {
+#ifdef _WIN32
+  _aligned_free(block);
+#else
+  if (block->mapped) {
+    munmap(block, huge_mapping_size(block->size + kHeaderSize));
+  } else {
+    free(block);
+  }
+#endif
+}
+
+// Free blocks keyed by size class.
+using FreeLists = std::unordered_map<size_t, std::vector<Block*>>;
+
+Block* pop_block(FreeLists& lists, size_t size) {
+  auto it = lists.find(size);
+  if (it == lists.end() || it->second.empty()) {
+    return nullptr;
+  }
+  Block* block = it->second.back();
+  it->second.pop_back();
+  return block;
+}
+
+void take_blocks(FreeLists& lists, std::vector<Block*>& out) {
+  for (auto& entry : lists) {
+    out.insert(out.end(), entry.second.begin(), entry.second.end());
+  }
+  lists.clear();
+}
+
+// Adds to a counter that only its own thread writes, so that it takes no
+// locked instruction. Other threads only read it.
+template <typename T>
+inline void add_owned(std::atomic<T>& counter, T delta) {
+  counter.store(
+      counter.load(std::memory_order_relaxed) + delta,
+      std::memory_order_relaxed);
+}
+
+struct ThreadCache {
+  // Only ever contended by empty_cache() and get_stats() running on another
+  // thread.
+  std::mutex mutex;
+  FreeLists blocks;
+  size_t cached_bytes = 0;
+  // Room reserved under the cap on cached bytes, at least cached_bytes.
+  size_t reserved_bytes = 0;
+
+  // Statistics of this thread's allocations and frees, summed by get_stats().
+  // allocated_bytes is the change not yet published to the global count; it
+  // is negative when the thread freed more than it allocated.
+  std::atomic<int64_t> allocated_bytes{0};
+  std::atomic<uint64_t> cache_hits{0};
+  std::atomic<uint64_t> system_allocations{0};
+  std::atomic<uint64_t> system_frees{0};
+};
+
+bool enabled_from_env() {
+  const char* env = std::getenv("ATEN_CPU_CACHING_ALLOCATOR");
+  return env && *env && std::strcmp(env, "0") != 0;
+}
+
+struct CachingAllocatorState {
+  std::atomic<bool> enabled{enabled_from_env()};
+  std::atomic<size_t> max_cached_bytes{std::numeric_limits<size_t>::max()};
+
+  // Bytes reserved under max_cached_bytes: the blocks in the global pool and
+  // the reservations of the thread caches.
+  std::atomic<uint64_t> reserved_bytes{0};
+
+  // Statistics that aren't kept by a thread cache: the allocated bytes the
+  // threads published, and the counts of exited threads, of threads being
+  // torn down and of empty_cache().
+  std::atomic<int64_t> allocated_bytes{0};
+  std::atomic<uint64_t> peak_allocated_bytes{0};
+  std::atomic<uint64_t> system_allocations{0};
+  std::atomic<uint64_t> system_frees{0};
+  std::atomic<uint64_t> cache_hits{0};
+
+  // Guards `blocks`, `cached_bytes` and `thread_caches`. When both are needed
+  // it is taken before a thread cache's mutex.
+  std::mutex mutex;
+  FreeLists blocks;
+  size_t cached_bytes = 0;
+  std::vector<ThreadCache*> thread_caches;
+
+  Block* malloc(size_t size);
+  void free(Block* block);
+  void empty_cache();
+  void release_reservations();
+  void register_thread_cache(ThreadCache* cache);
+  void release_thread_cache(ThreadCache* cache);
+  CPUCachingAllocatorStats get_stats();
+
+ private:
+  bool capped() const {
+    return max_cached_bytes.load() != std::numeric_limits<size_t>::max();
+  }
+
+  bool reserve_cached(size_t size) {
+    uint64_t cached = reserved_bytes.fetch_add(size) + size;
+    if (cached > max_cached_bytes.load()) {
+      reserved_bytes.fetch_sub(size);
+      return false;
+    }
+    return true;
+  }
+
+  // Makes room for size more bytes in a thread cache, whose mutex is held.
+  // Without a cap, reserves kReserveChunk ahead so that most frees don't
+  // touch reserved_bytes.
+  bool reserve_thread_cached(ThreadCache& cache, size_t size) {
+    size_t needed = cache.cached_bytes + size;
+    if (needed <= cache.reserved_bytes) {
+      return true;
+    }
+    size_t missing = needed - cache.reserved_bytes;
+    size_t amount = capped() ? missing : std::max(missing, kReserveChunk);
+    if (!reserve_cached(amount)) {
+      return false;
+    }
+    cache.reserved_bytes += amount;
+    return true;
+  }
+
+  // Returns the room a thread cache, whose mutex is held, doesn't use. Under
+  // a cap the room is shared right away, otherwise one chunk is kept.
+  void release_unused(ThreadCache& cache) {
+    size_t unused = cache.reserved_bytes - cache.cached_bytes;
+    size_t released = 0;
+    if (capped()) {
+      released = unused;
+    } else if (unused >= 2 * kReserveChunk) {
+      released = unused - kReserveChunk;
+    }
+    if (released > 0) {
+      reserved_bytes.fetch_sub(released);
+      cache.reserved_bytes -= released;
+    }
+  }
+
+  // Threads publish their allocated bytes once they changed by
+  // kAllocatedPublishBytes, so the peak is only updated then.
+  void record_allocated(ThreadCache* cache, int64_t size) {
+    if (cache) {
+      int64_t pending =
+          cache->allocated_bytes.load(std::memory_order_relaxed) + size;
+      if (pending < kAllocatedPublishBytes &&
+          pending > -kAllocatedPublishBytes) {
+        cache->allocated_bytes.store(pending, std::memory_order_relaxed);
+        return;
+      }
+      cache->allocated_bytes.store(0, std::memory_order_relaxed);
+      size = pending;
+    }
+    update_peak(allocated_bytes.fetch_add(size) + size);
+  }
+
+  void update_peak(int64_t allocated) {
+    uint64_t peak = peak_allocated_bytes.load();
+    while (allocated > 0 && static_cast<uint64_t>(allocated) > peak &&
+           !peak_allocated_bytes.compare_exchange_weak(
+               peak, static_cast<uint64_t>(allocated))) {
+    }
+  }
+};
+
+// Leaked on purpose: tensors may be freed by other static destructors or by
+// threads that outlive main().
+CachingAllocatorState& state() {
+  static CachingAllocatorState* state = new CachingAllocatorState();
+  return *state;
+}
+
+struct ThreadCacheHolder {
+  ThreadCache* cache = nullptr;
+  ~ThreadCacheHolder();
+};
+
+thread_local ThreadCacheHolder thread_cache_holder;
+// Set when the holder is destroyed, so that frees during thread teardown go
+// straight to the global pool. Trivially destructible, so always readable.
+thread_local bool thread_cache_destroyed = false;
+
+ThreadCacheHolder::~ThreadCacheHolder() {
+  thread_cache_destroyed = true;
+  if (cache) {
+    state().release_thread_cache(cache);
+    cache = nullptr;
+  }
+}
+
+ThreadCache* thread_cache() {
+  if (thread_cache_destroyed) {
+    return nullptr;
+  }
+  auto& holder = thread_cache_holder;
+  if (!holder.cache) {
+    holder.cache = new ThreadCache();
+    state().register_thread_cache(holder.cache);
+  }
+  return holder.cache;
+}
+
+Block* CachingAllocatorState::malloc(size_t size) {
+  ThreadCache* cache = thread_cache();
+  Block* block = nullptr;
+  if (cache && size <= CPUCachingAllocator::kThreadCacheMaxBlockSize) {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    block = pop_block(cache->blocks, size);
+    if (block) {
+      cache->cached_bytes -= size;
+      release_unused(*cache);
+    }
+  }
+  if (!block) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      block = pop_block(blocks, size);
+      if (block) {
+        cached_bytes -= size;
+      }
+    }
+    if (block) {
+      reserved_bytes.fetch_sub(size);
+    }
+  }
+  if (block) {
+    if (cache) {
+      add_owned(cache->cache_hits, uint64_t(1));
+    } else {
+      cache_hits++;
+    }
+  } else {
+    block = system_alloc(size);
+    if (!block) {
+      // the cache may be holding the memory we need
+      empty_cache();
+      block = system_alloc(size);
+    }
+    AT_CHECK(
+        block,
+        "CPUCachingAllocator: not enough memory: you tried to allocate ",
+        size,
+        " bytes.");
+    if (cache) {
+      add_owned(cache->system_allocations, uint64_t(1));
+    } else {
+      system_allocations++;
+    }
+  }
+  record_allocated(cache, static_cast<int64_t>(size));
+  return block;
+}
+
+void CachingAllocatorState::free(Block* block) {
+  size_t size = block->size;
+  ThreadCache* cache = thread_cache();
+  record_allocated(cache, -static_cast<int64_t>(size));
+  if (cache && size <= CPUCachingAllocator::kThreadCacheMaxBlockSize) {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (cache->cached_bytes + size <= kThreadCacheMaxBytes &&
+        reserve_thread_cached(*cache, size)) {
+      cache->blocks[size].push_back(block);
+      cache->cached_bytes += size;
+      return;
+    }
+  }
+  if (!reserve_cached(size)) {
+    system_free(block);
+    if (cache) {
+      add_owned(cache->system_frees, uint64_t(1));
+    } else {
+      system_frees++;
+    }
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  blocks[size].push_back(block);
+  cached_bytes += size;
+}
+
+void CachingAllocatorState::empty_cache() {
+  std::vector<Block*> released;
+  uint64_t unreserved = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto* cache : thread_caches) {
+      std::lock_guard<std::mutex> cache_lock(cache->mutex);
+      take_blocks(cache->blocks, released);
+      unreserved += cache->reserved_bytes;
+      cache->cached_bytes = 0;
+      cache->reserved_bytes = 0;
+    }
+    take_blocks(blocks, released);
+    unreserved += cached_bytes;
+    cached_bytes = 0;
+  }
+  reserved_bytes.fetch_sub(unreserved);
+  for (auto* block : released) {
+    system_free(block);
+  }
+  system_frees += released.size();
+}
+
+void CachingAllocatorState::release_reservations() {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto* cache : thread_caches) {
+    std::lock_guard<std::mutex> cache_lock(cache->mutex);
+    reserved_bytes.fetch_sub(cache->reserved_bytes - cache->cached_bytes);
+    cache->reserved_bytes = cache->cached_bytes;
+  }
+}
+
+void CachingAllocatorState::register_thread_cache(ThreadCache* cache) {
+  std::lock_guard<std::mutex> lock(mutex);
+  thread_caches.push_back(cache);
+}
+
+void CachingAllocatorState::release_thread_cache(ThreadCache* cache) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = thread_caches.begin(); it != thread_caches.end(); ++it) {
+      if (*it == cache) {
+        thread_caches.erase(it);
+        break;
+      }
+    }
+    // the blocks stay cached, they just become visible to every thread
+    std::lock_guard<std::mutex> cache_lock(cache->mutex);
+    for (auto& entry : cache->blocks) {
+      auto& list = blocks[entry.first];
+      list.insert(list.end(), entry.second.begin(), entry.second.end());
+    }
+    cached_bytes += cache->cached_bytes;
+    reserved_bytes.fetch_sub(cache->reserved_bytes - cache->cached_bytes);
+    // the counts outlive the thread
+    cache_hits += cache->cache_hits.load();
+    system_allocations += cache->system_allocations.load();
+    system_frees += cache->system_frees.load();
+    record_allocated(nullptr, cache->allocated_bytes.load());
+  }
+  delete cache;
+}
+
+CPUCachingAllocatorStats CachingAllocatorState::get_stats() {
+  CPUCachingAllocatorStats stats;
+  int64_t allocated = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    allocated = allocated_bytes.load();
+    stats.cached_bytes = cached_bytes;
+    stats.system_allocations = system_allocations.load();
+    stats.system_frees = system_frees.load();
+    stats.cache_hits = cache_hits.load();
+    for (auto* cache : thread_caches) {
+      allocated += cache->allocated_bytes.load(std::memory_order_relaxed);
+      stats.system_allocations +=
+          cache->system_allocations.load(std::memory_order_relaxed);
+      stats.system_frees += cache->system_frees.load(std::memory_order_relaxed);
+      stats.cache_hits += cache->cache_hits.load(std::memory_order_relaxed);
+      std::lock_guard<std::mutex> cache_lock(cache->mutex);
+      stats.cached_bytes += cache->cached_bytes;
+    }
+  }
+  stats.allocated_bytes = allocated > 0 ? static_cast<uint64_t>(allocated) : 0;
+  stats.peak_allocated_bytes =
+      std::max<uint64_t>(peak_allocated_bytes.load(), stats.allocated_bytes);
+  return stats;
+}
+
+void Delete(void* ptr) {
+  if (ptr) {
+    reportFree(ptr, Device(DeviceType::CPU));
+    state().free(data_block(ptr));
+  }
+}
+
+struct CPUCachingAllocatorImpl final : public Allocator {
+  DataPtr allocate(size_t nbytes) const override {
+    if (nbytes == 0) {
+      return {nullptr, nullptr, &Delete, Device(DeviceType::CPU)};
+    }
+    Block* block = state().malloc(CPUCachingAllocator::round_size(nbytes));
+    void* data = block_data(block);
+    reportAllocation(data, nbytes, Device(DeviceType::CPU));
+    return {data, data, &Delete, Device(DeviceType::CPU)};
+  }
+  DeleterFnPtr raw_deleter() const override {
+    return &Delete;
+  }
+};
+
+} // namespace
+
+Allocator* GetCPUCachingAllocator() {
+  static CPUCachingAllocatorImpl allocator;
+  return &allocator;
+}
+
+namespace CPUCachingAllocator {
+
+size_t round_size(size_t nbytes) {
+  if (nbytes <= kMinBlockSize) {
+    return kMinBlockSize;
+  }
+  // Blocks that get their own huge pages are rounded together with their
+  // header, so that they fill whole huge pages.
+  size_t total = nbytes + kHeaderSize;
+  if (!is_huge(total)) {
+    // four size classes per power of two
+    size_t step = size_t(1) << (highest_bit(nbytes - 1) - 2);
+    size_t rounded = (nbytes + step - 1) & ~(step - 1);
+    if (!is_huge(rounded + kHeaderSize)) {
+      return rounded;
+    }
+    // The class would spill its header onto a second huge page; use the
+    // first huge page instead, which still fits `nbytes`.
+  }
+  size_t step = size_t(1) << (highest_bit(total - 1) - 2);
+  if (step < kHugePageSize) {
+    step = kHugePageSize;
+  }
+  return ((total + step - 1) & ~(step - 1)) - kHeaderSize;
+}
+
+void set_enabled(bool enabled) {
+  state().enabled = enabled;
+}
+
+bool enabled() {
+  return state().enabled;
+}
+
+void set_max_cached_bytes(size_t max_bytes) {
+  auto& s = state();
+  s.max_cached_bytes = max_bytes;
+  s.release_reservations();
+  if (s.reserved_bytes > max_bytes) {
+    s.empty_cache();
+  }
+}
+
+size_t max_cached_bytes() {
+  return state().max_cached_bytes;
+}
+
+void empty_cache() {
+  state().empty_cache();
+}
+
+CPUCachingAllocatorStats get_stats() {
+  return state().get_stats();
+}
+
+void reset_peak_stats() {
+  auto& s = state();
+  s.peak_allocated_bytes = s.get_stats().allocated_bytes;
+}
+
+} // namespace CPUCachingAllocator
+} // namespace c10
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <c10/core/Allocator.h>
+#include <c10/macros/Macros.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// A caching allocator for CPU memory, the CPU counterpart of the CUDA caching
+// allocator (THCCachingAllocator).
+//
+// Every request is rounded up to a size class (four classes per power of two,
+// so at most 25% internal fragmentation) and freed blocks are kept in free
+// lists keyed by their size class instead of being returned to the system.
+// Workloads that free and reallocate the same shapes over and over, like an
+// eager-mode inference loop, then stop paying for page faults and for the
+// trimming madvise() calls glibc issues on large frees.
+//
+// - Blocks of at most kThreadCacheMaxBlockSize bytes are cached in a per-thread
+//   free list, so the common small allocation does not take a global lock.
+//   A thread's cache is bounded; overflow and the caches of exiting threads
+//   go to the global pool.
+// - Larger blocks are cached in a global pool guarded by a mutex.
+// - Blocks of at least 2MB are mapped directly, 2MB aligned, and on Linux are
+//   advised to be backed by transparent huge pages.
+// - The total amount of cached memory can be capped with
+//   set_max_cached_bytes(); a freed block that does not fit under the cap is
+//   released to the system. empty_cache() releases every cached block.
+// - Statistics are counted per thread and summed by get_stats(), so that
+//   allocating and freeing doesn't update counters shared between threads.
+//
+// The allocator is opt-in. Call CPUCachingAllocator::set_enabled(true) (or
+// torch.cpu.set_caching_allocator_enabled(True) from Python), or set the
+// ATEN_CPU_CACHING_ALLOCATOR=1 environment variable, to make it the default
+// allocator of ATen CPU tensors. Memory that was allocated before the switch
+// keeps its original deleter, so toggling it at runtime is safe. Caffe2 users
+// can install it with caffe2::SetCPUAllocator(c10::GetCPUCachingAllocator()).
+
+namespace c10 {
+
+struct CPUCachingAllocatorStats {
+  // bytes in blocks currently handed out, counted by size class
+  uint64_t allocated_bytes = 0;
+  // high-water mark of allocated_bytes since the last reset_peak_stats().
+  // Threads publish their allocated bytes in steps of 64KB, so peaks that
+  // last shorter than that may be missed by up to 64KB per thread.
+  uint64_t peak_allocated_bytes = 0;
+  // bytes in blocks held in the free lists
+  uint64_t cached_bytes = 0;
+  // blocks obtained from and returned to the system
+  uint64_t system_allocations = 0;
+  uint64_t system_frees = 0;
+  // allocations served from a free list
+  uint64_t cache_hits = 0;
+};
+
+// The allocator itself. It supports the raw allocate/deallocate interface.
+C10_API Allocator* GetCPUCachingAllocator();
+
+namespace CPUCachingAllocator {
+
+// Largest block size served from the per-thread caches.
+constexpr size_t kThreadCacheMaxBlockSize = 1 << 20;
+
+// Whether ATen allocates CPU tensors with the caching allocator.
+C10_API void set_enabled(bool enabled);
+C10_API bool enabled();
+
+// Cap on the number of cached bytes; unlimited by default.
+C10_API void set_max_cached_bytes(size_t max_bytes);
+C10_API size_t max_cached_bytes();
+
+// Releases all cached blocks, including those held by other threads, to the
+// system. Blocks that are still in use are not affected.
+C10_API void empty_cache();
+
+C10_API CPUCachingAllocatorStats get_stats();
+C10_API void reset_peak_stats();
+
+// The size class a request of nbytes is rounded up to. Exposed for testing.
+C10_API size_t round_size(size_t nbytes);
+
+} // namespace CPUCachingAllocator
+} // namespace c10
@@ -2,6 +2,7 @@
 
 #include <c10/util/ArrayRef.h>
 #include <c10/Half.h>
+#include <c10/BFloat16.h>
 #include <c10/util/typeid.h>
 
 #include <cstdint>
@@ -27,7 +28,8 @@ _(float,Float,d)   /* 6 */ \
 _(double,Double,d) /* 7 */ \
 _(at::ComplexHalf,ComplexHalf,z)        /* 8 */ \
 _(std::complex<float>,ComplexFloat,z)   /* 9 */ \
-_(std::complex<double>,ComplexDouble,z) /* 10 */
+_(std::complex<double>,ComplexDouble,z) /* 10 */ \
+_(at::BFloat16,BFloat16,d) /* 11 */
 
 // If you want to support ComplexHalf for real, replace occurrences
 // of this macro with AT_FORALL_SCALAR_TYPES_WITH_COMPLEX.  But
@@ -42,7 +44,8 @@ _(at::Half,Half,d) \
 _(float,Float,d)   \
 _(double,Double,d) \
 _(std::complex<float>,ComplexFloat,z) \
-_(std::complex<double>,ComplexDouble,z)
+_(std::complex<double>,ComplexDouble,z) \
+_(at::BFloat16,BFloat16,d)
 
 #define AT_FORALL_SCALAR_TYPES(_) \
 _(uint8_t,Byte,i)  \
@@ -159,7 +162,8 @@ static inline bool isIntegralType(ScalarType t) {
 static inline bool isFloatingType(ScalarType t) {
   return (t == ScalarType::Double ||
           t == ScalarType::Float ||
-          t == ScalarType::Half);
+          t == ScalarType::Half ||
+          t == ScalarType::BFloat16);
 }
 
 static inline bool isComplexType(ScalarType t) {
@@ -185,6 +189,19 @@ static inline ScalarType promoteTypes(ScalarType a, ScalarType b) {
   if (isComplexType(a) || isComplexType(b)) {
     AT_ERROR("promoteTypes with complex numbers is not handled yet; figure out what the correct rules should be");
   }
+  // BFloat16 is not part of NumPy's lattice: it behaves like Half towards the
+  // other types, and Half and BFloat16 only share Float as a common type.
+  constexpr auto bf = ScalarType::BFloat16;
+  if (a == bf || b == bf) {
+    if (a == b) {
+      return bf;
+    }
+    auto other = a == bf ? b : a;
+    if (other == f2) {
+      return f4;
+    }
+    return isFloatingType(other) ? other : bf;
+  }
   static constexpr ScalarType _promoteTypesLookup
       [static_cast<int>(ScalarType::NumOptions)]
       [static_cast<int>(ScalarType::NumOptions)] = {
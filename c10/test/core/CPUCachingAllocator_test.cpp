@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/CPUCachingAllocator.h>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+using namespace c10;
+
+TEST(CPUCachingAllocatorTest, RoundSize) {
+  EXPECT_EQ(CPUCachingAllocator::round_size(1), 64);
+  EXPECT_EQ(CPUCachingAllocator::round_size(64), 64);
+  EXPECT_EQ(CPUCachingAllocator::round_size(65), 80);
+  EXPECT_EQ(CPUCachingAllocator::round_size(1000), 1024);
+  EXPECT_EQ(CPUCachingAllocator::round_size(1025), 1280);
+  for (size_t n = 1; n < (size_t(1) << 26); n = n * 3 / 2 + 1) {
+    size_t size = CPUCachingAllocator::round_size(n);
+    EXPECT_GE(size, n);
+    EXPECT_LE(size, n + n / 4 + (size_t(2) << 20));
+    // a size class rounds to itself
+    EXPECT_EQ(CPUCachingAllocator::round_size(size), size);
+  }
+}
+
+TEST(CPUCachingAllocatorTest, ReusesBlocks) {
+  Allocator* allocator = GetCPUCachingAllocator();
+  CPUCachingAllocator::empty_cache();
+  auto before = CPUCachingAllocator::get_stats();
+
+  void* first = nullptr;
+  {
+    auto ptr = allocator->allocate(1000);
+    first = ptr.get();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % 64, 0);
+    std::memset(first, 1, 1000);
+    auto stats = CPUCachingAllocator::get_stats();
+    EXPECT_EQ(stats.allocated_bytes, before.allocated_bytes + 1024);
+    EXPECT_EQ(stats.system_allocations, before.system_allocations + 1);
+  }
+  auto stats = CPUCachingAllocator::get_stats();
+  EXPECT_EQ(stats.allocated_bytes, before.allocated_bytes);
+  EXPECT_EQ(stats.cached_bytes, before.cached_bytes + 1024);
+
+  // same size class, served from the cache
+  auto ptr = allocator->allocate(1010);
+  EXPECT_EQ(ptr.get(), first);
+  stats = CPUCachingAllocator::get_stats();
+  EXPECT_EQ(stats.system_allocations, before.system_allocations + 1);
+  EXPECT_EQ(stats.cache_hits, before.cache_hits + 1);
+}
+
+TEST(CPUCachingAllocatorTest, HugeBlocks) {
+  Allocator* allocator = GetCPUCachingAllocator();
+  size_t nbytes = size_t(5) << 20;
+  void* first = nullptr;
+  {
+    auto ptr = allocator->allocate(nbytes);
+    first = ptr.get();
+    std::memset(first, 1, nbytes);
+  }
+  auto ptr = allocator->allocate(nbytes);
+  EXPECT_EQ(ptr.get(), first);
+}
+
+TEST(CPUCachingAllocatorTest, RawInterface) {
+  Allocator* allocator = GetCPUCachingAllocator();
+  ASSERT_NE(allocator->raw_deleter(), nullptr);
+  void* ptr = allocator->raw_allocate(100);
+  std::memset(ptr, 0, 100);
+  allocator->raw_deallocate(ptr);
+}
+
+TEST(CPUCachingAllocatorTest, EmptyCache) {
+  Allocator* allocator = GetCPUCachingAllocator();
+  {
+    auto a = allocator->allocate(4096);
+    auto b = allocator->allocate(size_t(3) << 20);
+  }
+  // blocks cached by another thread are released too
+  std::thread([allocator] {
+    auto c = allocator->allocate(2048);
+  }).join();
+  EXPECT_GT(CPUCachingAllocator::get_stats().cached_bytes, 0);
+  CPUCachingAllocator::empty_cache();
+  EXPECT_EQ(CPUCachingAllocator::get_stats().cached_bytes, 0);
+}
+
+TEST(CPUCachingAllocatorTest, CacheCap) {
+  Allocator* allocator = GetCPUCachingAllocator();
+  CPUCachingAllocator::empty_cache();
+  CPUCachingAllocator::set_max_cached_bytes(8192);
+  auto before = CPUCachingAllocator::get_stats();
+  {
+    auto a = allocator->allocate(8192);
+    auto b = allocator->allocate(8192);
+  }
+  auto stats = CPUCachingAllocator::get_stats();
+  EXPECT_EQ(stats.cached_bytes, 8192);
+  EXPECT_EQ(stats.system_frees, before.system_frees + 1);
+  CPUCachingAllocator::set_max_cached_bytes(
+      std::numeric_limits<size_t>::max());
+  CPUCachingAllocator::empty_cache();
+}
+
+TEST(CPUCachingAllocatorTest, PeakStats) {
+  Allocator* allocator = GetCPUCachingAllocator();
+  CPUCachingAllocator::reset_peak_stats();
+  auto base = CPUCachingAllocator::get_stats().allocated_bytes;
+  {
+    auto a = allocator->allocate(1 << 16);
+    auto b = allocator->allocate(1 << 16);
+  }
+  auto stats = CPUCachingAllocator::get_stats();
+  EXPECT_EQ(stats.peak_allocated_bytes, base + (2 << 16));
+  CPUCachingAllocator::reset_peak_stats();
+  EXPECT_EQ(CPUCachingAllocator::get_stats().peak_allocated_bytes, base);
+}
+
+TEST(CPUCachingAllocatorTest, StatsAcrossThreads) {
+  Allocator* allocator = GetCPUCachingAllocator();
+  auto before = CPUCachingAllocator::get_stats();
+  {
+    // allocated by a thread that exits, freed by this one
+    DataPtr ptr;
+    std::thread([&] { ptr = allocator->allocate(4096); }).join();
+    auto stats = CPUCachingAllocator::get_stats();
+    EXPECT_EQ(stats.allocated_bytes, before.allocated_bytes + 4096);
+    EXPECT_GE(stats.peak_allocated_bytes, stats.allocated_bytes);
+    EXPECT_EQ(
+        stats.system_allocations + stats.cache_hits,
+        before.system_allocations + before.cache_hits + 1);
+  }
+  EXPECT_EQ(
+      CPUCachingAllocator::get_stats().allocated_bytes,
+      before.allocated_bytes);
+}
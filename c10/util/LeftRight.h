@@ -1,30 +1,50 @@
 #include <atomic>
+#include <cstddef>
 #include <functional>
 #include <mutex>
 #include <thread>
 
 namespace c10 {
 
+namespace detail {
+// The reader counter stripe of the calling thread. Threads are spread over
+// the stripes in the order they first read.
+inline size_t leftRightStripe() {
+  static std::atomic<size_t> next_stripe{0};
+  thread_local size_t stripe = next_stripe++;
+  return stripe;
+}
+} // namespace detail
+
 // LeftRight wait-free readers synchronization primitive
 // https://hal.archives-ouvertes.fr/hal-01207881/document
-template <typename T>
+//
+// With NumStripes > 1, every reader counter is split into that many counters
+// on separate cache lines, and each thread only touches its own, so that
+// readers on different cores don't contend for one cache line. Writers wait
+// for all of them.
+template <typename T, size_t NumStripes = 1>
 class LeftRight {
  public:
   LeftRight() {
-    counters_[0].store(0);
-    counters_[1].store(0);
+    for (auto& counters : counters_) {
+      for (auto& counter : counters) {
+        counter.value.store(0);
+      }
+    }
   }
 
   template <typename F>
   auto read(F&& readFunc) const -> typename std::result_of<F(const T&)>::type {
     auto localCounterIndex = counterIndex_.load();
-    ++counters_[localCounterIndex];
+    auto& counter = counters_[localCounterIndex][stripe()].value;
+    ++counter;
     try {
       auto r = readFunc(data_[dataIndex_.load()]);
-      --counters_[localCounterIndex];
+      --counter;
       return r;
     } catch (const std::exception& e) {
-      --counters_[localCounterIndex];
+      --counter;
       throw;
     }
   }
@@ -46,11 +66,11 @@ class LeftRight {
       writeFunc(data_[localDataIndex ^ 1]);
       dataIndex_ = localDataIndex ^ 1;
       auto localCounterIndex = counterIndex_.load();
-      while (counters_[localCounterIndex ^ 1].load()) {
+      while (hasReaders(localCounterIndex ^ 1)) {
         std::this_thread::yield();
       }
       counterIndex_ = localCounterIndex ^ 1;
-      while (counters_[localCounterIndex].load()) {
+      while (hasReaders(localCounterIndex)) {
         std::this_thread::yield();
       }
       return writeFunc(data_[localDataIndex]);
@@ -60,10 +80,30 @@ class LeftRight {
     }
   }
 
+  static size_t stripe() {
+    return NumStripes == 1 ? 0 : detail::leftRightStripe() % NumStripes;
+  }
+
+  bool hasReaders(uint8_t counterIndex) const {
+    for (const auto& counter : counters_[counterIndex]) {
+      if (counter.value.load()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Padded rather than aligned, since heap allocations aren't over-aligned
+  // before C++17
+  struct Counter {
+    std::atomic<int32_t> value;
+    char padding[NumStripes == 1 ? 1 : 64 - sizeof(std::atomic<int32_t>)];
+  };
+
   std::mutex mutex_;
   std::atomic<uint8_t> counterIndex_{0};
   std::atomic<uint8_t> dataIndex_{0};
-  mutable std::atomic<int32_t> counters_[2];
+  mutable Counter counters_[2][NumStripes];
   T data_[2];
 };
 
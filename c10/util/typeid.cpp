@@ -72,6 +72,10 @@ CAFFE_DEFINE_PREALLOCATED_KNOWN_TYPE(
     26,
     detail::_guard_long_unique<std::vector<long>>);
 
-CAFFE_DEFINE_PREALLOCATED_KNOWN_TYPE(27, _CaffeHighestPreallocatedTypeId)
+// at::ScalarType::BFloat16 was added after the ids above were handed out, so
+// it does not share its number with the ScalarType.
+CAFFE_DEFINE_PREALLOCATED_KNOWN_TYPE(27, at::BFloat16)
+
+CAFFE_DEFINE_PREALLOCATED_KNOWN_TYPE(28, _CaffeHighestPreallocatedTypeId)
 
 } // namespace caffe2
@@ -18,6 +18,7 @@
 #include <exception>
 
 #include "c10/util/Backtrace.h"
+#include "c10/BFloat16.h"
 #include "c10/Half.h"
 #include "c10/macros/Macros.h"
 #include "c10/util/C++17.h"
@@ -606,5 +607,9 @@ CAFFE_DECLARE_PREALLOCATED_KNOWN_TYPE(
     26,
     detail::_guard_long_unique<std::vector<long>>)
 
-CAFFE_DECLARE_PREALLOCATED_KNOWN_TYPE(27, _CaffeHighestPreallocatedTypeId)
+// at::ScalarType::BFloat16 was added after the ids above were handed out, so
+// it does not share its number with the ScalarType.
+CAFFE_DECLARE_PREALLOCATED_KNOWN_TYPE(27, at::BFloat16)
+
+CAFFE_DECLARE_PREALLOCATED_KNOWN_TYPE(28, _CaffeHighestPreallocatedTypeId)
 } // namespace caffe2
@@ -46,6 +46,12 @@ C10_DEFINE_bool(
     false,
     "Use per net thread pools");
 
+C10_DEFINE_bool(
+    caffe2_net_async_use_interop_pool,
+    false,
+    "Run CPU tasks on the shared inter-op thread pool (c10::global_work_queue)"
+    " unless a pool size or NUMA node is requested explicitly");
+
 C10_DEFINE_bool(
     caffe2_net_async_run_root_tasks_inline,
     false,
@@ -481,10 +487,26 @@ C10_DEFINE_SHARED_REGISTRY(
     int,
     bool);
 
-C10_REGISTER_CREATOR(
-    ThreadPoolRegistry,
-    CPU,
-    GetAsyncNetThreadPool<TaskThreadPool, PROTO_CPU>);
+namespace {
+// With --caffe2_net_async_use_interop_pool, CPU pools default to the
+// process-wide inter-op pool so that async nets, JIT forks and everything
+// else launched through at::launch share one bounded set of threads.
+std::shared_ptr<TaskThreadPoolBase>
+GetAsyncNetCPUThreadPool(int numa_node_id, int pool_size, bool create_new) {
+  if (FLAGS_caffe2_net_async_use_interop_pool && !create_new &&
+      numa_node_id < 0 && pool_size <= 0 &&
+      FLAGS_caffe2_net_async_thread_pool_size <= 0) {
+    // The inter-op pool lives for the whole process; don't let the net
+    // delete it.
+    return std::shared_ptr<TaskThreadPoolBase>(
+        &c10::global_work_queue(), [](TaskThreadPoolBase*) {});
+  }
+  return GetAsyncNetThreadPool<TaskThreadPool, PROTO_CPU>(
+      numa_node_id, pool_size, create_new);
+}
+} // namespace
+
+C10_REGISTER_CREATOR(ThreadPoolRegistry, CPU, GetAsyncNetCPUThreadPool);
 C10_REGISTER_CREATOR(
     ThreadPoolRegistry,
     CUDA,
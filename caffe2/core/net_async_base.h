@@ -21,6 +21,7 @@ C10_DECLARE_int(caffe2_net_async_thread_pool_size);
 C10_DECLARE_bool(caffe2_net_async_check_stream_status);
 C10_DECLARE_bool(caffe2_net_async_use_single_pool);
 C10_DECLARE_bool(caffe2_net_async_use_per_net_pools);
+C10_DECLARE_bool(caffe2_net_async_use_interop_pool);
 C10_DECLARE_bool(caffe2_net_async_run_root_tasks_inline);
 
 namespace caffe2 {
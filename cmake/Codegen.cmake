@@ -100,10 +100,20 @@ if (NOT BUILD_ATEN_MOBILE)
     IF(MSVC)
       LIST(APPEND CPU_CAPABILITY_FLAGS "${OPT_FLAG}/arch:AVX2")
     ELSE(MSVC)
-      LIST(APPEND CPU_CAPABILITY_FLAGS "${OPT_FLAG} -mavx2 -mfma")
+      LIST(APPEND CPU_CAPABILITY_FLAGS "${OPT_FLAG} -mavx2 -mfma -mf16c")
     ENDIF(MSVC)
   ENDIF(CXX_AVX2_FOUND)
 
+  IF(CXX_AVX512_FOUND)
+    SET(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DHAVE_AVX512_CPU_DEFINITION")
+    LIST(APPEND CPU_CAPABILITY_NAMES "AVX512")
+    IF(MSVC)
+      LIST(APPEND CPU_CAPABILITY_FLAGS "${OPT_FLAG}/arch:AVX512")
+    ELSE(MSVC)
+      LIST(APPEND CPU_CAPABILITY_FLAGS "${OPT_FLAG} -mavx512f -mavx512dq -mavx512vl -mavx512bw -mfma")
+    ENDIF(MSVC)
+  ENDIF(CXX_AVX512_FOUND)
+
   list(LENGTH CPU_CAPABILITY_NAMES NUM_CPU_CAPABILITY_NAMES)
   math(EXPR NUM_CPU_CAPABILITY_NAMES "${NUM_CPU_CAPABILITY_NAMES}-1")
 
@@ -665,6 +665,15 @@ if(USE_OPENMP)
   endif()
 endif()
 
+# ---[ ATen parallel backend
+if(ATEN_THREADING STREQUAL "NATIVE")
+  set(AT_PARALLEL_NATIVE 1)
+elseif(ATEN_THREADING STREQUAL "OMP")
+  set(AT_PARALLEL_NATIVE 0)
+else()
+  message(FATAL_ERROR "Unknown ATEN_THREADING: ${ATEN_THREADING} (expected OMP or NATIVE)")
+endif()
+
 
 # ---[ Android specific ones
 if(ANDROID)
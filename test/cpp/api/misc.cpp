@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/utils/tempfile.h>
+#include <torch/nn/checkpoint.h>
 #include <torch/nn/init.h>
 #include <torch/nn/modules/linear.h>
 #include <torch/types.h>
@@ -8,6 +10,11 @@
 
 #include <test/cpp/api/support.h>
 
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
 TEST(NoGradTest, SetsGradModeCorrectly) {
   torch::manual_seed(0);
   torch::NoGradGuard guard;
@@ -44,6 +51,105 @@ TEST_F(AutogradTest, CanPassCustomGradientInputs) {
   ASSERT_TRUE(x.grad().allclose(y * 2));
 }
 
+TEST(CheckpointTest, RecomputesForwardInBackward) {
+  torch::manual_seed(0);
+  torch::nn::Linear model(5, 2);
+  auto x = torch::randn({10, 5}, torch::requires_grad());
+
+  model->forward(x).sum().backward();
+  auto x_grad = x.grad().clone();
+  auto weight_grad = model->weight.grad().clone();
+  x.grad().zero_();
+  model->weight.grad().zero_();
+
+  int calls = 0;
+  auto outputs = torch::nn::checkpoint(
+      [&](const std::vector<torch::Tensor>& inputs) {
+        ++calls;
+        return std::vector<torch::Tensor>{model->forward(inputs[0])};
+      },
+      {x});
+  ASSERT_EQ(calls, 1);
+  ASSERT_TRUE(outputs[0].requires_grad());
+  outputs[0].sum().backward();
+  ASSERT_EQ(calls, 2);
+  ASSERT_TRUE(x.grad().allclose(x_grad));
+  ASSERT_TRUE(model->weight.grad().allclose(weight_grad));
+
+  x.grad().zero_();
+  torch::nn::checkpoint(model, x).sum().backward();
+  ASSERT_TRUE(x.grad().allclose(x_grad));
+}
+
+TEST(RecordFunctionTest, RunsCallbacks) {
+  using namespace torch::autograd::profiler;
+  // Removes the callback even if an assertion returns early, since it refers
+  // to the locals of the test
+  struct RemoveCallbackGuard {
+    explicit RemoveCallbackGuard(uint64_t handle) : handle(handle) {}
+    ~RemoveCallbackGuard() {
+      remove();
+    }
+    void remove() {
+      if (handle != 0) {
+        removeRecordFunctionCallback(handle);
+        handle = 0;
+      }
+    }
+    uint64_t handle;
+  };
+  std::vector<std::string> started;
+  std::vector<std::string> ended;
+  std::vector<std::vector<int64_t>> input_sizes;
+  RemoveCallbackGuard callback(addRecordFunctionCallback(
+      [&](const RecordFunction& fn) {
+        started.push_back(fn.name());
+        if (started.back() == "add") {
+          for (const auto& input : fn.inputs()) {
+            input_sizes.push_back(input.sizes().vec());
+          }
+          // doesn't run the callbacks again
+          torch::ones({1}).mul(2);
+        }
+      },
+      [&](const RecordFunction& fn) { ended.push_back(fn.name()); },
+      /*needs_inputs=*/true));
+  ASSERT_TRUE(hasRecordFunctionCallbacks());
+
+  auto x = torch::ones({2, 3});
+  auto y = torch::add(x, x);
+  ASSERT_EQ(std::count(started.begin(), started.end(), "add"), 1);
+  ASSERT_EQ(std::count(ended.begin(), ended.end(), "add"), 1);
+  ASSERT_EQ(std::count(started.begin(), started.end(), "mul"), 0);
+  ASSERT_EQ(input_sizes, (std::vector<std::vector<int64_t>>{{2, 3}, {2, 3}}));
+
+  started.clear();
+  {
+    AutoRecordFunctionCallbacksMode disabled(false);
+    ASSERT_FALSE(hasRecordFunctionCallbacks());
+    torch::add(x, x);
+  }
+  ASSERT_TRUE(started.empty());
+
+  callback.remove();
+  ASSERT_FALSE(hasRecordFunctionCallbacks());
+  torch::add(x, x);
+  ASSERT_TRUE(started.empty());
+}
+
+TEST(RecordFunctionTest, FreesRemovedCallbacks) {
+  using namespace torch::autograd::profiler;
+  auto state = std::make_shared<int>(0);
+  std::weak_ptr<int> weak_state = state;
+  auto handle = addRecordFunctionCallback(
+      [state](const RecordFunction&) { (*state)++; }, nullptr);
+  state.reset();
+  torch::ones({1}).mul(2);
+  ASSERT_GT(*weak_state.lock(), 0);
+  removeRecordFunctionCallback(handle);
+  ASSERT_TRUE(weak_state.expired());
+}
+
 TEST(NNInitTest, CanInitializeTensorThatRequiresGrad) {
   auto tensor = torch::empty({3, 4}, torch::requires_grad());
   ASSERT_THROWS_WITH(
@@ -2,6 +2,11 @@ import contextlib
 import gc
 import sys
 import math
+import json
+import os
+import shutil
+import tempfile
+import threading
 import torch
 import unittest
 import warnings
@@ -13,7 +18,7 @@ from functools import reduce, wraps
 from torch._six import inf, nan
 from torch.autograd.gradcheck import gradgradcheck, gradcheck
 from torch.autograd.function import once_differentiable
-from torch.autograd.profiler import profile
+from torch.autograd.profiler import profile, sampling_profile
 from common_utils import (TEST_MKL, TestCase, run_tests, skipIfNoLapack,
                           suppress_warnings, skipIfRocm,
                           prod_single_zero, random_square_matrix_of_rank,
@@ -1981,6 +1986,70 @@ class TestAutograd(TestCase):
         out.sum().backward()
         self.assertEqual(x.grad.data, y_data)
 
+    def test_multithreaded_cpu_backward(self):
+        engine = Variable._execution_engine
+        old_num_threads = engine.num_cpu_threads()
+        engine.set_num_cpu_threads(max(old_num_threads, 4))
+        try:
+            self.assertGreaterEqual(engine.num_cpu_threads(), 4)
+
+            x = torch.randn(8, 8, requires_grad=True)
+            ws = [torch.randn(8, 8, requires_grad=True) for _ in range(16)]
+            # independent towers joined by a sum, so the workers can run them at
+            # the same time
+            out = sum((x.mm(w).tanh().mm(w).sigmoid()).sum() for w in ws)
+            out.backward()
+
+            x_ = x.detach().requires_grad_()
+            ws_ = [w.detach().requires_grad_() for w in ws]
+            expected = torch.autograd.grad(
+                sum((x_.mm(w).tanh().mm(w).sigmoid()).sum() for w in ws_), [x_] + ws_)
+            self.assertEqual(x.grad, expected[0])
+            for w, grad in zip(ws, expected[1:]):
+                self.assertEqual(w.grad, grad)
+
+            # reentrant backwards from several towers at once
+            y_data = torch.randn(2, 2)
+
+            class Reenter(Function):
+                @staticmethod
+                def forward(ctx, x):
+                    with torch.enable_grad():
+                        ctx.x = Variable(x.data, requires_grad=True)
+                        ctx.output_var = ctx.x * y_data
+                    return ctx.output_var.detach()
+
+                @staticmethod
+                def backward(ctx, grad_output):
+                    with torch.enable_grad():
+                        ctx.output_var.sum().backward()
+                    return ctx.x.grad * grad_output
+
+            x = torch.randn(2, 2, requires_grad=True)
+            sum(Reenter.apply(x * i).sum() for i in range(8)).backward()
+            self.assertEqual(x.grad, y_data * sum(range(8)))
+
+            # concurrent backward calls accumulating into the same leaf
+            w = torch.randn(4, 4, requires_grad=True)
+
+            def run():
+                for _ in range(20):
+                    (w * 2).sum().backward()
+
+            threads = [threading.Thread(target=run) for _ in range(4)]
+            for t in threads:
+                t.start()
+            for t in threads:
+                t.join()
+            self.assertEqual(w.grad, torch.full((4, 4), 2 * 20 * 4))
+        finally:
+            engine.set_num_cpu_threads(old_num_threads)
+        self.assertEqual(engine.num_cpu_threads(), old_num_threads)
+        # the remaining workers still run backward
+        x = torch.randn(3, requires_grad=True)
+        (x * 2).sum().backward()
+        self.assertEqual(x.grad, torch.full((3,), 2))
+
     def test_broadcast_tensors(self):
         f_args_variable = (torch.randn(3, requires_grad=True),
                            torch.randn(1, 2, 1, requires_grad=True),
@@ -2262,6 +2331,69 @@ class TestAutograd(TestCase):
             self.assertEqual(info.name, expected_name)
             last_end = info.cpu_interval.end
 
+    def test_sampling_profiler(self):
+        x = torch.randn(2, 3)
+        sampling_profile.reset()
+        with sampling_profile(sample_period=1):
+            self.assertTrue(torch.autograd._is_sampling_profiler_enabled())
+            x + x
+        self.assertFalse(torch.autograd._is_sampling_profiler_enabled())
+        stats = {(op.name, op.shapes): op for op in sampling_profile.stats()}
+        self.assertIn(('add', '[[2, 3], [2, 3]]'), stats)
+        add = stats[('add', '[[2, 3], [2, 3]]')]
+        self.assertEqual(add.count, 1)
+        self.assertGreaterEqual(add.p99_ns, add.p50_ns)
+        self.assertLessEqual(add.total_ns, add.max_ns * add.count)
+
+        # one in four top-level calls is recorded
+        sampling_profile.reset()
+        with sampling_profile(sample_period=4, record_shapes=False):
+            for _ in range(8):
+                x.mul(2)
+        muls = [op for op in sampling_profile.stats() if op.name == 'mul']
+        self.assertEqual(len(muls), 1)
+        self.assertEqual(muls[0].count, 2)
+        self.assertEqual(muls[0].shapes, '')
+
+        sampling_profile.reset()
+        with sampling_profile(sample_period=1, record_memory=True) as prof:
+            x.mul(2)
+        mul = [op for op in prof.stats() if op.name == 'mul'][0]
+        self.assertGreaterEqual(mul.allocations, 1)
+        self.assertGreaterEqual(mul.allocated_bytes, x.numel() * x.element_size())
+        self.assertIn('mul', prof.table())
+
+        tmpdir = tempfile.mkdtemp()
+        try:
+            path = os.path.join(tmpdir, 'trace.json')
+            prof.export_chrome_trace(path)
+            with open(path) as f:
+                events = json.load(f)['traceEvents']
+            self.assertIn('mul', [event['name'] for event in events])
+        finally:
+            shutil.rmtree(tmpdir)
+
+        # what threads recorded outlives them
+        sampling_profile.reset()
+        with sampling_profile(sample_period=1, record_shapes=False) as prof:
+            for _ in range(4):
+                thread = threading.Thread(target=lambda: x.div(2))
+                thread.start()
+                thread.join()
+        divs = [op for op in prof.stats() if op.name == 'div']
+        self.assertEqual(len(divs), 1)
+        self.assertEqual(divs[0].count, 4)
+        tmpdir = tempfile.mkdtemp()
+        try:
+            path = os.path.join(tmpdir, 'trace.json')
+            prof.export_chrome_trace(path)
+            with open(path) as f:
+                events = json.load(f)['traceEvents']
+            self.assertEqual(len({event['tid'] for event in events if event['name'] == 'div'}), 4)
+        finally:
+            shutil.rmtree(tmpdir)
+        sampling_profile.reset()
+
     def test_dir(self):
         x = torch.randn(10, 10)
         keys = dir(x)
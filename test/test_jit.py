@@ -20,6 +20,7 @@ import os
 import io
 import itertools
 import sys
+import threading
 import unittest
 import inspect
 import textwrap
@@ -1661,6 +1662,165 @@ class TestJit(JitTestCase):
         self.assertEqual(result2, expected2)
         self.assertAllFused(script_f.graph_for(x, y))
 
+    @unittest.skipIf(IS_WINDOWS or IS_SANDCASTLE, "NYI: fuser support for Windows or Sandcastle")
+    @enable_cpu_fuser
+    def test_fused_contiguous_and_strided_cpu(self):
+        def f(x, y):
+            z = torch.clamp(x * y + x, -1.0, 1.0)
+            return torch.where(z > 0, torch.sqrt(z), torch.relu(y) - z)
+
+        script_f = torch.jit.script(f)
+        # the second size is above the threshold for running the kernel with
+        # OpenMP and is not a multiple of the vector width
+        for size in [(7, 5), (301, 997)]:
+            x = torch.randn(size)
+            y = torch.randn(size)
+            inputs = [(x, y), (x.t(), y.t()), (x, y.t().contiguous().t()), (x, y[0].expand_as(y))]
+            for a, b in inputs:
+                self.assertEqual(script_f(a, b), f(a, b))
+                self.assertAllFused(script_f.graph_for(a, b))
+
+    @unittest.skipIf(IS_WINDOWS or IS_SANDCASTLE, "NYI: fuser support for Windows or Sandcastle")
+    @enable_cpu_fuser
+    def test_fused_row_reductions_cpu(self):
+        def softmax(x, y):
+            return torch.softmax(x * y, -1)
+
+        def log_softmax(x, y):
+            return torch.log_softmax(x + y, 1)
+
+        def layer_norm(x, w, b):
+            return torch.layer_norm(x, [37], w, b, 1e-5, False)
+
+        def centered_sum_of_squares(x, y):
+            z = torch.relu(x - y)
+            z = z - z.mean(-1, keepdim=True)
+            return (z * z).sum(-1)
+
+        def sum_plus(x, y):
+            return x.sum(-1, keepdim=True) + y
+
+        x = torch.randn(13, 37)
+        y = torch.randn(13, 37)
+        w = torch.randn(37)
+        b = torch.randn(37)
+        column = torch.randn(13, 1)
+        strided = x.t().contiguous().t()
+        big = torch.randn(301, 997)
+        cases = [
+            (softmax, [(x, y), (strided, y), (x, column), (big, big)]),
+            (log_softmax, [(x, y), (x, w)]),
+            (layer_norm, [(x, w, b), (strided, w, b)]),
+            (centered_sum_of_squares, [(x, y), (x, column), (strided, w)]),
+            # the first input is summed over a broadcast dimension, which
+            # runs the fallback
+            (sum_plus, [(x, y), (column, x)]),
+        ]
+        for fn, inputs in cases:
+            script_fn = torch.jit.script(fn)
+            for args in inputs:
+                self.assertEqual(script_fn(*args), fn(*args))
+                self.assertAllFused(script_fn.graph_for(*args))
+
+        # the decomposition would broadcast weights of size 1, where
+        # layer_norm checks their sizes
+        script_layer_norm = torch.jit.script(layer_norm)
+        for _ in range(2):
+            self.assertRaises(RuntimeError, lambda: script_layer_norm(x, w[:1], b[:1]))
+
+    @unittest.skipIf(IS_WINDOWS or IS_SANDCASTLE, "NYI: fuser support for Windows or Sandcastle")
+    @enable_cpu_fuser
+    def test_fuser_disk_cache_cpu(self):
+        def f(disk_cache_x, disk_cache_y):
+            return (disk_cache_x + disk_cache_y).sigmoid() * 3.5
+
+        def g(disk_cache_a, disk_cache_b):
+            return (disk_cache_a + disk_cache_b).sigmoid() * 3.5
+
+        x = torch.randn(4, 4)
+        y = torch.randn(4, 4)
+        old_dir = torch._C._jit_get_fuser_cache_dir()
+        cache_dir = tempfile.mkdtemp()
+        try:
+            torch._C._jit_set_fuser_cache_dir(os.path.join(cache_dir, 'fuser'))
+            before = torch._C._jit_fuser_cache_stats()
+            # functions that only differ in their names have their own fusion
+            # groups, but generate the same kernel
+            for fn in [f, g]:
+                script_fn = torch.jit.script(fn)
+                self.assertEqual(script_fn(x, y), fn(x, y))
+                self.assertAllFused(script_fn.graph_for(x, y))
+            after = torch._C._jit_fuser_cache_stats()
+            self.assertEqual(after['stores'] - before['stores'], 1)
+            self.assertEqual(after['hits'] - before['hits'], 1)
+            files = os.listdir(os.path.join(cache_dir, 'fuser'))
+            self.assertEqual(sorted(os.path.splitext(name)[1] for name in files), ['.key', '.so'])
+        finally:
+            torch._C._jit_set_fuser_cache_dir(old_dir)
+            shutil.rmtree(cache_dir)
+
+    @unittest.skipIf(IS_WINDOWS or IS_SANDCASTLE, "NYI: fuser support for Windows or Sandcastle")
+    @enable_cpu_fuser
+    def test_fuser_disk_cache_unloadable_entry_cpu(self):
+        def f(unloadable_x, unloadable_y):
+            return (unloadable_x - unloadable_y).exp() * 0.5
+
+        def g(unloadable_a, unloadable_b):
+            return (unloadable_a - unloadable_b).exp() * 0.5
+
+        x = torch.randn(4, 4)
+        y = torch.randn(4, 4)
+        old_dir = torch._C._jit_get_fuser_cache_dir()
+        cache_dir = tempfile.mkdtemp()
+        try:
+            fuser_dir = os.path.join(cache_dir, 'fuser')
+            torch._C._jit_set_fuser_cache_dir(fuser_dir)
+            self.assertEqual(torch.jit.script(f)(x, y), f(x, y))
+            # an entry that can't be opened, e.g. because another process
+            # evicted it after the lookup, is compiled again
+            for name in os.listdir(fuser_dir):
+                if name.endswith('.so'):
+                    open(os.path.join(fuser_dir, name), 'w').close()
+            before = torch._C._jit_fuser_cache_stats()
+            script_g = torch.jit.script(g)
+            self.assertEqual(script_g(x, y), g(x, y))
+            self.assertAllFused(script_g.graph_for(x, y))
+            after = torch._C._jit_fuser_cache_stats()
+            self.assertEqual(after['hits'] - before['hits'], 1)
+            self.assertEqual(after['stores'] - before['stores'], 1)
+        finally:
+            torch._C._jit_set_fuser_cache_dir(old_dir)
+            shutil.rmtree(cache_dir)
+
+    @unittest.skipIf(IS_WINDOWS or IS_SANDCASTLE, "NYI: fuser support for Windows or Sandcastle")
+    @enable_cpu_fuser
+    def test_fuser_memory_plans_share_kernels(self):
+        @torch.jit.script
+        def fn(shared_kernel_x, shared_kernel_y):
+            return (shared_kernel_x * shared_kernel_y).tanh() + 1.5
+
+        inputs = [(torch.randn(n, 8), torch.randn(n, 8)) for n in [3, 5, 7]]
+        old_dir = torch._C._jit_get_fuser_cache_dir()
+        cache_dir = tempfile.mkdtemp()
+        try:
+            torch._C._jit_set_fuser_cache_dir(os.path.join(cache_dir, 'fuser'))
+            before = torch._C._jit_fuser_cache_stats()
+            with torch.no_grad():
+                torch._C._jit_set_memory_planning_enabled(True)
+                try:
+                    for x, y in inputs:
+                        self.assertEqual(fn(x, y), (x * y).tanh() + 1.5)
+                finally:
+                    torch._C._jit_set_memory_planning_enabled(False)
+            self.assertEqual(len(fn.get_debug_state().memory_plans), len(inputs))
+            # the plans for each size reuse the kernel compiled for the first
+            after = torch._C._jit_fuser_cache_stats()
+            self.assertEqual(after['misses'] - before['misses'], 1)
+            self.assertEqual(after['hits'] - before['hits'], 0)
+        finally:
+            torch._C._jit_set_fuser_cache_dir(old_dir)
+            shutil.rmtree(cache_dir)
+
     # more manual test of graph executor that can be used as a scratchpad
     def test_ge(self):
         def foo(a, b):
@@ -1995,6 +2155,160 @@ class TestJit(JitTestCase):
         self.run_pass('constant_propagation', constant_prop.graph)
         self.assertExpected(canonical(constant_prop.graph))
 
+    def test_freeze_module(self):
+        class ConvBN(torch.jit.ScriptModule):
+            def __init__(self):
+                super(ConvBN, self).__init__()
+                self.conv = nn.Conv2d(3, 8, 3, padding=1)
+                self.bn = nn.BatchNorm2d(8)
+                self.drop = nn.Dropout(0.5)
+
+            @torch.jit.script_method
+            def forward(self, x):
+                return self.drop(F.relu(self.bn(self.conv(x))))
+
+        def randomize_stats(module):
+            for name, buf in module.named_buffers():
+                if name.endswith('running_mean'):
+                    buf.uniform_(-1, 1)
+                elif name.endswith('running_var'):
+                    buf.uniform_(0.5, 2)
+
+        scripted = ConvBN()
+        randomize_stats(scripted)
+        with self.assertRaisesRegex(RuntimeError, "training mode"):
+            torch._C._jit_pass_freeze_module(scripted)
+        scripted.eval()
+
+        lin = nn.Sequential(nn.Linear(16, 32), nn.BatchNorm1d(32), nn.Dropout(), nn.Linear(32, 4))
+        randomize_stats(lin)
+        traced = torch.jit.trace(lin.eval(), torch.randn(5, 16))
+
+        for m, x in [(scripted, torch.randn(2, 3, 10, 10)), (traced, torch.randn(5, 16))]:
+            frozen = torch._C._jit_pass_freeze_module(m)
+            graph = frozen._get_method('forward').graph
+            self.assertEqual(len(list(graph.inputs())), 1)
+            self.assertGraphContainsExactly(graph, 'aten::batch_norm', 0)
+            self.assertGraphContainsExactly(graph, 'aten::dropout', 0)
+            with torch.no_grad():
+                self.assertEqual(frozen.forward(x), m(x))
+
+    def test_memory_planning(self):
+        @torch.jit.script
+        def fn(x, w):
+            a = torch.mm(x, w)
+            b = torch.mm(a, w)
+            c = torch.mm(b, w)
+            d = torch.mm(c, w)
+            return torch.mm(d, w)
+
+        w = torch.randn(32, 32)
+        inputs = [torch.randn(16, 32), torch.randn(8, 32)]
+        with torch.no_grad():
+            expected = [fn(x, w) for x in inputs]
+            torch._C._jit_set_memory_planning_enabled(True)
+            try:
+                for _ in range(2):
+                    for x, out in zip(inputs, expected):
+                        self.assertEqual(fn(x, w), out)
+            finally:
+                torch._C._jit_set_memory_planning_enabled(False)
+
+        plans = list(fn.get_debug_state().memory_plans.values())
+        self.assertEqual(len(plans), len(inputs))
+        for plan in plans:
+            stats = plan.memory_plan
+            # a and c share memory, and so do b and d
+            self.assertEqual(stats['num_tensors'], 4)
+            self.assertEqual(stats['planned_bytes'], stats['peak_bytes'])
+            self.assertEqual(stats['unshared_bytes'], 2 * stats['planned_bytes'])
+
+    def test_memory_planning_escaping_views(self):
+        # split_with_sizes returns views of y without alias annotations, so
+        # y must not be planned into an arena that the next run overwrites
+        @torch.jit.script
+        def fn(x):
+            y = x + 1
+            return y.split_with_sizes([2, 2])
+
+        with torch.no_grad():
+            torch._C._jit_set_memory_planning_enabled(True)
+            try:
+                first = fn(torch.zeros(4, 3))
+                second = fn(torch.ones(4, 3))
+            finally:
+                torch._C._jit_set_memory_planning_enabled(False)
+        for out in first:
+            self.assertEqual(out, torch.ones(2, 3))
+        for out in second:
+            self.assertEqual(out, torch.full((2, 3), 2))
+
+    def test_graph_executor_multithreaded(self):
+        @torch.jit.script
+        def fn(x, w):
+            return torch.relu(torch.mm(x, w)) + 1
+
+        w = torch.randn(8, 8)
+        inputs = [torch.randn(4, 8) for _ in range(8)]
+        results = [None] * len(inputs)
+
+        def run(i):
+            for _ in range(50):
+                results[i] = fn(inputs[i], w)
+
+        threads = [threading.Thread(target=run, args=(i,)) for i in range(len(inputs))]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        for x, result in zip(inputs, results):
+            self.assertEqual(result, torch.relu(x.mm(w)) + 1)
+        state = fn.get_debug_state()
+        self.assertEqual(len(state.execution_plans), 1)
+        self.assertEqual(state.execution_plan_cache.misses, 1)
+
+    def test_graph_executor_cache_policy(self):
+        @torch.jit.script
+        def fn(x, w):
+            a = torch.mm(x, w)
+            b = torch.mm(a, w)
+            return torch.mm(b, w)
+
+        w = torch.randn(16, 16)
+        x = torch.randn(4, 16)
+        x_grad = x.clone().requires_grad_()
+        old_policy = torch._C._jit_get_graph_executor_cache_policy()
+        policy = torch._C.GraphExecutorCachePolicy()
+        policy.max_plans = 1
+        policy.bucket_sizes = True
+        torch._C._jit_set_graph_executor_cache_policy(policy)
+        try:
+            # the plan for inputs that require grad evicts the other one
+            for inp in [x, x, x_grad, x]:
+                self.assertEqual(fn(inp, w), x.mm(w).mm(w).mm(w))
+            state = fn.get_debug_state()
+            self.assertEqual(len(state.execution_plans), 1)
+            self.assertEqual(state.execution_plan_cache.hits, 1)
+            self.assertEqual(state.execution_plan_cache.misses, 3)
+            self.assertEqual(state.execution_plan_cache.evictions, 2)
+
+            # the sizes of all of these round up to 16 x 16
+            inputs = [torch.randn(n, 16) for n in range(9, 17)]
+            with torch.no_grad():
+                expected = [x.mm(w).mm(w).mm(w) for x in inputs]
+                torch._C._jit_set_memory_planning_enabled(True)
+                try:
+                    for x, out in zip(inputs, expected):
+                        self.assertEqual(fn(x, w), out)
+                finally:
+                    torch._C._jit_set_memory_planning_enabled(False)
+            state = fn.get_debug_state()
+            self.assertEqual(len(state.memory_plans), 1)
+            self.assertEqual(state.memory_plan_cache.misses, 1)
+            self.assertEqual(state.memory_plan_cache.hits, len(inputs) - 1)
+        finally:
+            torch._C._jit_set_graph_executor_cache_policy(old_policy)
+
     def test_trace_detach(self):
         def foo(x, w):
             return torch.matmul(x, w).detach()
@@ -4428,6 +4742,24 @@ a")
         inputs = self._make_scalar_vars([10], torch.int64)
         self.checkScript(func, inputs, optimize=True)
 
+    def test_interpreter_scalar_ops(self):
+        def func(n, x):
+            # type: (int, float) -> Tuple[int, float, List[int], List[float]]
+            a = 0
+            b = 1
+            y = x
+            for i in range(n):
+                # loop-carried values that swap registers
+                a, b = b, a + b
+                if y * 2.0 >= x and i != 3:
+                    y = y - 0.5
+                else:
+                    y = y + 1.0
+            return a, y, [a, b, n - a], [x, y]
+
+        self.checkScript(func, (10, 4.0), optimize=True)
+        self.checkScript(func, (0, 1.5), optimize=True)
+
     def test_if(self):
         def func(a, b):
             # type: (int, int) -> int
@@ -7126,6 +7458,32 @@ a")
         self.assertEqual(torch.autograd.grad(slstm(*inputs).sum(), inputs),
                          torch.autograd.grad(lstm(*inputs).sum(), inputs))
 
+    def test_batch_independent_gemms(self):
+        @torch.jit.script
+        def heads(x, wq, wk, wv):
+            q = torch.matmul(x, wq)
+            k = torch.matmul(x, wk)
+            v = torch.mm(x, wv)
+            return q, k, v
+
+        @torch.jit.script
+        def towers(a, b, c, d, w):
+            return torch.mm(a, w), torch.mm(b, w.t()), torch.mm(c, d), torch.mm(d, c)
+
+        x = torch.randn(16, 32)
+        heads_inputs = (x, torch.randn(32, 8), torch.randn(32, 16), torch.randn(32, 8))
+        towers_inputs = (torch.randn(4, 8), torch.randn(4, 8), torch.randn(8, 8), torch.randn(8, 8),
+                         torch.randn(8, 8))
+        q, k, v = heads(*heads_inputs)
+        self.assertEqual(q, x.mm(heads_inputs[1]))
+        self.assertEqual(k, x.mm(heads_inputs[2]))
+        self.assertEqual(v, x.mm(heads_inputs[3]))
+        self.assertTrue(q.is_contiguous())
+        a, b, c, d, w = towers_inputs
+        self.assertEqual(towers(*towers_inputs), (a.mm(w), b.mm(w.t()), c.mm(d), d.mm(c)))
+        self.assertIn('prim::LinearBatchSide', str(heads.graph_for(*heads_inputs)))
+        self.assertIn('prim::MMBatchStack', str(towers.graph_for(*towers_inputs)))
+
     def test_loop_unrolling(self):
         def fn(x):
             y = 0
@@ -10918,6 +11276,46 @@ class TestAsync(JitTestCase):
         self.assertEqual(y2, foo2(x1, x2))
         self.assertEqual(y3, foo3(x1, x2, x3))
 
+    def test_async_fork_independent_branches(self):
+        def towers(x, w1, w2, w3):
+            a = torch.relu(torch.mm(x, w1))
+            b = torch.relu(torch.mm(x, w2))
+            c = torch.tanh(torch.mm(x, w3))
+            small = x + 1
+            return torch.cat([a, b, c], 1), small
+
+        x = torch.rand(4, 8)
+        ws = [torch.rand(8, 8) for _ in range(3)]
+
+        graph = torch.jit.script(towers).graph
+        self.run_pass('fork_independent_branches', graph)
+        # the calling thread runs the last tower, and the cheap branch stays inline
+        self.assertGraphContainsExactly(graph, 'prim::fork', 2)
+        self.assertGraphContainsExactly(graph, 'aten::wait', 2)
+
+        torch._C._jit_set_parallel_branches_enabled(True)
+        try:
+            scripted = torch.jit.script(towers)
+            with torch.no_grad():
+                self.assertEqual(scripted(x, *ws), towers(x, *ws))
+                plan = get_execution_plan(scripted.get_debug_state())
+                self.assertGraphContainsExactly(plan.graph, 'prim::fork', 2)
+        finally:
+            torch._C._jit_set_parallel_branches_enabled(False)
+
+    def test_async_script_error(self):
+        @torch.jit.script
+        def foo(x):
+            return torch.mm(x, x)
+
+        @torch.jit.script
+        def wait_script(x):
+            fut = torch.jit._fork(foo, x)
+            return torch.jit._wait(fut)
+
+        with self.assertRaisesRegex(RuntimeError, "matrices expected"):
+            wait_script(torch.rand(2, 3, 4))
+
 
 for test in autograd_method_tests:
     add_autograd_test(*test)
@@ -2344,6 +2344,92 @@ class TestNN(NNTestCase):
         self._test_EmbeddingBag(False, 'sum', True)
         self._test_EmbeddingBag(False, 'mean', True)
 
+    def test_embedding_bag_empty_input(self):
+        weight = torch.randn(10, 3, requires_grad=True)
+        input = torch.empty(0, 4, dtype=torch.long)
+        for mode in ['sum', 'mean', 'max']:
+            output = F.embedding_bag(input, weight, mode=mode)
+            self.assertEqual(output.size(), (0, 3))
+            output.sum().backward()
+            self.assertEqual(weight.grad, torch.zeros(10, 3))
+            weight.grad = None
+
+        indices = torch.tensor([1, 2], dtype=torch.long)
+        offsets = torch.empty(0, dtype=torch.long)
+        with self.assertRaisesRegex(RuntimeError, "expected no indices without offsets"):
+            torch.embedding_bag(weight, indices, offsets)
+
+    def test_embedding_bag_per_sample_weights(self):
+        for dtype, sparse in itertools.product([torch.float, torch.double], [False, True]):
+            es = nn.EmbeddingBag(10, 5, mode='sum', sparse=sparse).to(dtype)
+            input = torch.tensor([3, 1, 1, 9, 0, 4, 3], dtype=torch.long)
+            offsets = torch.tensor([0, 0, 3, 3, 6], dtype=torch.long)
+            per_sample_weights = torch.randn(7, dtype=dtype, requires_grad=True)
+
+            output = es(input, offsets, per_sample_weights)
+            weighted = es.weight[input] * per_sample_weights.unsqueeze(1)
+            expected = torch.stack([weighted[0:0].sum(0), weighted[0:3].sum(0), weighted[3:3].sum(0),
+                                    weighted[3:6].sum(0), weighted[6:].sum(0)])
+            self.assertEqual(output, expected, dtype2prec[dtype])
+
+            grad = torch.randn_like(output)
+            output.backward(grad)
+            weight_grad, psw_grad = es.weight.grad, per_sample_weights.grad
+            es.zero_grad()
+            per_sample_weights.grad = None
+            expected.backward(grad)
+            if sparse:
+                weight_grad = weight_grad.to_dense()
+            self.assertEqual(weight_grad, es.weight.grad, dtype2prec[dtype])
+            self.assertEqual(psw_grad, per_sample_weights.grad, dtype2prec[dtype])
+
+            # 2D input, one weight per entry
+            output = es(input[:6].view(2, 3), per_sample_weights=per_sample_weights[:6].view(2, 3))
+            self.assertEqual(output, torch.stack([weighted[0:3].sum(0), weighted[3:6].sum(0)]),
+                             dtype2prec[dtype])
+
+        weight = torch.randn(6, 4, dtype=torch.double, requires_grad=True)
+        input = torch.tensor([0, 5, 2, 2, 1], dtype=torch.long)
+        offsets = torch.tensor([0, 2], dtype=torch.long)
+        per_sample_weights = torch.randn(5, dtype=torch.double, requires_grad=True)
+        gradcheck(lambda w, p: F.embedding_bag(input, w, offsets, mode='sum', per_sample_weights=p),
+                  (weight, per_sample_weights))
+
+        es = nn.EmbeddingBag(10, 5, mode='mean')
+        self.assertRaises(NotImplementedError, lambda: es(input, offsets, torch.ones(5)))
+        es = nn.EmbeddingBag(10, 5, mode='sum')
+        self.assertRaises(ValueError, lambda: es(input, offsets, torch.ones(4)))
+
+    def test_fused_rowwise_embedding_bag(self):
+        weight = torch.randn(20, 7)
+        weight[3] = 0.5
+        input = torch.tensor([3, 19, 0, 0, 7, 3], dtype=torch.long)
+        offsets = torch.tensor([0, 2, 2, 5], dtype=torch.long)
+        per_sample_weights = torch.rand(6)
+        for bits, levels in [(8, 255), (4, 15)]:
+            packed = torch.fused_rowwise_quantize(weight, bits)
+            self.assertEqual(packed.dtype, torch.uint8)
+            dequantized = torch.fused_rowwise_dequantize(packed, bits)[:, :7]
+            step = (weight.max(1)[0] - weight.min(1)[0]) / levels
+            # 4-bit scales and biases are stored as half
+            self.assertLessEqual(((dequantized - weight).abs() - step.unsqueeze(1) / 2).max().item(),
+                                 1e-5 if bits == 8 else 1e-2)
+            self.assertEqual(dequantized[3], weight[3], 1e-3)
+
+            table = torch.fused_rowwise_dequantize(packed, bits)
+            for mode, mode_enum in [('sum', 0), ('mean', 1)]:
+                output = torch.fused_rowwise_embedding_bag(packed, input, offsets, bits, mode_enum)
+                expected = F.embedding_bag(input, table, offsets, mode=mode)
+                self.assertEqual(output, expected, 1e-4)
+            output = torch.fused_rowwise_embedding_bag(packed, input, offsets, bits, 0, per_sample_weights)
+            expected = F.embedding_bag(input, table, offsets, mode='sum',
+                                       per_sample_weights=per_sample_weights)
+            self.assertEqual(output, expected, 1e-4)
+
+        self.assertRaises(RuntimeError, lambda: torch.fused_rowwise_quantize(weight, 2))
+        self.assertRaises(RuntimeError, lambda: torch.fused_rowwise_embedding_bag(
+            torch.fused_rowwise_quantize(weight), torch.tensor([20]), torch.tensor([0])))
+
     @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
     @repeat_test_for_types(ALL_TENSORTYPES)
     @skipIfRocm
@@ -3936,6 +4022,69 @@ class TestNN(NNTestCase):
                                         m2.weight.grad.data], 0),
                              prec=dtype2prec[dtype])
 
+    def _conv2d_nogroup_reference(self, input, weight, bias, stride, padding, dilation, groups):
+        outputs = []
+        for g, (input_g, weight_g) in enumerate(zip(input.chunk(groups, 1), weight.chunk(groups, 0))):
+            bias_g = bias.chunk(groups)[g] if bias is not None else None
+            outputs.append(torch._convolution_nogroup(input_g, weight_g, bias_g, stride, padding,
+                                                      dilation, False, [0, 0]))
+        return torch.cat(outputs, 1)
+
+    def test_cpu_conv2d_algorithms(self):
+        # (batch, channels, out_channels, size, kernel, stride, padding, dilation, groups, algorithms)
+        # algorithms: 1 direct, 2 pointwise, 3 Winograd F(2x2,3x3), 4 Winograd F(4x4,3x3)
+        configs = [
+            (2, 16, 24, 18, 3, 1, 1, 1, 1, [1, 3, 4]),
+            (1, 16, 16, 7, 3, 1, 2, 1, 2, [1, 3, 4]),
+            (2, 8, 8, 9, 3, 1, 0, 1, 1, [1, 3, 4]),
+            (2, 12, 12, 11, 3, 2, 1, 1, 12, [1]),
+            (2, 6, 12, 10, 5, 1, 2, 2, 3, [1]),
+            (2, 8, 16, 9, 1, 1, 0, 1, 1, [1, 2]),
+            (3, 8, 6, 9, 1, 2, 0, 1, 2, [1, 2]),
+        ]
+        for dtype in [torch.float, torch.double]:
+            for (n, c, oc, size, k, stride, padding, dilation, groups, algorithms) in configs:
+                input = torch.randn(n, c, size, size + 1, dtype=dtype)
+                weight = torch.randn(oc, c // groups, k, k, dtype=dtype)
+                bias = torch.randn(oc, dtype=dtype)
+                expected = self._conv2d_nogroup_reference(input, weight, bias, [stride] * 2,
+                                                          [padding] * 2, [dilation] * 2, groups)
+                for algorithm in [0] + algorithms:
+                    output = torch._cpu_conv2d(input, weight, bias, [padding] * 2, [stride] * 2,
+                                               [dilation] * 2, groups, algorithm)
+                    self.assertEqual(output, expected, prec=1e-3 if dtype == torch.float else 1e-8)
+                self.assertEqual(F.conv2d(input, weight, bias, stride, padding, dilation, groups),
+                                 expected, prec=1e-3 if dtype == torch.float else 1e-8)
+
+        input = torch.randn(1, 8, 6, 6)
+        weight = torch.randn(8, 8, 3, 3)
+        self.assertRaises(RuntimeError, lambda: torch._cpu_conv2d(input, weight, None, [1, 1], [2, 2],
+                                                                  [1, 1], 1, 3))
+        self.assertRaises(RuntimeError, lambda: torch._cpu_conv2d(input, weight, None, [1, 1], [1, 1],
+                                                                  [1, 1], 1, 2))
+
+    def test_cpu_conv2d_gradcheck(self):
+        configs = [
+            (8, 8, 6, 3, 1, 1, 1, 1, 3),
+            (8, 8, 9, 3, 1, 1, 1, 2, 4),
+            (4, 4, 6, 3, 2, 1, 1, 4, 1),
+            (4, 6, 7, 3, 1, 2, 2, 2, 1),
+            (4, 6, 5, 1, 2, 0, 1, 2, 2),
+            # reduction above kDirectMaxReduction: im2col + GEMM weight gradient
+            (66, 2, 6, 3, 2, 1, 2, 1, 0),
+        ]
+        for (c, oc, size, k, stride, padding, dilation, groups, algorithm) in configs:
+            input = torch.randn(2, c, size, size, dtype=torch.double, requires_grad=True)
+            weight = torch.randn(oc, c // groups, k, k, dtype=torch.double, requires_grad=True)
+            bias = torch.randn(oc, dtype=torch.double, requires_grad=True)
+
+            def func(input, weight, bias):
+                return torch._cpu_conv2d(input, weight, bias, [padding] * 2, [stride] * 2,
+                                         [dilation] * 2, groups, algorithm)
+
+            self.assertTrue(gradcheck(func, (input, weight, bias)))
+            self.assertTrue(gradgradcheck(func, (input, weight, bias)))
+
     def test_MaxUnpool2d_output_size(self):
         m = nn.MaxPool2d(3, stride=2, return_indices=True)
         mu = nn.MaxUnpool2d(3, stride=2)
@@ -4263,8 +4412,8 @@ class TestNN(NNTestCase):
         self._test_variable_sequence("cuda", dtype)
 
     def test_LSTM_cell(self):
-        # this is just a smoke test; these modules are implemented through
-        # autograd so no Jacobian test is needed
+        # this is just a smoke test; the fused cells they are built on are
+        # checked by test_fused_rnn_cells_cpu
         for bias in (True, False):
             input = torch.randn(3, 10)
             hx = torch.randn(3, 20)
@@ -4275,6 +4424,104 @@ class TestNN(NNTestCase):
 
             (hx + cx).sum().backward()
 
+    def test_fused_rnn_cells_cpu(self):
+        # hidden sizes below, at and above a vector width, with a ragged tail
+        for hidden_size in (3, 8, 13):
+            for bias in (True, False):
+                input = torch.randn(4, 6, dtype=torch.double, requires_grad=True)
+                hx = torch.randn(4, hidden_size, dtype=torch.double, requires_grad=True)
+                cx = torch.randn(4, hidden_size, dtype=torch.double, requires_grad=True)
+
+                lstm = nn.LSTMCell(6, hidden_size, bias=bias).double()
+                self.assertTrue(gradcheck(lambda i, h, c: lstm(i, (h, c)), (input, hx, cx)))
+                self.assertTrue(gradcheck(lambda i, h, c: lstm(i, (h, c))[0], (input, hx, cx)))
+                self.assertTrue(gradcheck(lambda i, h, c: lstm(i, (h, c))[1], (input, hx, cx)))
+
+                gru = nn.GRUCell(6, hidden_size, bias=bias).double()
+                self.assertTrue(gradcheck(gru, (input, hx)))
+
+    def test_fused_rnn_cells_double_backward(self):
+        devices = ['cpu'] + (['cuda'] if TEST_CUDA else [])
+        for device in devices:
+            for bias in (True, False):
+                input = torch.randn(3, 4, dtype=torch.double, device=device, requires_grad=True)
+                hx = torch.randn(3, 5, dtype=torch.double, device=device, requires_grad=True)
+                cx = torch.randn(3, 5, dtype=torch.double, device=device, requires_grad=True)
+
+                lstm = nn.LSTMCell(4, 5, bias=bias).double().to(device)
+                self.assertTrue(gradgradcheck(lambda i, h, c: lstm(i, (h, c)), (input, hx, cx)))
+                self.assertTrue(gradgradcheck(lambda i, h, c: lstm(i, (h, c))[1], (input, hx, cx)))
+
+                gru = nn.GRUCell(4, 5, bias=bias).double().to(device)
+                self.assertTrue(gradgradcheck(gru, (input, hx)))
+
+        # cuDNN RNNs have no double backward, so only check the layers on CPU
+        lstm = nn.LSTM(4, 5, num_layers=2).double()
+        seq = torch.randn(2, 3, 4, dtype=torch.double, requires_grad=True)
+        self.assertTrue(gradgradcheck(lambda x: lstm(x)[0], (seq,)))
+
+    def test_rnn_cpu_matches_unfused_reference(self):
+        def lstm_cell(x, hx, cx, w_ih, w_hh, b_ih, b_hh):
+            gates = F.linear(x, w_ih, b_ih) + F.linear(hx, w_hh, b_hh)
+            ingate, forgetgate, cellgate, outgate = gates.chunk(4, 1)
+            cy = forgetgate.sigmoid() * cx + ingate.sigmoid() * cellgate.tanh()
+            return outgate.sigmoid() * cy.tanh(), cy
+
+        def gru_cell(x, hx, w_ih, w_hh, b_ih, b_hh):
+            i_r, i_i, i_n = F.linear(x, w_ih, b_ih).chunk(3, 1)
+            h_r, h_i, h_n = F.linear(hx, w_hh, b_hh).chunk(3, 1)
+            resetgate = (i_r + h_r).sigmoid()
+            inputgate = (i_i + h_i).sigmoid()
+            newgate = (i_n + resetgate * h_n).tanh()
+            return newgate + inputgate * (hx - newgate)
+
+        def reference(rnn, input, hx):
+            is_lstm = isinstance(rnn, nn.LSTM)
+            num_directions = 2 if rnn.bidirectional else 1
+            hy, cy = [], []
+            for layer in range(rnn.num_layers):
+                outputs = []
+                for direction in range(num_directions):
+                    suffix = '_l{}{}'.format(layer, '_reverse' if direction else '')
+                    params = [getattr(rnn, name + suffix) for name in ('weight_ih', 'weight_hh', 'bias_ih', 'bias_hh')]
+                    index = layer * num_directions + direction
+                    h = hx[0][index] if is_lstm else hx[index]
+                    c = hx[1][index] if is_lstm else None
+                    steps = range(input.size(0) - 1, -1, -1) if direction else range(input.size(0))
+                    step_outputs = [None] * input.size(0)
+                    for t in steps:
+                        if is_lstm:
+                            h, c = lstm_cell(input[t], h, c, *params)
+                        else:
+                            h = gru_cell(input[t], h, *params)
+                        step_outputs[t] = h
+                    outputs.append(torch.stack(step_outputs, 0))
+                    hy.append(h)
+                    cy.append(c)
+                input = torch.cat(outputs, 2)
+            if is_lstm:
+                return input, (torch.stack(hy, 0), torch.stack(cy, 0))
+            return input, torch.stack(hy, 0)
+
+        for module in (nn.LSTM, nn.GRU):
+            for bidirectional in (False, True):
+                rnn = module(6, 7, num_layers=2, bidirectional=bidirectional).double()
+                num_directions = 2 if bidirectional else 1
+                input = torch.randn(5, 3, 6, dtype=torch.double, requires_grad=True)
+                h0 = torch.randn(2 * num_directions, 3, 7, dtype=torch.double)
+                hx = (h0, torch.randn_like(h0)) if module is nn.LSTM else h0
+
+                output, hidden = rnn(input, hx)
+                ref_output, ref_hidden = reference(rnn, input, hx)
+                self.assertEqual(output, ref_output)
+                self.assertEqual(hidden, ref_hidden)
+
+                grad_output = torch.randn_like(output)
+                grads = torch.autograd.grad(output, [input] + list(rnn.parameters()), grad_output)
+                ref_grads = torch.autograd.grad(ref_output, [input] + list(rnn.parameters()), grad_output)
+                for grad, ref_grad in zip(grads, ref_grads):
+                    self.assertEqual(grad, ref_grad)
+
     @unittest.skipIf(not (TEST_CUDNN and TEST_MULTIGPU), 'CUDNN or multi-gpu not available')
     def test_cudnn_rnn_dropout_states_device(self):
         rnn = nn.RNN(10, 20, num_layers=2, dropout=.5)
@@ -3434,6 +3434,28 @@ class _TestTorchMixin(object):
         torch.zeros(5, 6).copy_(torch.zeros(6))
         self.assertRaises(RuntimeError, lambda: torch.zeros(5, 6).copy_(torch.zeros(30)))
 
+    def test_mixed_layouts(self):
+        # operands whose fastest moving dimensions disagree are iterated in
+        # tiles; use sizes that are not multiples of the tile size
+        for dtype in [torch.float, torch.double, torch.uint8]:
+            a = torch.randn(130, 259).mul_(10).to(dtype)
+            b = torch.randn(259, 130).mul_(10).to(dtype)
+            self.assertEqual(a + b.t(), a + b.t().contiguous(), 0)
+            self.assertEqual(b.t() * a, b.t().contiguous() * a, 0)
+
+            x = torch.randn(3, 67, 45, 33).mul_(10).to(dtype)
+            nhwc = torch.empty(3, 45, 33, 67, dtype=dtype).permute(0, 3, 1, 2)
+            nhwc.copy_(x)
+            self.assertEqual(nhwc, x, 0)
+            self.assertEqual(nhwc.contiguous(), x, 0)
+            y = torch.empty_like(x)
+            y.copy_(x.transpose(1, 3).contiguous().transpose(1, 3))
+            self.assertEqual(y, x, 0)
+
+            out = torch.empty(259, 130, dtype=dtype).t()
+            torch.add(a, b.t(), out=out)
+            self.assertEqual(out, a + b.t().contiguous(), 0)
+
     def test_randperm(self):
         _RNGState = torch.get_rng_state()
         res1 = torch.randperm(100)
@@ -3639,6 +3661,37 @@ class _TestTorchMixin(object):
         self.assertEqual(top1, top2)
         self.assertEqual(idx1, idx2)
 
+    def test_sort_topk_large_slices(self):
+        # long slices take the radix sort and heap selection paths on CPU
+        for dtype in [torch.float, torch.double, torch.long, torch.int, torch.short, torch.uint8]:
+            x = torch.randint(0, 100, (4, 3000), dtype=dtype)
+            for descending in (False, True):
+                values, indices = x.sort(1, descending)
+                self.assertEqual(values, x.gather(1, indices), 0)
+                if descending:
+                    self.assertTrue((values[:, :-1] >= values[:, 1:]).all())
+                else:
+                    self.assertTrue((values[:, :-1] <= values[:, 1:]).all())
+                # the sort is stable
+                ties = values[:, :-1] == values[:, 1:]
+                self.assertTrue((indices[:, :-1] < indices[:, 1:])[ties].all())
+                for k in (1, 10, 700, 2900):
+                    top_values, top_indices = x.t().topk(k, 0, descending)
+                    self.assertEqual(top_values, values.t()[:k], 0)
+                    self.assertEqual(top_values, x.t().gather(0, top_indices), 0)
+            k = random.randint(1, 3000)
+            self.assertEqual(x.kthvalue(k, 1)[0], x.sort(1)[0][:, k - 1], 0)
+
+    def test_sort_nan(self):
+        x = torch.tensor([1., float('nan'), -float('inf'), 0., float('inf'), -1.])
+        values, indices = x.sort()
+        self.assertEqual(values[:5], torch.tensor([-float('inf'), -1., 0., 1., float('inf')]))
+        self.assertTrue(math.isnan(values[5]))
+        self.assertEqual(indices[5], 1)
+        values, indices = x.sort(descending=True)
+        self.assertTrue(math.isnan(values[0]))
+        self.assertEqual(x.topk(2)[1], torch.tensor([1, 4]))
+
     def test_kthvalue(self):
         SIZE = 50
         x = torch.rand(SIZE, SIZE, SIZE)
@@ -7552,6 +7605,30 @@ class _TestTorchMixin(object):
         self.assertEqual(v.storage()[0], v.data[0][0])
         self.assertEqual(v.storage()[14], v.data[2][4])
 
+    def test_cpu_caching_allocator(self):
+        was_enabled = torch.cpu.caching_allocator_enabled()
+        torch.cpu.set_caching_allocator_enabled(True)
+        try:
+            torch.cpu.empty_cache()
+            base = torch.cpu.memory_allocated()
+            x = torch.ones(1000)
+            self.assertEqual(torch.cpu.memory_allocated(), base + 4096)
+            ptr = x.data_ptr()
+            del x
+            self.assertEqual(torch.cpu.memory_allocated(), base)
+            self.assertEqual(torch.cpu.memory_cached(), 4096)
+            hits = torch.cpu.memory_stats()['cache_hits']
+            # the same size class is served from the cache
+            y = torch.zeros(1010)
+            self.assertEqual(y.data_ptr(), ptr)
+            self.assertEqual(torch.cpu.memory_stats()['cache_hits'], hits + 1)
+            self.assertEqual(y.sum().item(), 0)
+            del y
+            torch.cpu.empty_cache()
+            self.assertEqual(torch.cpu.memory_cached(), 0)
+        finally:
+            torch.cpu.set_caching_allocator_enabled(was_enabled)
+
     def test_nonzero(self):
         num_src = 12
 
@@ -7835,6 +7912,22 @@ class _TestTorchMixin(object):
         self.assertRaises(TypeError,
                           lambda: torch.isclose(x, x, torch.tensor(1.5), torch.tensor(1., requires_grad=True)).all())
 
+    def test_parsing_signature_cache(self):
+        # calls with the same types of arguments may reuse the signature that
+        # the previous ones bound to
+        x = torch.randn(2, 3)
+        y = torch.randn(2, 3)
+        for _ in range(3):
+            self.assertEqual(torch.max(x, 1)[1], x.argmax(1))
+            self.assertEqual(torch.max(x, y), torch.where(x > y, x, y))
+            self.assertEqual(x.add(y, alpha=2), x + 2 * y)
+            # a zero-dim tensor binds to a number only if it doesn't require grad
+            self.assertEqual(x.add(torch.tensor(2.), y), x + 2 * y)
+            self.assertRaises(TypeError, lambda: x.add(torch.tensor(2., requires_grad=True), y))
+            self.assertRaises(TypeError, lambda: x.add(torch.ones(2), y))
+            self.assertEqual(x.view(3, 2), x.view((3, 2)))
+            self.assertEqual(x.view(torch.tensor(3), 2), x.view(3, 2))
+
     def test_parsing_intlist(self):
         #  parse with integer variables
         self.assertEqual(torch.Size([3, 4]), torch.ones((torch.tensor(3), torch.tensor(4))).shape)
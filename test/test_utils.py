@@ -256,6 +256,71 @@ class TestCheckpoint(TestCase):
 
             self.assertEqual(grad_with_checkpointing, grad_no_checkpointing)
 
+    def test_checkpoint_native(self):
+        model = nn.Sequential(
+            nn.Linear(100, 50),
+            nn.ReLU(),
+            nn.Dropout(),
+            nn.Linear(50, 20),
+            nn.ReLU(),
+        )
+        inp = torch.randn(4, 100, requires_grad=True)
+
+        state = torch.get_rng_state()
+        with torch.utils.checkpoint.record_saved_tensors_memory():
+            stats = torch.utils.checkpoint.saved_tensors_memory_stats(reset_peak=True)
+            out = model(inp)
+            peak = torch.utils.checkpoint.saved_tensors_memory_stats()['peak_resident_bytes']
+        out.sum().backward()
+        grads = [inp.grad] + [p.grad.clone() for p in model.parameters()]
+
+        torch.set_rng_state(state)
+        inp.grad = None
+        model.zero_grad()
+        with torch.utils.checkpoint.record_saved_tensors_memory():
+            torch.utils.checkpoint.saved_tensors_memory_stats(reset_peak=True)
+            out_checkpointed = checkpoint(model, inp, native=True)
+            peak_checkpointed = torch.utils.checkpoint.saved_tensors_memory_stats()['peak_resident_bytes']
+        self.assertFalse(torch.autograd._is_saved_tensors_memory_stats_enabled())
+        out_checkpointed.sum().backward()
+        grads_checkpointed = [inp.grad] + [p.grad for p in model.parameters()]
+
+        self.assertEqual(out, out_checkpointed)
+        for grad, grad_checkpointed in zip(grads, grads_checkpointed):
+            self.assertEqual(grad, grad_checkpointed)
+        # only the input is saved
+        self.assertLess(peak_checkpointed - stats['resident_bytes'], peak - stats['resident_bytes'])
+
+        out = checkpoint(lambda x: (x * 2,), inp, native=True)
+        self.assertIsInstance(out, tuple)
+        self.assertEqual(len(out), 1)
+        out = checkpoint(lambda x, y: (x * y, x + y), inp, inp, native=True)
+        self.assertIsInstance(out, tuple)
+        with self.assertRaisesRegex(RuntimeError, "Checkpointing is not compatible"):
+            torch.autograd.grad(out[0].sum(), inp)
+
+    @unittest.skipIf(not HAS_CUDA, 'No CUDA')
+    def test_offload_saved_tensors(self):
+        model = nn.Sequential(nn.Linear(64, 64), nn.Tanh(), nn.Linear(64, 64), nn.Tanh()).cuda()
+        inp = torch.randn(16, 64, device='cuda', requires_grad=True)
+        model(inp).sum().backward()
+        grads = [inp.grad] + [p.grad.clone() for p in model.parameters()]
+
+        inp.grad = None
+        model.zero_grad()
+        before = torch.utils.checkpoint.saved_tensors_memory_stats()
+        with torch.utils.checkpoint.offload_saved_tensors(), \
+                torch.utils.checkpoint.record_saved_tensors_memory():
+            out = model(inp).sum()
+        self.assertFalse(torch.autograd._is_saved_tensors_offload_enabled())
+        self.assertGreater(torch.utils.checkpoint.saved_tensors_memory_stats()['offloaded_bytes'],
+                           before['offloaded_bytes'])
+        out.backward()
+        self.assertEqual(torch.utils.checkpoint.saved_tensors_memory_stats()['offloaded_bytes'],
+                         before['offloaded_bytes'])
+        for grad, grad_offloaded in zip(grads, [inp.grad] + [p.grad for p in model.parameters()]):
+            self.assertEqual(grad, grad_offloaded)
+
 
 class TestDataLoader(TestCase):
     def setUp(self):
@@ -128,7 +128,7 @@ if (${cond}) {
 """)
 
 RECORD_FUNCTION = CodeTemplate("""\
-profiler::RecordFunction profiler("${name}", Function::peek_at_next_sequence_nr());""")
+profiler::RecordFunction profiler("${name}", Function::peek_at_next_sequence_nr()${profiled_inputs});""")
 
 SELECT = CodeTemplate("""\
 if (${cond}) {
@@ -654,7 +654,9 @@ def emit_body(declaration):
 
     body = []
     if base_name not in DONT_PROFILE:
-        body.append(RECORD_FUNCTION.substitute(combined))
+        profiled_inputs = ''.join(', ' + arg['name'] for arg in inputs
+                                  if arg['simple_type'] in {'Tensor', 'TensorList'})
+        body.append(RECORD_FUNCTION.substitute(combined, profiled_inputs=profiled_inputs))
     if strategy != 'use_type':
         body.extend(unpack_args(env, declaration))
     if requires_derivative:
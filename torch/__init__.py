@@ -280,6 +280,7 @@ del ByteStorageBase
 ################################################################################
 
 import torch.cuda
+import torch.cpu
 import torch.autograd
 from torch.autograd import no_grad, enable_grad, set_grad_enabled
 import torch.nn
@@ -1756,6 +1756,78 @@ Example::
             [5, 6, 7, 8]])
 """)
 
+add_docstr(torch.fused_rowwise_dequantize,
+           r"""
+fused_rowwise_dequantize(input, bits=8) -> Tensor
+
+Expands a table packed by :func:`torch.fused_rowwise_quantize` back to a float
+tensor, computing ``scale * q + bias`` for every quantized value ``q`` of a row.
+
+For ``bits=4`` the result always has an even number of columns; when the
+original table had an odd number of columns, the last one is padding.
+
+Args:
+    input (ByteTensor): the packed 2-D table
+    bits (int): the number of bits per value the table was packed with, 8 or 4
+""")
+
+add_docstr(torch.fused_rowwise_embedding_bag,
+           r"""
+fused_rowwise_embedding_bag(weight, input, offsets, bits=8, mode=0, per_sample_weights=None) -> Tensor
+
+Computes sums or means of bags of embeddings like
+:func:`torch.nn.functional.embedding_bag`, reading the embeddings from a table
+packed by :func:`torch.fused_rowwise_quantize`. Rows are dequantized on the fly,
+so the full precision table is never materialized. Only supported on CPU, and
+not differentiable.
+
+Args:
+    weight (ByteTensor): the packed 2-D table
+    input (LongTensor): the concatenated indices of all bags
+    offsets (LongTensor): the starting position of each bag in :attr:`input`
+    bits (int): the number of bits per value the table was packed with, 8 or 4
+    mode (int): ``0`` to sum the bags, ``1`` to average them
+    per_sample_weights (Tensor, optional): a float tensor with one weight per
+        index in :attr:`input`. Only supported when :attr:`mode` is ``0``.
+
+Example::
+
+    >>> weight = torch.rand(10, 3)
+    >>> packed = torch.fused_rowwise_quantize(weight)
+    >>> input = torch.tensor([1, 2, 4, 5, 4, 3, 2, 9])
+    >>> offsets = torch.tensor([0, 4])
+    >>> torch.fused_rowwise_embedding_bag(packed, input, offsets)
+    tensor([[ 1.8530,  2.1624,  1.3597],
+            [ 2.2106,  1.4918,  2.6617]])
+""")
+
+add_docstr(torch.fused_rowwise_quantize,
+           r"""
+fused_rowwise_quantize(input, bits=8) -> Tensor
+
+Quantizes every row of a 2-D float tensor, typically an embedding table, to
+``bits`` bits per value with a scale and bias of its own, so that the
+quantization levels evenly span the values between the minimum and maximum of
+the row.
+
+The result is a ``uint8`` tensor with one packed row per input row. For
+``bits=8`` a packed row holds one byte per value followed by the scale and bias
+as ``float``. For ``bits=4`` it holds two values per byte, low nibble first,
+followed by the scale and bias as ``half``.
+
+Args:
+    input (Tensor): the 2-D float tensor to quantize
+    bits (int): the number of bits per value, 8 or 4
+
+Example::
+
+    >>> weight = torch.randn(1000, 64)
+    >>> torch.fused_rowwise_quantize(weight).shape
+    torch.Size([1000, 72])
+    >>> torch.fused_rowwise_quantize(weight, 4).shape
+    torch.Size([1000, 36])
+""")
+
 add_docstr(torch.gather,
            r"""
 gather(input, dim, index, out=None) -> Tensor
@@ -2014,6 +2086,14 @@ get_num_threads() -> int
 Gets the number of OpenMP threads used for parallelizing CPU operations
 """)
 
+add_docstr(torch.get_num_interop_threads,
+           r"""
+get_num_interop_threads() -> int
+
+Gets the number of threads used for inter-op parallelism on CPU
+(e.g. in JIT ``torch.jit._fork``)
+""")
+
 add_docstr(torch.gt,
            r"""
 gt(input, other, out=None) -> Tensor
@@ -4142,6 +4222,20 @@ set_num_threads(int)
 Sets the number of OpenMP threads used for parallelizing CPU operations
 """)
 
+add_docstr(torch.set_num_interop_threads,
+           r"""
+set_num_interop_threads(int)
+
+Sets the number of threads used for inter-op parallelism on CPU
+(e.g. in JIT ``torch.jit._fork``, and Caffe2 async nets run with
+``--caffe2_net_async_use_interop_pool``). Defaults to 1.
+
+.. warning::
+    Can only be called once and before any inter-op parallel work is
+    started. The default can also be set through the
+    ``ATEN_NUM_INTEROP_THREADS`` environment variable.
+""")
+
 add_docstr(torch.sigmoid,
            r"""
 sigmoid(input, out=None) -> Tensor
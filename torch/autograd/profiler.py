@@ -222,6 +222,102 @@ class profile(object):
     total_average.__doc__ = EventList.total_average.__doc__
 
 
+class sampling_profile(object):
+    """Context manager that enables the sampling profiler, meant to stay on in production.
+
+    Instead of recording every operation like :class:`profile`, each thread
+    records one in :attr:`sample_period` of its top-level operations (those
+    not called by another recorded operation) together with everything they
+    call, and aggregates them in place by operation and input shapes. The
+    aggregated stats can be read at any time with :meth:`stats` or
+    :meth:`table`, also while operations run on other threads. The profiler
+    is global to the process: the stats include all threads, and are kept
+    after the profiler is disabled, until :meth:`reset`.
+
+    Arguments:
+        sample_period (int, optional): Record one in this many top-level
+            operations of each thread. Default: ``100``
+        record_shapes (bool, optional): Aggregate the operations by the sizes
+            of their tensor inputs too. Default: ``True``
+        record_memory (bool, optional): Count the CPU allocations and frees
+            made by each recorded operation. This costs more than the rest,
+            every free has to be looked up. Default: ``False``
+        max_trace_events (int, optional): The number of most recent recorded
+            operations of each thread kept for :meth:`export_chrome_trace`.
+            Default: ``65536``
+
+    Example:
+        >>> with torch.autograd.profiler.sampling_profile(sample_period=10) as prof:
+        ...     for _ in range(1000):
+        ...         model(x)
+        >>> print(prof.table(row_limit=10))
+    """
+
+    def __init__(self, sample_period=100, record_shapes=True, record_memory=False,
+                 max_trace_events=65536):
+        self.sample_period = sample_period
+        self.record_shapes = record_shapes
+        self.record_memory = record_memory
+        self.max_trace_events = max_trace_events
+
+    def start(self):
+        torch.autograd._enable_sampling_profiler(self.sample_period, self.record_shapes,
+                                                 self.record_memory, self.max_trace_events)
+
+    def stop(self):
+        torch.autograd._disable_sampling_profiler()
+
+    def __enter__(self):
+        self.start()
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.stop()
+        return False
+
+    @staticmethod
+    def reset():
+        """Clears the stats and the trace of all threads."""
+        torch.autograd._reset_sampling_profiler()
+
+    @staticmethod
+    def stats():
+        """Returns the stats of every sampled operation and input shapes, by
+        decreasing total time. Times are in nanoseconds, the percentiles are
+        within 12.5%."""
+        return torch.autograd._sampling_profiler_stats()
+
+    def table(self, row_limit=None):
+        """Returns the stats as a table, one row per operation and input shapes."""
+        stats = self.stats()[:row_limit]
+        if not stats:
+            return ''
+        name_width = max(len(op.name) for op in stats) + 2
+        shapes_width = max(len(op.shapes) for op in stats) + 2
+        row_format = '{: <' + str(name_width) + '}{: <' + str(shapes_width) + '}' + '{: >12}' * 7
+        header = row_format.format('Name', 'Shapes', 'Count', 'Total', 'Avg', 'p50', 'p99', 'Max',
+                                   'Alloc bytes')
+        lines = [header, '-' * len(header)]
+        for op in stats:
+            lines.append(row_format.format(
+                op.name, op.shapes, op.count, format_time(op.total_ns / 1000.0),
+                format_time(op.total_ns / 1000.0 / op.count), format_time(op.p50_ns / 1000.0),
+                format_time(op.p99_ns / 1000.0), format_time(op.max_ns / 1000.0),
+                op.allocated_bytes))
+        return '\n'.join(lines) + '\n'
+
+    @staticmethod
+    def export_chrome_trace(path):
+        """Exports the most recent sampled operations as a Chrome tracing file.
+
+        It can be loaded and inspected under the ``chrome://tracing`` URL.
+
+        Arguments:
+            path (str): Path where the trace will be written.
+        """
+        torch.autograd._export_sampling_profiler_chrome_trace(path)
+
+
 class emit_nvtx(object):
     """Context manager that makes every autograd operation emit an NVTX range.
 
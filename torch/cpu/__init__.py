@@ -0,0 +1,105 @@
+r"""
+This package controls the caching allocator for CPU tensors.
+
+By default every CPU tensor is allocated from and returned to the system.
+Programs that repeatedly free and reallocate tensors of the same sizes, such
+as an inference loop, can instead opt in to a caching allocator that keeps
+freed blocks around for reuse, like the CUDA caching allocator does for GPU
+memory. It can also be enabled by setting the ``ATEN_CPU_CACHING_ALLOCATOR=1``
+environment variable before starting the process.
+"""
+
+import torch
+
+
+def set_caching_allocator_enabled(enabled):
+    r"""Enables or disables the caching allocator for CPU tensors allocated
+    from now on.
+
+    Tensors allocated before the call keep using the allocator they were
+    created with. Disabling the caching allocator does not release the memory
+    it has cached; call :func:`~torch.cpu.empty_cache` for that.
+
+    Arguments:
+        enabled (bool): whether new CPU tensors use the caching allocator.
+    """
+    torch._C._cpu_setCachingAllocatorEnabled(enabled)
+
+
+def caching_allocator_enabled():
+    r"""Returns whether CPU tensors are allocated with the caching allocator."""
+    return torch._C._cpu_cachingAllocatorEnabled()
+
+
+def empty_cache():
+    r"""Releases all unoccupied memory currently held by the CPU caching
+    allocator back to the system, including the blocks cached by other
+    threads.
+    """
+    torch._C._cpu_emptyCache()
+
+
+def memory_allocated():
+    r"""Returns the CPU memory occupied by tensors allocated with the caching
+    allocator, in bytes.
+
+    .. note::
+        Requests are rounded up to a size class, so this can be up to a quarter
+        larger than the sum of the tensor sizes.
+    """
+    return torch._C._cpu_memoryStats()['allocated_bytes']
+
+
+def max_memory_allocated():
+    r"""Returns the maximum CPU memory occupied by tensors allocated with the
+    caching allocator, in bytes, since the beginning of the program or the
+    last call to :func:`~torch.cpu.reset_max_memory_allocated`.
+    """
+    return torch._C._cpu_memoryStats()['peak_allocated_bytes']
+
+
+def reset_max_memory_allocated():
+    r"""Resets the starting point for tracking the maximum CPU memory occupied
+    by tensors. See :func:`~torch.cpu.max_memory_allocated`.
+    """
+    torch._C._cpu_resetMaxMemoryAllocated()
+
+
+def memory_cached():
+    r"""Returns the CPU memory held by the caching allocator for reuse, in
+    bytes.
+    """
+    return torch._C._cpu_memoryStats()['cached_bytes']
+
+
+def set_max_memory_cached(max_bytes):
+    r"""Limits the CPU memory the caching allocator holds for reuse.
+
+    Freed blocks that do not fit under the limit are returned to the system.
+    If more than :attr:`max_bytes` is cached already, the cache is emptied.
+
+    Arguments:
+        max_bytes (int): the limit, in bytes.
+    """
+    torch._C._cpu_setMaxMemoryCached(max_bytes)
+
+
+def max_memory_cached():
+    r"""Returns the limit set by :func:`~torch.cpu.set_max_memory_cached`."""
+    return torch._C._cpu_maxMemoryCached()
+
+
+def memory_stats():
+    r"""Returns a dictionary of CPU caching allocator statistics.
+
+    The dictionary has the following keys:
+
+    - ``allocated_bytes``: memory occupied by tensors.
+    - ``peak_allocated_bytes``: maximum of ``allocated_bytes`` since the last
+      :func:`~torch.cpu.reset_max_memory_allocated`.
+    - ``cached_bytes``: memory held for reuse.
+    - ``system_allocations``: number of blocks obtained from the system.
+    - ``system_frees``: number of blocks returned to the system.
+    - ``cache_hits``: number of allocations served from the cache.
+    """
+    return torch._C._cpu_memoryStats()
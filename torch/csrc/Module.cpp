@@ -14,7 +14,9 @@
 #include <ATen/ExpandUtils.h>
 #include <ATen/dlpack.h>
 #include <ATen/DLConvertor.h>
+#include <ATen/Parallel.h>
 #include <ATen/Utils.h>
+#include <c10/core/CPUCachingAllocator.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -151,11 +153,96 @@ static PyObject * THPModule_getNumThreads(PyObject *module)
 
 static PyObject * THPModule_setNumThreads(PyObject *module, PyObject *arg)
 {
+  HANDLE_TH_ERRORS
   THPUtils_assert(THPUtils_checkLong(arg), "set_num_threads expects an int, "
           "but got %s", THPUtils_typename(arg));
-  THSetNumThreads((int)THPUtils_unpackLong(arg));
-  at::set_num_threads((int)THPUtils_unpackLong(arg));
+  at::set_num_intraop_threads((int)THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_getNumInteropThreads(PyObject *module)
+{
+  return PyLong_FromLong(at::get_num_interop_threads());
+}
+
+static PyObject * THPModule_setNumInteropThreads(PyObject *module, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "set_num_interop_threads expects an int, "
+          "but got %s", THPUtils_typename(arg));
+  at::set_num_interop_threads((int)THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_cpuSetCachingAllocatorEnabled(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyBool_Check(arg), "set_caching_allocator_enabled expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  c10::CPUCachingAllocator::set_enabled(arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_cpuCachingAllocatorEnabled(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  if (c10::CPUCachingAllocator::enabled()) Py_RETURN_TRUE;
+  else Py_RETURN_FALSE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_cpuEmptyCache(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  c10::CPUCachingAllocator::empty_cache();
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_cpuSetMaxMemoryCached(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "set_max_memory_cached expects an int, "
+          "but got %s", THPUtils_typename(arg));
+  auto max_bytes = THPUtils_unpackLong(arg);
+  THPUtils_assert(max_bytes >= 0, "set_max_memory_cached expects a non-negative "
+          "number of bytes, but got %lld", (long long)max_bytes);
+  c10::CPUCachingAllocator::set_max_cached_bytes((size_t)max_bytes);
   Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_cpuMaxMemoryCached(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  return PyLong_FromSize_t(c10::CPUCachingAllocator::max_cached_bytes());
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_cpuMemoryStats(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  auto stats = c10::CPUCachingAllocator::get_stats();
+  py::dict result;
+  result["allocated_bytes"] = stats.allocated_bytes;
+  result["peak_allocated_bytes"] = stats.peak_allocated_bytes;
+  result["cached_bytes"] = stats.cached_bytes;
+  result["system_allocations"] = stats.system_allocations;
+  result["system_frees"] = stats.system_frees;
+  result["cache_hits"] = stats.cache_hits;
+  return result.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_cpuResetMaxMemoryAllocated(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  c10::CPUCachingAllocator::reset_peak_stats();
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
 }
 
 PyObject * THPModule_setDefaultTensorType(PyObject *_unused, PyObject *type)
@@ -437,6 +524,15 @@ static PyMethodDef TorchMethods[] = {
   {"_get_backcompat_keepdim_warn", (PyCFunction)THPModule_getBackcompatKeepdimWarn, METH_NOARGS, nullptr},
   {"get_num_threads", (PyCFunction)THPModule_getNumThreads,     METH_NOARGS,  nullptr},
   {"set_num_threads", (PyCFunction)THPModule_setNumThreads,     METH_O,       nullptr},
+  {"get_num_interop_threads", (PyCFunction)THPModule_getNumInteropThreads,     METH_NOARGS,  nullptr},
+  {"set_num_interop_threads", (PyCFunction)THPModule_setNumInteropThreads,     METH_O,       nullptr},
+  {"_cpu_setCachingAllocatorEnabled", (PyCFunction)THPModule_cpuSetCachingAllocatorEnabled, METH_O, nullptr},
+  {"_cpu_cachingAllocatorEnabled", (PyCFunction)THPModule_cpuCachingAllocatorEnabled, METH_NOARGS, nullptr},
+  {"_cpu_emptyCache", (PyCFunction)THPModule_cpuEmptyCache,     METH_NOARGS,  nullptr},
+  {"_cpu_setMaxMemoryCached", (PyCFunction)THPModule_cpuSetMaxMemoryCached, METH_O, nullptr},
+  {"_cpu_maxMemoryCached", (PyCFunction)THPModule_cpuMaxMemoryCached, METH_NOARGS, nullptr},
+  {"_cpu_memoryStats", (PyCFunction)THPModule_cpuMemoryStats,   METH_NOARGS,  nullptr},
+  {"_cpu_resetMaxMemoryAllocated", (PyCFunction)THPModule_cpuResetMaxMemoryAllocated, METH_NOARGS, nullptr},
   {"_get_cudnn_enabled", (PyCFunction)THPModule_userEnabledCuDNN, METH_NOARGS,     nullptr},
   {"_set_cudnn_enabled", (PyCFunction)THPModule_setUserEnabledCuDNN, METH_O,  nullptr},
   {"_get_cudnn_benchmark", (PyCFunction)THPModule_benchmarkCuDNN, METH_NOARGS,     nullptr},
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <torch/nn/checkpoint.h>
 #include <torch/nn/cloneable.h>
 #include <torch/nn/init.h>
 #include <torch/nn/module.h>
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <torch/nn/pimpl.h>
+#include <torch/types.h>
+
+#include <torch/csrc/autograd/functions/checkpoint.h>
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/utils/functional.h>
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace nn {
+namespace detail {
+inline autograd::variable_list as_variables(const std::vector<Tensor>& tensors) {
+  return fmap(tensors, [](const Tensor& tensor) -> autograd::Variable {
+    return autograd::as_variable_ref(tensor);
+  });
+}
+} // namespace detail
+
+/// Runs `function(inputs)` without keeping the intermediate values its
+/// backward pass needs, and computes them again by running `function` a
+/// second time when the outputs are backpropagated through. This trades
+/// compute for memory: only the inputs of each checkpointed segment of a
+/// deep model stay alive until backward. Gradients are accumulated into the
+/// parameters `function` uses, so the outputs must be used with
+/// `backward()`. `function` must compute the same thing when it is run
+/// again; the state of the CPU generator is restored for it, random ops on
+/// CUDA are not replayed.
+inline std::vector<Tensor> checkpoint(
+    std::function<std::vector<Tensor>(const std::vector<Tensor>&)> function,
+    const std::vector<Tensor>& inputs) {
+  auto outputs = autograd::checkpoint(
+      [function](const autograd::variable_list& inputs) {
+        return detail::as_variables(
+            function(std::vector<Tensor>(inputs.begin(), inputs.end())));
+      },
+      detail::as_variables(inputs));
+  return {outputs.begin(), outputs.end()};
+}
+
+/// Checkpoints the `forward()` of a module that takes and returns a single
+/// tensor, e.g. a block of a `Sequential`. See `checkpoint()` above.
+template <typename ModuleType>
+Tensor checkpoint(ModuleHolder<ModuleType> module, const Tensor& input) {
+  // the lambda is const, so it holds the module by a shared_ptr to a
+  // non-const module rather than by a const ModuleHolder
+  std::shared_ptr<ModuleType> impl = module.ptr();
+  return checkpoint(
+      [impl](const std::vector<Tensor>& inputs) {
+        return std::vector<Tensor>{impl->forward(inputs[0])};
+      },
+      {input})[0];
+}
+
+} // namespace nn
+} // namespace torch
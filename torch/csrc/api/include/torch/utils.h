@@ -1,6 +1,7 @@
 #pragma once
 
 #include <torch/csrc/autograd/grad_mode.h>
+#include <torch/csrc/autograd/saved_variable.h>
 
 #include <cstdint>
 
@@ -13,6 +14,10 @@ struct TORCH_API NoGradGuard : public AutoGradMode {
   NoGradGuard() : AutoGradMode(/*enabled=*/false) {}
 };
 
+/// A RAII, thread local (!) guard that moves the tensors saved for backward
+/// by future CUDA operations to pinned host memory until they are needed.
+using autograd::SavedVariableOffloadGuard;
+
 /// Sets the global random seed for all newly created CPU and CUDA tensors.
 using at::manual_seed;
 } // namespace torch
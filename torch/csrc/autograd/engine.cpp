@@ -11,6 +11,7 @@
 #include <ATen/ExpandUtils.h>
 #include <c10/util/Exception.h>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -50,11 +51,13 @@ static thread_local int worker_device = NO_DEVICE;
 static thread_local bool checkpoint_valid = true;
 
 // XXX: Changes to the way multithreading works in execute should be done with
-// great care. Right now the implementation guarantees that a single function's
-// apply will never be entered concurrently (even if multiple graphs are
-// executed at the same time). Adding multiple threads per-device or removing
-// engine thread affinity to the device can break this invariant, and we depend
-// on it in a few places (e.g. AccumulateGrad function).
+// great care. A single function's apply is entered at most once per graph
+// task, but when the CPU has more than one worker thread (see
+// Engine::set_num_cpu_threads), the functions of concurrent backward calls
+// that share part of their graph may run at the same time. AccumulateGrad
+// locks itself for this. Other functions only read their saved state in
+// apply, except for releasing it when keep_graph is false, and backward
+// calls sharing a graph that doesn't retain it were already an error.
 
 struct FunctionTask {
   GraphTask* base;
@@ -77,13 +80,27 @@ struct CompareFunctionTaskTime {
   }
 };
 
+// The CPU queue is shared by all CPU worker threads, which take tasks from it
+// in the order given by CompareFunctionTaskTime.
 struct ReadyQueue {
   std::priority_queue<FunctionTask, std::vector<FunctionTask>, CompareFunctionTaskTime> heap;
   std::condition_variable not_empty;
   std::mutex mutex;
+  // The number of idle workers that should exit, see
+  // Engine::set_num_cpu_threads
+  int workers_to_stop = 0;
 
   void push(FunctionTask item);
-  FunctionTask pop();
+  // Waits for a task, or returns a task without a base if graph_task is
+  // finished first or, for a worker outside of any graph task, if it should
+  // exit
+  FunctionTask pop(GraphTask* graph_task);
+  // Wakes up the threads waiting for their graph task to finish
+  void notify_all();
+  // Asks n idle workers to exit
+  void stop_workers(int n);
+  // Withdraws up to n requests to exit, returns how many were withdrawn
+  int keep_workers(int n);
 };
 
 // Note [Reentrant backwards]
@@ -95,9 +112,9 @@ struct ReadyQueue {
 //  differentiation finishes so that you can get the final result variables
 //  of the backwards pass.
 //
-//  2. The engine operates by having a single worker thread per work queue,
-//  and every work queue is pinned to a specific device where the
-//  operation is executed.
+//  2. The engine operates by having worker threads per work queue (one per
+//  GPU, a configurable number for the CPU), and every work queue is pinned
+//  to a specific device where the operation is executed.
 //
 // The problem is, suppose that you call backward() inside of a worker
 // thread.  By property (1), we're supposed to block until the nested task
@@ -119,8 +136,10 @@ struct ReadyQueue {
 //
 //  - When we finish a GraphTask, we have to make sure we wake up the worker
 //    thread so that it actually has a chance to exit the thread_main()
-//    loop.  Thus the faffing about in thread_main() after
-//    evaluate_function() completes.
+//    loop, even if another thread of the same device finished it.  Thus
+//    the faffing about in thread_main() after evaluate_function()
+//    completes, and ReadyQueue::pop() returning when the graph task is
+//    done.
 
 
 // GraphTask holds metadata needed for a single execution of backward()
@@ -189,14 +208,47 @@ auto ReadyQueue::push(FunctionTask item) -> void {
   not_empty.notify_one();
 }
 
-auto ReadyQueue::pop() -> FunctionTask {
+auto ReadyQueue::pop(GraphTask* graph_task) -> FunctionTask {
   std::unique_lock<std::mutex> lock(mutex);
-  not_empty.wait(lock, [this]{ return !heap.empty(); });
+  auto finished = [graph_task]{
+    return graph_task && graph_task->outstanding_tasks.load() == 0;
+  };
+  auto stopped = [&]{
+    return !graph_task && workers_to_stop > 0;
+  };
+  not_empty.wait(lock, [&]{ return !heap.empty() || finished() || stopped(); });
+  if (finished()) {
+    return FunctionTask(nullptr, nullptr, InputBuffer(0));
+  }
+  if (stopped()) {
+    workers_to_stop--;
+    return FunctionTask(nullptr, nullptr, InputBuffer(0));
+  }
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
   auto task = std::move(const_cast<FunctionTask&>(heap.top())); heap.pop();
   return task;
 }
 
+auto ReadyQueue::notify_all() -> void {
+  // Take the mutex so that a thread that just saw its graph task unfinished
+  // is already waiting
+  std::lock_guard<std::mutex> lock(mutex);
+  not_empty.notify_all();
+}
+
+auto ReadyQueue::stop_workers(int n) -> void {
+  std::lock_guard<std::mutex> lock(mutex);
+  workers_to_stop += n;
+  not_empty.notify_all();
+}
+
+auto ReadyQueue::keep_workers(int n) -> int {
+  std::lock_guard<std::mutex> lock(mutex);
+  int kept = std::min(n, workers_to_stop);
+  workers_to_stop -= kept;
+  return kept;
+}
+
 Engine::Engine() = default;
 
 // This Engine's ReadyQueues and their corresponding threads are leaked here
@@ -240,7 +292,9 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
   // Why the test on graph_task->outstanding_tasks?  See
   // Note [Reentrant backwards]
   while (!graph_task || graph_task->outstanding_tasks > 0) {
-    FunctionTask task = queue->pop();
+    FunctionTask task = queue->pop(graph_task);
+    // graph_task finished while we were waiting, or this worker was stopped
+    if (!task.base) break;
     if (task.fn && !task.base->has_error.load()) {
       GradMode::set_enabled(task.base->grad_mode);
       try {
@@ -260,20 +314,16 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
         task.base->not_done.notify_all();
       }
     } else {
-      // If it's a task initiated from this thread, decrease the counter, but
-      // don't do anything - loop condition will do all checks for us next.
-      if (base_owner == worker_device) {
-        --task.base->outstanding_tasks;
-      // Otherwise send a dummy function task to the owning thread just to
-      // ensure that it's not sleeping. If it has work, it might see that
-      // graph_task->outstanding_tasks == 0 before it gets to the task, but
-      // it's a no-op anyway.
-      } else if (base_owner != worker_device) {
-        if (--task.base->outstanding_tasks == 0) {
-          // Synchronize outstanding_tasks with queue mutex
-          std::atomic_thread_fence(std::memory_order_release);
-          ready_queue(base_owner).push(FunctionTask(task.base, nullptr, InputBuffer(0)));
-        }
+      // Wake up the owning thread, in case it's waiting in the queue of its
+      // device. If this is the owning thread, the loop condition will do all
+      // checks for us next. If the owning thread has work, it might see that
+      // graph_task->outstanding_tasks == 0 after it's done with it.
+      // CPU workers share their queue, so the owner may be another thread
+      // of the same device, even when a single worker is requested, while
+      // stopped ones finish their task.
+      if (--task.base->outstanding_tasks == 0 &&
+          (base_owner != worker_device || base_owner == -1)) {
+        ready_queue(base_owner).notify_all();
       }
     }
   }
@@ -627,6 +677,30 @@ auto Engine::ready_queue(int device) -> ReadyQueue& {
   return *ready_queues.at(device + 1);
 }
 
+auto Engine::set_num_cpu_threads(int num_threads) -> void {
+  AT_CHECK(num_threads > 0, "the number of CPU threads must be positive, but got ", num_threads);
+  std::lock_guard<std::mutex> lock(cpu_threads_mutex_);
+  if (cpu_threads_started_) {
+    // Surplus workers exit once they are idle; new ones first take the
+    // place of those that haven't yet.
+    auto& queue = ready_queue(-1);
+    int delta = num_threads - num_cpu_threads_;
+    if (delta < 0) {
+      queue.stop_workers(-delta);
+    } else {
+      for (int i = queue.keep_workers(delta); i < delta; ++i) {
+        std::thread t(&Engine::thread_init, this, -1);
+        t.detach();
+      }
+    }
+  }
+  num_cpu_threads_ = num_threads;
+}
+
+auto Engine::num_cpu_threads() const -> int {
+  return num_cpu_threads_;
+}
+
 auto Engine::start_threads() -> void {
   int num_devices = 0;
 #ifdef USE_CUDA
@@ -637,14 +711,21 @@ auto Engine::start_threads() -> void {
   }
 #endif
   // One for CPU, plus one for every GPU device
-  int num_threads = num_devices + 1;
-  ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_threads);
+  int num_queues = num_devices + 1;
+  ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_queues);
   for (auto& queue : ready_queues)
     queue.reset(new ReadyQueue());
-  for (int i = 0; i < num_threads; ++i) {
+  // The CPU queue is shared by num_cpu_threads_ threads, every GPU gets one
+  std::lock_guard<std::mutex> lock(cpu_threads_mutex_);
+  for (int i = 0; i < num_cpu_threads_; ++i) {
+    std::thread t(&Engine::thread_init, this, -1);
+    t.detach();
+  }
+  for (int i = 1; i < num_queues; ++i) {
     std::thread t(&Engine::thread_init, this, i - 1);
     t.detach();
   }
+  cpu_threads_started_ = true;
 }
 
 void GraphTask::init_to_execute(Function& graph_root, const edge_list& outputs) {
@@ -8,10 +8,12 @@
 #include "torch/csrc/autograd/input_buffer.h"
 #include "torch/csrc/autograd/anomaly_mode.h"
 
+#include <atomic>
 #include <deque>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -51,6 +53,13 @@ struct TORCH_API Engine {
 
   bool is_checkpoint_valid();
 
+  // Sets the number of threads that run the functions of the backward pass on
+  // the CPU (1 by default). They take tasks from the same queue, so
+  // independent branches of the graph run in parallel. Can be called at any
+  // time; when it decreases, the surplus threads exit once they are idle.
+  void set_num_cpu_threads(int num_threads);
+  int num_cpu_threads() const;
+
 protected:
   void compute_dependencies(Function* root, GraphTask& task);
   void evaluate_function(FunctionTask& task);
@@ -64,6 +73,9 @@ protected:
   std::vector<std::shared_ptr<ReadyQueue>> ready_queues;
   std::vector<std::function<void()>> final_callbacks;
   std::mutex post_callbacks_lock;
+  std::atomic<int> num_cpu_threads_{1};
+  std::mutex cpu_threads_mutex_;
+  bool cpu_threads_started_ = false;
 };
 
 // allow python_engine to override the default engine when it loads
@@ -7,6 +7,7 @@
 #include "torch/csrc/autograd/functions/utils.h"
 
 #include <cstdint>
+#include <mutex>
 #include <stdexcept>
 #include <utility>
 
@@ -23,8 +24,8 @@ AccumulateGrad::AccumulateGrad(Variable variable_)
 }
 
 auto AccumulateGrad::apply(variable_list&& grads) -> variable_list {
-  // XXX: this method is not thread-safe!
   check_input_variables("AccumulateGrad", grads, 1, 0);
+  std::lock_guard<std::mutex> lock(mutex_);
 
   if (!grads[0].defined())
     return {};
@@ -3,6 +3,8 @@
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/variable.h"
 
+#include <mutex>
+
 namespace torch { namespace autograd {
 
 struct AccumulateGrad : public Function {
@@ -11,6 +13,11 @@ struct AccumulateGrad : public Function {
   variable_list apply(variable_list&& grads) override;
 
   Variable variable;
+
+ private:
+  // Backward passes running on different CPU worker threads can accumulate
+  // into the same leaf
+  std::mutex mutex_;
 };
 
 }} // namespace torch::autograd
@@ -0,0 +1,123 @@
+#include "torch/csrc/autograd/functions/checkpoint.h"
+
+#include "torch/csrc/autograd/engine.h"
+#include "torch/csrc/autograd/functions/utils.h"
+#include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/autograd/variable.h"
+
+#include <ATen/ATen.h>
+#include <c10/util/Exception.h>
+
+#include <memory>
+#include <utility>
+
+namespace torch { namespace autograd {
+
+namespace {
+
+std::unique_ptr<at::Generator> copy_cpu_rng_state() {
+  auto state = at::getNonVariableType(at::Backend::CPU, at::kByte).generator();
+  state->copy(at::globalContext().defaultGenerator(at::kCPU));
+  return state;
+}
+
+} // anonymous namespace
+
+Checkpoint::Checkpoint(
+    CheckpointFunction fn_,
+    const variable_list& inputs_,
+    edge_list&& next_edges)
+    : Function(std::move(next_edges)), fn(std::move(fn_)) {
+  inputs.reserve(inputs_.size());
+  for (const auto& input : inputs_) {
+    inputs.emplace_back(input, /*is_output=*/false);
+  }
+}
+
+auto Checkpoint::apply(variable_list&& grads) -> variable_list {
+  AT_CHECK(
+      Engine::get_default_engine().is_checkpoint_valid(),
+      "Checkpointing is not compatible with .grad(), please use .backward() if possible");
+  AT_CHECK(fn, ERR_BACKWARD_TWICE);
+
+  variable_list detached_inputs;
+  detached_inputs.reserve(inputs.size());
+  for (const auto& saved : inputs) {
+    auto input = saved.unpack();
+    if (!input.defined()) {
+      detached_inputs.emplace_back();
+      continue;
+    }
+    auto detached = input.detach();
+    detached.set_requires_grad(input.requires_grad());
+    detached_inputs.push_back(std::move(detached));
+  }
+
+  bool create_graph = GradMode::is_enabled();
+  variable_list outputs;
+  {
+    auto surrounding_rng_state = copy_cpu_rng_state();
+    auto& cpu_generator = at::globalContext().defaultGenerator(at::kCPU);
+    cpu_generator.copy(*cpu_rng_state);
+    AutoGradMode enable_grad(true);
+    try {
+      outputs = fn(detached_inputs);
+    } catch (...) {
+      cpu_generator.copy(*surrounding_rng_state);
+      throw;
+    }
+    cpu_generator.copy(*surrounding_rng_state);
+  }
+  AT_CHECK(
+      outputs.size() == grads.size(), "a checkpointed function returned ",
+      outputs.size(), " outputs when it was run again, but ", grads.size(),
+      " in the forward pass");
+
+  edge_list roots;
+  variable_list root_grads;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    if (outputs[i].defined() && outputs[i].requires_grad() && grads[i].defined()) {
+      roots.push_back(outputs[i].gradient_edge());
+      root_grads.push_back(std::move(grads[i]));
+    }
+  }
+  if (!roots.empty()) {
+    Engine::get_default_engine().execute(
+        roots, root_grads, /*keep_graph=*/false, create_graph);
+  }
+
+  variable_list grad_inputs;
+  grad_inputs.reserve(detached_inputs.size());
+  for (auto& input : detached_inputs) {
+    grad_inputs.push_back(input.defined() ? as_variable_ref(input.grad()) : Variable());
+  }
+  return grad_inputs;
+}
+
+void Checkpoint::release_variables() {
+  inputs.clear();
+  fn = nullptr;
+}
+
+variable_list checkpoint(CheckpointFunction fn, const variable_list& inputs) {
+  auto cpu_rng_state = copy_cpu_rng_state();
+  variable_list outputs;
+  {
+    AutoGradMode no_grad(false);
+    outputs = fn(inputs);
+    // fn may return one of its inputs, whose history must not be replaced
+    for (auto& output : outputs) {
+      if (output.defined()) {
+        output = output.detach();
+      }
+    }
+  }
+  if (compute_requires_grad(inputs)) {
+    auto grad_fn = std::make_shared<Checkpoint>(std::move(fn), inputs, collect_next_edges(inputs));
+    grad_fn->cpu_rng_state = std::move(cpu_rng_state);
+    set_history(outputs, grad_fn);
+  }
+  return outputs;
+}
+
+}}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "torch/csrc/WindowsTorchApiMacro.h"
+#include "torch/csrc/autograd/function.h"
+#include "torch/csrc/autograd/saved_variable.h"
+#include "torch/csrc/autograd/variable.h"
+
+#include <ATen/core/Generator.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace torch { namespace autograd {
+
+using CheckpointFunction = std::function<variable_list(const variable_list&)>;
+
+// The grad_fn of the outputs of a checkpointed segment. It only saves the
+// inputs of the segment; in backward it runs fn again on them with grad mode
+// enabled, which saves the activations for the duration of this apply, and
+// backpropagates through the result with a nested call to the Engine. Like
+// the Python checkpoint, this accumulates into the .grad of every leaf fn
+// uses, so it only works with backward(), not with grad().
+struct TORCH_API Checkpoint : public Function {
+  Checkpoint(CheckpointFunction fn, const variable_list& inputs, edge_list&& next_edges);
+
+  variable_list apply(variable_list&& grads) override;
+  void release_variables() override;
+
+  CheckpointFunction fn;
+  std::vector<SavedVariable> inputs;
+  // The state of the CPU generator before the forward pass, so that random
+  // ops give the same results when they are run again
+  std::unique_ptr<at::Generator> cpu_rng_state;
+};
+
+// Runs fn(inputs) without saving the variables needed for its backward, and
+// returns its outputs, which run fn again when they are backpropagated
+// through. Trades compute for memory in deep models. fn must compute the
+// same thing every time it's called; only the state of the CPU generator is
+// restored for it, random ops on CUDA tensors are not.
+TORCH_API variable_list checkpoint(CheckpointFunction fn, const variable_list& inputs);
+
+}}
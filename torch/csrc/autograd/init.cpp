@@ -6,6 +6,9 @@
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/python_function.h"
 #include "torch/csrc/autograd/function.h"
+#include "torch/csrc/autograd/functions/checkpoint.h"
+#include "torch/csrc/autograd/saved_variable.h"
+#include "torch/csrc/utils/auto_gil.h"
 
 PyObject * THPAutograd_initExtension(PyObject *_unused)
 {
@@ -50,6 +53,79 @@ PyObject * THPAutograd_initExtension(PyObject *_unused)
   });
   m.def("_pop_range", []() { torch::autograd::profiler::popRange(); });
 
+  py::class_<torch::autograd::profiler::SampledOpStats>(m, "SampledOpStats")
+      .def_readonly("name", &torch::autograd::profiler::SampledOpStats::name)
+      .def_readonly("shapes", &torch::autograd::profiler::SampledOpStats::shapes)
+      .def_readonly("count", &torch::autograd::profiler::SampledOpStats::count)
+      .def_readonly("total_ns", &torch::autograd::profiler::SampledOpStats::total_ns)
+      .def_readonly("max_ns", &torch::autograd::profiler::SampledOpStats::max_ns)
+      .def_readonly("p50_ns", &torch::autograd::profiler::SampledOpStats::p50_ns)
+      .def_readonly("p99_ns", &torch::autograd::profiler::SampledOpStats::p99_ns)
+      .def_readonly("allocations", &torch::autograd::profiler::SampledOpStats::allocations)
+      .def_readonly("allocated_bytes", &torch::autograd::profiler::SampledOpStats::allocated_bytes)
+      .def_readonly("frees", &torch::autograd::profiler::SampledOpStats::frees)
+      .def_readonly("freed_bytes", &torch::autograd::profiler::SampledOpStats::freed_bytes);
+
+  m.def("_enable_sampling_profiler", [](int64_t sample_period, bool record_shapes,
+                                        bool record_memory, int64_t max_trace_events) {
+    torch::autograd::profiler::SamplingProfilerConfig config;
+    config.sample_period = sample_period;
+    config.record_shapes = record_shapes;
+    config.record_memory = record_memory;
+    config.max_trace_events = max_trace_events;
+    torch::autograd::profiler::enableSamplingProfiler(config);
+  });
+  m.def("_disable_sampling_profiler", torch::autograd::profiler::disableSamplingProfiler);
+  m.def("_is_sampling_profiler_enabled", torch::autograd::profiler::isSamplingProfilerEnabled);
+  m.def("_sampling_profiler_stats", torch::autograd::profiler::samplingProfilerStats);
+  m.def("_reset_sampling_profiler", torch::autograd::profiler::resetSamplingProfiler);
+  m.def("_export_sampling_profiler_chrome_trace",
+        torch::autograd::profiler::exportSamplingProfilerChromeTrace);
+
+  using torch::autograd::Variable;
+  using torch::autograd::variable_list;
+  m.def("_checkpoint", [](py::function fn, variable_list inputs) {
+    // fn is called again from a worker thread in backward, and can be
+    // released on any thread
+    std::shared_ptr<PyObject> callable(fn.release().ptr(), [](PyObject* obj) {
+      AutoGIL gil;
+      Py_DECREF(obj);
+    });
+    return torch::autograd::checkpoint(
+        [callable](const variable_list& inputs) {
+          AutoGIL gil;
+          py::tuple args = py::cast(inputs);
+          py::object result = py::handle(callable.get())(*args);
+          if (THPVariable_Check(result.ptr())) {
+            return variable_list{result.cast<Variable>()};
+          }
+          return result.cast<variable_list>();
+        },
+        inputs);
+  });
+
+  m.def("_set_saved_tensors_offload", [](bool enabled) {
+    torch::autograd::SavedVariableOffload::set_enabled(enabled);
+  });
+  m.def("_is_saved_tensors_offload_enabled", []() {
+    return torch::autograd::SavedVariableOffload::is_enabled();
+  });
+  m.def("_set_saved_tensors_memory_stats_enabled",
+        torch::autograd::set_saved_variable_memory_stats_enabled);
+  m.def("_is_saved_tensors_memory_stats_enabled",
+        torch::autograd::saved_variable_memory_stats_enabled);
+  m.def("_saved_tensors_memory_stats", []() {
+    auto stats = torch::autograd::saved_variable_memory_stats();
+    py::dict result;
+    result["resident_bytes"] = stats.resident_bytes;
+    result["peak_resident_bytes"] = stats.peak_resident_bytes;
+    result["offloaded_bytes"] = stats.offloaded_bytes;
+    result["peak_offloaded_bytes"] = stats.peak_offloaded_bytes;
+    return result;
+  });
+  m.def("_reset_peak_saved_tensors_memory_stats",
+        torch::autograd::reset_peak_saved_variable_memory_stats);
+
   Py_RETURN_TRUE;
 }
 
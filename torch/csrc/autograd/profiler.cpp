@@ -5,7 +5,14 @@
 #include "ATen/cuda/CUDAGuard.h"
 #endif
 
+#include <c10/core/Allocator.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
 #include <sstream>
+#include <unordered_map>
 
 namespace torch { namespace autograd { namespace profiler {
 
@@ -101,6 +108,407 @@ void popRange() {
   }
 }
 
+// Sampling profiler
+//
+// Every thread counts its top-level RecordFunctions, and records one in
+// sample_period of them with everything nested in it. A call that isn't
+// recorded costs a check of the enabled flag and of the thread's nesting
+// depth. The recorded calls are aggregated by their thread into its own
+// table, under a mutex only taken by readers otherwise, so threads never
+// wait for each other.
+
+namespace {
+
+std::atomic<bool> sampling_enabled{false};
+std::atomic<int64_t> sample_period{100};
+std::atomic<bool> sample_shapes{true};
+std::atomic<bool> sample_memory{false};
+std::atomic<int64_t> max_trace_events{1 << 16};
+
+// Latencies in buckets of 1/8 of a power of two
+struct LatencyHistogram {
+  static constexpr int kSubBuckets = 8;
+  static constexpr int kBuckets = 64 * kSubBuckets;
+
+  static int bucket(int64_t ns) {
+    if (ns < kSubBuckets) return static_cast<int>(std::max<int64_t>(ns, 0));
+    int log = 3;
+    while ((ns >> (log + 1)) != 0) log++;
+    int sub = static_cast<int>((ns >> (log - 3)) & (kSubBuckets - 1));
+    return (log - 2) * kSubBuckets + sub;
+  }
+
+  // the upper bound of the bucket
+  static int64_t bound(int index) {
+    if (index < kSubBuckets) return index;
+    int log = index / kSubBuckets + 2;
+    int64_t sub = index % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << (log - 3)) - 1;
+  }
+
+  void add(int64_t ns) {
+    counts[bucket(ns)]++;
+  }
+
+  void merge(const LatencyHistogram& other) {
+    for (int i = 0; i < kBuckets; ++i) {
+      counts[i] += other.counts[i];
+    }
+  }
+
+  int64_t percentile(double p, int64_t total) const {
+    int64_t rank = static_cast<int64_t>(p * total);
+    int64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+      seen += counts[i];
+      if (seen > rank) return bound(i);
+    }
+    return 0;
+  }
+
+  std::array<int64_t, kBuckets> counts{};
+};
+
+struct OpAggregate {
+  int64_t count = 0;
+  int64_t total_ns = 0;
+  int64_t max_ns = 0;
+  int64_t allocations = 0;
+  int64_t allocated_bytes = 0;
+  int64_t frees = 0;
+  int64_t freed_bytes = 0;
+  LatencyHistogram histogram;
+};
+
+struct MemoryCounts {
+  int64_t allocations = 0;
+  int64_t allocated_bytes = 0;
+  int64_t frees = 0;
+  int64_t freed_bytes = 0;
+};
+
+// A recorded call that is running
+struct SampleFrame {
+  std::string name;
+  std::string shapes;
+  int64_t start_ns;
+  MemoryCounts memory;
+};
+
+struct TraceEvent {
+  std::string name;
+  std::string shapes;
+  int64_t start_ns;
+  int64_t duration_ns;
+  MemoryCounts memory;
+};
+
+using OpKey = std::pair<std::string, std::string>;
+
+struct OpKeyHash {
+  size_t operator()(const OpKey& key) const {
+    return std::hash<std::string>()(key.first) * 31 + std::hash<std::string>()(key.second);
+  }
+};
+
+struct SamplingThreadState {
+  // Only touched by the owning thread
+  int64_t depth = 0;
+  int64_t top_level_calls = 0;
+  bool recording = false;
+  std::vector<SampleFrame> frames;
+
+  // Written by the owning thread, read and reset by others
+  std::mutex mutex;
+  std::unordered_map<OpKey, OpAggregate, OpKeyHash> ops;
+  std::vector<TraceEvent> trace; // a ring buffer
+  size_t trace_next = 0;
+  uint64_t thread_id;
+};
+
+void mergeOps(std::unordered_map<OpKey, OpAggregate, OpKeyHash>& into,
+              const std::unordered_map<OpKey, OpAggregate, OpKeyHash>& ops) {
+  for (const auto& entry : ops) {
+    auto& op = into[entry.first];
+    const auto& other = entry.second;
+    op.count += other.count;
+    op.total_ns += other.total_ns;
+    op.max_ns = std::max(op.max_ns, other.max_ns);
+    op.allocations += other.allocations;
+    op.allocated_bytes += other.allocated_bytes;
+    op.frees += other.frees;
+    op.freed_bytes += other.freed_bytes;
+    op.histogram.merge(other.histogram);
+  }
+}
+
+// The states of the running threads, and what the exited ones recorded: their
+// ops merged together and the latest of their trace events, in one ring of
+// at most max_trace_events. All guarded by sampling_states_mutex.
+std::mutex sampling_states_mutex;
+std::vector<SamplingThreadState*> sampling_states;
+std::unordered_map<OpKey, OpAggregate, OpKeyHash> exited_threads_ops;
+std::vector<std::pair<uint64_t, TraceEvent>> exited_threads_trace;
+size_t exited_threads_trace_next = 0;
+uint64_t next_sampling_thread_id = 0;
+
+void retireSamplingState(std::unique_ptr<SamplingThreadState> state) {
+  std::lock_guard<std::mutex> states_guard(sampling_states_mutex);
+  sampling_states.erase(
+      std::find(sampling_states.begin(), sampling_states.end(), state.get()));
+  std::lock_guard<std::mutex> guard(state->mutex);
+  mergeOps(exited_threads_ops, state->ops);
+  size_t max_events = static_cast<size_t>(max_trace_events.load(std::memory_order_relaxed));
+  for (auto& event : state->trace) {
+    if (max_events == 0) break;
+    std::pair<uint64_t, TraceEvent> entry(state->thread_id, std::move(event));
+    if (exited_threads_trace.size() < max_events) {
+      exited_threads_trace.push_back(std::move(entry));
+    } else {
+      exited_threads_trace[exited_threads_trace_next % exited_threads_trace.size()] = std::move(entry);
+    }
+    exited_threads_trace_next++;
+  }
+}
+
+// Owns the state of its thread and hands what it recorded over to
+// exited_threads_ops and exited_threads_trace when the thread exits, so
+// that threads that come and go don't each keep a trace buffer alive.
+struct SamplingStateOwner {
+  std::unique_ptr<SamplingThreadState> state;
+  ~SamplingStateOwner();
+};
+
+thread_local SamplingThreadState* sampling_state = nullptr;
+thread_local SamplingStateOwner sampling_state_owner;
+
+SamplingStateOwner::~SamplingStateOwner() {
+  if (state) {
+    sampling_state = nullptr;
+    retireSamplingState(std::move(state));
+  }
+}
+
+SamplingThreadState& getSamplingState() {
+  if (!sampling_state) {
+    std::unique_ptr<SamplingThreadState> state(new SamplingThreadState());
+    std::lock_guard<std::mutex> guard(sampling_states_mutex);
+    state->thread_id = next_sampling_thread_id++;
+    sampling_states.push_back(state.get());
+    sampling_state = state.get();
+    sampling_state_owner.state = std::move(state);
+  }
+  return *sampling_state;
+}
+
+// Returns whether the call is recorded
+bool enterSampledCall(SamplingThreadState& state) {
+  if (state.depth++ == 0) {
+    state.recording = ++state.top_level_calls % sample_period.load(std::memory_order_relaxed) == 0;
+  }
+  return state.recording;
+}
+
+// The bytes of the CPU allocations made by recorded calls that are still
+// alive, so that their frees can be counted. Sharded by address to keep
+// frees on different threads from waiting for each other. Each shard also
+// keeps a bit per address hash, set on insert and reset once the shard is
+// empty, so that most frees, of allocations that were never tracked, return
+// without taking the lock.
+struct LiveAllocations {
+  static constexpr size_t kShards = 16;
+  static constexpr size_t kMaxPerShard = 1 << 16;
+  static constexpr size_t kFilterWords = 256;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<void*, size_t> sizes;
+    std::array<std::atomic<uint64_t>, kFilterWords> filter;
+  };
+
+  LiveAllocations() {
+    for (auto& s : shards) resetFilter(s);
+  }
+
+  static size_t hash(void* ptr) {
+    return reinterpret_cast<uintptr_t>(ptr) >> 6;
+  }
+
+  Shard& shard(void* ptr) {
+    return shards[hash(ptr) % kShards];
+  }
+
+  static std::atomic<uint64_t>& filterWord(Shard& s, void* ptr, uint64_t& bit) {
+    size_t h = hash(ptr) / kShards;
+    bit = uint64_t(1) << (h % 64);
+    return s.filter[(h / 64) % kFilterWords];
+  }
+
+  void insert(void* ptr, size_t nbytes) {
+    auto& s = shard(ptr);
+    std::lock_guard<std::mutex> guard(s.mutex);
+    if (s.sizes.size() < kMaxPerShard) {
+      s.sizes[ptr] = nbytes;
+      uint64_t bit;
+      filterWord(s, ptr, bit).fetch_or(bit, std::memory_order_relaxed);
+    }
+  }
+
+  // the size of ptr if it was tracked, or 0
+  size_t erase(void* ptr) {
+    auto& s = shard(ptr);
+    uint64_t bit;
+    // the bit was set under the lock before ptr could be freed
+    if (!(filterWord(s, ptr, bit).load(std::memory_order_relaxed) & bit)) return 0;
+    std::lock_guard<std::mutex> guard(s.mutex);
+    auto it = s.sizes.find(ptr);
+    if (it == s.sizes.end()) return 0;
+    size_t nbytes = it->second;
+    s.sizes.erase(it);
+    if (s.sizes.empty()) resetFilter(s);
+    return nbytes;
+  }
+
+  void clear() {
+    for (auto& s : shards) {
+      std::lock_guard<std::mutex> guard(s.mutex);
+      s.sizes.clear();
+      resetFilter(s);
+    }
+  }
+
+  static void resetFilter(Shard& s) {
+    for (auto& word : s.filter) word.store(0, std::memory_order_relaxed);
+  }
+
+  std::array<Shard, kShards> shards;
+};
+
+LiveAllocations live_allocations;
+
+struct SamplingMemoryObserver final : public c10::MemoryObserver {
+  void allocated(void* ptr, size_t nbytes, c10::Device device) override {
+    if (!sample_memory.load(std::memory_order_relaxed) || !sampling_state) return;
+    auto& state = *sampling_state;
+    if (!state.recording || state.frames.empty()) return;
+    auto& memory = state.frames.back().memory;
+    memory.allocations++;
+    memory.allocated_bytes += nbytes;
+    live_allocations.insert(ptr, nbytes);
+  }
+
+  void freed(void* ptr, c10::Device device) override {
+    if (!sample_memory.load(std::memory_order_relaxed)) return;
+    size_t nbytes = live_allocations.erase(ptr);
+    if (!sampling_state) return;
+    auto& state = *sampling_state;
+    if (!state.recording || state.frames.empty()) return;
+    auto& memory = state.frames.back().memory;
+    memory.frees++;
+    memory.freed_bytes += nbytes;
+  }
+};
+
+SamplingMemoryObserver sampling_memory_observer;
+
+std::string formatShapes(const std::vector<std::vector<int64_t>>& shapes) {
+  std::ostringstream out;
+  out << "[";
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    if (i > 0) out << ", ";
+    out << "[";
+    for (size_t j = 0; j < shapes[i].size(); ++j) {
+      if (j > 0) out << ", ";
+      out << shapes[i][j];
+    }
+    out << "]";
+  }
+  out << "]";
+  return out.str();
+}
+
+void writeJsonString(std::ostream& out, const std::string& str) {
+  out << '"';
+  for (char c : str) {
+    switch (c) {
+      case '"': out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      case '\n': out << "\\n"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out << ' ';
+        } else {
+          out << c;
+        }
+    }
+  }
+  out << '"';
+}
+
+} // anonymous namespace
+
+void RecordFunction::beginSample(const char* name) {
+  auto& state = getSamplingState();
+  sampled_ = true;
+  if (enterSampledCall(state)) {
+    state.frames.push_back(SampleFrame{name, std::string(), getTime(), MemoryCounts()});
+  }
+}
+
+void RecordFunction::beginSample(const std::string& name) {
+  auto& state = getSamplingState();
+  sampled_ = true;
+  if (enterSampledCall(state)) {
+    state.frames.push_back(SampleFrame{name, std::string(), getTime(), MemoryCounts()});
+  }
+}
+
+void RecordFunction::endSample() {
+  auto& state = *sampling_state;
+  if (state.recording && !state.frames.empty()) {
+    int64_t end_ns = getTime();
+    auto frame = std::move(state.frames.back());
+    state.frames.pop_back();
+    int64_t duration_ns = end_ns - frame.start_ns;
+
+    std::lock_guard<std::mutex> guard(state.mutex);
+    auto& op = state.ops[OpKey(frame.name, frame.shapes)];
+    op.count++;
+    op.total_ns += duration_ns;
+    op.max_ns = std::max(op.max_ns, duration_ns);
+    op.histogram.add(duration_ns);
+    op.allocations += frame.memory.allocations;
+    op.allocated_bytes += frame.memory.allocated_bytes;
+    op.frees += frame.memory.frees;
+    op.freed_bytes += frame.memory.freed_bytes;
+
+    size_t max_events = static_cast<size_t>(max_trace_events.load(std::memory_order_relaxed));
+    if (max_events > 0) {
+      TraceEvent event{std::move(frame.name), std::move(frame.shapes), frame.start_ns, duration_ns, frame.memory};
+      if (state.trace.size() < max_events) {
+        state.trace.push_back(std::move(event));
+      } else {
+        state.trace[state.trace_next % state.trace.size()] = std::move(event);
+      }
+      state.trace_next++;
+    }
+  }
+  if (--state.depth == 0) {
+    state.recording = false;
+  }
+}
+
+bool RecordFunction::recordsInputShapes() const {
+  return sampling_state->recording && sample_shapes.load(std::memory_order_relaxed);
+}
+
+void RecordFunction::recordInputShapes(const std::vector<std::vector<int64_t>>& shapes) {
+  auto& state = *sampling_state;
+  if (!state.frames.empty()) {
+    state.frames.back().shapes = formatShapes(shapes);
+  }
+}
+
 RecordFunction::RecordFunction(Function* fn) {
   // typeid(*fn).name() would avoid an additional string allocation.
   // However, typeid(*fn).name() would cause nvtx annotations for all user-defined 
@@ -109,19 +517,322 @@ RecordFunction::RecordFunction(Function* fn) {
   // fn->name() ensures that nvtx annotations for custom function backward() methods
   // receive a relevant, demangled name.
   pushRangeImpl(fn->name(), ", stashed seq=", fn->sequence_nr());
+  if (sampling_enabled.load(std::memory_order_relaxed)) {
+    // only pay for the name of the function if the call is recorded
+    auto& state = getSamplingState();
+    sampled_ = true;
+    if (enterSampledCall(state)) {
+      state.frames.push_back(SampleFrame{fn->name(), std::string(), getTime(), MemoryCounts()});
+    }
+  }
+  if (takeCallbacks()) {
+    owned_name_ = fn->name();
+    name_ = owned_name_.c_str();
+    sequence_nr_ = fn->sequence_nr();
+    runStartCallbacks();
+  }
 }
 
 RecordFunction::RecordFunction(std::string name) {
+  if (sampling_enabled.load(std::memory_order_relaxed)) {
+    beginSample(name);
+  }
+  if (takeCallbacks()) {
+    owned_name_ = name;
+    name_ = owned_name_.c_str();
+  }
   pushRangeImpl(std::move(name));
+  if (callbacks_) {
+    runStartCallbacks();
+  }
 }
 
 RecordFunction::RecordFunction(const char* name) {
   pushRangeImpl<const char*>(name);
+  if (sampling_enabled.load(std::memory_order_relaxed)) {
+    beginSample(name);
+  }
+  if (takeCallbacks()) {
+    name_ = name;
+    runStartCallbacks();
+  }
 }
 
 RecordFunction::RecordFunction(const char* name, int64_t current_sequence_nr)
+    : RecordFunction(name, current_sequence_nr, DeferCallbacks()) {
+  if (callbacks_) {
+    runStartCallbacks();
+  }
+}
+
+RecordFunction::RecordFunction(const char* name, int64_t current_sequence_nr, DeferCallbacks)
 {
   pushRangeImpl<const char*>(name, ", seq=", current_sequence_nr);
+  if (sampling_enabled.load(std::memory_order_relaxed)) {
+    beginSample(name);
+  }
+  if (takeCallbacks()) {
+    name_ = name;
+    sequence_nr_ = current_sequence_nr;
+  }
+}
+
+RecordFunction::RecordFunction(CallbacksOnly, const char* name, at::ArrayRef<c10::IValue> inputs)
+    : callbacks_only_(true) {
+  if (takeCallbacks()) {
+    name_ = name;
+    if (callbacksNeedInputs()) {
+      for (const auto& input : inputs) {
+        if (input.isTensor()) {
+          inputs_.push_back(input.toTensor());
+        } else if (input.isTensorList()) {
+          appendInputs(inputs_, input.toTensorListRef());
+        }
+      }
+    }
+    runStartCallbacks();
+  }
+}
+
+// RecordFunction callbacks
+//
+// The callbacks are kept in an immutable list that is replaced whenever one
+// is added or removed, so a call takes the current list with one atomic load
+// and runs the end callbacks of the same list it ran the start callbacks of.
+// Calls hold the list by a shared_ptr, so a replaced list, and the state its
+// callbacks captured, is freed when the last call that took it ends. A
+// separate flag keeps calls from touching the shared_ptr while there are no
+// callbacks.
+
+struct RecordFunctionCallbackList {
+  struct Entry {
+    uint64_t handle;
+    RecordFunctionCallback start;
+    RecordFunctionCallback end;
+    bool needs_inputs;
+  };
+  std::vector<Entry> entries;
+  bool needs_inputs = false;
+};
+
+namespace {
+
+// Only accessed through std::atomic_load and std::atomic_store
+std::shared_ptr<const RecordFunctionCallbackList> record_function_callbacks;
+std::atomic<bool> has_record_function_callbacks{false};
+std::mutex record_function_callbacks_mutex;
+uint64_t next_callback_handle = 1;
+thread_local bool callbacks_enabled = true;
+std::atomic<uint64_t> next_callbacks_thread_id{0};
+
+uint64_t callbacksThreadId() {
+  thread_local uint64_t id = next_callbacks_thread_id++;
+  return id;
+}
+
+// Must hold record_function_callbacks_mutex
+void publishCallbacks(std::unique_ptr<RecordFunctionCallbackList> list) {
+  for (const auto& entry : list->entries) {
+    list->needs_inputs = list->needs_inputs || entry.needs_inputs;
+  }
+  std::shared_ptr<const RecordFunctionCallbackList> published;
+  if (!list->entries.empty()) {
+    published = std::move(list);
+  }
+  has_record_function_callbacks.store(published != nullptr, std::memory_order_relaxed);
+  std::atomic_store(&record_function_callbacks, std::move(published));
+}
+
+// Disables the callbacks of the thread while callbacks run, so that the ops
+// they call don't run them again
+struct RunningCallbacksGuard {
+  RunningCallbacksGuard() : prev_enabled(callbacks_enabled) {
+    callbacks_enabled = false;
+  }
+  ~RunningCallbacksGuard() {
+    callbacks_enabled = prev_enabled;
+  }
+  bool prev_enabled;
+};
+
+} // anonymous namespace
+
+bool RecordFunction::takeCallbacks() {
+  if (!has_record_function_callbacks.load(std::memory_order_relaxed) || !callbacks_enabled) {
+    return false;
+  }
+  auto callbacks = std::atomic_load(&record_function_callbacks);
+  if (!callbacks) {
+    return false;
+  }
+  callbacks_ = std::move(callbacks);
+  thread_id_ = callbacksThreadId();
+  return true;
+}
+
+bool RecordFunction::callbacksNeedInputs() const {
+  return callbacks_->needs_inputs;
+}
+
+void RecordFunction::runStartCallbacks() {
+  RunningCallbacksGuard guard;
+  for (const auto& entry : callbacks_->entries) {
+    if (entry.start) {
+      entry.start(*this);
+    }
+  }
+}
+
+void RecordFunction::runEndCallbacks() {
+  RunningCallbacksGuard guard;
+  for (auto it = callbacks_->entries.rbegin(); it != callbacks_->entries.rend(); ++it) {
+    if (it->end) {
+      it->end(*this);
+    }
+  }
+}
+
+uint64_t addRecordFunctionCallback(
+    RecordFunctionCallback start,
+    RecordFunctionCallback end,
+    bool needs_inputs) {
+  std::lock_guard<std::mutex> guard(record_function_callbacks_mutex);
+  const auto current = std::atomic_load(&record_function_callbacks);
+  auto list = current ? std::unique_ptr<RecordFunctionCallbackList>(new RecordFunctionCallbackList(*current))
+                      : std::unique_ptr<RecordFunctionCallbackList>(new RecordFunctionCallbackList());
+  uint64_t handle = next_callback_handle++;
+  list->entries.push_back({handle, std::move(start), std::move(end), needs_inputs});
+  publishCallbacks(std::move(list));
+  return handle;
+}
+
+void removeRecordFunctionCallback(uint64_t handle) {
+  std::lock_guard<std::mutex> guard(record_function_callbacks_mutex);
+  const auto current = std::atomic_load(&record_function_callbacks);
+  if (!current) {
+    return;
+  }
+  std::unique_ptr<RecordFunctionCallbackList> list(new RecordFunctionCallbackList());
+  for (const auto& entry : current->entries) {
+    if (entry.handle != handle) {
+      list->entries.push_back(entry);
+    }
+  }
+  publishCallbacks(std::move(list));
+}
+
+bool hasRecordFunctionCallbacks() {
+  return has_record_function_callbacks.load(std::memory_order_relaxed) && callbacks_enabled;
+}
+
+bool RecordFunctionCallbacksMode::is_enabled() {
+  return callbacks_enabled;
+}
+
+void RecordFunctionCallbacksMode::set_enabled(bool enabled) {
+  callbacks_enabled = enabled;
+}
+
+void enableSamplingProfiler(SamplingProfilerConfig config) {
+  AT_CHECK(config.sample_period > 0, "sample_period must be positive, but got ", config.sample_period);
+  AT_CHECK(config.max_trace_events >= 0, "max_trace_events can't be negative");
+  sample_period = config.sample_period;
+  sample_shapes = config.record_shapes;
+  sample_memory = config.record_memory;
+  max_trace_events = config.max_trace_events;
+  c10::setMemoryObserver(config.record_memory ? &sampling_memory_observer : nullptr);
+  sampling_enabled = true;
+}
+
+void disableSamplingProfiler() {
+  sampling_enabled = false;
+  sample_memory = false;
+  c10::setMemoryObserver(nullptr);
+  live_allocations.clear();
+}
+
+bool isSamplingProfilerEnabled() {
+  return sampling_enabled;
+}
+
+std::vector<SampledOpStats> samplingProfilerStats() {
+  std::unordered_map<OpKey, OpAggregate, OpKeyHash> merged;
+  {
+    std::lock_guard<std::mutex> states_guard(sampling_states_mutex);
+    merged = exited_threads_ops;
+    for (auto& state : sampling_states) {
+      std::lock_guard<std::mutex> guard(state->mutex);
+      mergeOps(merged, state->ops);
+    }
+  }
+  std::vector<SampledOpStats> result;
+  result.reserve(merged.size());
+  for (const auto& entry : merged) {
+    const auto& op = entry.second;
+    SampledOpStats stats;
+    stats.name = entry.first.first;
+    stats.shapes = entry.first.second;
+    stats.count = op.count;
+    stats.total_ns = op.total_ns;
+    stats.max_ns = op.max_ns;
+    stats.p50_ns = std::min(op.histogram.percentile(0.5, op.count), op.max_ns);
+    stats.p99_ns = std::min(op.histogram.percentile(0.99, op.count), op.max_ns);
+    stats.allocations = op.allocations;
+    stats.allocated_bytes = op.allocated_bytes;
+    stats.frees = op.frees;
+    stats.freed_bytes = op.freed_bytes;
+    result.push_back(std::move(stats));
+  }
+  std::sort(result.begin(), result.end(), [](const SampledOpStats& a, const SampledOpStats& b) {
+    return a.total_ns > b.total_ns;
+  });
+  return result;
+}
+
+void resetSamplingProfiler() {
+  std::lock_guard<std::mutex> states_guard(sampling_states_mutex);
+  exited_threads_ops.clear();
+  exited_threads_trace.clear();
+  exited_threads_trace_next = 0;
+  for (auto& state : sampling_states) {
+    std::lock_guard<std::mutex> guard(state->mutex);
+    state->ops.clear();
+    state->trace.clear();
+    state->trace_next = 0;
+  }
+}
+
+void exportSamplingProfilerChromeTrace(const std::string& path) {
+  std::ofstream out(path);
+  AT_CHECK(out, "can't open ", path, " for writing");
+  out << "{\"traceEvents\": [";
+  bool first = true;
+  auto write_event = [&](uint64_t thread_id, const TraceEvent& event) {
+    out << (first ? "\n" : ",\n") << "{\"name\": ";
+    writeJsonString(out, event.name);
+    out << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << thread_id
+        << ", \"ts\": " << event.start_ns / 1000.0
+        << ", \"dur\": " << event.duration_ns / 1000.0
+        << ", \"args\": {\"shapes\": ";
+    writeJsonString(out, event.shapes);
+    out << ", \"allocations\": " << event.memory.allocations
+        << ", \"allocated_bytes\": " << event.memory.allocated_bytes
+        << ", \"frees\": " << event.memory.frees
+        << ", \"freed_bytes\": " << event.memory.freed_bytes << "}}";
+    first = false;
+  };
+  std::lock_guard<std::mutex> states_guard(sampling_states_mutex);
+  for (const auto& entry : exited_threads_trace) {
+    write_event(entry.first, entry.second);
+  }
+  for (auto& state : sampling_states) {
+    std::lock_guard<std::mutex> guard(state->mutex);
+    for (const auto& event : state->trace) {
+      write_event(state->thread_id, event);
+    }
+  }
+  out << "\n]}\n";
+  AT_CHECK(out, "failed to write the chrome trace to ", path);
 }
 
 #ifdef USE_CUDA
@@ -14,7 +14,9 @@
 #include <sstream>
 #include <forward_list>
 #include <tuple>
+#include <functional>
 #include "ATen/ATen.h"
+#include "ATen/core/ivalue.h"
 #include "torch/csrc/WindowsTorchApiMacro.h"
 #include "torch/csrc/cuda/cuda_check.h"
 #ifdef USE_CUDA
@@ -195,6 +197,12 @@ TORCH_API void mark(std::string name, bool include_cuda = true);
 TORCH_API void pushRange(std::string name);
 TORCH_API void popRange();
 
+struct RecordFunction;
+struct RecordFunctionCallbackList;
+
+// Called when a RecordFunction starts or ends, see addRecordFunctionCallback
+using RecordFunctionCallback = std::function<void(const RecordFunction&)>;
+
 struct TORCH_API RecordFunction {
   explicit RecordFunction(Function* fn);
 
@@ -204,9 +212,142 @@ struct TORCH_API RecordFunction {
 
   explicit RecordFunction(const char* name, int64_t current_sequence_nr);
 
+  // Also records the tensor inputs of the call, for the sampling profiler and
+  // the callbacks that ask for them. They are only read if one of them does.
+  template <typename... Tensors>
+  RecordFunction(const char* name, int64_t current_sequence_nr, const Tensors&... inputs)
+      : RecordFunction(name, current_sequence_nr, DeferCallbacks()) {
+    if (sampled_ && recordsInputShapes()) {
+      std::vector<std::vector<int64_t>> shapes;
+      int expand[] = {0, (appendShapes(shapes, inputs), 0)...};
+      (void)expand;
+      recordInputShapes(shapes);
+    }
+    if (callbacks_) {
+      if (callbacksNeedInputs()) {
+        int expand[] = {0, (appendInputs(inputs_, inputs), 0)...};
+        (void)expand;
+      }
+      runStartCallbacks();
+    }
+  }
+
+  // Only runs the callbacks, for calls that the profilers don't record, e.g.
+  // the instructions of the JIT interpreter
+  struct CallbacksOnly {};
+  RecordFunction(CallbacksOnly, const char* name, at::ArrayRef<c10::IValue> inputs);
+
+  RecordFunction(const RecordFunction&) = delete;
+  RecordFunction& operator=(const RecordFunction&) = delete;
+
   ~RecordFunction() {
-    popRange();
+    if (callbacks_) {
+      runEndCallbacks();
+    }
+    if (!callbacks_only_) {
+      popRange();
+    }
+    if (sampled_) {
+      endSample();
+    }
+  }
+
+  // What the callbacks can look at. The name and the thread are only set
+  // while callbacks run.
+  const char* name() const {
+    return name_;
+  }
+  // -1 if the call doesn't have one
+  int64_t sequence_nr() const {
+    return sequence_nr_;
+  }
+  // The tensor inputs, with the tensors of lists flattened. Only recorded if
+  // a callback was added with needs_inputs, and for ops that pass them.
+  const std::vector<at::Tensor>& inputs() const {
+    return inputs_;
+  }
+  // Small integers given to threads in the order they first run callbacks
+  uint64_t thread_id() const {
+    return thread_id_;
+  }
+
+ private:
+  struct DeferCallbacks {};
+  RecordFunction(const char* name, int64_t current_sequence_nr, DeferCallbacks);
+
+  static void appendShapes(std::vector<std::vector<int64_t>>& shapes, const at::Tensor& tensor) {
+    shapes.push_back(tensor.defined() ? tensor.sizes().vec() : std::vector<int64_t>());
+  }
+  static void appendShapes(std::vector<std::vector<int64_t>>& shapes, at::TensorList tensors) {
+    for (const auto& tensor : tensors) {
+      appendShapes(shapes, tensor);
+    }
+  }
+  static void appendInputs(std::vector<at::Tensor>& inputs, const at::Tensor& tensor) {
+    inputs.push_back(tensor);
+  }
+  static void appendInputs(std::vector<at::Tensor>& inputs, at::TensorList tensors) {
+    inputs.insert(inputs.end(), tensors.begin(), tensors.end());
+  }
+
+  void beginSample(const char* name);
+  void beginSample(const std::string& name);
+  void endSample();
+  bool recordsInputShapes() const;
+  void recordInputShapes(const std::vector<std::vector<int64_t>>& shapes);
+
+  // Takes the callbacks of this thread, returns whether there are any
+  bool takeCallbacks();
+  bool callbacksNeedInputs() const;
+  void runStartCallbacks();
+  void runEndCallbacks();
+
+  // Whether the sampling profiler tracks this call, see profiler.cpp
+  bool sampled_ = false;
+  bool callbacks_only_ = false;
+  // The callbacks that ran when the call started, if any
+  std::shared_ptr<const RecordFunctionCallbackList> callbacks_;
+  const char* name_ = "";
+  std::string owned_name_;
+  int64_t sequence_nr_ = -1;
+  std::vector<at::Tensor> inputs_;
+  uint64_t thread_id_ = 0;
+};
+
+// Callbacks let other tracing and metrics systems observe every
+// RecordFunction, i.e. every ATen op called through VariableType, every
+// autograd Function and every instruction of the JIT interpreter, without
+// the profilers. start runs when the call starts and end when it ends, on
+// the thread that made the call, and both may be empty. A call runs the end
+// callbacks of the callbacks it ran at its start, even if they are removed
+// in between. Callbacks can be added and removed at any time, from any
+// thread. They must not throw, and RecordFunctions made by a callback don't
+// run callbacks. When no callback is added, a RecordFunction only pays for
+// an atomic load. Returns a handle for removeRecordFunctionCallback.
+TORCH_API uint64_t addRecordFunctionCallback(
+    RecordFunctionCallback start,
+    RecordFunctionCallback end,
+    bool needs_inputs = false);
+TORCH_API void removeRecordFunctionCallback(uint64_t handle);
+TORCH_API bool hasRecordFunctionCallbacks();
+
+// Whether the callbacks run for the calls of this thread, true by default
+struct TORCH_API RecordFunctionCallbacksMode {
+  static bool is_enabled();
+  static void set_enabled(bool enabled);
+};
+
+// A RAII, thread local guard that enables or disables the callbacks, and
+// sets them back upon destruction
+struct TORCH_API AutoRecordFunctionCallbacksMode {
+  AutoRecordFunctionCallbacksMode(bool enabled)
+      : prev_mode(RecordFunctionCallbacksMode::is_enabled()) {
+    RecordFunctionCallbacksMode::set_enabled(enabled);
+  }
+  ~AutoRecordFunctionCallbacksMode() {
+    RecordFunctionCallbacksMode::set_enabled(prev_mode);
   }
+  bool prev_mode;
 };
 
 using thread_event_lists = std::vector<std::vector<Event>>;
@@ -215,5 +356,46 @@ using thread_event_lists = std::vector<std::vector<Event>>;
 TORCH_API void enableProfiler(ProfilerState new_state);
 TORCH_API thread_event_lists disableProfiler();
 
+// The sampling profiler is meant to stay enabled in production. Instead of
+// recording every RecordFunction, each thread records one in sample_period
+// of its top-level calls (those not nested in another RecordFunction) and
+// all the calls nested in them, and aggregates them in place into a
+// histogram per op and input shapes. Only the most recent sampled calls are
+// kept for the chrome trace. It is independent of the profiler above, and
+// unlike it, can be enabled, read and disabled while ops are running.
+struct SamplingProfilerConfig {
+  int64_t sample_period = 100;
+  // record the sizes of the tensor inputs of the sampled ops
+  bool record_shapes = true;
+  // tie the CPU allocations and frees made by a sampled op to it
+  bool record_memory = false;
+  // the number of sampled calls kept for the chrome trace, per thread
+  int64_t max_trace_events = 1 << 16;
+};
+
+struct SampledOpStats {
+  std::string name;
+  std::string shapes;
+  int64_t count = 0;
+  int64_t total_ns = 0;
+  int64_t max_ns = 0;
+  // from a histogram with 8 buckets per power of two, so within 12.5%
+  int64_t p50_ns = 0;
+  int64_t p99_ns = 0;
+  int64_t allocations = 0;
+  int64_t allocated_bytes = 0;
+  int64_t frees = 0;
+  int64_t freed_bytes = 0;
+};
+
+TORCH_API void enableSamplingProfiler(SamplingProfilerConfig config = SamplingProfilerConfig());
+TORCH_API void disableSamplingProfiler();
+TORCH_API bool isSamplingProfilerEnabled();
+// The stats of every op and input shapes sampled since the last reset, by
+// decreasing total time
+TORCH_API std::vector<SampledOpStats> samplingProfilerStats();
+TORCH_API void resetSamplingProfiler();
+TORCH_API void exportSamplingProfilerChromeTrace(const std::string& path);
+
 } // namespace profiler
 }} // namespace torch::autograd
@@ -5,13 +5,115 @@
 #include "torch/csrc/autograd/variable.h"
 
 #include <ATen/Tensor.h>
+#include <ATen/detail/CUDAHooksInterface.h>
 
+#include <atomic>
 #include <cstdint>
 #include <list>
 #include <memory>
 
 namespace torch { namespace autograd {
 
+namespace {
+
+thread_local bool SavedVariableOffload_enabled = false;
+// Off by default so that saving a variable touches no shared counters
+std::atomic<bool> memory_stats_enabled{false};
+
+struct BytesCounter {
+  std::atomic<int64_t> current{0};
+  std::atomic<int64_t> peak{0};
+
+  void add(int64_t nbytes) {
+    int64_t now = current.fetch_add(nbytes) + nbytes;
+    int64_t prev_peak = peak.load();
+    while (now > prev_peak && !peak.compare_exchange_weak(prev_peak, now)) {}
+  }
+};
+
+BytesCounter resident_bytes;
+BytesCounter offloaded_bytes;
+
+BytesCounter& counter(bool offloaded) {
+  return offloaded ? offloaded_bytes : resident_bytes;
+}
+
+// A copy of a CUDA tensor in pinned host memory. The copy is synchronous:
+// backward may unpack the variable on another stream, which nothing would
+// order after a copy still running on the current one.
+at::Tensor offload(const at::Tensor& data) {
+  auto* allocator = at::detail::getCUDAHooks().getPinnedMemoryAllocator();
+  auto host = data.type().toBackend(at::Backend::CPU).tensorWithAllocator(data.sizes(), allocator);
+  host.copy_(data, /*non_blocking=*/false);
+  return host;
+}
+
+} // anonymous namespace
+
+bool SavedVariableOffload::is_enabled() {
+  return SavedVariableOffload_enabled;
+}
+
+void SavedVariableOffload::set_enabled(bool enabled) {
+  SavedVariableOffload_enabled = enabled;
+}
+
+bool saved_variable_memory_stats_enabled() {
+  return memory_stats_enabled.load(std::memory_order_relaxed);
+}
+
+void set_saved_variable_memory_stats_enabled(bool enabled) {
+  memory_stats_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+SavedVariableMemoryStats saved_variable_memory_stats() {
+  SavedVariableMemoryStats stats;
+  stats.resident_bytes = resident_bytes.current;
+  stats.peak_resident_bytes = resident_bytes.peak;
+  stats.offloaded_bytes = offloaded_bytes.current;
+  stats.peak_offloaded_bytes = offloaded_bytes.peak;
+  return stats;
+}
+
+void reset_peak_saved_variable_memory_stats() {
+  resident_bytes.peak = resident_bytes.current.load();
+  offloaded_bytes.peak = offloaded_bytes.current.load();
+}
+
+SavedVariable::SavedBytes::SavedBytes(int64_t nbytes, bool offloaded)
+    : nbytes(nbytes), offloaded(offloaded) {
+  counter(offloaded).add(nbytes);
+}
+
+auto SavedVariable::SavedBytes::of(const at::Tensor& data, bool offloaded) -> SavedBytes {
+  if (!saved_variable_memory_stats_enabled()) {
+    return SavedBytes();
+  }
+  return SavedBytes(data.numel() * data.type().elementSizeInBytes(), offloaded);
+}
+
+SavedVariable::SavedBytes::SavedBytes(SavedBytes&& other) noexcept
+    : nbytes(other.nbytes), offloaded(other.offloaded) {
+  other.nbytes = 0;
+}
+
+auto SavedVariable::SavedBytes::operator=(SavedBytes&& other) noexcept -> SavedBytes& {
+  if (this != &other) {
+    reset();
+    nbytes = other.nbytes;
+    offloaded = other.offloaded;
+    other.nbytes = 0;
+  }
+  return *this;
+}
+
+void SavedVariable::SavedBytes::reset() {
+  if (nbytes != 0) {
+    counter(offloaded).add(-nbytes);
+    nbytes = 0;
+  }
+}
+
 SavedVariable::SavedVariable(const Variable& variable, bool is_output) {
   if (variable.defined()) {
     was_default_constructed_ = false;
@@ -21,6 +123,11 @@ SavedVariable::SavedVariable(const Variable& variable, bool is_output) {
     // These copies are all shared_ptr copies, so slightly more expensive.
     // Do them here instead of in the init list in case data is undefined.
     data_ = variable.data();
+    if (SavedVariableOffload::is_enabled() && data_.is_cuda() && data_.is_contiguous()) {
+      offloaded_from_ = data_.device();
+      data_ = offload(data_);
+    }
+    saved_bytes_ = SavedBytes::of(data_, offloaded_from_.has_value());
     if (variable.is_leaf()) {
       grad_accumulator_ = variable.grad_accumulator();
     } else if (!is_output) {
@@ -55,14 +162,19 @@ Variable SavedVariable::unpack(std::shared_ptr<Function> saved_for) const {
     grad_fn = std::move(saved_for);
   }
 
+  auto data = data_;
+  if (offloaded_from_) {
+    data = data.to(data.options().device(*offloaded_from_), /*non_blocking=*/true);
+  }
+
   // NB: saved views are unpacked as normal Variables (not views) even though
   // they still share the same storage. This works only because we never call
   // in-place functions on unpacked variables.
   Variable var;
   if (grad_fn) {
-    var = make_variable(data_, Edge(std::move(grad_fn), output_nr_));
+    var = make_variable(data, Edge(std::move(grad_fn), output_nr_));
   } else {
-    var = make_variable(data_, requires_grad_);
+    var = make_variable(data, requires_grad_);
   }
   var.set_version_counter(saved_version_);
 
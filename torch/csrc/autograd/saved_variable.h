@@ -16,6 +16,48 @@ struct Function;
 
 TORCH_API extern const char* ERR_BACKWARD_TWICE;
 
+/// Whether saved CUDA tensors are moved to pinned host memory until backward.
+/// Like `GradMode`, this is thread local, and only affects the variables saved
+/// while it is enabled. Offloading lowers the device memory used by the
+/// activations of a deep model at the cost of a copy to the host in forward
+/// and one back to the device every time the variable is unpacked.
+struct TORCH_API SavedVariableOffload {
+  static bool is_enabled();
+  static void set_enabled(bool enabled);
+};
+
+/// A RAII, thread local guard that enables or disables offloading of saved
+/// variables, and sets it back to the original value upon destruction.
+struct TORCH_API SavedVariableOffloadGuard {
+  SavedVariableOffloadGuard(bool enabled = true)
+      : prev_mode(SavedVariableOffload::is_enabled()) {
+    SavedVariableOffload::set_enabled(enabled);
+  }
+  ~SavedVariableOffloadGuard() {
+    SavedVariableOffload::set_enabled(prev_mode);
+  }
+  bool prev_mode;
+};
+
+/// The bytes of the tensors held by all saved variables of the process,
+/// counting a tensor again for every variable that saves it. Resident bytes
+/// are kept on the device the tensors were computed on, offloaded bytes in
+/// host memory (see `SavedVariableOffload`). Only variables saved while
+/// `set_saved_variable_memory_stats_enabled(true)` is in effect are counted.
+struct SavedVariableMemoryStats {
+  int64_t resident_bytes = 0;
+  int64_t peak_resident_bytes = 0;
+  int64_t offloaded_bytes = 0;
+  int64_t peak_offloaded_bytes = 0;
+};
+
+TORCH_API bool saved_variable_memory_stats_enabled();
+/// Process wide, unlike `SavedVariableOffload`. Counting is off by default.
+TORCH_API void set_saved_variable_memory_stats_enabled(bool enabled);
+TORCH_API SavedVariableMemoryStats saved_variable_memory_stats();
+/// Sets the peaks to the current number of bytes.
+TORCH_API void reset_peak_saved_variable_memory_stats();
+
 /// A snapshot of a variable at a certain version. A `SavedVariable` stores
 /// enough information to reconstruct a variable from a certain point in time.
 class TORCH_API SavedVariable {
@@ -31,6 +73,7 @@ class TORCH_API SavedVariable {
   Variable unpack(std::shared_ptr<Function> saved_for = nullptr) const;
 
   void reset_data() {
+    saved_bytes_.reset();
     return data_.reset();
   }
 
@@ -39,7 +82,27 @@ class TORCH_API SavedVariable {
   }
 
  private:
+  // Counts the bytes of data_ in the memory stats while it is alive
+  struct TORCH_API SavedBytes {
+    SavedBytes() = default;
+    SavedBytes(int64_t nbytes, bool offloaded);
+    // Counts nothing unless the memory stats are enabled
+    static SavedBytes of(const at::Tensor& data, bool offloaded);
+    SavedBytes(SavedBytes&& other) noexcept;
+    SavedBytes& operator=(SavedBytes&& other) noexcept;
+    ~SavedBytes() {
+      reset();
+    }
+    void reset();
+
+    int64_t nbytes = 0;
+    bool offloaded = false;
+  };
+
   at::Tensor data_;
+  SavedBytes saved_bytes_;
+  // The device data_ was moved from if it is offloaded
+  c10::optional<at::Device> offloaded_from_;
 
   // The gradient function associated with this node. If has_grad_fn
   // is false, then this is a leaf node. Note that the grad_fn is not saved if
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include "torch/csrc/autograd/variable.h"
@@ -224,12 +225,34 @@ struct CompleteArgumentSpec {
       // each POD has a running tally of all dimensions including its own
       pod.total_dims = total_dims;
     }
-    // we precompute the hash_code to minimize the time inside of hash
-    // table operations where we may need to hold a compiler cache lock.
-    hash_code = hash_combine(0, ninputs);
-    for(auto d : data) {
-      hash_code = hash_combine(hash_code, d);
+    computeHashCode();
+  }
+
+  // The spec of contiguous inputs whose sizes are the sizes of this spec
+  // rounded up to powers of two, which inputs of similar sizes share
+  CompleteArgumentSpec roundUpSizes() const {
+    CompleteArgumentSpec result = *this;
+    auto pods = tensor_info();
+    int64_t* sizes = result.sizes_strides();
+    int32_t prev_total_dims = 0;
+    for (int32_t i = 0; i < ninputs; i++) {
+      const int32_t ndim = pods[i].total_dims - prev_total_dims;
+      prev_total_dims = pods[i].total_dims;
+      int64_t* strides = sizes + ndim;
+      int64_t stride = 1;
+      for (int32_t d = ndim - 1; d >= 0; d--) {
+        int64_t size = 1;
+        while (size < sizes[d]) {
+          size *= 2;
+        }
+        sizes[d] = sizes[d] == 0 ? 0 : size;
+        strides[d] = stride;
+        stride *= std::max<int64_t>(sizes[d], 1);
+      }
+      sizes += 2 * ndim;
     }
+    result.computeHashCode();
+    return result;
   }
 
   // equality is fast: check ninputs, and then check the raw array data,
@@ -250,6 +273,14 @@ struct CompleteArgumentSpec {
   }
 
 private:
+  // we precompute the hash_code to minimize the time inside of hash
+  // table operations where we may need to hold a compiler cache lock.
+  void computeHashCode() {
+    hash_code = hash_combine(0, ninputs);
+    for(auto d : data) {
+      hash_code = hash_combine(hash_code, d);
+    }
+  }
   ArrayRef<CompleteArgumentInfoPOD> tensor_info() const {
     return ArrayRef<CompleteArgumentInfoPOD>(
             reinterpret_cast<const CompleteArgumentInfoPOD*>(data.data()), ninputs);
@@ -23,6 +23,9 @@
 #include <cstdint>
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace torch { namespace jit { namespace fuser {
 
@@ -265,6 +268,194 @@ static void emitIndexingFor(
   }
 }
 
+// True if the tensor can be indexed with the linear index of the kernel
+static bool isFlatContiguous(const TensorDesc& desc) {
+  return desc.nDim() <= 1 && desc.lastIsContiguous();
+}
+
+// Accesses the element of the formal-th tensor. CPU kernels whose tensors
+// are all contiguous use the linear index instead of per-tensor offsets.
+static std::string tensorAccess(const size_t formal, const bool flat_index) {
+  const auto tensor = "t" + std::to_string(formal);
+  return tensor + ".data[" + (flat_index ? "linearIndex" : tensor + "_offset") + "]";
+}
+
+// Note [Fused row reductions]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// On the CPU, the pointwise ops of a fusion group can be followed by
+// reductions over the innermost dimension (sum, mean, max_values and
+// min_values), and their results can be used by further pointwise ops as long
+// as the reduced dimension is kept. The graph fuser decomposes softmax,
+// log_softmax and layer_norm over the last dimension into such ops.
+//
+// The innermost dimension of the map size is called a row. Values are either
+// computed per element (inputs and pointwise ops of them) or once per row
+// (reductions, and pointwise ops whose tensor inputs are all per-row values).
+// The kernel runs one iteration per row: every reduction loops over the row,
+// recomputing the per-element values it depends on, per-row values are
+// computed as soon as their inputs are, and a last loop over the row writes
+// the per-element outputs. A row stays in cache between these loops, so the
+// inputs are read from memory once however many reductions there are.
+//
+// This is only correct if every per-element value has the map size and
+// every per-row value has the map size with the innermost dimension set to 1,
+// which depends on the sizes of the inputs. The executor checks this before
+// launching the kernel and runs the fallback if it doesn't hold.
+
+std::unordered_set<const Value*> rowValues(const Graph& graph) {
+  std::unordered_set<const Value*> row_values;
+  for (const Node* n : graph.nodes()) {
+    if (isRowReduction(n)) {
+      row_values.insert(n->output());
+      continue;
+    }
+    if (n->kind() == prim::Constant) continue;
+    const bool per_row = std::all_of(
+      n->inputs().begin()
+    , n->inputs().end()
+    , [&](const Value* v) {
+        return !v->type()->isSubtypeOf(DynamicType::get()) || row_values.count(v) > 0;
+      });
+    if (per_row) {
+      row_values.insert(n->outputs().begin(), n->outputs().end());
+    }
+  }
+  return row_values;
+}
+
+#if USE_CPU_FUSER
+
+// Writes the body of the loop over rows of a kernel with row reductions
+// (see Note [Fused row reductions])
+static std::string emitRowReductionBody(
+  const Graph& graph
+, const std::vector<std::pair<const Value*, const TensorDesc&>>& flat_inputs
+, const std::vector<std::pair<const Value*, TensorDesc>>& flat_outputs
+, const std::vector<std::string>& formal_offsets
+, const bool flat_index) {
+  const auto row_values = rowValues(graph);
+  std::unordered_map<const Value*, size_t> input_formals;
+  for (size_t i = 0; i < flat_inputs.size(); ++i) {
+    input_formals.emplace(flat_inputs[i].first, i);
+  }
+
+  TemplateEnv env;
+  std::stringstream body;
+
+  // Writes a loop over the row that computes the per-element values roots
+  // depend on and then runs epilogue for every element
+  auto emitRowLoop = [&](
+    const std::vector<const Value*>& roots
+  , const std::string& pragma
+  , const std::string& epilogue) {
+    std::unordered_set<const Node*> nodes;
+    std::vector<bool> needs_input(flat_inputs.size(), false);
+    std::vector<const Value*> stack = roots;
+    while (!stack.empty()) {
+      const Value* v = stack.back();
+      stack.pop_back();
+      if (row_values.count(v) > 0) continue;
+      const auto input = input_formals.find(v);
+      if (input != input_formals.end()) {
+        needs_input[input->second] = true;
+        continue;
+      }
+      const Node* n = v->node();
+      if (n->kind() == prim::Constant || !nodes.insert(n).second) continue;
+      stack.insert(stack.end(), n->inputs().begin(), n->inputs().end());
+    }
+
+    body << pragma;
+    body << "for (IndexType i = 0; i < rowSize; ++i) {\n";
+    body << "IndexType linearIndex = row * rowSize + i;\n";
+    for (size_t i = 0; i < flat_inputs.size(); ++i) {
+      if (!needs_input[i]) continue;
+      if (!flat_index) body << formal_offsets[i];
+      env.s("node", valueName(flat_inputs[i].first));
+      env.s("access", tensorAccess(i, flat_index));
+      env.s("lhs_type", calcScalarTypeName(flat_inputs[i].second.scalar_type));
+      body << format("${lhs_type} ${node} = ${access};\n", env);
+    }
+    for (const Node* n : graph.nodes()) {
+      if (nodes.count(n) == 0) continue;
+      env.s("node", valueName(n->output()));
+      env.s("rhs", encodeRHS(n));
+      env.s("lhs_type", variableType(n->output()->type()));
+      body << format("${lhs_type} ${node} = ${rhs};\n", env);
+    }
+    body << epilogue;
+    body << "}\n";
+  };
+
+  // Scalar constants used by pointwise ops are shared by all loops
+  for (const Node* n : graph.nodes()) {
+    if (n->kind() != prim::Constant) continue;
+    const auto kind = n->output()->type()->kind();
+    if (kind != TypeKind::IntType && kind != TypeKind::FloatType) continue;
+    env.s("node", valueName(n->output()));
+    env.s("rhs", encodeRHS(n));
+    env.s("lhs_type", variableType(n->output()->type()));
+    body << format("${lhs_type} ${node} = ${rhs};\n", env);
+  }
+
+  for (const Node* n : graph.nodes()) {
+    if (n->kind() == prim::Constant) continue;
+    env.s("node", valueName(n->output()));
+    env.s("lhs_type", variableType(n->output()->type()));
+    if (isRowReduction(n)) {
+      env.s("in", valueName(n->input(0)));
+      if (n->kind() == aten::sum || n->kind() == aten::mean) {
+        body << format("${lhs_type} ${node} = 0;\n", env);
+        emitRowLoop(
+          {n->input(0)}
+        , format("#pragma omp simd reduction(+:${node})\n", env)
+        , format("${node} += ${in};\n", env));
+        if (n->kind() == aten::mean) {
+          body << format("${node} /= static_cast<${lhs_type}>(rowSize);\n", env);
+        }
+      } else {
+        // NaN propagates like in the unfused reductions
+        env.s("init", n->kind() == aten::max_values ? "NEG_INFINITY" : "POS_INFINITY");
+        env.s("cmp", n->kind() == aten::max_values ? ">" : "<");
+        body << format("${lhs_type} ${node} = ${init};\n", env);
+        emitRowLoop(
+          {n->input(0)}
+        , ""
+        , format("${node} = (${in} ${cmp} ${node} || ${in} != ${in}) ? ${in} : ${node};\n", env));
+      }
+    } else if (row_values.count(n->output()) > 0) {
+      env.s("rhs", encodeRHS(n));
+      body << format("${lhs_type} ${node} = ${rhs};\n", env);
+    }
+  }
+
+  // Writes the outputs
+  std::vector<const Value*> element_outputs;
+  std::stringstream element_writes;
+  for (size_t i = 0; i < flat_outputs.size(); ++i) {
+    const Value* o = flat_outputs[i].first;
+    const auto formal = flat_inputs.size() + i;
+    env.s("node", valueName(o));
+    if (row_values.count(o) > 0) {
+      // Outputs are allocated contiguous
+      env.s("tensor", "t" + std::to_string(formal));
+      body << format("${tensor}.data[row] = ${node};\n", env);
+    } else {
+      element_outputs.push_back(o);
+      env.s("access", tensorAccess(formal, flat_index));
+      if (!flat_index) element_writes << formal_offsets[formal];
+      element_writes << format("${access} = ${node};\n", env);
+    }
+  }
+  if (!element_outputs.empty()) {
+    emitRowLoop(element_outputs, flat_index ? "#pragma omp simd\n" : "", element_writes.str());
+  }
+
+  return body.str();
+}
+
+#endif // USE_CPU_FUSER
+
 // TODO: handle cases where we need to generate > 2^32 element tensors
 std::tuple<
   std::string
@@ -285,12 +476,18 @@ generateKernel(
   std::stringstream tensorOffsets;
   std::vector<std::string> formals;
   std::vector<std::string> argument_loads;
+  std::vector<std::string> formal_offsets;
+  bool all_contiguous = true;
 
   // Lambda for writing arguments
   auto emitFormal = [&](const Value* n, const TensorDesc& desc) {
     std::string tensor = "t" + std::to_string(formals.size()); //can't be unique() because Param may be an output
     const auto nDim = desc.nDim();
-    emitIndexingFor(tensorOffsets, tensor, nDim,  desc.lastIsContiguous());
+    all_contiguous = all_contiguous && isFlatContiguous(desc);
+    std::stringstream offsets;
+    emitIndexingFor(offsets, tensor, nDim,  desc.lastIsContiguous());
+    tensorOffsets << offsets.str();
+    formal_offsets.push_back(offsets.str());
     env.s("tensor", tensor);
     env.d("formal_index", formals.size() + 1); // + 1 because the first argument is the linearIndex
     env.d("nDim", nDim);
@@ -344,13 +541,52 @@ generateKernel(
     }
   }
 
+  const bool flat_index = !use_cuda && all_contiguous;
+
+  // Kernels with row reductions loop over rows (see
+  // Note [Fused row reductions]) and take the number and the size of the
+  // rows as extra arguments
+  const bool has_row_reductions = std::any_of(
+    graph.nodes().begin()
+  , graph.nodes().end()
+  , isRowReduction);
+  if (has_row_reductions) {
+    #if USE_CPU_FUSER
+      JIT_ASSERT(!use_cuda);
+      for (const auto& chunk : chunk_desc) JIT_ASSERT(chunk.isNoop());
+      for (const auto& concat : concat_desc) JIT_ASSERT(concat.isNoop());
+      for (const auto* arg : {"nRows", "rowSize"}) {
+        env.d("formal_index", formals.size() + 1);
+        formals.push_back(std::string("IndexType ") + arg);
+        argument_loads.push_back(format("*static_cast<IndexType*>(args[${formal_index}])", env));
+      }
+      env.s("rowBody", emitRowReductionBody(
+        graph
+      , flat_inputs
+      , flat_output_nodes
+      , formal_offsets
+      , flat_index));
+      env.v("formals", formals);
+      env.v("argument_loads", argument_loads);
+      env.s("type_declarations", cpu::type_declarations_template.format(env));
+      env.s("kernelLoop", cpu::cpu_row_kernel_template.format(env));
+      const auto code_string = cpu::cpu_compilation_unit_template.format(env);
+      if (debugFuser()) {
+        std::cerr << "fusion code:" << code_string << std::endl;
+      }
+      return std::make_tuple(code_string, std::move(chunk_desc), std::move(concat_desc), false);
+    #else
+      throw std::runtime_error("CPU Fusion requested but not supported");
+    #endif // USE_CPU_FUSER
+  }
+
   // Acquires input values
   bool has_half_tensor = false;
   size_t formal_count = 0;
   for (const auto input : flat_inputs) {
     auto p = input.first;
     env.s("node", valueName(p));
-    env.d("formal", formal_count++);
+    const auto access = tensorAccess(formal_count++, flat_index);
 
     // Acquires and converts (if needed) inputs
     // Note: conversion from half is only supported for CUDA kernels.
@@ -359,12 +595,10 @@ generateKernel(
     const auto is_half = (input.second.scalar_type == at::ScalarType::Half);
     if (is_half) {
       JIT_ASSERT(use_cuda);
-      env.s(
-        "access"
-      , format("__half2float(t${formal}.data[t${formal}_offset])", env));
+      env.s("access", "__half2float(" + access + ")");
       has_half_tensor = true;
     } else {
-      env.s("access", format("t${formal}.data[t${formal}_offset]", env));
+      env.s("access", access);
     }
     env.s("lhs_type", calcScalarTypeName(input.second.scalar_type));
 
@@ -392,8 +626,7 @@ generateKernel(
   // Generates writes to output tensors
   for (const auto& output : flat_output_nodes) {
     const auto& o = output.first;
-    env.d("formal", formal_count++);
-    env.s("access", format("t${formal}.data[t${formal}_offset]",env));
+    env.s("access", tensorAccess(formal_count++, flat_index));
     env.s("node", valueName(o));
 
     // Acquires and converts (if needed) outputs
@@ -444,6 +677,9 @@ generateKernel(
   } else {
     #if USE_CPU_FUSER
       env.s("type_declarations", cpu::type_declarations_template.format(env));
+      env.s("kernelLoop", flat_index
+        ? cpu::cpu_contiguous_kernel_template.format(env)
+        : cpu::cpu_strided_kernel_template.format(env));
       code_string = cpu::cpu_compilation_unit_template.format(env);
     #else
       throw std::runtime_error("CPU Fusion requested but not supported");
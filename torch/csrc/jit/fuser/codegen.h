@@ -12,6 +12,7 @@
 #include <vector>
 #include <iostream>
 #include <string>
+#include <unordered_set>
 
 namespace torch { namespace jit { namespace fuser {
 
@@ -33,6 +34,11 @@ generateKernel(
 , const std::vector<TensorDesc>& output_desc
 , const bool use_cuda);
 
+// Returns the values of a fusion group with row reductions that are computed
+// once per row instead of once per element (see Note [Fused row reductions]
+// in codegen.cpp).
+TORCH_API std::unordered_set<const Value*> rowValues(const Graph& graph);
+
 } // namespace fuser
 } // namespace jit
 } // namespace torch
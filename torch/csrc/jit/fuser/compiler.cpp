@@ -21,6 +21,7 @@
 
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <unordered_set>
 #include <utility>
 #include <string>
@@ -117,6 +118,24 @@ static void setInputBroadcastGroups(KernelSpec& spec) {
   , std::back_inserter(spec.inputBroadcastGroups()));
 }
 
+// Outputs computed once per row have the map size with a trailing 1, or
+// without the innermost dimension if they come from a reduction that doesn't
+// keep it (see Note [Fused row reductions] in codegen.cpp)
+static void setOutputShapes(KernelSpec& spec) {
+  spec.rowValues() = rowValues(*spec.graph());
+  const auto& row_values = spec.rowValues();
+  for (const Value* output : (spec.graph())->outputs()) {
+    const Node* producer = output->node();
+    if (row_values.count(output) == 0) {
+      spec.outputShapes().push_back(OutputShape::Map);
+    } else if (isRowReduction(producer) && !*producer->get<bool>(attr::keepdim)) {
+      spec.outputShapes().push_back(OutputShape::SqueezedRow);
+    } else {
+      spec.outputShapes().push_back(OutputShape::Row);
+    }
+  }
+}
+
 // Performs "upfront" compilation where storage is known but shapes are not.
 // Currently identifies how to expand all tensors so that all intermediate
 // tensors are the same shape, simplifying code generation.
@@ -129,12 +148,19 @@ static void setInputBroadcastGroups(KernelSpec& spec) {
 static void upfrontCompilation(KernelSpec& spec) {
   setInputBroadcastGroups(spec);
   setInputChunkDescriptors(spec);
+  setOutputShapes(spec);
 }
 
 int64_t registerFusion(const Node* fusion_group) {
-  // Creates and stores the FusionSpec
+  // Creates and stores the FusionSpec. Kernels are specialized to the
+  // arguments at run time (see ArgSpec), not to the sizes seen by shape
+  // analysis, so the copies of a fusion group in the plans a GraphExecutor
+  // specializes to each input size reuse one spec and its compiled kernels.
   auto graph = fusion_group->g(attr::Subgraph)->copy();
   EraseShapeInformation(graph);
+  static std::mutex registration_mutex;
+  std::lock_guard<std::mutex> guard{registration_mutex};
+  if (const auto cached_key = lookupGraph(graph)) return *cached_key;
   const auto key = store(graph);
 
   if (canFuseOnCPU() || canFuseOnGPU()) {
@@ -158,18 +184,26 @@ std::shared_ptr<FusedKernel> compileKernel(
   c10::optional<at::ScalarType> scalar_type;
   for (size_t i = 0; i < input_desc.size(); i++) {
     const auto& desc = input_desc[i];
-    graph->inputs()[i]->setType(TensorType::create(desc.scalar_type, device, desc.nDim())); // TODO: nDim is bad, as it is collapsed
+    // Note: inputs are expanded to the map size, and reductions need the
+    // uncollapsed number of dimensions to propagate types
+    graph->inputs()[i]->setType(TensorType::create(desc.scalar_type, device, map_size.size()));
   }
 
   PropagateInputShapes(graph);
 
   // Creates output descriptions
   std::vector<TensorDesc> output_desc;
-  for (const Value* output : graph->outputs()) {
+  for (size_t i = 0; i < graph->outputs().size(); ++i) {
+    const Value* output = graph->outputs()[i];
     std::vector<int64_t> sizes = map_size;
     if (output->node()->kind() == prim::FusedConcat) {
       sizes.at(output->node()->i(attr::dim)) *= output->node()->inputs().size();
     }
+    if (spec.outputShapes()[i] == OutputShape::Row) {
+      sizes.back() = 1;
+    } else if (spec.outputShapes()[i] == OutputShape::SqueezedRow) {
+      sizes.pop_back();
+    }
     auto scalar_type = output->type()->expect<c10::TensorType const>()->scalarType();
     auto type = CompleteTensorType::create(scalar_type, device, sizes);
     output_desc.emplace_back(std::move(type));
@@ -1,13 +1,16 @@
 #include "torch/csrc/jit/fuser/cpu/fused_kernel.h"
 
+#include "ATen/native/DispatchStub.h"
 #include "torch/csrc/jit/assertions.h"
 #include "torch/csrc/jit/code_template.h"
 #include "torch/csrc/jit/fuser/compiler.h"
 #include "torch/csrc/jit/fuser/cpu/temp_file.h"
 #include "torch/csrc/jit/fuser/cpu/dynamic_library.h"
+#include "torch/csrc/jit/fuser/kernel_cache.h"
 #include "torch/csrc/utils/memory.h"
 
 #include <sstream>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <string>
@@ -17,6 +20,7 @@ namespace torch { namespace jit { namespace fuser { namespace cpu {
 
 static const std::string so_template = "/tmp/pytorch_fuserXXXXXX.so";
 static const std::string cpp_template = "/tmp/pytorch_fuserXXXXXX.cpp";
+static const std::string kernel_symbol = "fused_kernel";
 static const std::string check_exists_string = "which '${program}' > /dev/null";
 
 static bool programExists(const std::string& program) {
@@ -26,6 +30,43 @@ static bool programExists(const std::string& program) {
   return (system(cmd.c_str()) == 0);
 }
 
+static const std::string version_string = "\"${cxx}\" -dumpversion";
+
+// Returns the output of `cxx -dumpversion`, part of the disk cache key
+static std::string compilerVersion(const std::string& cxx) {
+  TemplateEnv env;
+  env.s("cxx", cxx);
+  std::string cmd = format(version_string, env);
+  std::string version;
+  if (FILE* pipe = popen(cmd.c_str(), "r")) {
+    char buf[128];
+    while (fgets(buf, sizeof(buf), pipe) != nullptr) {
+      version += buf;
+    }
+    pclose(pipe);
+  }
+  return version;
+}
+
+// Instruction set flags for the CPU this process runs on, picked the same
+// way ATen picks its vectorized kernels (so ATEN_CPU_CAPABILITY applies here
+// too). AVX512 is capped at AVX2 for the reason given at compile_string.
+static std::string isaFlags() {
+#if defined(__x86_64__) || defined(_M_X64)
+  using at::native::CPUCapability;
+  switch (at::native::get_cpu_capability()) {
+    case CPUCapability::AVX512:
+    case CPUCapability::AVX2:
+      return "-mavx2 -mfma";
+    case CPUCapability::AVX:
+      return "-mavx";
+    default:
+      break;
+  }
+#endif
+  return "";
+}
+
 // A single compiler config is accessed through getConfig() (below)
 // Controls compilation options and may be updated based on the result
 // of compilation attempts.
@@ -38,12 +79,16 @@ struct CompilerConfig {
 
     if (!programExists(cxx)) {
       cxx = "";
+    } else {
+      cxx_version = compilerVersion(cxx);
     }
   }
 
   ~CompilerConfig() = default;
 
   std::string cxx = "g++"; // compiler location
+  std::string cxx_version;
+  std::string isa_flags = isaFlags();
   bool openmp = true;
 };
 
@@ -62,23 +107,36 @@ static CompilerConfig& getConfig() {
 // understand for AVX512. When we need better CPU performance this
 // optimization can be re-enabled by tracking down the platforms where
 // this error occurs and only selectively disabling it.
+// Instead, ${isa_flags} names the instruction sets explicitly (see isaFlags).
+// -fno-math-errno and -fno-trapping-math let the compiler vectorize sqrt and
+// the ternaries emitted for relu, clamp, where, etc.; neither changes results.
 static const std::string compile_string =
   "\"${cxx}\" -O3 -g "
 #ifndef __PPC64__
 //  "-march=native "
 #endif
+  "${isa_flags} -fno-math-errno -fno-trapping-math "
   "-std=c++11 -fPIC ${fopenmp} -shared \"${cpp_file}\" -o \"${so_file}\" -lm";
 
-static void runCompiler(
+static std::string compileCommand(
   const std::string& cpp_file
-, const std::string& so_file) {
+, const std::string& so_file
+, bool openmp) {
   auto& config = getConfig();
   TemplateEnv env;
   env.s("cxx", config.cxx);
-  env.s("fopenmp", config.openmp ? "-fopenmp" : "");
+  env.s("isa_flags", config.isa_flags);
+  env.s("fopenmp", openmp ? "-fopenmp" : "");
   env.s("cpp_file", cpp_file);
   env.s("so_file", so_file);
-  std::string result = format(compile_string, env);
+  return format(compile_string, env);
+}
+
+static void runCompiler(
+  const std::string& cpp_file
+, const std::string& so_file) {
+  auto& config = getConfig();
+  std::string result = compileCommand(cpp_file, so_file, config.openmp);
   int r = system(result.c_str());
   if (config.openmp && r != 0) {
     std::cerr << "warning: pytorch jit fuser failed to compile with openmp, trying without it...\n";
@@ -114,16 +172,40 @@ FusedKernelCPU::FusedKernelCPU(
           std::move(chunk_desc),
           std::move(concat_desc),
           has_random) {
-  auto& config = getConfig();
-  TempFile so_file(so_template, 3);
-  TempFile cpp_file(cpp_template, 4);
-  cpp_file.write(code_);
-  cpp_file.sync();
-  runCompiler(cpp_file.name(), so_file.name());
-  if (debugFuser() >= 2) disas(so_file.name());
-  so_lib = make_unique<DynamicLibrary>(so_file.name().c_str());
+  // Kernel names come from a per-process counter. The library is built from
+  // the code with the name replaced by a fixed one, so that the same fusion
+  // has the same source, and thus disk cache entry, in every process.
+  std::string source = code_;
+  for (size_t pos = source.find(name_); pos != std::string::npos;
+       pos = source.find(name_, pos + kernel_symbol.size())) {
+    source.replace(pos, name_.size(), kernel_symbol);
+  }
+
+  // See Note [Fuser disk cache]. The key leaves -fopenmp out: runCompiler
+  // only knows whether the compiler supports it after the compilation, and
+  // the library computes the same results with or without it.
+  const std::string cacheKey =
+      compileCommand("", "", /*openmp=*/false) + "\n" + getConfig().cxx_version + source;
+  if (const auto cached = lookupCompiledKernel(cacheKey)) {
+    // Another process may evict the entry before it is opened, in which
+    // case the kernel is compiled as if it had missed
+    try {
+      so_lib = make_unique<DynamicLibrary>(cached->c_str());
+    } catch (const c10::Error&) {
+    }
+  }
+  if (!so_lib) {
+    TempFile so_file(so_template, 3);
+    TempFile cpp_file(cpp_template, 4);
+    cpp_file.write(source);
+    cpp_file.sync();
+    runCompiler(cpp_file.name(), so_file.name());
+    if (debugFuser() >= 2) disas(so_file.name());
+    storeCompiledKernel(cacheKey, so_file.name());
+    so_lib = make_unique<DynamicLibrary>(so_file.name().c_str());
+  }
   #pragma GCC diagnostic ignored "-Wpedantic"
-    kernel = reinterpret_cast<void(*)(uint32_t, void**)>(so_lib->sym(name_.c_str()));
+    kernel = reinterpret_cast<void(*)(uint32_t, void**)>(so_lib->sym(kernel_symbol.c_str()));
   #pragma GCC diagnostic pop
 }
 
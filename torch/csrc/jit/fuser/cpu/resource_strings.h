@@ -41,6 +41,16 @@ scalar_t rsqrtf(scalar_t x) {
 ${type_declarations}
 
 #define OMP_THRESHOLD 100000
+${kernelLoop}
+
+extern "C"
+void ${kernelName}(IndexType totalElements, void ** args) {
+  ${kernelName}_kernel(totalElements ${,argument_loads});
+}
+)");
+
+// General case: every tensor computes its own offset from the linear index.
+static auto cpu_strided_kernel_template = CodeTemplate(R"(
 static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
   #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
   for (IndexType linearIndex = 0;
@@ -52,10 +62,30 @@ static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
       ${kernelBody}
     }
 }
+)");
 
-extern "C"
-void ${kernelName}(IndexType totalElements, void ** args) {
-  ${kernelName}_kernel(totalElements ${,argument_loads});
+// Used when all inputs and outputs are contiguous. Every tensor is indexed
+// with `linearIndex` directly, so the loop has no div/mod and is vectorized
+// (outputs are freshly allocated, so no iteration depends on another).
+static auto cpu_contiguous_kernel_template = CodeTemplate(R"(
+static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
+  #pragma omp parallel for simd if(totalElements > OMP_THRESHOLD)
+  for (IndexType linearIndex = 0;
+        linearIndex < totalElements;
+        linearIndex += 1) {
+      ${kernelBody}
+    }
+}
+)");
+
+// Used for kernels with row reductions (see Note [Fused row reductions] in
+// codegen.cpp). Every iteration computes one row of the map size.
+static auto cpu_row_kernel_template = CodeTemplate(R"(
+static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
+  #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
+  for (IndexType row = 0; row < nRows; row += 1) {
+      ${rowBody}
+    }
 }
 )");
 
@@ -87,6 +87,69 @@ static c10::optional<std::vector<int64_t>> canRunKernel(
   return map_size;
 }
 
+// Broadcasts sizes into result in place, like at::infer_size. Returns false
+// if they don't broadcast.
+static bool broadcastInto(std::vector<int64_t>& result, at::IntList sizes) {
+  if (sizes.size() > result.size()) {
+    result.insert(result.begin(), sizes.size() - result.size(), 1);
+  }
+  const size_t offset = result.size() - sizes.size();
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    auto& size = result[offset + i];
+    if (size == 1) {
+      size = sizes[i];
+    } else if (sizes[i] != 1 && sizes[i] != size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Kernels with row reductions are only correct if every value they compute
+// per element has the map size and every value they compute per row has the
+// map size with the innermost dimension set to 1 (see
+// Note [Fused row reductions] in codegen.cpp). Checks this by propagating the
+// sizes of the (unexpanded) arguments through the graph. Since every node
+// output that passes the check has one of those two sizes, only the sizes of
+// the arguments need to be looked up.
+static bool canRunRowReductions(
+  const KernelSpec& spec
+, at::TensorList args
+, const std::vector<int64_t>& map_size) {
+  // Empty maps take the fallback, which also raises the errors of
+  // max_values and min_values
+  if (map_size.empty()) return false;
+  if (std::find(map_size.begin(), map_size.end(), 0) != map_size.end()) return false;
+  std::vector<int64_t> row_size = map_size;
+  row_size.back() = 1;
+
+  const auto& row_values = spec.rowValues();
+  const auto sizesOf = [&](const Value* v) -> at::IntList {
+    if (v->node()->kind() == prim::Param) return args[v->offset()].sizes();
+    return row_values.count(v) > 0 ? row_size : map_size;
+  };
+  std::vector<int64_t> n_sizes;
+  n_sizes.reserve(map_size.size());
+  for (const Node* n : spec.graph()->nodes()) {
+    if (n->kind() == prim::Constant) continue;
+    n_sizes.clear();
+    for (const Value* input : n->inputs()) {
+      if (!input->type()->isSubtypeOf(DynamicType::get())) continue;
+      const auto input_sizes = sizesOf(input);
+      if (isRowReduction(n)) {
+        if (input_sizes != at::IntList(map_size)) return false;
+        n_sizes = row_size;
+        break;
+      }
+      if (!broadcastInto(n_sizes, input_sizes)) return false;
+    }
+    if (n_sizes != (row_values.count(n->output()) > 0 ? row_size : map_size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Arguments are expanded to a common shape, referred to as the "map size,"
 // (see above).
 // Note: Arguments are mutated by this call, although map_size is restored
@@ -161,7 +224,8 @@ static void compressContiguous(
 // Launches the requested fusion on the given device with the given inputs.
 // Output pointers are stored in outputs (to be put on the stack later).
 void launchFusion(
-  const FusedKernel& fusion
+  const KernelSpec& spec
+, const FusedKernel& fusion
 , const at::Device device
 , const at::ArrayRef<at::Tensor>& inputs
 , std::vector<at::Tensor>& outputs) {
@@ -254,7 +318,13 @@ void launchFusion(
   for (size_t i = 0; i < fusion.outputDesc().size(); ++i) {
     const auto& c = fusion.concatDesc()[i];
     if (c.isNoop()) {
-      outputs.push_back(at::empty(map_size, ref_options.dtype(fusion.outputDesc()[i].scalar_type)));
+      std::vector<int64_t> output_size = map_size.vec();
+      if (spec.outputShapes()[i] == OutputShape::Row) {
+        output_size.back() = 1;
+      } else if (spec.outputShapes()[i] == OutputShape::SqueezedRow) {
+        output_size.pop_back();
+      }
+      outputs.push_back(at::empty(output_size, ref_options.dtype(fusion.outputDesc()[i].scalar_type)));
       addTensorInfo(fusion.outputDesc()[i], outputs[i]);
     } else {
       size_t small_size = map_size[c.dim()];
@@ -274,6 +344,16 @@ void launchFusion(
     }
   }
 
+  // Kernels with row reductions take the number and the size of the rows
+  uint32_t n_rows = 0;
+  uint32_t row_size = 0;
+  if (spec.hasRowReductions()) {
+    row_size = map_size.back();
+    n_rows = numel / row_size;
+    arguments.push_back(&n_rows);
+    arguments.push_back(&row_size);
+  }
+
   fusion.launch_raw(numel, arguments);
 }
 
@@ -308,11 +388,17 @@ bool runFusion(
   if (device.is_cuda() && !canFuseOnGPU()) return false;
   if (device.is_cpu() && !canFuseOnCPU()) return false;
 
+  // Row reductions are only generated for the CPU
+  if (spec.hasRowReductions() && !device.is_cpu()) return false;
+
   // Validates sizes and expands inputs as needed
   auto maybe_map_size = canRunKernel(spec, inputs);
 
   // Tries to run fallback if map size can't be computed
   if (!maybe_map_size) return false;
+  if (spec.hasRowReductions() && !canRunRowReductions(spec, inputs, *maybe_map_size)) {
+    return false;
+  }
   expandArgs(spec, inputs, *maybe_map_size);
 
   // Retrieves the kernel, compiling (and caching) if necessary
@@ -327,7 +413,7 @@ bool runFusion(
 
   // Launches fusion
   std::vector<at::Tensor> outputs;
-  launchFusion(*(*maybe_kernel), device, inputs, outputs);
+  launchFusion(spec, *(*maybe_kernel), device, inputs, outputs);
 
   // Updates stack
   drop(stack, spec.nInputs());
@@ -5,6 +5,7 @@
   #include "torch/csrc/jit/fuser/compiler.h"
   #include "torch/csrc/jit/fuser/executor.h"
   #include "torch/csrc/jit/fuser/fallback.h"
+  #include "torch/csrc/jit/fuser/kernel_cache.h"
 #endif // USE_CUDA_FUSER || USE_CPU_FUSER
 
 #include <stdexcept>
@@ -90,5 +91,32 @@ size_t nCompiledKernels() {
   #endif // USE_CUDA_FUSER || USE_CPU_FUSER
 }
 
+std::string getFuserCacheDir() {
+  #if USE_CPU_FUSER
+    return fuser::diskCacheDir();
+  #else
+    return "";
+  #endif // USE_CPU_FUSER
+}
+
+void setFuserCacheDir(const std::string& dir) {
+  #if USE_CPU_FUSER
+    fuser::setDiskCacheDir(dir);
+  #endif // USE_CPU_FUSER
+}
+
+std::unordered_map<std::string, size_t> fuserCacheStats() {
+  #if USE_CPU_FUSER
+    const auto stats = fuser::diskCacheStats();
+    return {
+      {"hits", stats.hits}
+    , {"misses", stats.misses}
+    , {"stores", stats.stores}
+    , {"evictions", stats.evictions}};
+  #else
+    return {};
+  #endif // USE_CPU_FUSER
+}
+
 } // namespace jit
 } // namespace torch
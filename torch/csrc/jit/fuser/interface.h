@@ -6,6 +6,8 @@
 #include "torch/csrc/jit/stack.h"
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <cstdint>
 
@@ -39,5 +41,13 @@ TORCH_API std::vector<at::Tensor> debugLaunchGraph(
 
 TORCH_API size_t nCompiledKernels();
 
+// Directory of the on-disk cache of compiled CPU kernels. An empty string
+// means the cache is disabled.
+TORCH_API std::string getFuserCacheDir();
+TORCH_API void setFuserCacheDir(const std::string& dir);
+
+// Number of disk cache hits, misses, stores and evictions in this process
+TORCH_API std::unordered_map<std::string, size_t> fuserCacheStats();
+
 } // namespace jit
 } // namespace torch
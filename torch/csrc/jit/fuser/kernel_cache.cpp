@@ -3,6 +3,22 @@
 #include <unordered_map>
 #include <mutex>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <ctime>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
 
 namespace torch { namespace jit { namespace fuser {
 
@@ -12,6 +28,7 @@ struct KernelCacheImpl {
   std::mutex mutex_;
   int64_t kernel_counter{0};
   std::unordered_map<int64_t, KernelSpec> specMap_;
+  std::unordered_map<std::string, int64_t> graphToKey_;
 };
 
 static KernelCacheImpl& getKernelCache() {
@@ -29,9 +46,19 @@ int64_t store(std::shared_ptr<Graph> graph) {
     std::piecewise_construct
   , std::forward_as_tuple(key)
   , std::forward_as_tuple(key, graph));
+  cache.graphToKey_.emplace(graph->toString(), key);
   return key;
 }
 
+at::optional<int64_t> lookupGraph(std::shared_ptr<Graph> graph) {
+  auto& cache = getKernelCache();
+  const auto repr = graph->toString();
+  std::lock_guard<std::mutex> guard{cache.mutex_};
+  auto it = cache.graphToKey_.find(repr);
+  if (it == cache.graphToKey_.end()) return at::nullopt;
+  return it->second;
+}
+
 at::optional<KernelSpec*> retrieve(const int64_t key) { 
   auto& cache = getKernelCache();
   std::lock_guard<std::mutex> guard{cache.mutex_};
@@ -40,6 +67,245 @@ at::optional<KernelSpec*> retrieve(const int64_t key) {
   return &(it->second);
 }
 
+// Note [Fuser disk cache]
+// ~~~~~~~~~~~~~~~~~~~~~~~
+// Compiling a fused CPU kernel runs the system compiler, which takes a good
+// fraction of a second per kernel and is repeated by every process. Compiled
+// libraries are therefore also kept in a directory:
+//
+//   PYTORCH_FUSER_CACHE_DIR      cache directory; an empty value disables the
+//                                cache (default: $XDG_CACHE_HOME/torch/fuser,
+//                                or ~/.cache/torch/fuser)
+//   PYTORCH_FUSER_CACHE_SIZE_MB  size limit of the directory (default: 256)
+//
+// An entry is a pair of files named after the 64-bit FNV-1a hash of its key:
+// <hash>.key holds the key and <hash>.so the library. A lookup only hits if
+// the stored key is identical to the requested one, so a hash collision
+// costs a compilation, not a wrong kernel.
+//
+// Files are written under a temporary name in the cache directory and then
+// renamed, which is atomic, so processes sharing the directory never see a
+// partially written file. The library is renamed into place before its key,
+// and concurrent writers of the same entry write identical contents.
+//
+// Hits update the modification time of the library. When a store takes the
+// directory over its size limit, the least recently used entries are deleted
+// until it is back under 3/4 of the limit. A deleted library stays valid for
+// processes that have already loaded it.
+//
+// The directory can be populated ahead of time, e.g. at deploy time, by
+// running the model on representative inputs with PYTORCH_FUSER_CACHE_DIR
+// pointing at the directory that is then shipped with it. The key includes
+// the compiler version and the instruction set flags, so the directory is
+// only reused on machines with the same compiler and CPU capability.
+
+namespace {
+
+struct DiskCache {
+  DiskCache() {
+    const char* dir_env = getenv("PYTORCH_FUSER_CACHE_DIR");
+    if (dir_env != nullptr) {
+      dir = dir_env;
+    } else if (const char* xdg_env = getenv("XDG_CACHE_HOME")) {
+      dir = std::string(xdg_env) + "/torch/fuser";
+    } else if (const char* home_env = getenv("HOME")) {
+      dir = std::string(home_env) + "/.cache/torch/fuser";
+    }
+    const char* size_env = getenv("PYTORCH_FUSER_CACHE_SIZE_MB");
+    if (size_env != nullptr) {
+      size_limit = std::strtoull(size_env, nullptr, 10) << 20;
+    }
+  }
+
+  std::mutex mutex;
+  std::string dir;
+  bool dir_created = false;
+  uint64_t size_limit = uint64_t(256) << 20;
+  DiskCacheStats stats;
+};
+
+DiskCache& getDiskCache() {
+  static DiskCache cache;
+  return cache;
+}
+
+void warn(const std::string& msg) {
+  std::cerr << "warning: pytorch jit fuser kernel cache: " << msg << "\n";
+}
+
+std::string hashKey(const std::string& key) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const unsigned char c : key) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));
+  return buf;
+}
+
+// mkdir -p
+bool createDirectories(const std::string& dir) {
+  for (size_t pos = 1; pos <= dir.size(); ++pos) {
+    if (pos == dir.size() || dir[pos] == '/') {
+      const std::string prefix = dir.substr(0, pos);
+      if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool readFile(const std::string& path, std::string& contents) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  std::ostringstream ss;
+  ss << file.rdbuf();
+  contents = ss.str();
+  return true;
+}
+
+// Writes contents to a temporary file in dir and renames it to path
+bool writeFileAtomic(
+  const std::string& dir
+, const std::string& path
+, const std::string& contents) {
+  std::string tmp = dir + "/.tmpXXXXXX";
+  const int fd = mkstemp(&tmp[0]);
+  if (fd == -1) return false;
+  size_t written = 0;
+  while (written < contents.size()) {
+    const auto r = write(fd, contents.data() + written, contents.size() - written);
+    if (r <= 0) break;
+    written += r;
+  }
+  const bool ok = (close(fd) == 0) && written == contents.size()
+    && chmod(tmp.c_str(), 0644) == 0
+    && rename(tmp.c_str(), path.c_str()) == 0;
+  if (!ok) unlink(tmp.c_str());
+  return ok;
+}
+
+struct Entry {
+  std::string hash;
+  time_t mtime = 0;
+  uint64_t size = 0;
+};
+
+// Deletes the least recently used entries once the directory is over the
+// size limit. Also removes temporary files left behind by dead processes.
+void evict(DiskCache& cache) {
+  DIR* d = opendir(cache.dir.c_str());
+  if (d == nullptr) return;
+  std::unordered_map<std::string, Entry> entries;
+  uint64_t total = 0;
+  const time_t now = time(nullptr);
+  while (dirent* ent = readdir(d)) {
+    const std::string name = ent->d_name;
+    const std::string path = cache.dir + "/" + name;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+    if (name.compare(0, 4, ".tmp") == 0 && now - st.st_mtime > 24 * 60 * 60) {
+      unlink(path.c_str());
+      continue;
+    }
+    const auto dot = name.rfind('.');
+    if (dot == std::string::npos || dot == 0) continue;
+    const std::string ext = name.substr(dot);
+    if (ext != ".so" && ext != ".key") continue;
+    auto& entry = entries[name.substr(0, dot)];
+    entry.hash = name.substr(0, dot);
+    entry.size += st.st_size;
+    if (ext == ".so") entry.mtime = st.st_mtime;
+    total += st.st_size;
+  }
+  closedir(d);
+  if (total <= cache.size_limit) return;
+
+  std::vector<Entry> sorted;
+  for (const auto& kv : entries) sorted.push_back(kv.second);
+  std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) {
+    return a.mtime < b.mtime;
+  });
+  for (const auto& entry : sorted) {
+    if (total <= cache.size_limit / 4 * 3) break;
+    // the key goes first so that lookups stop matching before the library
+    // disappears
+    unlink((cache.dir + "/" + entry.hash + ".key").c_str());
+    unlink((cache.dir + "/" + entry.hash + ".so").c_str());
+    total -= entry.size;
+    cache.stats.evictions++;
+  }
+}
+
+} // namespace
+
+std::string diskCacheDir() {
+  auto& cache = getDiskCache();
+  std::lock_guard<std::mutex> guard{cache.mutex};
+  return cache.dir;
+}
+
+void setDiskCacheDir(const std::string& dir) {
+  auto& cache = getDiskCache();
+  std::lock_guard<std::mutex> guard{cache.mutex};
+  cache.dir = dir;
+  cache.dir_created = false;
+}
+
+at::optional<std::string> lookupCompiledKernel(const std::string& key) {
+  auto& cache = getDiskCache();
+  std::lock_guard<std::mutex> guard{cache.mutex};
+  if (cache.dir.empty()) return at::nullopt;
+
+  const std::string base = cache.dir + "/" + hashKey(key);
+  std::string stored_key;
+  if (!readFile(base + ".key", stored_key) || stored_key != key) {
+    cache.stats.misses++;
+    return at::nullopt;
+  }
+  const std::string so_file = base + ".so";
+  if (utime(so_file.c_str(), nullptr) != 0) {
+    cache.stats.misses++;
+    return at::nullopt;
+  }
+  cache.stats.hits++;
+  return so_file;
+}
+
+void storeCompiledKernel(const std::string& key, const std::string& so_file) {
+  auto& cache = getDiskCache();
+  std::lock_guard<std::mutex> guard{cache.mutex};
+  if (cache.dir.empty()) return;
+
+  if (!cache.dir_created) {
+    if (!createDirectories(cache.dir)) {
+      warn("can't create " + cache.dir + ", disabling the cache");
+      cache.dir.clear();
+      return;
+    }
+    cache.dir_created = true;
+  }
+
+  std::string library;
+  const std::string base = cache.dir + "/" + hashKey(key);
+  if (!readFile(so_file, library)
+      || !writeFileAtomic(cache.dir, base + ".so", library)
+      || !writeFileAtomic(cache.dir, base + ".key", key)) {
+    warn("can't write to " + cache.dir);
+    return;
+  }
+  cache.stats.stores++;
+  evict(cache);
+}
+
+DiskCacheStats diskCacheStats() {
+  auto& cache = getDiskCache();
+  std::lock_guard<std::mutex> guard{cache.mutex};
+  return cache.stats;
+}
+
 } // namespace fuser
 } // namespace jit
-} // namespace torch
\ No newline at end of file
+} // namespace torch
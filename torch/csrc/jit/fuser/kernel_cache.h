@@ -9,6 +9,7 @@
 
 #include <cstdint> 
 #include <functional>
+#include <string>
 
 namespace torch { namespace jit { namespace fuser {
 
@@ -20,6 +21,37 @@ TORCH_API int64_t store(std::shared_ptr<Graph> graph);
 // Returns the graph corresponding to the given key (if it exists)
 TORCH_API at::optional<KernelSpec*> retrieve(const int64_t key);
 
+// Returns the key of a stored graph that prints the same as graph (if there
+// is one), so that copies of a fusion group share their compiled kernels
+TORCH_API at::optional<int64_t> lookupGraph(std::shared_ptr<Graph> graph);
+
+// On-disk cache of compiled CPU kernels, shared by every process that uses
+// the same directory. Keys are the compiler command line, without OpenMP,
+// followed by the generated source. See Note [Fuser disk cache] in kernel_cache.cpp.
+
+struct DiskCacheStats {
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t stores = 0;
+  size_t evictions = 0;
+};
+
+// Returns the cache directory, or an empty string if the cache is disabled
+TORCH_API std::string diskCacheDir();
+
+// Sets the cache directory. An empty string disables the cache.
+TORCH_API void setDiskCacheDir(const std::string& dir);
+
+// Returns the path to the library compiled for key (if it is cached)
+TORCH_API at::optional<std::string> lookupCompiledKernel(const std::string& key);
+
+// Copies the library at so_file, compiled for key, into the cache and evicts
+// the least recently used entries if the cache exceeds its size limit.
+// Failures are reported as warnings: the caller still has so_file.
+TORCH_API void storeCompiledKernel(const std::string& key, const std::string& so_file);
+
+TORCH_API DiskCacheStats diskCacheStats();
+
 } // namespace fuser
 } // namespace jit
 } // namespace torch
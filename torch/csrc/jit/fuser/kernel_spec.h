@@ -8,14 +8,17 @@
 #include "torch/csrc/jit/stack.h"
 #include "torch/csrc/jit/interpreter.h"
 #include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/passes/graph_fuser.h"
 #include "torch/csrc/jit/fuser/interface.h"
 #include "torch/csrc/jit/fuser/arg_spec.h"
 #include "torch/csrc/jit/fuser/fused_kernel.h"
 
+#include <algorithm>
 #include <memory>
 #include <cstdint>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
 
 namespace torch { namespace jit { namespace fuser {
@@ -41,6 +44,21 @@ private:
   int64_t dim_;
 };
 
+// Reductions over the innermost dimension, which CPU fusion groups can
+// contain (see Note [Fused row reductions] in codegen.cpp).
+inline bool isRowReduction(const Node* node) {
+  return node->kind() == aten::sum
+      || node->kind() == aten::mean
+      || node->kind() == aten::max_values
+      || node->kind() == aten::min_values;
+}
+
+// How the shape of a fusion output relates to the map size. Outputs of
+// kernels without row reductions always have the map size; per-row outputs
+// have it with the innermost dimension set to 1 or, for reductions that don't
+// keep it, removed.
+enum class OutputShape { Map, Row, SqueezedRow };
+
  // "Kernel Specification." - Contains device-independent fusion information.
  // Each kernel specification contains a map of instantiated generated functions
  // that implement some or most of its functionality. Multiple generated
@@ -58,10 +76,16 @@ struct TORCH_API KernelSpec {
   , std::shared_ptr<Graph> _graph)
   : key_{_key}
   , graph_{_graph}
-  , code_{_graph}
+  , code_{fallbackGraph(_graph)}
   , nInputs_{_graph->inputs().size()}
   , inputBroadcastGroups_{}
   , inputChunks_{}
+  , outputShapes_{}
+  , rowValues_{}
+  , hasRowReductions_{std::any_of(
+      _graph->nodes().begin()
+    , _graph->nodes().end()
+    , isRowReduction)}
   , kernels_{}
   { }
 
@@ -81,6 +105,15 @@ struct TORCH_API KernelSpec {
   std::vector<PartitionInfo>& inputChunks() { return inputChunks_; }
   const std::vector<PartitionInfo>& inputChunks() const { return inputChunks_; }
 
+  std::vector<OutputShape>& outputShapes() { return outputShapes_; }
+  const std::vector<OutputShape>& outputShapes() const { return outputShapes_; }
+
+  // The values computed once per row (see rowValues in codegen.h)
+  std::unordered_set<const Value*>& rowValues() { return rowValues_; }
+  const std::unordered_set<const Value*>& rowValues() const { return rowValues_; }
+
+  bool hasRowReductions() const { return hasRowReductions_; }
+
   // Cache functions
   c10::optional<std::shared_ptr<FusedKernel>> findKernel(const ArgSpec& arg_spec) const {
     std::lock_guard<std::mutex> guard{mutex_};
@@ -96,12 +129,22 @@ struct TORCH_API KernelSpec {
   }
 
 private:
+  // The fallback runs the ops that the graph fuser decomposed undecomposed
+  static std::shared_ptr<Graph> fallbackGraph(const std::shared_ptr<Graph>& graph) {
+    auto fallback = graph->copy();
+    RecomposeRowNormalizations(*fallback);
+    return fallback;
+  }
+
   int64_t key_;
   std::shared_ptr<Graph> graph_;
   Code code_;
   uint64_t nInputs_;
   std::vector<std::vector<int64_t>> inputBroadcastGroups_;
   std::vector<PartitionInfo> inputChunks_;
+  std::vector<OutputShape> outputShapes_;
+  std::unordered_set<const Value*> rowValues_;
+  bool hasRowReductions_;
   mutable std::mutex mutex_;
   mutable std::unordered_map<
     ArgSpec
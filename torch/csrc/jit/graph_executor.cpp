@@ -6,12 +6,14 @@
 #include "torch/csrc/jit/autodiff.h"
 #include "torch/csrc/jit/interpreter.h"
 #include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/memory_planning.h"
 #include "torch/csrc/jit/tracer.h"
 #include "torch/csrc/jit/passes/batch_mm.h"
 #include "torch/csrc/jit/passes/common_subexpression_elimination.h"
 #include "torch/csrc/jit/passes/constant_pooling.h"
 #include "torch/csrc/jit/passes/create_autodiff_subgraphs.h"
 #include "torch/csrc/jit/passes/dead_code_elimination.h"
+#include "torch/csrc/jit/passes/fork_independent_branches.h"
 #include "torch/csrc/jit/passes/graph_fuser.h"
 #include "torch/csrc/jit/passes/inplace_check.h"
 #include "torch/csrc/jit/passes/peephole.h"
@@ -32,6 +34,11 @@
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/jit/script/compiler.h"
 
+#include "c10/util/LeftRight.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -48,10 +55,143 @@ using tensor_list = std::vector<at::Tensor>;
 using Variable = autograd::Variable;
 using autograd::variable_list;
 
+std::atomic<bool> memory_planning_enabled {false};
+std::atomic<bool> parallel_branches_enabled {false};
+
+// see GraphExecutorCachePolicy
+std::atomic<size_t> max_plans {0};
+std::atomic<size_t> max_memory_plans {8};
+std::atomic<bool> bucket_sizes {false};
+
+// A map from specs to plans that many threads can look plans up in without
+// locking (see c10::LeftRight), while one thread at a time adds or evicts
+// plans. Plans are handed out as shared_ptrs, so a run keeps its plan alive
+// even if another thread evicts it meanwhile. GraphExecutorImpl holds its
+// compile_mutex around every insert, and around reads of stats.
+//
+// Lookups only record which plans were used since the last insert, so that
+// hits don't write to memory shared with other threads most of the time,
+// which makes the eviction order an approximation of least recently used.
+// For the same reason the reader counts and the hit count are striped, each
+// thread only updating the counters on its own cache line.
+template <typename Spec, typename Plan>
+struct PlanCache {
+  static constexpr size_t kStripes = 16;
+  struct Entry {
+    explicit Entry(std::shared_ptr<Plan> plan) : plan(std::move(plan)) {}
+    std::shared_ptr<Plan> plan;
+    std::atomic<uint64_t> last_use {0}; // the epoch it was last looked up in
+  };
+  using Map = std::unordered_map<Spec, std::shared_ptr<Entry>>;
+
+  // returns nullptr if spec isn't cached, and marks it as used otherwise
+  std::shared_ptr<Plan> find(const Spec& spec) {
+    return map.read([&](const Map& m) -> std::shared_ptr<Plan> {
+      auto it = m.find(spec);
+      if (it == m.end()) {
+        return nullptr;
+      }
+      auto& stripe_hits = hits[c10::detail::leftRightStripe() % kStripes].value;
+      stripe_hits.fetch_add(1, std::memory_order_relaxed);
+      auto& last_use = it->second->last_use;
+      const uint64_t now = epoch.load(std::memory_order_relaxed);
+      if (last_use.load(std::memory_order_relaxed) != now) {
+        last_use.store(now, std::memory_order_relaxed);
+      }
+      return it->second->plan;
+    });
+  }
+
+  // doesn't mark spec as used
+  std::shared_ptr<Plan> peek(const Spec& spec) const {
+    return map.read([&](const Map& m) -> std::shared_ptr<Plan> {
+      auto it = m.find(spec);
+      return it == m.end() ? nullptr : it->second->plan;
+    });
+  }
+
+  // evicts the least recently used plans until there is room for plan
+  // (max_size == 0 means there is no limit)
+  void insert(const Spec& spec, std::shared_ptr<Plan> plan, size_t max_size) {
+    std::vector<Spec> evicted;
+    map.read([&](const Map& m) {
+      std::vector<std::pair<uint64_t, const Spec*>> by_use;
+      for (const auto& entry : m) {
+        by_use.emplace_back(entry.second->last_use.load(), &entry.first);
+      }
+      std::sort(by_use.begin(), by_use.end(), [](
+          const std::pair<uint64_t, const Spec*>& a,
+          const std::pair<uint64_t, const Spec*>& b) {
+        return a.first < b.first;
+      });
+      for (size_t i = 0; max_size > 0 && m.size() - i >= max_size; ++i) {
+        evicted.push_back(*by_use[i].second);
+      }
+      return 0;
+    });
+    auto entry = std::make_shared<Entry>(std::move(plan));
+    entry->last_use = epoch.fetch_add(1) + 1;
+    map.write([&](Map& m) {
+      for (const Spec& s : evicted) {
+        m.erase(s);
+      }
+      m.emplace(spec, entry);
+    });
+    stats.evictions += evicted.size();
+  }
+
+  // calls fn with every spec and its plan
+  template <typename F>
+  void forEach(F&& fn) const {
+    map.read([&](const Map& m) {
+      for (const auto& entry : m) {
+        fn(entry.first, *entry.second->plan);
+      }
+      return 0;
+    });
+  }
+
+  GraphExecutorCacheStats getStats() const {
+    GraphExecutorCacheStats result = stats;
+    result.hits = 0;
+    for (const auto& stripe_hits : hits) {
+      result.hits += stripe_hits.value.load();
+    }
+    return result;
+  }
+
+  struct HitCounter {
+    std::atomic<size_t> value {0};
+    char padding[64 - sizeof(std::atomic<size_t>)];
+  };
+
+  c10::LeftRight<Map, kStripes> map;
+  std::atomic<uint64_t> epoch {0};   // advances with every insert
+  HitCounter hits[kStripes];
+  GraphExecutorCacheStats stats;     // misses, evictions and compile time
+};
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+size_t countNodes(Block* block) {
+  size_t n = 0;
+  for (Node* node : block->nodes()) {
+    n++;
+    for (Block* b : node->blocks()) {
+      n += countNodes(b);
+    }
+  }
+  return n;
+}
+
 struct ExecutionPlan {
   ExecutionPlan() = default;
-  ExecutionPlan(std::shared_ptr<Graph> graph)
-    : code(graph)
+  ExecutionPlan(std::shared_ptr<Graph> graph, bool plan_memory = false)
+    : code(graph, plan_memory)
     , graph(std::move(graph)) {}
 
   void run(Stack& stack) const {
@@ -66,11 +206,15 @@ struct ExecutionPlan {
     ExecutionPlanState state;
     state.code = &code;
     state.graph = graph.get();
+    state.memory_plan = code.memoryPlanStats();
     return state;
   }
 
   Code code;
   std::shared_ptr<Graph> graph;
+  // true if the graph doesn't need gradients and only takes flat inputs, so
+  // it can be specialized to the sizes of its inputs and memory planned
+  bool can_plan_memory = false;
 };
 
 struct DifferentiableGraphBackward : public autograd::Function {
@@ -345,8 +489,11 @@ struct GraphExecutorImpl {
       return runTraced(stack);
     }
 
-    auto & execution_plan = optimize ? getOrCompile(stack) : getOrCompileFallback();
-    return execution_plan.run(stack);
+    auto execution_plan = optimize ? getOrCompile(stack) : getOrCompileFallback();
+    if (execution_plan->can_plan_memory && memoryPlanningEnabled()) {
+      return getOrCompileMemoryPlan(*execution_plan, stack)->run(stack);
+    }
+    return execution_plan->run(stack);
   }
 
   std::shared_ptr<Graph> graphFor(const Stack& stack) const {
@@ -355,24 +502,31 @@ struct GraphExecutorImpl {
     ArgumentSpec spec(autograd::GradMode::is_enabled(), inputs, num_flat_inputs);
 
     if (!optimize) {
-      AT_CHECK(fallback, "No graph found for given inputs");
-      return fallback.graph;
+      auto plan = std::atomic_load(&fallback);
+      AT_CHECK(plan, "No graph found for given inputs");
+      return plan->graph;
     }
 
-    auto it = plan_cache.find(spec);
-    AT_CHECK(it != plan_cache.end(), "No graph found for given inputs");
-    return it->second.graph;
+    auto plan = plan_cache.peek(spec);
+    AT_CHECK(plan, "No graph found for given inputs");
+    return plan->graph;
   }
 
   GraphExecutorState getDebugState() {
     GraphExecutorState state;
     state.graph = graph.get();
-    if (fallback) {
-      state.fallback = fallback.getDebugState();
-    }
-    for (auto & entry : plan_cache) {
-      state.execution_plans.emplace(entry.first, entry.second.getDebugState());
+    if (auto plan = std::atomic_load(&fallback)) {
+      state.fallback = plan->getDebugState();
     }
+    plan_cache.forEach([&](const ArgumentSpec& spec, ExecutionPlan& plan) {
+      state.execution_plans.emplace(spec, plan.getDebugState());
+    });
+    memory_plan_cache.forEach([&](const CompleteArgumentSpec& spec, ExecutionPlan& plan) {
+      state.memory_plans.emplace(spec, plan.getDebugState());
+    });
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    state.execution_plan_cache = plan_cache.getStats();
+    state.memory_plan_cache = memory_plan_cache.getStats();
     return state;
   }
 
@@ -387,29 +541,77 @@ struct GraphExecutorImpl {
 private:
   friend struct GraphExecutor;
 
-  const ExecutionPlan & getOrCompileFallback() {
+  std::shared_ptr<const ExecutionPlan> getOrCompileFallback() {
+    if (auto plan = std::atomic_load(&fallback)) {
+      return plan;
+    }
     std::lock_guard<std::mutex> lock(compile_mutex);
     if(!fallback) {
       auto graph_ = graph->copy();
       runRequiredPasses(graph_);
-      fallback = ExecutionPlan(graph_);
+      std::atomic_store(&fallback, std::make_shared<ExecutionPlan>(graph_));
     }
     return fallback;
   }
 
-  const ExecutionPlan & getOrCompile(const Stack& stack) {
-    // outside lock guard, to minimize the time holding the lock on the fast path
-    // ArgumentSpec even computes its hashCode here.
+  std::shared_ptr<const ExecutionPlan> getOrCompile(const Stack& stack) {
+    // ArgumentSpec even computes its hashCode here, and the lookup doesn't
+    // lock, so runs of plans that are already compiled never wait for each
+    // other (or for a compilation).
     ArgumentSpec spec(autograd::GradMode::is_enabled(), last(stack, num_inputs), num_flat_inputs);
-    {
-      std::lock_guard<std::mutex> lock(compile_mutex);
-      auto it = plan_cache.find(spec);
-      if (it != plan_cache.end())
-        return it->second;
-      auto plan = compileSpec(spec);
-      auto r = plan_cache.emplace(std::move(spec), std::move(plan));
-      return r.first->second;
+    if (auto plan = plan_cache.find(spec))
+      return plan;
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    // another thread may have compiled it while we waited for the lock
+    if (auto plan = plan_cache.peek(spec))
+      return plan;
+    plan_cache.stats.misses++;
+    auto start = Clock::now();
+    auto plan = std::make_shared<ExecutionPlan>(compileSpec(spec));
+    plan_cache.stats.compile_seconds += secondsSince(start);
+    plan_cache.insert(spec, plan, max_plans);
+    return plan;
+  }
+
+  // Returns plan specialized to the sizes of the inputs on the stack, with
+  // its intermediate tensors planned (see Note [Memory planning]). Inputs
+  // whose sizes keep changing evict each other's plans, unless their sizes
+  // are bucketed (see GraphExecutorCachePolicy).
+  std::shared_ptr<const ExecutionPlan> getOrCompileMemoryPlan(const ExecutionPlan& plan, const Stack& stack) {
+    CompleteArgumentSpec spec(autograd::GradMode::is_enabled(), last(stack, num_inputs));
+    const bool bucket = bucket_sizes && !bucketing_unsupported;
+    CompleteArgumentSpec key = bucket ? spec.roundUpSizes() : spec;
+    if (auto planned = memory_plan_cache.find(key))
+      return planned;
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    if (auto planned = memory_plan_cache.peek(key))
+      return planned;
+    memory_plan_cache.stats.misses++;
+    auto start = Clock::now();
+    auto graph = specializeToSizes(plan, key);
+    // Shape analysis inserts expands to the sizes it sees for some
+    // broadcasting ops, which would be wrong for the smaller inputs of a
+    // bucket, so graphs that need them are specialized to the exact sizes.
+    if (bucket && countNodes(graph->block()) != countNodes(plan.graph->block())) {
+      bucketing_unsupported = true;
+      key = spec;
+      graph = specializeToSizes(plan, key);
     }
+    auto planned = std::make_shared<ExecutionPlan>(graph, /*plan_memory=*/true);
+    memory_plan_cache.stats.compile_seconds += secondsSince(start);
+    memory_plan_cache.insert(key, planned, max_memory_plans);
+    return planned;
+  }
+
+  std::shared_ptr<Graph> specializeToSizes(const ExecutionPlan& plan, const CompleteArgumentSpec& spec) {
+    auto graph = plan.graph->copy();
+    for (size_t i = 0; i < spec.size(); ++i) {
+      if (spec.at(i).isTensor() && spec.at(i).defined()) {
+        graph->inputs()[i]->setType(spec.at(i));
+      }
+    }
+    PropagateInputShapes(graph);
+    return graph;
   }
 
   ExecutionPlan compileSpec(const ArgumentSpec & spec) {
@@ -449,10 +651,15 @@ private:
       InlineAutodiffSubgraphs(opt_graph, autodiffSubgraphInlineThreshold);
     } else {
       runNondiffOptimization(opt_graph);
+      if (parallelBranchesEnabled()) {
+        ForkIndependentBranches(opt_graph);
+      }
     }
     // Make sure there are no leftovers from any passes.
     EliminateDeadCode(opt_graph);
-    return ExecutionPlan(opt_graph);
+    ExecutionPlan plan(opt_graph);
+    plan.can_plan_memory = !needsGradient(opt_graph) && num_flat_inputs == num_inputs;
+    return plan;
   }
 
   void runOptimization(std::shared_ptr<Graph>& graph, const ArgumentSpec& spec) {
@@ -513,7 +720,7 @@ private:
     // NB: we could just run the fallback in here and call it a day, but that would loose all
     // the control flow information we have in the graph. Thus, we run the fallback to
     // get the correct output values, but we will override the tracing states later.
-    getOrCompileFallback().run(stack);
+    getOrCompileFallback()->run(stack);
 
     // Traces always have types propagated through them, so we make sure to
     // also propagate types through the graph we are inserting here.
@@ -546,15 +753,24 @@ private:
   const size_t num_outputs;
 
   // Populated only when optimize is false (and in that case plan_cache will be unused).
-  // The compiled version of graph.
-  ExecutionPlan fallback;
+  // The compiled version of graph. Only accessed with std::atomic_load/store.
+  std::shared_ptr<ExecutionPlan> fallback;
 
   // Mapping from argument configurations to optimized versions of the graph that are
   // specialized to the spec.
-  std::unordered_map<ArgumentSpec, ExecutionPlan> plan_cache;
-
-  // GraphExecutors can be accessed from multiple threads, so this thread needs to be
-  // held every time we access the fallback or plan_cache.
+  PlanCache<ArgumentSpec, ExecutionPlan> plan_cache;
+
+  // Memory planned versions of the plans in plan_cache, specialized to the
+  // (possibly bucketed) sizes of the inputs. Only used when memory planning is
+  // enabled.
+  PlanCache<CompleteArgumentSpec, ExecutionPlan> memory_plan_cache;
+  // set once specializing graph to bucketed sizes inserted nodes, see
+  // getOrCompileMemoryPlan
+  std::atomic<bool> bucketing_unsupported {false};
+
+  // GraphExecutors can be accessed from multiple threads, so this lock needs to be
+  // held every time we compile a plan and add it to the fallback, plan_cache or
+  // memory_plan_cache. Looking plans up doesn't need it.
   std::mutex compile_mutex;
 
   // Some tunable parameters
@@ -586,6 +802,36 @@ void GraphExecutor::debugDisableAutodiffSubgraphInlining() {
 }
 
 
+void setMemoryPlanningEnabled(bool enabled) {
+  memory_planning_enabled = enabled;
+}
+
+bool memoryPlanningEnabled() {
+  return memory_planning_enabled;
+}
+
+void setGraphExecutorCachePolicy(const GraphExecutorCachePolicy& policy) {
+  max_plans = policy.max_plans;
+  max_memory_plans = policy.max_memory_plans;
+  bucket_sizes = policy.bucket_sizes;
+}
+
+GraphExecutorCachePolicy graphExecutorCachePolicy() {
+  GraphExecutorCachePolicy policy;
+  policy.max_plans = max_plans;
+  policy.max_memory_plans = max_memory_plans;
+  policy.bucket_sizes = bucket_sizes;
+  return policy;
+}
+
+void setParallelBranchesEnabled(bool enabled) {
+  parallel_branches_enabled = enabled;
+}
+
+bool parallelBranchesEnabled() {
+  return parallel_branches_enabled;
+}
+
 void runRequiredPasses(const std::shared_ptr<Graph>& g)  {
   specializeUndef(*g);
   LowerGradOf(*g);
@@ -17,12 +17,23 @@ struct GraphExecutorState;
 struct ExecutionPlanState {
   Code* code = nullptr;
   const Graph* graph = nullptr;
+  const MemoryPlanStats* memory_plan = nullptr; // null if nothing was planned
+};
+
+struct GraphExecutorCacheStats {
+  size_t hits = 0;
+  size_t misses = 0;           // each one compiles a plan
+  size_t evictions = 0;
+  double compile_seconds = 0;  // spent compiling the plans of the misses
 };
 
 struct GraphExecutorState {
   const Graph* graph = nullptr;
   ExecutionPlanState fallback; // XXX: members of this field are optional
   std::unordered_map<ArgumentSpec, ExecutionPlanState> execution_plans;
+  std::unordered_map<CompleteArgumentSpec, ExecutionPlanState> memory_plans;
+  GraphExecutorCacheStats execution_plan_cache;
+  GraphExecutorCacheStats memory_plan_cache;
 };
 
 struct GraphExecutorImpl;
@@ -41,6 +52,35 @@ private:
   std::shared_ptr<GraphExecutorImpl> pImpl;
 };
 
+// Specialize graphs run without gradients to the sizes of their inputs and
+// plan the memory of their intermediate tensors ahead of time (see
+// Note [Memory planning]). Off by default.
+TORCH_API void setMemoryPlanningEnabled(bool enabled);
+TORCH_API bool memoryPlanningEnabled();
+
+// How many plans every graph executor keeps, and how it keys memory plans.
+// When a cache is full, the least recently used plan is evicted to make room
+// for a new one.
+struct GraphExecutorCachePolicy {
+  // optimized plans, one per ArgumentSpec (0 keeps all of them)
+  size_t max_plans = 0;
+  // memory plans, one per input sizes (0 keeps all of them)
+  size_t max_memory_plans = 8;
+  // round the sizes of inputs up to powers of two before specializing a
+  // memory plan to them, so that inputs of similar sizes (e.g. sequences of
+  // different lengths) share a plan planned for the biggest of them
+  bool bucket_sizes = false;
+};
+
+TORCH_API void setGraphExecutorCachePolicy(const GraphExecutorCachePolicy& policy);
+TORCH_API GraphExecutorCachePolicy graphExecutorCachePolicy();
+
+// Run independent branches of graphs run without gradients concurrently on
+// the inter-op pool (see ForkIndependentBranches). Off by default, and only
+// affects graphs compiled after it is changed.
+TORCH_API void setParallelBranchesEnabled(bool enabled);
+TORCH_API bool parallelBranchesEnabled();
+
 // These passes need to run before it is valid to pass to the interpreter
 // regardless of whether sizes have been specialized or not.
 TORCH_API void runRequiredPasses(const std::shared_ptr<Graph>& g);
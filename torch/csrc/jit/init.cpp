@@ -13,6 +13,8 @@
 #include "torch/csrc/jit/passes/onnx.h"
 #include "torch/csrc/jit/passes/dead_code_elimination.h"
 #include "torch/csrc/jit/passes/erase_number_types.h"
+#include "torch/csrc/jit/passes/fork_independent_branches.h"
+#include "torch/csrc/jit/passes/freeze_module.h"
 #include "torch/csrc/jit/passes/onnx/prepare_division_for_onnx.h"
 #include "torch/csrc/jit/passes/common_subexpression_elimination.h"
 #include "torch/csrc/jit/passes/constant_pooling.h"
@@ -31,6 +33,7 @@
 #include "torch/csrc/jit/passes/specialize_undef.h"
 #include "torch/csrc/jit/passes/utils/check_alias_annotation.h"
 #include "torch/csrc/jit/graph_executor.h"
+#include "torch/csrc/jit/memory_planning.h"
 #include "torch/csrc/jit/script/init.h"
 #include "torch/csrc/jit/script/python_tree_views.h"
 #include "torch/csrc/jit/batched/BatchTensor.h"
@@ -156,7 +159,18 @@ void initJITBindings(PyObject *module) {
    .def("_jit_pass_fixup_onnx_loops", FixupONNXLoops)
    .def("_jit_pass_canonicalize_ops", CanonicalizeOps)
    .def("_jit_pass_specialize_undef", specializeUndef)
+   .def("_jit_pass_freeze_module", FreezeModule)
+   .def("_jit_pass_fork_independent_branches", [](std::shared_ptr<Graph>& g, size_t min_cost) {
+     return ForkIndependentBranches(g, min_cost);
+   }, py::arg("graph"), py::arg("min_cost") = kDefaultMinBranchCost)
    .def("_jit_override_can_fuse_on_cpu", &overrideCanFuseOnCPU)
+   .def("_jit_get_fuser_cache_dir", &getFuserCacheDir)
+   .def("_jit_set_fuser_cache_dir", &setFuserCacheDir)
+   .def("_jit_fuser_cache_stats", &fuserCacheStats)
+   .def("_jit_set_memory_planning_enabled", &setMemoryPlanningEnabled)
+   .def("_jit_set_graph_executor_cache_policy", &setGraphExecutorCachePolicy)
+   .def("_jit_get_graph_executor_cache_policy", &graphExecutorCachePolicy)
+   .def("_jit_set_parallel_branches_enabled", &setParallelBranchesEnabled)
    .def("_jit_differentiate", [](Graph &g) {
        // the python binding slightly differs in semantics
        // it makes a copy of the input Graph, and works on that
@@ -190,6 +204,17 @@ void initJITBindings(PyObject *module) {
     })
     .def_property_readonly("code", [](ExecutionPlanState& s) {
       return s.code;
+    })
+    .def_property_readonly("memory_plan", [](ExecutionPlanState& s) -> py::object {
+      if (!s.memory_plan) {
+        return py::none();
+      }
+      py::dict stats;
+      stats["num_tensors"] = s.memory_plan->num_tensors;
+      stats["planned_bytes"] = s.memory_plan->planned_bytes;
+      stats["unshared_bytes"] = s.memory_plan->unshared_bytes;
+      stats["peak_bytes"] = s.memory_plan->peak_bytes;
+      return std::move(stats);
     });
 
   py::class_<Gradient>(m, "Gradient")
@@ -215,6 +240,18 @@ void initJITBindings(PyObject *module) {
       return m.df_output_vjps;
     });
 
+  py::class_<GraphExecutorCachePolicy>(m, "GraphExecutorCachePolicy")
+    .def(py::init<>())
+    .def_readwrite("max_plans", &GraphExecutorCachePolicy::max_plans)
+    .def_readwrite("max_memory_plans", &GraphExecutorCachePolicy::max_memory_plans)
+    .def_readwrite("bucket_sizes", &GraphExecutorCachePolicy::bucket_sizes);
+
+  py::class_<GraphExecutorCacheStats>(m, "GraphExecutorCacheStats")
+    .def_readonly("hits", &GraphExecutorCacheStats::hits)
+    .def_readonly("misses", &GraphExecutorCacheStats::misses)
+    .def_readonly("evictions", &GraphExecutorCacheStats::evictions)
+    .def_readonly("compile_seconds", &GraphExecutorCacheStats::compile_seconds);
+
   py::class_<GraphExecutorState>(m, "GraphExecutorState")
     .def_property_readonly("graph", [](GraphExecutorState& s) {
       return s.graph;
@@ -222,6 +259,15 @@ void initJITBindings(PyObject *module) {
     .def_property_readonly("execution_plans", [](GraphExecutorState& s) {
       return s.execution_plans;
     })
+    .def_property_readonly("memory_plans", [](GraphExecutorState& s) {
+      return s.memory_plans;
+    })
+    .def_property_readonly("execution_plan_cache", [](GraphExecutorState& s) {
+      return s.execution_plan_cache;
+    })
+    .def_property_readonly("memory_plan_cache", [](GraphExecutorState& s) {
+      return s.memory_plan_cache;
+    })
     .def_property_readonly("fallback", [](GraphExecutorState& s) {
       return s.fallback;
     });
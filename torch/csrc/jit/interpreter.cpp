@@ -10,16 +10,22 @@
 #include "torch/csrc/jit/ir.h"
 #include "torch/csrc/jit/ivalue.h"
 #include "torch/csrc/jit/constants.h"
+#include "torch/csrc/jit/memory_planning.h"
 #include "torch/csrc/jit/operator.h"
 #include "torch/csrc/variable_tensor_functions.h"
 #include "torch/csrc/jit/script/jit_exception.h"
 
+#include <ATen/Parallel.h>
+
+#include <atomic>
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <ostream>
 #include <stdexcept>
+#include <thread>
 #include <typeinfo>
 #include <unordered_map>
 #include <unordered_set>
@@ -349,14 +355,104 @@ struct UseList {
   ListHandle<bool> free_flags;
 };
 
+// Note [Interpreter opcodes]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Most instructions call an Operation: their inputs are pushed on the stack,
+// the std::function is called and the outputs are popped off the stack into
+// registers. For graphs of many small ops (scalar math, loop counters, list
+// construction) this costs more than the ops themselves, so control flow and
+// the most common prim ops get their own opcode, which the interpreter loop
+// executes in place, reading and writing registers directly.
+enum class OpCode : uint8_t {
+  OP,          // outputs = callback(inputs)
+  CONSTANT,    // output = constant
+  ASSIGN,      // outputs = inputs, all inputs are read before any output is written
+  DROP,        // free the inputs
+  JUMP,        // pc += jump_offset
+  JUMP_TRUE,   // if input: pc += jump_offset
+  JUMP_FALSE,  // if not input: pc += jump_offset
+  // output = input0 op input1
+  INT_ADD, INT_SUB, INT_MUL, INT_EQ, INT_NE, INT_LT, INT_GT, INT_LE, INT_GE,
+  FLOAT_ADD, FLOAT_SUB, FLOAT_MUL, FLOAT_EQ, FLOAT_NE, FLOAT_LT, FLOAT_GT, FLOAT_LE, FLOAT_GE,
+  BOOL_AND,
+  // output = [inputs]
+  INT_LIST, FLOAT_LIST, TENSOR_LIST,
+};
+
+// The opcode that executes n without calling its Operation, if there is one
+OpCode specializedOpCode(const Node* n) {
+  switch (n->kind()) {
+    case prim::Constant:
+      return OpCode::CONSTANT;
+    case prim::Drop:
+      return OpCode::DROP;
+    case prim::ListConstruct: {
+      auto elem_type = n->output()->type()->expect<ListType>()->getElementType();
+      if (elem_type->kind() == TypeKind::IntType) {
+        return OpCode::INT_LIST;
+      } else if (elem_type->kind() == TypeKind::FloatType) {
+        return OpCode::FLOAT_LIST;
+      } else if (elem_type->isSubtypeOf(DynamicType::get())) {
+        return OpCode::TENSOR_LIST;
+      }
+      return OpCode::OP;
+    }
+    default:
+      break;
+  }
+  if (n->inputs().size() != 2 || n->outputs().size() != 1) {
+    return OpCode::OP;
+  }
+  const auto type = n->input(0)->type()->kind();
+  if (n->input(1)->type()->kind() != type) {
+    return OpCode::OP;
+  }
+  if (type == TypeKind::IntType) {
+    switch (n->kind()) {
+      case aten::add: return OpCode::INT_ADD;
+      case aten::sub: return OpCode::INT_SUB;
+      case aten::mul: return OpCode::INT_MUL;
+      case aten::eq: return OpCode::INT_EQ;
+      case aten::ne: return OpCode::INT_NE;
+      case aten::lt: return OpCode::INT_LT;
+      case aten::gt: return OpCode::INT_GT;
+      case aten::le: return OpCode::INT_LE;
+      case aten::ge: return OpCode::INT_GE;
+      default: break;
+    }
+  } else if (type == TypeKind::FloatType) {
+    switch (n->kind()) {
+      case aten::add: return OpCode::FLOAT_ADD;
+      case aten::sub: return OpCode::FLOAT_SUB;
+      case aten::mul: return OpCode::FLOAT_MUL;
+      case aten::eq: return OpCode::FLOAT_EQ;
+      case aten::ne: return OpCode::FLOAT_NE;
+      case aten::lt: return OpCode::FLOAT_LT;
+      case aten::gt: return OpCode::FLOAT_GT;
+      case aten::le: return OpCode::FLOAT_LE;
+      case aten::ge: return OpCode::FLOAT_GE;
+      default: break;
+    }
+  } else if (type == TypeKind::BoolType && n->kind() == aten::__and__) {
+    return OpCode::BOOL_AND;
+  }
+  return OpCode::OP;
+}
+
 // one instruction plus meta-data
 // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
 struct Instruction {
-  Operation callback;
+  OpCode op = OpCode::OP;
+  Operation callback; // only used by OP
   UseList inputs;
   ListHandle<int> outputs;
+  int jump_offset = 0; // only used by jumps
+  IValue constant; // only used by CONSTANT
   Symbol debug_name; // used in dump to understand the generated code
   std::shared_ptr<SourceLocation> debug_location; // for error reporting
+  // buffer of the memory arena passed as the out argument to callback, or -1
+  // (see Note [Memory planning])
+  int out_buffer = -1;
 };
 
 
@@ -365,43 +461,46 @@ int relativeJump(int from_inst, int to_inst) {
 }
 
 struct CodeImpl {
-  CodeImpl(const std::shared_ptr<Graph>& graph_)
+  CodeImpl(const std::shared_ptr<Graph>& graph_, bool plan_memory)
       : preprocess(*graph_) {
     graph = preprocess.graph;
+    if (plan_memory) {
+      memory_plan = planMemory(graph->block());
+    }
+    for (auto& slot : free_arenas) {
+      slot.store(nullptr);
+    }
     insertNodesFromBlock(graph->block());
   }
+  ~CodeImpl() {
+    for (auto& slot : free_arenas) {
+      delete slot.load();
+    }
+  }
 
   // jump when input is false
   void createJumpFalse(int from_inst, int to_inst) {
     auto & inst = instructions[from_inst];
-    JIT_ASSERT(inst.debug_name == prim::Placeholder);
-    auto offset = relativeJump(from_inst, to_inst);
-    inst.callback = [offset](Stack & stack) {
-      auto t = pop(stack).toBool();
-      return t ? 0 : offset;
-    };
+    JIT_ASSERT(inst.debug_name == prim::Placeholder && inst.inputs.values.size == 1);
+    inst.op = OpCode::JUMP_FALSE;
+    inst.jump_offset = relativeJump(from_inst, to_inst);
     inst.debug_name = prim::JumpZ;
   }
 
   // jump when input is true
   void createJumpTrue(int from_inst, int to_inst) {
     auto & inst = instructions[from_inst];
-    JIT_ASSERT(inst.debug_name == prim::Placeholder);
-    auto offset = relativeJump(from_inst, to_inst);
-    inst.callback = [offset](Stack & stack) {
-      auto t = pop(stack).toBool();
-      return t ? offset : 0;
-    };
+    JIT_ASSERT(inst.debug_name == prim::Placeholder && inst.inputs.values.size == 1);
+    inst.op = OpCode::JUMP_TRUE;
+    inst.jump_offset = relativeJump(from_inst, to_inst);
     inst.debug_name = prim::JumpNZ;
   }
 
   void createJump(int from_inst, int to_inst) {
     auto & inst = instructions[from_inst];
     JIT_ASSERT(inst.debug_name == prim::Placeholder);
-    auto offset = relativeJump(from_inst, to_inst);
-    inst.callback = [=](Stack & stack) {
-      return offset;
-    };
+    inst.op = OpCode::JUMP;
+    inst.jump_offset = relativeJump(from_inst, to_inst);
     inst.debug_name = prim::Jump;
   }
 
@@ -452,26 +551,26 @@ struct CodeImpl {
           // JumpZ c, end
           // begin:
           //   <body>
-          //   c, l0 = v0, v1
-          //   JumpNZ c, begin
+          //   l0 = v1
+          //   JumpNZ v0, begin
           // end:
 
+          // After desugarTripCounts, the conditions are the outputs of
+          // nodes, so the assignments to the block inputs can't overwrite
+          // them before the jumps read them.
           auto body_block = node->blocks()[0];
+          auto loop_flags = moveFlags(node);
+          auto body_flags = moveFlags(body_block);
 
-          // before assign op: stack: ... <cond> <loop-carried-depdencies>
-          insertAssign(source_location, node->inputs(), moveFlags(node), body_block->inputs());
-          // after assign op: stack: ... <cond>
-          // cond_branch consumes <cond> from top of the stack
-          auto cond_branch = insertInstruction(prim::Placeholder, source_location,{}, {}, {});
-          // after branch: stack: ...
+          insertAssign(source_location, node->inputs().slice(1), loop_flags.slice(1), body_block->inputs());
+          auto cond_branch = insertInstruction(prim::Placeholder, source_location,
+              node->inputs().slice(0, 1), loop_flags.slice(0, 1), {});
 
           auto entry = instructions.size();
           insertNodesFromBlock(body_block);
-          // before assign op: stack: ... <cond> <loop-carried-depdencies>
-          insertAssign(source_location, body_block->outputs(), moveFlags(body_block), body_block->inputs());
-          // after assign op: stack: ... <cond>
-          auto cond_branch_end = insertInstruction(prim::Placeholder, source_location, {}, {}, {});
-          // after branch: stack: ...
+          insertAssign(source_location, body_block->outputs().slice(1), body_flags.slice(1), body_block->inputs());
+          auto cond_branch_end = insertInstruction(prim::Placeholder, source_location,
+              body_block->outputs().slice(0, 1), body_flags.slice(0, 1), {});
 
           aliasRegistersTo(node->outputs(), body_block->inputs());
           createJumpFalse(cond_branch, instructions.size());
@@ -486,7 +585,24 @@ struct CodeImpl {
 
   size_t insertInstruction(Node * n) {
     auto inst = insertInstruction(n->kind(), n->getSourceLocation(), n->inputs(), moveFlags(n) , n->outputs());
-    instructions[inst].callback = getOperation(n);
+    auto & instruction = instructions[inst];
+    auto planned = memory_plan.nodes.find(n);
+    if (planned != memory_plan.nodes.end()) {
+      instruction.callback = planned->second.out_variant;
+      instruction.out_buffer = planned->second.buffer;
+      return inst;
+    }
+    instruction.op = specializedOpCode(n);
+    if (instruction.op == OpCode::CONSTANT) {
+      if (auto constant = toIValue(n->output())) {
+        instruction.constant = std::move(*constant);
+      } else {
+        instruction.op = OpCode::OP;
+      }
+    }
+    if (instruction.op == OpCode::OP) {
+      instruction.callback = getOperation(n);
+    }
     return inst;
   }
   size_t insertInstruction(Symbol sym,
@@ -522,9 +638,7 @@ struct CodeImpl {
   size_t insertAssign(std::shared_ptr<SourceLocation> debug_location, ArrayRef<Value*> inputs, ArrayRef<uint8_t> move_flags, ArrayRef<Value*> outputs) {
     auto inst = insertInstruction(prim::Assign, std::move(debug_location),inputs, move_flags, outputs);
     // This node effectively forwards its inputs into different places in a register list.
-    // We don't need to manipulate the stack in any way, because all inputs are also outputs,
-    // and the interpreter will take care of putting them in correct places.
-    instructions[inst].callback = [](Stack& stack) { return 0; };
+    instructions[inst].op = OpCode::ASSIGN;
     return inst;
   }
 
@@ -616,6 +730,40 @@ struct CodeImpl {
       dumpInstruction(out, i);
       out << "\n";
     }
+    if (!memory_plan.empty()) {
+      out << memory_plan.stats << "\n";
+    }
+  }
+
+  // Every run in progress uses its own arena. Released arenas are kept in a
+  // few slots that runs swap them in and out of without locking, starting
+  // from a slot picked by their thread so that concurrent runs rarely touch
+  // the same one. An arena released when all slots are taken is freed.
+  std::unique_ptr<MemoryArena> acquireArena() {
+    const size_t start = firstArenaSlot();
+    for (size_t i = 0; i < kArenaSlots; ++i) {
+      auto& slot = free_arenas[(start + i) % kArenaSlots];
+      if (slot.load(std::memory_order_relaxed)) {
+        if (auto arena = slot.exchange(nullptr, std::memory_order_acquire)) {
+          return std::unique_ptr<MemoryArena>(arena);
+        }
+      }
+    }
+    return std::unique_ptr<MemoryArena>(new MemoryArena(memory_plan));
+  }
+  void releaseArena(std::unique_ptr<MemoryArena> arena) {
+    const size_t start = firstArenaSlot();
+    for (size_t i = 0; i < kArenaSlots; ++i) {
+      MemoryArena* empty = nullptr;
+      if (free_arenas[(start + i) % kArenaSlots].compare_exchange_strong(
+              empty, arena.get(), std::memory_order_release)) {
+        arena.release();
+        return;
+      }
+    }
+  }
+  static size_t firstArenaSlot() {
+    return std::hash<std::thread::id>()(std::this_thread::get_id()) % kArenaSlots;
   }
 
   // We MUST hold onto graph here because some Operators stored in the
@@ -637,6 +785,10 @@ struct CodeImpl {
   // the interpreter is mostly linearly scanning through memory
   std::vector<int> int_data;
   std::vector<bool> bool_data;
+
+  MemoryPlan memory_plan;
+  static constexpr size_t kArenaSlots = 16;
+  std::atomic<MemoryArena*> free_arenas[kArenaSlots];
 };
 
 // InterpreterState state that and used to compute a Code
@@ -646,6 +798,15 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
     int_data(function->int_data.data()),
     bool_data(function->bool_data),
     registers(function->register_size) {
+    if (!function->memory_plan.empty()) {
+      arena = function->acquireArena();
+    }
+  }
+  ~InterpreterStateImpl() {
+    if (arena) {
+      registers.clear();
+      function->releaseArena(std::move(arena));
+    }
   }
 
  private:
@@ -664,14 +825,106 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
         // std::cout << "\n";
         auto & inst = instructions[pc];
         try {
-          loadTensorsFromRegisters(inst.inputs, stack);
-          size_t new_pc = pc + 1 + inst.callback(stack);
-          for (int i = inst.outputs.size - 1; i >= 0; --i) {
-            int reg = get(inst.outputs, i);
-            registers[reg] = pop(stack);
-            // std::cout << "pop reg[" << reg << "];\n" << registers[reg] << "\n";
+          switch (inst.op) {
+            case OpCode::OP: {
+              loadTensorsFromRegisters(inst.inputs, stack);
+              c10::optional<autograd::profiler::RecordFunction> record;
+              if (autograd::profiler::hasRecordFunctionCallbacks()) {
+                record.emplace(
+                    autograd::profiler::RecordFunction::CallbacksOnly(),
+                    inst.debug_name.toQualString(),
+                    jit::last(stack, inst.inputs.values.size));
+              }
+              if (inst.out_buffer >= 0) {
+                stack.emplace_back(arena->buffers[inst.out_buffer]);
+              }
+              size_t new_pc = pc + 1 + inst.callback(stack);
+              storeOutputsToRegisters(inst.outputs, stack);
+              pc = new_pc;
+            } break;
+            case OpCode::CONSTANT:
+              registers[get(inst.outputs, 0)] = inst.constant;
+              ++pc;
+              break;
+            case OpCode::ASSIGN:
+              if (inst.inputs.values.size == 1) {
+                registers[get(inst.outputs, 0)] = loadInput(inst.inputs, 0);
+              } else {
+                loadTensorsFromRegisters(inst.inputs, stack);
+                storeOutputsToRegisters(inst.outputs, stack);
+              }
+              ++pc;
+              break;
+            case OpCode::DROP:
+              for (int i = 0; i < inst.inputs.values.size; ++i) {
+                if (get(inst.inputs.free_flags, i)) {
+                  registers[get(inst.inputs.values, i)] = IValue();
+                }
+              }
+              ++pc;
+              break;
+            case OpCode::JUMP:
+              pc += 1 + inst.jump_offset;
+              break;
+            case OpCode::JUMP_TRUE:
+              pc += 1 + (loadInput(inst.inputs, 0).toBool() ? inst.jump_offset : 0);
+              break;
+            case OpCode::JUMP_FALSE:
+              pc += 1 + (loadInput(inst.inputs, 0).toBool() ? 0 : inst.jump_offset);
+              break;
+#define BINARY_OPCODE(opcode, to_value, op)                       \
+            case OpCode::opcode: {                                \
+              auto a = registers[get(inst.inputs.values, 0)].to_value(); \
+              auto b = registers[get(inst.inputs.values, 1)].to_value(); \
+              registers[get(inst.outputs, 0)] = op;               \
+              ++pc;                                               \
+            } break;
+            BINARY_OPCODE(INT_ADD, toInt, a + b)
+            BINARY_OPCODE(INT_SUB, toInt, a - b)
+            BINARY_OPCODE(INT_MUL, toInt, a * b)
+            BINARY_OPCODE(INT_EQ, toInt, a == b)
+            BINARY_OPCODE(INT_NE, toInt, a != b)
+            BINARY_OPCODE(INT_LT, toInt, a < b)
+            BINARY_OPCODE(INT_GT, toInt, a > b)
+            BINARY_OPCODE(INT_LE, toInt, a <= b)
+            BINARY_OPCODE(INT_GE, toInt, a >= b)
+            BINARY_OPCODE(FLOAT_ADD, toDouble, a + b)
+            BINARY_OPCODE(FLOAT_SUB, toDouble, a - b)
+            BINARY_OPCODE(FLOAT_MUL, toDouble, a * b)
+            BINARY_OPCODE(FLOAT_EQ, toDouble, a == b)
+            BINARY_OPCODE(FLOAT_NE, toDouble, a != b)
+            BINARY_OPCODE(FLOAT_LT, toDouble, a < b)
+            BINARY_OPCODE(FLOAT_GT, toDouble, a > b)
+            BINARY_OPCODE(FLOAT_LE, toDouble, a <= b)
+            BINARY_OPCODE(FLOAT_GE, toDouble, a >= b)
+            BINARY_OPCODE(BOOL_AND, toBool, a && b)
+#undef BINARY_OPCODE
+            case OpCode::INT_LIST: {
+              std::vector<int64_t> vals(inst.inputs.values.size);
+              for (size_t i = 0; i < vals.size(); ++i) {
+                vals[i] = registers[get(inst.inputs.values, i)].toInt();
+              }
+              registers[get(inst.outputs, 0)] = std::move(vals);
+              ++pc;
+            } break;
+            case OpCode::FLOAT_LIST: {
+              std::vector<double> vals(inst.inputs.values.size);
+              for (size_t i = 0; i < vals.size(); ++i) {
+                vals[i] = registers[get(inst.inputs.values, i)].toDouble();
+              }
+              registers[get(inst.outputs, 0)] = std::move(vals);
+              ++pc;
+            } break;
+            case OpCode::TENSOR_LIST: {
+              std::vector<at::Tensor> vals;
+              vals.reserve(inst.inputs.values.size);
+              for (int i = 0; i < inst.inputs.values.size; ++i) {
+                vals.push_back(loadInput(inst.inputs, i).toTensor());
+              }
+              registers[get(inst.outputs, 0)] = std::move(vals);
+              ++pc;
+            } break;
           }
-          pc = new_pc;
         } catch (Suspend& e) {
           // wait() expects a single input
           JIT_ASSERT(inst.inputs.values.size == 1);
@@ -688,8 +941,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
           // the current thread will continue running before it suspends.
           InterpreterState state(intrusive_from_this());
           e.future->addCallback([state]() {
-            c10::global_work_queue().run(
-                InterpreterContinuation(state, Stack()));
+            at::launch(InterpreterContinuation(state, Stack()));
           });
 
           return true;
@@ -728,7 +980,13 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
 
   c10::intrusive_ptr<Future> runAsync(Stack& stack) {
     getOrCreateFuture();
-    runImpl(stack);
+    // this usually runs as a task of the inter-op pool, which drops
+    // exceptions, so errors are passed to whoever waits for the future
+    try {
+      runImpl(stack);
+    } catch (std::exception& e) {
+      future->markCompletedWithError(e.what());
+    }
     return future;
   }
 
@@ -754,6 +1012,22 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
   bool get(const ListHandle<bool> & list, int i) {
     return bool_data[list.start + i];
   }
+  // the value of input i of an instruction, moved out of its register if
+  // this is its last use
+  IValue loadInput(const UseList & uses, int i) {
+    int reg = get(uses.values, i);
+    if (get(uses.free_flags, i)) {
+      return std::move(registers[reg]);
+    }
+    return registers[reg];
+  }
+  void storeOutputsToRegisters(const ListHandle<int> & outputs, Stack & stack) {
+    for (int i = outputs.size - 1; i >= 0; --i) {
+      int reg = get(outputs, i);
+      registers[reg] = pop(stack);
+      // std::cout << "pop reg[" << reg << "];\n" << registers[reg] << "\n";
+    }
+  }
   void loadTensorsFromRegisters(const UseList & uses, Stack & stack) {
     for(int i = 0; i < uses.values.size; i++) {
       int reg = get(uses.values,i);
@@ -790,6 +1064,9 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
 
   // single buffer for input/output calls to ATen functions, so that we do not reallocate
   Stack stack;
+
+  // where planned nodes write their outputs (see Note [Memory planning])
+  std::unique_ptr<MemoryArena> arena;
 };
 
 std::ostream & operator<<(std::ostream & out, const Code & code) {
@@ -798,14 +1075,18 @@ std::ostream & operator<<(std::ostream & out, const Code & code) {
   return out;
 }
 
-Code::Code(const std::shared_ptr<Graph>& graph)
-    : pImpl(new CodeImpl(graph)) {}
+Code::Code(const std::shared_ptr<Graph>& graph, bool plan_memory)
+    : pImpl(new CodeImpl(graph, plan_memory)) {}
 Code::~Code() = default;
 
 const std::vector<GraphExecutor*>& Code::grad_executors() {
   return pImpl->grad_executors();
 }
 
+const MemoryPlanStats* Code::memoryPlanStats() const {
+  return pImpl->memory_plan.empty() ? nullptr : &pImpl->memory_plan.stats;
+}
+
 InterpreterState::InterpreterState(const Code & code)
   : pImpl(c10::make_intrusive<InterpreterStateImpl>(code)) {}
 InterpreterState::~InterpreterState() = default;
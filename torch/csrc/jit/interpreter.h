@@ -3,6 +3,7 @@
 #include <vector>
 #include "c10/util/Optional.h"
 
+#include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/jit/ivalue.h"
 #include "torch/csrc/WindowsTorchApiMacro.h"
 
@@ -22,6 +23,7 @@ struct Node;
 struct GraphExecutor;
 struct CodeImpl;
 struct InterpreterStateImpl;
+struct MemoryPlanStats;
 struct Graph;
 struct Node;
 using Stack = std::vector<c10::IValue>;
@@ -29,11 +31,16 @@ using Stack = std::vector<c10::IValue>;
 struct TORCH_API Code {
   Code()
     : pImpl(nullptr) {}
-  explicit Code(const std::shared_ptr<Graph>& graph);
+  // If plan_memory is true, the tensor outputs of graph must have complete
+  // types (see Note [Memory planning])
+  explicit Code(const std::shared_ptr<Graph>& graph, bool plan_memory = false);
   ~Code();
 
   const std::vector<GraphExecutor*>& grad_executors();
 
+  // nullptr if no tensor is planned
+  const MemoryPlanStats* memoryPlanStats() const;
+
   explicit operator bool() const {
     return pImpl != nullptr;
   }
@@ -72,14 +79,20 @@ struct Suspend : public std::exception {
 
 struct InterpreterContinuation {
   InterpreterContinuation(InterpreterState state_, Stack stack_)
-      : state(std::move(state_)), stack(std::move(stack_)) {}
+      : state(std::move(state_)),
+        stack(std::move(stack_)),
+        grad_mode_enabled(autograd::GradMode::is_enabled()) {}
 
   void operator()(void) {
+    // continuations run on other threads, with the grad mode of the thread
+    // that created them
+    autograd::AutoGradMode grad_mode(grad_mode_enabled);
     state.runAsync(stack);
   }
 
  private:
   InterpreterState state;
   Stack stack;
+  bool grad_mode_enabled;
 };
 }}
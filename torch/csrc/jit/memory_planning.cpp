@@ -0,0 +1,289 @@
+#include "torch/csrc/jit/memory_planning.h"
+
+#include "torch/csrc/autograd/variable.h"
+#include "torch/csrc/jit/assertions.h"
+#include "torch/csrc/jit/operator.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace torch { namespace jit {
+
+// Note [Memory planning]
+// ~~~~~~~~~~~~~~~~~~~~~~
+// Normally every op allocates its outputs and the interpreter frees them
+// after their last use, so a graph run in a loop with the same shapes
+// allocates and frees the same sizes on every call. When all sizes are known
+// (the graph executor specializes a graph to the sizes of its inputs for
+// this, see GraphExecutorImpl::getOrCompileMemoryPlan), the outputs of ops
+// with an out= variant can instead be written to fixed places in an arena
+// that is allocated once, and tensors whose lifetimes don't overlap can
+// share memory.
+//
+// Only tensors that can't outlive the graph are planned: outputs of nodes of
+// the top level block, on the CPU, that are not graph outputs and are only
+// read by ops known to only read their inputs (see copiesInputs). Their
+// lifetime goes from the node that writes them to the node (or the top level
+// node containing the node) that reads them last, and two tensors can share
+// memory if their lifetimes don't overlap; a node never writes to the memory
+// of its own inputs. The offsets are assigned greedily, largest tensors
+// first, each at the lowest offset that doesn't overlap the tensors alive at
+// the same time that are already placed.
+//
+// The interpreter passes the buffer of a planned node as the out argument of
+// the out= variant of its op. The sizes planned for may be bigger than the
+// actual ones (the executor can round them up so that similar shapes share a
+// plan), and the out= variant resizes the buffer within its memory. If an op
+// produces a bigger output than planned, the buffer is reallocated out of
+// the arena instead of writing to the memory of another tensor, and stays
+// there for the next runs that use this arena. Every concurrent run of a
+// graph takes its own arena from a pool kept by its Code.
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+
+size_t alignUp(size_t n) {
+  return (n + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Ops that are known to only read their inputs and return new tensors.
+// Alias annotations can't be relied on for this: ops like split_with_sizes
+// and _unsafe_view return views of their inputs without being annotated,
+// and others like contiguous, to, _cast_Float or dropout in eval mode may
+// return their input as is.
+const std::unordered_set<Symbol>& copiesInputs() {
+  static const std::unordered_set<Symbol> kinds = {
+    aten::add,
+    aten::sub,
+    aten::mul,
+    aten::div,
+    aten::neg,
+    aten::abs,
+    aten::exp,
+    aten::log,
+    aten::sqrt,
+    aten::rsqrt,
+    aten::pow,
+    aten::clamp,
+    aten::relu,
+    aten::threshold,
+    aten::sigmoid,
+    aten::tanh,
+    aten::addcmul,
+    aten::addcdiv,
+    aten::where,
+    aten::eq,
+    aten::ne,
+    aten::lt,
+    aten::le,
+    aten::gt,
+    aten::ge,
+    aten::mm,
+    aten::bmm,
+    aten::addmm,
+    aten::baddbmm,
+    aten::linear,
+    aten::conv1d,
+    aten::conv2d,
+    aten::conv3d,
+    aten::_convolution,
+    aten::cat,
+    aten::stack,
+    aten::sum,
+    aten::mean,
+    aten::softmax,
+    aten::log_softmax,
+    aten::batch_norm,
+    aten::layer_norm,
+    aten::max_pool2d,
+    aten::avg_pool2d,
+    aten::adaptive_avg_pool2d,
+    aten::index_select,
+    aten::embedding,
+  };
+  return kinds;
+}
+
+// Can user read a planned tensor without it escaping?
+bool canReadPlanned(const Node* user) {
+  switch (user->kind()) {
+    case prim::Drop:
+    case prim::FusionGroup:
+    case prim::Print:
+    case prim::TensorToBool:
+    case prim::TensorToNum:
+    case prim::ImplicitTensorToNum:
+      return true;
+    default:
+      break;
+  }
+  if (copiesInputs().count(user->kind()) == 0) {
+    return false;
+  }
+  const FunctionSchema* schema = user->maybeSchema();
+  if (!schema) {
+    return false;
+  }
+  // out= variants and in-place overloads write to an argument
+  for (const auto& arg : schema->arguments()) {
+    if (arg.alias_info()) return false;
+  }
+  for (const auto& ret : schema->returns()) {
+    if (ret.alias_info()) return false;
+  }
+  return true;
+}
+
+// The operator taking the arguments of node followed by a Tensor out
+c10::optional<Operation> findOutVariant(const Node* node) {
+  const FunctionSchema* schema = node->maybeSchema();
+  if (!schema || schema->returns().size() != 1) {
+    return c10::nullopt;
+  }
+  const auto& args = schema->arguments();
+  for (const auto& op : getAllOperatorsFor(node->kind())) {
+    const auto& out_args = op->schema().arguments();
+    if (out_args.size() != args.size() + 1 || out_args.back().name() != "out" ||
+        !out_args.back().type()->isSubtypeOf(DynamicType::get())) {
+      continue;
+    }
+    bool same_args = true;
+    for (size_t i = 0; i < args.size(); ++i) {
+      same_args = same_args && args[i].name() == out_args[i].name() &&
+          *args[i].type() == *out_args[i].type();
+    }
+    if (same_args) {
+      return op->getOperation(node);
+    }
+  }
+  return c10::nullopt;
+}
+
+struct Lifetime {
+  const Node* node;
+  size_t begin;
+  size_t end;
+  size_t nbytes;
+};
+
+} // anonymous namespace
+
+MemoryPlan planMemory(Block* block) {
+  std::unordered_map<const Node*, size_t> index;
+  for (Node* n : block->nodes()) {
+    index.emplace(n, index.size());
+  }
+  auto topLevelIndex = [&](Node* n) {
+    while (n->owningBlock() != block) {
+      n = n->owningBlock()->owningNode();
+    }
+    return index.at(n);
+  };
+
+  MemoryPlan plan;
+  std::vector<Lifetime> lifetimes;
+  std::unordered_map<const Node*, Operation> out_variants;
+  for (Node* n : block->nodes()) {
+    if (n->outputs().size() != 1 || !n->kind().is_aten()) continue;
+    auto type = n->output()->type()->cast<CompleteTensorType>();
+    if (!type || !type->device().is_cpu()) continue;
+    Lifetime lifetime {n, index.at(n), index.at(n), 0};
+    bool can_plan = true;
+    for (const Use& use : n->output()->uses()) {
+      can_plan = can_plan && canReadPlanned(use.user);
+      lifetime.end = std::max(lifetime.end, topLevelIndex(use.user));
+    }
+    if (!can_plan) continue;
+    int64_t numel = 1;
+    for (int64_t size : type->sizes()) {
+      numel *= size;
+    }
+    lifetime.nbytes = numel * at::elementSize(type->scalarType());
+    if (lifetime.nbytes == 0) continue;
+    auto out_variant = findOutVariant(n);
+    if (!out_variant) continue;
+    out_variants.emplace(n, std::move(*out_variant));
+    lifetimes.push_back(lifetime);
+  }
+
+  // Greedy by size
+  std::vector<size_t> order(lifetimes.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return lifetimes[a].nbytes > lifetimes[b].nbytes;
+  });
+  std::vector<size_t> offsets(lifetimes.size());
+  std::vector<size_t> placed;
+  for (size_t i : order) {
+    const auto& lifetime = lifetimes[i];
+    // the placed tensors alive at the same time, by offset
+    std::vector<size_t> overlapping;
+    for (size_t j : placed) {
+      if (lifetimes[j].begin <= lifetime.end && lifetime.begin <= lifetimes[j].end) {
+        overlapping.push_back(j);
+      }
+    }
+    std::sort(overlapping.begin(), overlapping.end(), [&](size_t a, size_t b) {
+      return offsets[a] < offsets[b];
+    });
+    size_t offset = 0;
+    for (size_t j : overlapping) {
+      if (offset + lifetime.nbytes <= offsets[j]) break;
+      offset = std::max(offset, alignUp(offsets[j] + lifetimes[j].nbytes));
+    }
+    offsets[i] = offset;
+    placed.push_back(i);
+  }
+
+  for (size_t i = 0; i < lifetimes.size(); ++i) {
+    const Node* n = lifetimes[i].node;
+    auto type = n->output()->type()->expect<CompleteTensorType>();
+    plan.nodes.emplace(n, MemoryPlan::PlannedNode{plan.buffers.size(), std::move(out_variants.at(n))});
+    plan.buffers.push_back(MemoryPlan::Buffer{offsets[i], type->scalarType(), type->sizes()});
+    plan.stats.num_tensors++;
+    plan.stats.planned_bytes = std::max(plan.stats.planned_bytes, alignUp(offsets[i] + lifetimes[i].nbytes));
+    plan.stats.unshared_bytes += lifetimes[i].nbytes;
+  }
+  std::vector<int64_t> live(index.size() + 1, 0);
+  for (const auto& lifetime : lifetimes) {
+    live[lifetime.begin] += lifetime.nbytes;
+    live[lifetime.end + 1] -= lifetime.nbytes;
+  }
+  int64_t live_bytes = 0;
+  for (int64_t delta : live) {
+    live_bytes += delta;
+    plan.stats.peak_bytes = std::max(plan.stats.peak_bytes, static_cast<size_t>(live_bytes));
+  }
+  return plan;
+}
+
+MemoryArena::MemoryArena(const MemoryPlan& plan)
+  : memory(at::empty({static_cast<int64_t>(plan.stats.planned_bytes)}, at::kByte)) {
+  buffers.reserve(plan.buffers.size());
+  auto* data = static_cast<uint8_t*>(memory.data_ptr());
+  for (const auto& buffer : plan.buffers) {
+    // the buffers keep the memory alive, even if one outlived the arena
+    at::Tensor memory_ref = memory;
+    auto tensor = at::from_blob(
+        data + buffer.offset,
+        buffer.sizes,
+        [memory_ref](void*) {},
+        at::device(at::kCPU).dtype(buffer.scalar_type));
+    // growing past the planned size moves the buffer out of the arena
+    auto* storage = tensor.storage().unsafeGetStorageImpl();
+    storage->set_allocator(at::getCPUAllocator());
+    storage->set_resizable(true);
+    buffers.push_back(autograd::make_variable(std::move(tensor)));
+  }
+}
+
+std::ostream& operator<<(std::ostream& out, const MemoryPlanStats& stats) {
+  return out << "memory plan: " << stats.num_tensors << " tensors in "
+             << stats.planned_bytes << " bytes (" << stats.unshared_bytes
+             << " bytes unshared, " << stats.peak_bytes << " bytes peak)";
+}
+
+}} // namespace torch::jit
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/stack.h"
+#include "torch/csrc/WindowsTorchApiMacro.h"
+
+#include "ATen/ATen.h"
+
+#include <cstddef>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace torch { namespace jit {
+
+struct MemoryPlanStats {
+  size_t num_tensors = 0;     // tensors written to the arena
+  size_t planned_bytes = 0;   // size of the arena
+  size_t unshared_bytes = 0;  // total size of these tensors
+  size_t peak_bytes = 0;      // most bytes of these tensors alive at once
+};
+
+// Where the outputs of the nodes of a graph go in a preallocated arena
+// (see Note [Memory planning])
+struct MemoryPlan {
+  struct Buffer {
+    size_t offset; // in bytes
+    at::ScalarType scalar_type;
+    std::vector<int64_t> sizes;
+  };
+  struct PlannedNode {
+    size_t buffer;
+    Operation out_variant; // takes the buffer as its last argument
+  };
+
+  bool empty() const {
+    return nodes.empty();
+  }
+
+  std::vector<Buffer> buffers;
+  std::unordered_map<const Node*, PlannedNode> nodes;
+  MemoryPlanStats stats;
+};
+
+// Plans the nodes of block, the top level block of a graph preprocessed for
+// the interpreter, whose tensor outputs have complete types
+TORCH_API MemoryPlan planMemory(Block* block);
+
+// The memory of one run of a planned graph
+struct MemoryArena {
+  explicit MemoryArena(const MemoryPlan& plan);
+
+  at::Tensor memory;
+  // variables that view memory, one for each buffer of the plan
+  std::vector<at::Tensor> buffers;
+};
+
+TORCH_API std::ostream& operator<<(std::ostream& out, const MemoryPlanStats& stats);
+
+}} // namespace torch::jit
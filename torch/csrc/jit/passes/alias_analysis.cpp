@@ -278,6 +278,8 @@ void AliasDb::analyze(Node* node) {
     case prim::FusedConcat:
     case prim::MMTreeReduce:
     case prim::MMBatchSide:
+    case prim::LinearBatchSide:
+    case prim::MMBatchStack:
     case prim::None:
     case prim::BroadcastSizes:
     case prim::ChunkSizes:
@@ -13,6 +13,7 @@
 #include <ATen/ATen.h>
 #include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace torch { namespace jit {
 
@@ -306,26 +307,41 @@ RegisterOperators mm_batch_side_reg({
     })
 });
 
+// Sorts mms in topological order and keeps the ones that don't depend on the
+// ones kept before them.
+std::vector<Node*> filterIndependent(std::vector<Node*> mms, const AliasDb& alias_db) {
+  if (mms.size() == 0) {
+    return mms;
+  }
+  std::sort(mms.begin(), mms.end(), [](Node* n, Node* m) { return n->isBefore(m); });
+  // Filter out dependent MMs. This algorithm might do very badly if e.g. you have
+  // a lot of independent MMs, that depend on the first one, but I doubt this will
+  // be a common scenario.
+  for (size_t i = 0; i < mms.size(); ++i) {
+    if (mms[i] == nullptr) continue;
+    for (size_t j = i + 1; j < mms.size(); ++j) {
+      if (mms[j] == nullptr) continue;
+      if (!mms[j]->couldMoveBeforeTopologically(mms[i], alias_db)) {
+        mms[j] = nullptr;
+      }
+    }
+  }
+  return filter(mms, [](Node *n) { return n != nullptr; });
+}
+
+// Moves all mms right before the last one, they have to be independent and in
+// topological order.
+void moveToLast(std::vector<Node*>& mms, const AliasDb& alias_db) {
+  for (int64_t i = static_cast<int64_t>(mms.size()) - 2; i >= 0; --i) {
+    bool move_ok = mms[i]->moveBeforeTopologicallyValid(mms[i + 1], alias_db);
+    JIT_ASSERT(move_ok);
+  }
+}
+
 std::pair<std::vector<Node*>, std::vector<Node*>>
 gatherIndependentMMUses(Value *value, const AliasDb& alias_db) {
   const auto postprocess = [&](std::vector<Node*> mms) {
-    if (mms.size() == 0) {
-      return mms;
-    }
-    std::sort(mms.begin(), mms.end(), [](Node* n, Node* m) { return n->isBefore(m); });
-    // Filter out dependent MMs. This algorithm might do very badly if e.g. you have
-    // a lot of independent MMs, that depend on the first one, but I doubt this will
-    // be a common scenario.
-    for (size_t i = 0; i < mms.size(); ++i) {
-      if (mms[i] == nullptr) continue;
-      for (size_t j = i + 1; j < mms.size(); ++j) {
-        if (mms[j] == nullptr) continue;
-        if (!mms[j]->couldMoveBeforeTopologically(mms[i], alias_db)) {
-          mms[j] = nullptr;
-        }
-      }
-    }
-    return filter(mms, [](Node *n) { return n != nullptr; });
+    return filterIndependent(std::move(mms), alias_db);
   };
 
   Block * block = value->node()->owningBlock();
@@ -349,10 +365,7 @@ void BatchMMSide(Block * block, const AliasDb& alias_db) {
   static constexpr size_t how_many_is_many = 8;
   const auto batch_side = [&](std::vector<Node*>& mms, Side side) {
     JIT_ASSERT(!mms.empty());
-    for (int64_t i = static_cast<int64_t>(mms.size()) - 2; i >= 0; --i) {
-      bool move_ok = mms[i]->moveBeforeTopologicallyValid(mms[i + 1], alias_db);
-      JIT_ASSERT(move_ok);
-    }
+    moveToLast(mms, alias_db);
     WithInsertPoint insert_guard { mms[0] };
     Graph* graph = mms[0]->owningGraph();
     Node* batch_mm = graph->create(prim::MMBatchSide,
@@ -391,6 +404,279 @@ void BatchMMSide(Block * block, const AliasDb& alias_db) {
 
 }
 
+// Note [Batching independent GEMMs]
+// Multi-head and multi-tower models apply many independent linear layers to
+// the same input, each with its own weight, and small models issue many small
+// independent mms. Two more rewrites batch these:
+//
+//   - linear, matmul and mm nodes that share their input and have 2-d weights
+//     become a prim::LinearBatchSide, which concatenates the weights (and
+//     biases) along the output features, runs a single GEMM and splits its
+//     output into the original outputs:
+//
+//       %q = aten::linear(%x, %wq, %bq)
+//       %k = aten::linear(%x, %wk, %bk)   =>   %q, %k, %v = prim::LinearBatchSide(%x, %wq, %wk, %wv, %bq, %bk, %bv)
+//       %v = aten::matmul(%x, %wv_t)           (with %wv = aten::t(%wv_t))
+//
+//   - independent mms become a prim::MMBatchStack, which stacks the operands
+//     of the mms of the same shape and runs a single bmm.
+//
+// Like prim::MMBatchSide, both only know the shapes at runtime, so they run
+// the GEMMs one by one when the shapes don't match or batching wouldn't pay
+// off. Concatenating or stacking copies the operands on every call, which is
+// only worth it when the GEMMs are small enough that running them one at a
+// time leaves most of the machine idle, and when the copied operands are
+// reused for enough rows (see shape_is_fast_for_concat and
+// shape_is_fast_for_stack).
+
+// Tunable parameters
+static constexpr size_t min_linear_batch_size = 2;
+static constexpr size_t min_mm_stack_size = 4;
+
+// Concatenating the weights copies all of them, so each row of the weights has
+// to be used by enough rows of the input, and weights that big already make
+// for an efficient GEMM on their own.
+bool shape_is_fast_for_concat(const at::Tensor& input, at::TensorList weights) {
+  const int64_t in_features = weights[0].size(1);
+  int64_t out_features = 0;
+  for (const at::Tensor& weight : weights) {
+    out_features += weight.size(0);
+  }
+  const int64_t rows = in_features == 0 ? 0 : input.numel() / in_features;
+  return rows >= 8 && in_features * out_features <= 1024 * 2048;
+}
+
+bool can_concat_weights(const at::Tensor& input, at::TensorList weights, at::TensorList biases) {
+  if (input.dim() == 0) return false;
+  for (size_t i = 0; i < weights.size(); ++i) {
+    const at::Tensor& weight = weights[i];
+    if (weight.dim() != 2 || weight.size(1) != input.size(-1) ||
+        weight.type() != input.type()) {
+      return false;
+    }
+    const at::Tensor& bias = biases[i];
+    if (bias.defined() && (bias.dim() != 1 || bias.size(0) != weight.size(0) ||
+                           bias.type() != input.type())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+RegisterOperators linear_batch_side_reg({
+  Operator(
+    prim::LinearBatchSide,
+    [](const Node* node) {
+      const bool has_bias = node->i(Symbol::attr("has_bias"));
+      const size_t num_weights = (node->inputs().size() - 1) / (has_bias ? 2 : 1);
+      return [num_weights, has_bias](Stack& stack) {
+        std::vector<at::Tensor> biases(num_weights);
+        if (has_bias) {
+          // absent biases are None
+          auto bias_inputs = last(stack, num_weights);
+          for (size_t i = 0; i < num_weights; ++i) {
+            if (bias_inputs[i].isTensor()) {
+              biases[i] = bias_inputs[i].toTensor();
+            }
+          }
+          drop(stack, num_weights);
+        }
+        std::vector<at::Tensor> weights;
+        weights.reserve(num_weights);
+        for (auto it = stack.end() - num_weights; it != stack.end(); ++it) {
+          weights.push_back(std::move(*it).toTensor());
+        }
+        drop(stack, num_weights);
+        at::Tensor input;
+        pop(stack, input);
+
+        if (can_concat_weights(input, weights, biases) &&
+            shape_is_fast_for_concat(input, weights)) {
+          std::vector<int64_t> split_sizes;
+          split_sizes.reserve(num_weights);
+          bool any_bias = false;
+          for (size_t i = 0; i < num_weights; ++i) {
+            split_sizes.push_back(weights[i].size(0));
+            any_bias = any_bias || biases[i].defined();
+          }
+          at::Tensor bias;
+          if (any_bias) {
+            for (size_t i = 0; i < num_weights; ++i) {
+              if (!biases[i].defined()) {
+                biases[i] = at::zeros({weights[i].size(0)}, input.options());
+              }
+            }
+            bias = at::cat(biases, /*dim=*/0);
+          }
+          auto output = at::linear(input, at::cat(weights, /*dim=*/0), bias);
+          // the slices along the last dim aren't contiguous, and views of the
+          // outputs (e.g. splitting them into heads) may need them to be
+          for (at::Tensor& slice : output.split_with_sizes(split_sizes, /*dim=*/-1)) {
+            stack.emplace_back(slice.contiguous());
+          }
+        } else {
+          for (size_t i = 0; i < num_weights; ++i) {
+            stack.emplace_back(at::linear(input, weights[i], biases[i]));
+          }
+        }
+        return 0;
+      };
+    })
+});
+
+// Stacking the operands copies all of them, which only pays off for GEMMs
+// small enough to be dominated by their fixed costs.
+bool shape_is_fast_for_stack(const at::Tensor& lhs, const at::Tensor& rhs) {
+  return lhs.size(0) * lhs.size(1) * rhs.size(1) <= 128 * 128 * 128;
+}
+
+RegisterOperators mm_batch_stack_reg({
+  Operator(
+    prim::MMBatchStack,
+    [](const Node* node) {
+      size_t num_mms = node->inputs().size() / 2;
+      return [num_mms](Stack& stack) {
+        std::vector<at::Tensor> inputs;
+        inputs.reserve(2 * num_mms);
+        for (auto it = stack.end() - 2 * num_mms; it != stack.end(); ++it) {
+          inputs.push_back(std::move(*it).toTensor());
+        }
+        drop(stack, 2 * num_mms);
+        auto lhses = at::TensorList(inputs).slice(0, num_mms);
+        auto rhses = at::TensorList(inputs).slice(num_mms);
+
+        std::vector<at::Tensor> outputs(num_mms);
+        for (size_t i = 0; i < num_mms; ++i) {
+          if (outputs[i].defined()) continue;
+          // the mms of the same shape as this one that are still to be done
+          std::vector<size_t> same_shape = {i};
+          for (size_t j = i + 1; j < num_mms; ++j) {
+            if (!outputs[j].defined() &&
+                lhses[j].sizes() == lhses[i].sizes() && rhses[j].sizes() == rhses[i].sizes() &&
+                lhses[j].type() == lhses[i].type() && rhses[j].type() == rhses[i].type()) {
+              same_shape.push_back(j);
+            }
+          }
+          if (same_shape.size() > 1 && lhses[i].dim() == 2 && rhses[i].dim() == 2 &&
+              shape_is_fast_for_stack(lhses[i], rhses[i])) {
+            std::vector<at::Tensor> lhs, rhs;
+            for (size_t j : same_shape) {
+              lhs.push_back(lhses[j]);
+              rhs.push_back(rhses[j]);
+            }
+            auto results = at::bmm(at::stack(lhs), at::stack(rhs)).unbind(0);
+            for (size_t k = 0; k < same_shape.size(); ++k) {
+              outputs[same_shape[k]] = std::move(results[k]);
+            }
+          } else {
+            outputs[i] = lhses[i].mm(rhses[i]);
+          }
+        }
+        stack.insert(stack.end(), std::make_move_iterator(outputs.begin()),
+                                  std::make_move_iterator(outputs.end()));
+        return 0;
+      };
+    })
+});
+
+// Is node a GEMM of value by a 2-d weight that prim::LinearBatchSide can run?
+bool isLinearOf(Node* node, Value* value) {
+  if (node->matches("aten::linear(Tensor input, Tensor weight, Tensor? bias) -> Tensor")) {
+    return node->inputs()[0] == value && node->inputs()[1] != value;
+  }
+  if (node->matches("aten::matmul(Tensor self, Tensor other) -> Tensor") ||
+      node->matches("aten::mm(Tensor self, Tensor mat2) -> Tensor")) {
+    // the weight gets transposed, which needs it to be 2-d
+    auto type = node->inputs()[1]->type()->cast<TensorType>();
+    return node->inputs()[0] == value && node->inputs()[1] != value &&
+        type && type->dim() == 2;
+  }
+  return false;
+}
+
+void BatchLinearSide(Block* block, const AliasDb& alias_db) {
+  Graph* graph = block->owningGraph();
+  std::unordered_set<Value*> considered_values;
+  // the batched nodes get moved, so iterate over a copy of the list
+  std::vector<Node*> nodes(block->nodes().begin(), block->nodes().end());
+  for (Node* node : nodes) {
+    for (Block* subblock : node->blocks()) {
+      BatchLinearSide(subblock, alias_db);
+    }
+    if (node->inputs().empty() || !isLinearOf(node, node->inputs()[0])) continue;
+    Value* input = node->inputs()[0];
+    if (!considered_values.emplace(input).second) continue;
+
+    std::vector<Node*> linears;
+    for (const Use& u : input->uses()) {
+      if (u.user->owningBlock() == block && u.offset == 0 && isLinearOf(u.user, input)) {
+        linears.push_back(u.user);
+      }
+    }
+    linears = filterIndependent(std::move(linears), alias_db);
+    if (linears.size() < min_linear_batch_size) continue;
+
+    bool has_bias = false;
+    for (Node* linear : linears) {
+      if (linear->kind() == aten::linear) {
+        auto bias_kind = linear->inputs()[2]->node()->kind();
+        has_bias = has_bias || (bias_kind != prim::None && bias_kind != prim::Undefined);
+      }
+    }
+    moveToLast(linears, alias_db);
+    WithInsertPoint insert_guard { linears.back() };
+    Node* batch_linear = graph->create(prim::LinearBatchSide,
+                                       /*inputs=*/{input}, /*num_outputs=*/linears.size());
+    batch_linear->i_(Symbol::attr("has_bias"), has_bias);
+    for (Node* linear : linears) {
+      Value* weight = linear->inputs()[1];
+      batch_linear->addInput(linear->kind() == aten::linear ? weight : graph->insert(aten::t, {weight}));
+    }
+    if (has_bias) {
+      for (Node* linear : linears) {
+        batch_linear->addInput(linear->kind() == aten::linear
+            ? linear->inputs()[2]
+            : graph->insertNode(graph->createNone(DynamicType::get()))->output());
+      }
+    }
+    graph->insertNode(batch_linear);
+    for (size_t i = 0; i < linears.size(); ++i) {
+      batch_linear->outputs()[i]->setType(linears[i]->output()->type());
+      linears[i]->output()->replaceAllUsesWith(batch_linear->outputs()[i]);
+    }
+  }
+}
+
+void BatchMMStack(Block* block, const AliasDb& alias_db) {
+  Graph* graph = block->owningGraph();
+  std::vector<Node*> mms;
+  for (Node* node : block->nodes()) {
+    for (Block* subblock : node->blocks()) {
+      BatchMMStack(subblock, alias_db);
+    }
+    if (node->matches("aten::mm(Tensor self, Tensor mat2) -> Tensor")) {
+      mms.push_back(node);
+    }
+  }
+  mms = filterIndependent(std::move(mms), alias_db);
+  if (mms.size() < min_mm_stack_size) return;
+
+  moveToLast(mms, alias_db);
+  WithInsertPoint insert_guard { mms.back() };
+  Node* batch_mm = graph->insertNode(graph->create(prim::MMBatchStack,
+                                                   /*inputs=*/{}, /*num_outputs=*/mms.size()));
+  for (Node* mm : mms) {
+    batch_mm->addInput(mm->inputs()[0]);
+  }
+  for (Node* mm : mms) {
+    batch_mm->addInput(mm->inputs()[1]);
+  }
+  for (size_t i = 0; i < mms.size(); ++i) {
+    batch_mm->outputs()[i]->setType(mms[i]->output()->type());
+    mms[i]->output()->replaceAllUsesWith(batch_mm->outputs()[i]);
+  }
+}
+
 bool hasMutableOperators(Block* block) {
   for (auto n : block->nodes()) {
     if (n->kind().is_aten() && n->schema().is_mutable())
@@ -411,6 +697,12 @@ void BatchMM(std::shared_ptr<Graph>& graph) {
   const auto alias_db = AliasAnalysis(graph);
   BatchMMTreeReduce(graph->block());
   BatchMMSide(graph->block(), alias_db);
+  // drop the mms replaced above, so they aren't batched again
+  EliminateDeadCode(graph);
+  // See Note [Batching independent GEMMs]
+  BatchLinearSide(graph->block(), alias_db);
+  EliminateDeadCode(graph);
+  BatchMMStack(graph->block(), alias_db);
   EliminateDeadCode(graph);
   // It's possible that transpose rearrangements have created sequences of consecutive
   // transposes that didn't exist before.
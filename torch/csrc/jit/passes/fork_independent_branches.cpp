@@ -0,0 +1,266 @@
+#include "torch/csrc/jit/passes/fork_independent_branches.h"
+
+#include "torch/csrc/jit/passes/alias_analysis.h"
+#include "torch/csrc/jit/passes/dead_code_elimination.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace torch { namespace jit {
+
+// A branch is a set of nodes of the top level block that computes a single
+// value, the output of its root, and whose other values are only used inside
+// the branch. For every node with several inputs (a join, e.g. the
+// aten::cat at the end of a multi-tower model, or the return node), the
+// branches computing its inputs are grown backwards from their roots, taking
+// every node whose outputs are only used by the branch. If at least two of
+// them cost more than the threshold, all but the last one are moved to a
+// prim::fork subgraph, and the calling thread runs the last one while the
+// others run on the inter-op pool:
+//
+//   %a = aten::mm(%x, %w1)              %fa = prim::fork[Subgraph=<a>](%x, %w1)
+//   %ra = aten::relu(%a)          =>    %b = aten::mm(%x, %w2)
+//   %b = aten::mm(%x, %w2)              %rb = aten::relu(%b)
+//   %rb = aten::relu(%b)                %ra = aten::wait(%fa)
+//   %l = prim::ListConstruct(%ra, %rb)  %l = prim::ListConstruct(%ra, %rb)
+//
+// The fork is placed right after the last value the branch reads is
+// computed, and the wait right before the first use of its output.
+// Branches only contain nodes without blocks or side effects that
+// AliasDb knows don't write to anything or read something written to by
+// another node, so running them at a different time is safe. Joins are
+// visited last to first, so the largest branches are found first; nodes
+// already moved into a fork are not visited again.
+
+namespace {
+
+// roughly the cost of one elementwise op
+constexpr size_t kOpCost = 1;
+// roughly the cost of an op with a reduction dimension, or an RNN
+constexpr size_t kHeavyOpCost = 10;
+
+bool isHeavyOp(const Node* node) {
+  static const std::unordered_set<Symbol> kinds = {
+    aten::mm,
+    aten::bmm,
+    aten::addmm,
+    aten::baddbmm,
+    aten::matmul,
+    aten::linear,
+    aten::_convolution,
+    aten::conv1d,
+    aten::conv2d,
+    aten::conv3d,
+    aten::conv_transpose1d,
+    aten::conv_transpose2d,
+    aten::conv_transpose3d,
+    aten::embedding_bag,
+    aten::lstm,
+    aten::gru,
+    aten::rnn_tanh,
+    prim::MMTreeReduce,
+    prim::MMBatchSide,
+    prim::LinearBatchSide,
+    prim::MMBatchStack,
+  };
+  return kinds.count(node->kind()) > 0;
+}
+
+size_t nodeCost(const Node* node) {
+  if (node->kind() == prim::FusionGroup) {
+    size_t cost = 0;
+    for (const Node* n : node->g(attr::Subgraph)->nodes()) {
+      cost += nodeCost(n);
+    }
+    return cost;
+  }
+  if (isHeavyOp(node)) {
+    return kHeavyOpCost;
+  }
+  for (const Value* output : node->outputs()) {
+    if (output->type()->isSubtypeOf(DynamicType::get())) {
+      return kOpCost;
+    }
+  }
+  return 0;
+}
+
+struct Branch {
+  std::vector<Node*> nodes; // in program order, the root is last
+  size_t cost = 0;
+};
+
+struct BranchForker {
+  BranchForker(std::shared_ptr<Graph> graph, size_t min_cost)
+      : graph_(std::move(graph)), aliasDb_(graph_), min_cost_(min_cost) {}
+
+  void run() {
+    Block* block = graph_->block();
+    for (Node* node : block->nodes()) {
+      index_.emplace(node, nodes_.size());
+      nodes_.push_back(node);
+    }
+
+    std::vector<Branch> forked;
+    std::vector<Node*> joins = {block->return_node()};
+    joins.insert(joins.end(), nodes_.rbegin(), nodes_.rend());
+    for (Node* join : joins) {
+      if (assigned_.count(join) > 0) continue;
+      std::vector<Branch> branches;
+      std::unordered_set<Node*> roots;
+      for (Value* input : join->inputs()) {
+        Node* root = input->node();
+        if (index_.count(root) == 0 || assigned_.count(root) > 0 ||
+            !roots.insert(root).second || !canFork(root) ||
+            root->outputs().size() != 1) {
+          continue;
+        }
+        auto branch = growBranch(root);
+        if (branch.cost >= min_cost_) {
+          branches.push_back(std::move(branch));
+        }
+      }
+      if (branches.size() < 2) continue;
+      std::sort(branches.begin(), branches.end(), [&](const Branch& a, const Branch& b) {
+        return index_.at(a.nodes.back()) < index_.at(b.nodes.back());
+      });
+      // the calling thread runs the last branch, its nodes may still be
+      // forked for joins inside it
+      branches.pop_back();
+      for (auto& branch : branches) {
+        assigned_.insert(branch.nodes.begin(), branch.nodes.end());
+        forked.push_back(std::move(branch));
+      }
+    }
+
+    for (const auto& branch : forked) {
+      fork(branch);
+    }
+  }
+
+ private:
+  bool canFork(Node* node) const {
+    if (!node->blocks().empty()) return false;
+    switch (node->kind()) {
+      case prim::Print:
+      case prim::RaiseException:
+      case prim::PythonOp:
+      case prim::fork:
+      case aten::warn:
+        return false;
+      default:
+        break;
+    }
+    static const Symbol wait = Symbol::fromQualString("aten::wait");
+    if (node->kind() == wait) return false;
+    return !aliasDb_.hasWildcard(node) && !aliasDb_.hasWriters(node);
+  }
+
+  Branch growBranch(Node* root) const {
+    std::unordered_set<Node*> members = {root};
+    for (size_t i = index_.at(root); i-- > 0;) {
+      Node* node = nodes_[i];
+      if (node->outputs().empty() || assigned_.count(node) > 0 || !canFork(node)) {
+        continue;
+      }
+      bool only_used_by_branch = true;
+      for (Value* output : node->outputs()) {
+        for (const Use& use : output->uses()) {
+          only_used_by_branch = only_used_by_branch && members.count(use.user) > 0;
+        }
+      }
+      if (only_used_by_branch) {
+        members.insert(node);
+      }
+    }
+    Branch branch;
+    branch.nodes.assign(members.begin(), members.end());
+    std::sort(branch.nodes.begin(), branch.nodes.end(), [&](Node* a, Node* b) {
+      return index_.at(a) < index_.at(b);
+    });
+    for (Node* node : branch.nodes) {
+      branch.cost += nodeCost(node);
+    }
+    return branch;
+  }
+
+  // the node of block that is or contains node
+  static Node* ownerInBlock(Node* node, Block* block) {
+    while (node->owningBlock() != block) {
+      node = node->owningBlock()->owningNode();
+    }
+    return node;
+  }
+
+  void fork(const Branch& branch) {
+    Block* block = graph_->block();
+    Node* root = branch.nodes.back();
+    Node* fork_node = graph_->create(prim::fork, 1)
+        ->setSourceLocation(root->getSourceLocation());
+    auto subgraph = std::make_shared<Graph>();
+
+    // the values the branch reads become inputs of the fork
+    std::unordered_map<Value*, Value*> env;
+    Node* last_producer = nullptr;
+    auto value_map = [&](Value* v) -> Value* {
+      auto it = env.find(v);
+      if (it != env.end()) return it->second;
+      fork_node->addInput(v);
+      Node* producer = v->node();
+      if (producer->kind() != prim::Param &&
+          (!last_producer || last_producer->isBefore(producer))) {
+        last_producer = producer;
+      }
+      return env[v] = subgraph->addInput()->copyMetadata(v);
+    };
+    for (Node* node : branch.nodes) {
+      Node* clone = subgraph->insertNode(subgraph->createClone(node, value_map));
+      for (size_t i = 0; i < node->outputs().size(); ++i) {
+        env[node->outputs()[i]] = clone->outputs()[i];
+      }
+    }
+    subgraph->registerOutput(env.at(root->output()));
+    fork_node->g_(attr::Subgraph, subgraph);
+    fork_node->output()->setType(FutureType::create(root->output()->type()));
+    if (last_producer) {
+      fork_node->insertAfter(last_producer);
+    } else {
+      fork_node->insertBefore(*block->nodes().begin());
+    }
+
+    Node* first_use = nullptr;
+    for (const Use& use : root->output()->uses()) {
+      Node* user = ownerInBlock(use.user, block);
+      if (!first_use || user->isBefore(first_use)) {
+        first_use = user;
+      }
+    }
+    Node* wait = graph_->create(Symbol::fromQualString("aten::wait"), {fork_node->output()}, 1)
+        ->setSourceLocation(root->getSourceLocation());
+    wait->output()->setType(root->output()->type());
+    wait->insertBefore(first_use);
+    root->output()->replaceAllUsesWith(wait->output());
+
+    for (auto it = branch.nodes.rbegin(); it != branch.nodes.rend(); ++it) {
+      (*it)->destroy();
+    }
+  }
+
+  std::shared_ptr<Graph> graph_;
+  AliasDb aliasDb_;
+  const size_t min_cost_;
+  std::vector<Node*> nodes_; // of the top level block, in program order
+  std::unordered_map<Node*, size_t> index_;
+  std::unordered_set<Node*> assigned_; // nodes of forked branches
+};
+
+} // anonymous namespace
+
+void ForkIndependentBranches(std::shared_ptr<Graph>& graph, size_t min_cost) {
+  BranchForker(graph, min_cost).run();
+  EliminateDeadCode(graph);
+}
+
+}}
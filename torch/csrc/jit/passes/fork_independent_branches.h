@@ -0,0 +1,20 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Branches cheaper than this (see branchCost in fork_independent_branches.cpp)
+// are not worth a task on the inter-op pool
+constexpr size_t kDefaultMinBranchCost = 10;
+
+// Moves independent branches of the top level block of graph that cost at
+// least min_cost into prim::fork subgraphs, with an aten::wait before their
+// first use, so that the interpreter runs them concurrently on the inter-op
+// pool. Only branches free of side effects and of ops that write to memory
+// other nodes can see are moved.
+TORCH_API void ForkIndependentBranches(
+    std::shared_ptr<Graph>& graph,
+    size_t min_cost = kDefaultMinBranchCost);
+
+}}
@@ -0,0 +1,284 @@
+#include "torch/csrc/jit/passes/freeze_module.h"
+
+#include "torch/csrc/jit/constants.h"
+#include "torch/csrc/jit/passes/constant_pooling.h"
+#include "torch/csrc/jit/passes/constant_propagation.h"
+#include "torch/csrc/jit/passes/dead_code_elimination.h"
+
+#include <ATen/ATen.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace torch { namespace jit {
+
+// Freezing turns a module into a set of graphs that only take the inputs of
+// its methods. Once parameters and buffers are constants, the existing
+// passes can evaluate everything that only depends on them: the
+// `self.training` checks and the branches they guard, weight.t() in linear
+// layers, etc. On top of that it does the rewrites that are only valid for
+// inference with fixed weights:
+//
+//    - dropout with train=False is the identity
+//    - batch_norm with training=False is an affine map per channel, which is
+//      folded into the weight and the bias of a convolution or linear layer
+//      that only feeds it
+//    - a transposed weight feeding a matrix multiply is stored transposed, so
+//      the GEMM reads it contiguously
+//
+// Linear layers are only folded with a following batch_norm if they are an
+// aten::addmm or an aten::linear of a 2-d input. In scripted code,
+// F.linear picks addmm at runtime, based on the rank of the input, so only
+// traced linear layers are folded.
+
+namespace {
+
+// The value of a constant tensor input, an undefined tensor for an absent
+// optional tensor, or nullopt if the value isn't known
+c10::optional<at::Tensor> constantTensor(Value* v) {
+  const auto kind = v->node()->kind();
+  if (kind == prim::Undefined || kind == prim::None) {
+    return at::Tensor();
+  }
+  auto ivalue = toIValue(v);
+  if (!ivalue || !ivalue->isTensor()) {
+    return c10::nullopt;
+  }
+  return ivalue->toTensor();
+}
+
+bool isConstantOne(Value* v) {
+  auto ivalue = toIValue(v);
+  return ivalue &&
+      ((ivalue->isInt() && ivalue->toInt() == 1) ||
+       (ivalue->isDouble() && ivalue->toDouble() == 1.0));
+}
+
+bool isDropout(Node* node) {
+  static const std::vector<Symbol> dropouts = {
+    aten::dropout,
+    aten::feature_dropout,
+    aten::alpha_dropout,
+    aten::feature_alpha_dropout,
+    Symbol::fromQualString("aten::dropout_"),
+    Symbol::fromQualString("aten::feature_dropout_"),
+    Symbol::fromQualString("aten::alpha_dropout_"),
+    Symbol::fromQualString("aten::feature_alpha_dropout_"),
+  };
+  return std::find(dropouts.begin(), dropouts.end(), node->kind()) != dropouts.end();
+}
+
+void RemoveDropout(Block* block) {
+  for (auto it = block->nodes().begin(); it != block->nodes().end();) {
+    Node* node = *it++;
+    for (Block* sub_block : node->blocks()) {
+      RemoveDropout(sub_block);
+    }
+    // dropout(input, p, train)
+    if (!isDropout(node)) continue;
+    auto train = constant_as<bool>(node->input(2));
+    if (train && !*train) {
+      node->output()->replaceAllUsesWith(node->input(0));
+      node->destroy();
+    }
+  }
+}
+
+// Multiplies the output channels of producer by scale and adds shift to them
+// by rewriting its weight and bias. Returns false if producer isn't a
+// convolution or linear layer with constant weights.
+bool foldIntoProducer(Node* producer, const at::Tensor& scale, const at::Tensor& shift) {
+  size_t weight_index = 1;
+  size_t bias_index = 2;
+  int64_t channel_dim = 0;
+  switch (producer->kind()) {
+    case aten::_convolution: {
+      // _convolution(input, weight, bias, stride, padding, dilation,
+      //              transposed, output_padding, groups, ...)
+      auto transposed = constant_as<bool>(producer->input(6));
+      if (!transposed || *transposed) return false;
+      break;
+    }
+    case aten::conv1d:
+    case aten::conv2d:
+    case aten::conv3d:
+      // conv{1,2,3}d(input, weight, bias, stride, padding, dilation, groups)
+      break;
+    case aten::linear: {
+      // linear(input, weight, bias); batch_norm normalizes dim 1, which
+      // only is the feature dim of a 2-d output
+      auto type = producer->input(0)->type()->cast<TensorType>();
+      if (!type || type->dim() != 2) return false;
+      break;
+    }
+    case aten::addmm:
+      // addmm(self, mat1, mat2, beta, alpha), where mat2 is the transposed
+      // weight
+      if (!isConstantOne(producer->input(3)) || !isConstantOne(producer->input(4))) {
+        return false;
+      }
+      weight_index = 2;
+      bias_index = 0;
+      channel_dim = 1;
+      break;
+    default:
+      return false;
+  }
+
+  auto weight = constantTensor(producer->input(weight_index));
+  auto bias = constantTensor(producer->input(bias_index));
+  if (!weight || !weight->defined() || !bias) return false;
+  const auto channels = scale.numel();
+  if (weight->dim() < 2 || weight->size(channel_dim) != channels ||
+      weight->scalar_type() != scale.scalar_type() ||
+      weight->device() != scale.device()) {
+    return false;
+  }
+  if (bias->defined() && (bias->dim() != 1 || bias->size(0) != channels)) {
+    return false;
+  }
+
+  std::vector<int64_t> scale_shape(weight->dim(), 1);
+  scale_shape[channel_dim] = -1;
+  at::Tensor new_weight = *weight * scale.reshape(scale_shape);
+  at::Tensor new_bias = bias->defined() ? *bias * scale + shift : shift;
+
+  auto graph = producer->owningGraph();
+  WithInsertPoint guard(producer);
+  producer->replaceInput(weight_index, graph->insertConstant(new_weight));
+  producer->replaceInput(bias_index, graph->insertConstant(new_bias));
+  return true;
+}
+
+void FoldBatchNorm(Block* block) {
+  for (auto it = block->nodes().begin(); it != block->nodes().end();) {
+    Node* node = *it++;
+    for (Block* sub_block : node->blocks()) {
+      FoldBatchNorm(sub_block);
+    }
+    // batch_norm(input, weight, bias, running_mean, running_var, training,
+    //            momentum, eps, cudnn_enabled)
+    if (node->kind() != aten::batch_norm) continue;
+    auto weight = constantTensor(node->input(1));
+    auto bias = constantTensor(node->input(2));
+    auto mean = constantTensor(node->input(3));
+    auto var = constantTensor(node->input(4));
+    auto training = constant_as<bool>(node->input(5));
+    auto eps = constant_as<double>(node->input(7));
+    if (!weight || !bias || !mean || !mean->defined() || !var ||
+        !var->defined() || !training || *training || !eps) {
+      continue;
+    }
+    Value* input = node->input(0);
+    if (input->uses().size() != 1) continue;
+
+    // y = (x - mean) / sqrt(var + eps) * weight + bias = x * scale + shift
+    at::Tensor scale = at::rsqrt(*var + *eps);
+    if (weight->defined()) scale = scale * *weight;
+    at::Tensor shift = -*mean * scale;
+    if (bias->defined()) shift = shift + *bias;
+    if (foldIntoProducer(input->node(), scale, shift)) {
+      node->output()->replaceAllUsesWith(input);
+      node->destroy();
+    }
+  }
+}
+
+void PretransposeLinearWeights(Block* block) {
+  for (Node* node : block->nodes()) {
+    for (Block* sub_block : node->blocks()) {
+      PretransposeLinearWeights(sub_block);
+    }
+    // addmm(self, mat1, mat2, ...), mm(self, mat2), matmul(self, other)
+    size_t index;
+    if (node->kind() == aten::addmm) {
+      index = 2;
+    } else if (node->kind() == aten::mm || node->kind() == aten::matmul) {
+      index = 1;
+    } else {
+      continue;
+    }
+    auto weight = constantTensor(node->input(index));
+    if (!weight || !weight->defined() || weight->dim() != 2 ||
+        weight->is_contiguous() || !weight->t().is_contiguous()) {
+      continue;
+    }
+    WithInsertPoint guard(node);
+    node->replaceInput(index, node->owningGraph()->insertConstant(weight->contiguous()));
+  }
+}
+
+bool inTrainingMode(const script::Module& module) {
+  // see ModuleValue::attr in script/init.cpp for how self.training is stored
+  if (auto training = module.get_parameters().find("training")) {
+    if (training->slot()->item<int64_t>() != 0) return true;
+  }
+  for (const auto& item : module.get_modules()) {
+    if (inTrainingMode(*item->module)) return true;
+  }
+  return false;
+}
+
+std::shared_ptr<Graph> freezeGraph(script::Method& method) {
+  method.ensure_defined();
+  auto graph = method.graph()->copy();
+  const auto params = method.params();
+  const size_t num_inputs = method.num_inputs();
+  {
+    WithInsertPoint guard(*graph->nodes().begin());
+    for (size_t i = 0; i < params.size(); ++i) {
+      const at::Tensor& param = *params[i];
+      Value* constant = param.defined()
+          ? graph->insertConstant(param)
+          : graph->insertNode(graph->createUndefined())->output();
+      graph->inputs().at(num_inputs + i)->replaceAllUsesWith(constant);
+    }
+  }
+  while (graph->inputs().size() > num_inputs) {
+    graph->eraseInput(graph->inputs().size() - 1);
+  }
+
+  ConstantPropagation(graph);
+  RemoveDropout(graph->block());
+  FoldBatchNorm(graph->block());
+  PretransposeLinearWeights(graph->block());
+  ConstantPropagation(graph);
+  ConstantPooling(graph);
+  EliminateDeadCode(graph);
+  return graph;
+}
+
+} // anonymous namespace
+
+void RemoveDropout(std::shared_ptr<Graph>& graph) {
+  RemoveDropout(graph->block());
+}
+
+void FoldBatchNorm(std::shared_ptr<Graph>& graph) {
+  FoldBatchNorm(graph->block());
+  EliminateDeadCode(graph);
+}
+
+void PretransposeLinearWeights(std::shared_ptr<Graph>& graph) {
+  PretransposeLinearWeights(graph->block());
+  EliminateDeadCode(graph);
+}
+
+std::shared_ptr<script::Module> FreezeModule(const script::Module& module) {
+  AT_CHECK(!inTrainingMode(module),
+      "can't freeze a module in training mode, call eval() on it first");
+  auto frozen = std::make_shared<script::Module>();
+  frozen->set_optimized(module.is_optimized());
+  for (const auto& item : module.get_modules()) {
+    frozen->register_module(item.key(), FreezeModule(*item->module));
+  }
+  for (const auto& item : module.get_methods()) {
+    script::Method& method = *item.value();
+    auto graph = freezeGraph(method);
+    frozen->create_method(item.key(), std::move(graph), {})
+        .setSchema(method.getSchema());
+  }
+  return frozen;
+}
+
+}}
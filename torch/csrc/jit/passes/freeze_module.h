@@ -0,0 +1,21 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/script/module.h"
+
+namespace torch { namespace jit {
+
+// Returns a copy of module specialized for inference. The parameters and
+// buffers used by its methods become constants, dropout and training-only
+// branches are removed, batch_norm is folded into the preceding convolution
+// or linear layer, and linear weights are stored pre-transposed. The module
+// must be in eval mode. The frozen module doesn't see later updates to the
+// parameters of the original one.
+TORCH_API std::shared_ptr<script::Module> FreezeModule(const script::Module& module);
+
+// The graph parts of FreezeModule, for graphs whose parameters are constants
+TORCH_API void RemoveDropout(std::shared_ptr<Graph>& graph);
+TORCH_API void FoldBatchNorm(std::shared_ptr<Graph>& graph);
+TORCH_API void PretransposeLinearWeights(std::shared_ptr<Graph>& graph);
+
+}}
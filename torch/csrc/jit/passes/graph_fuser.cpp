@@ -10,6 +10,7 @@
 #include "torch/csrc/jit/assertions.h"
 #include "ATen/ExpandUtils.h"
 #include <unordered_map>
+#include <algorithm>
 
 #ifdef USE_CUDA
   #include "cuda.h" // for CUDA_VERSION
@@ -113,6 +114,54 @@ bool isSimpleMap(Node *node) {
   return true;
 }
 
+// Is dim the innermost dimension of x, a tensor the CPU fuser can reduce?
+bool isInnermostCPUDim(Value * x, int64_t dim) {
+  auto type = x->type()->cast<TensorType>();
+  return type && type->device().is_cpu() && type->dim() > 0 &&
+      (type->scalarType() == at::kFloat || type->scalarType() == at::kDouble) &&
+      (dim == -1 || dim == type->dim() - 1);
+}
+
+// Can this node be fused as a reduction over the innermost dimension? (see
+// Note [Fused row reductions] in fuser/codegen.cpp) Only CPU kernels support
+// these, and the reduced dimension has to be a constant.
+bool isFusableRowReduction(Node * node) {
+  static OperatorSet list_dim_reductions {{
+    "aten::sum(Tensor self, int[] dim, bool keepdim) -> Tensor",
+    "aten::mean(Tensor self, int[] dim, bool keepdim) -> Tensor",
+  }};
+  static OperatorSet int_dim_reductions {{
+    "aten::max_values(Tensor self, int dim, bool keepdim) -> Tensor",
+    "aten::min_values(Tensor self, int dim, bool keepdim) -> Tensor",
+  }};
+  c10::optional<int64_t> dim;
+  if (list_dim_reductions.find(node)) {
+    auto dims = node->get<std::vector<int64_t>>(attr::dim);
+    if (dims && dims->size() == 1) dim = dims->at(0);
+  } else if (int_dim_reductions.find(node)) {
+    dim = node->get<int64_t>(attr::dim);
+  }
+  if (!dim || !node->is_constant(attr::keepdim)) {
+    return false;
+  }
+  if (!isInnermostCPUDim(node->input(0), *dim)) {
+    return false;
+  }
+  // Fused kernels don't produce 0-dim outputs
+  return *node->get<bool>(attr::keepdim) ||
+      node->input(0)->type()->expect<TensorType>()->dim() > 1;
+}
+
+bool keepsReducedDim(Node * node) {
+  return *node->get<bool>(attr::keepdim);
+}
+
+// Inside of fusion groups, reductions have been checked already
+bool isRowReductionKind(Node * node) {
+  return node->kind() == aten::sum || node->kind() == aten::mean ||
+      node->kind() == aten::max_values || node->kind() == aten::min_values;
+}
+
 Value * broadcastSizes(at::ArrayRef<Value*> sizes) {
   JIT_ASSERT(!sizes.empty());
   Graph * graph = sizes[0]->owningGraph();
@@ -138,7 +187,8 @@ struct GraphFuser {
     // We don't want to bother with cross-block node movements, as they
     // are not necessarily correct.
     if (node->owningBlock() != block_) return false;
-    return node->kind() == prim::FusionGroup || isSimpleMap(node);
+    return node->kind() == prim::FusionGroup || isSimpleMap(node) ||
+        (isFusableRowReduction(node) && keepsReducedDim(node));
   }
 
   bool isFusableCatNode(Node * node) {
@@ -164,8 +214,50 @@ struct GraphFuser {
     return isFusable(node) || isFusableOnlyAsExitNode(node);
   }
 
+  // Reductions that drop the reduced dimension are also exit nodes, as their
+  // results broadcast differently from the per-row values of the group.
   bool isFusableOnlyAsExitNode(Node * node) {
-    return isFusableCatNode(node) || node->kind() == prim::FusedConcat;
+    return isFusableCatNode(node) || node->kind() == prim::FusedConcat ||
+        (isFusableRowReduction(node) && !keepsReducedDim(node));
+  }
+
+  bool containsRowReductions(Node * node) {
+    if (node->kind() == prim::FusionGroup) {
+      auto nodes = getSubgraph(node).nodes();
+      return std::any_of(nodes.begin(), nodes.end(), isRowReductionKind);
+    }
+    return isRowReductionKind(node);
+  }
+
+  bool containsChunksOrConcats(Node * node) {
+    if (node->kind() == prim::FusionGroup) {
+      auto nodes = getSubgraph(node).nodes();
+      return std::any_of(nodes.begin(), nodes.end(), [](Node * n) {
+        return n->kind() == prim::ConstantChunk || n->kind() == prim::FusedConcat;
+      });
+    }
+    return node->kind() == aten::cat || node->kind() == prim::FusedConcat;
+  }
+
+  // Kernels with row reductions don't support chunks and concats
+  bool canFuseRowReductions(Node * consumer, Node * producer) {
+    if (!containsRowReductions(consumer) && !containsRowReductions(producer)) {
+      return true;
+    }
+    return !containsChunksOrConcats(consumer) && !containsChunksOrConcats(producer);
+  }
+
+  // Merging a producer group moves all of the consumer's uses of its outputs
+  // into the group, including uses of outputs that must remain outputs
+  bool consumerUsesExitOutputs(Node * consumer, Node * producer_group) {
+    if (producer_group->kind() != prim::FusionGroup) return false;
+    for (Value * output : producer_group->outputs()) {
+      if (!mustRemainAsFusionGroupOutput(output)) continue;
+      for (const Use & u : output->uses()) {
+        if (u.user == consumer) return true;
+      }
+    }
+    return false;
   }
 
   bool calculatesSize(Node * node) {
@@ -328,6 +420,17 @@ struct GraphFuser {
     return group;
   }
 
+  // Moves nodes, in program order and whose outputs are only used by the
+  // nodes after them except for the last one, into a new fusion group
+  Node * fuseNodes(const std::vector<Node*>& nodes) {
+    Node * group = createSingletonFusionGroup(nodes.back());
+    for (auto it = nodes.rbegin() + 1; it != nodes.rend(); ++it) {
+      mergeNodeIntoGroup(group, *it);
+      (*it)->destroy();
+    }
+    return group;
+  }
+
   // TODO: remove this and use WithInsertPoint instead
   void insertAt(Node ** insertion_point, Node * n) {
     n->insertAfter(*insertion_point);
@@ -347,6 +450,8 @@ struct GraphFuser {
         ? consumer->namedInput(attr::tensors)->node()
         : consumer;
     bool shouldFuse = isFusable(producer->node()) &&
+        canFuseRowReductions(consumer, producer->node()) &&
+        !consumerUsesExitOutputs(consumer, producer->node()) &&
         // Rearrange nodes such that all uses of producer are after the
         // consumer. Fusion will rewrite those later uses to use the version of
         // producer generated by the fused blob. In this case, producer becomes
@@ -398,7 +503,7 @@ struct GraphFuser {
   }
 
   bool canFuseChunk(Node* consumer, Value* producer) {
-    if (consumer->kind() != prim::FusionGroup) {
+    if (consumer->kind() != prim::FusionGroup || containsRowReductions(consumer)) {
       return false;
     }
     // Does the chunk have constant chunks/dim?
@@ -623,6 +728,7 @@ struct GraphFuser {
         chunk->inputs().end(),
         [&](Value * producer_for_chunk) {
           return isFusable(producer_for_chunk->node()) &&
+              !containsRowReductions(producer_for_chunk->node()) &&
               allUsersAreThisConsumerOrCalcSizes(chunk, producer_for_chunk);
         });
     if (it == chunk->inputs().end()) {
@@ -864,8 +970,17 @@ struct GraphFuser {
         shape_of.emplace(outputs.at(outputs.size() - 1), last_size);
         continue;
       }
+      // The shapes of reductions, and of the values computed from them, aren't
+      // broadcasts of input shapes.
+      if (isRowReductionKind(n)) {
+        continue;
+      }
       auto tensor_inputs = filter(n->inputs(),
                                   [](Value * v) { return v->type()->isSubtypeOf(DynamicType::get()); });
+      if (std::any_of(tensor_inputs.begin(), tensor_inputs.end(),
+                      [&](Value * v) { return shape_of.count(v) == 0; })) {
+        continue;
+      }
       auto shapes = fmap(tensor_inputs, [&](Value * v) { return shape_of.at(v); });
       JIT_ASSERT(!shapes.empty());
       shape_of.emplace(n->output(), shapes.size() == 1 ? shapes[0] : broadcastSizes(shapes));
@@ -999,12 +1114,170 @@ void PeepholeOptimizeShapeExpressions(Block * block) {
   }
 }
 
+bool isDefinedTensor(Value * v) {
+  return v->type()->isSubtypeOf(DynamicType::get()) &&
+      v->node()->kind() != prim::Undefined;
+}
+
+// The reductions keep the reduced dimension, so all intermediates have the
+// type of the input except for its sizes
+TypePtr withoutSizes(Value * x) {
+  auto type = x->type()->expect<TensorType>();
+  return type->withDim(type->dim());
+}
+
+Value * insertOp(Graph * graph, Symbol kind, at::ArrayRef<Value*> inputs, const TypePtr& type) {
+  Node * n = graph->insertNode(graph->create(kind, inputs));
+  n->output()->setType(type);
+  return n->output();
+}
+
+// The result of a decomposed normalization is tagged with the op it was
+// decomposed from, so that the fallback of its fusion group can run that op
+// instead (see RecomposeRowNormalizations)
+const Symbol kDecomposedFrom = Symbol::attr("decomposed_from");
+
+// Does the statically known tensor type of v have these sizes?
+bool hasSizes(Value * v, const std::vector<int64_t>& sizes) {
+  auto type = v->type()->cast<CompleteTensorType>();
+  return type && type->sizes() == sizes;
+}
+
+// Rewrites softmax, log_softmax and layer_norm over the innermost dimension of
+// CPU tensors into pointwise ops and row reductions, so that the graph fuser
+// can turn each of them into a single kernel (see Note [Fused row reductions]
+// in fuser/codegen.cpp). Unfused, the decomposition would be much slower than
+// the op, so it is moved into a fusion group of its own right away, which the
+// graph fuser then grows like any other.
+void DecomposeRowNormalizations(Block * block, const std::shared_ptr<Graph>& graph) {
+  for (auto it = block->nodes().begin(); it != block->nodes().end(); ++it) {
+    Node * node = *it;
+    for (Block * subblock : node->blocks()) {
+      DecomposeRowNormalizations(subblock, graph);
+    }
+    const bool is_softmax = node->matches("aten::softmax(Tensor self, int dim) -> Tensor", {attr::dim});
+    const bool is_log_softmax = node->matches("aten::log_softmax(Tensor self, int dim) -> Tensor", {attr::dim});
+    const bool is_layer_norm = node->matches(
+        "aten::layer_norm(Tensor input, int[] normalized_shape, Tensor? weight, Tensor? bias, float eps, bool cudnn_enable) -> Tensor",
+        {attr::normalized_shape, attr::eps});
+    if (!is_softmax && !is_log_softmax && !is_layer_norm) continue;
+
+    Value * x = node->input(0);
+    WithInsertPoint guard(node);
+    std::vector<Node*> ops;
+    auto op = [&](Symbol kind, at::ArrayRef<Value*> inputs, const TypePtr& type) {
+      Value * v = insertOp(graph.get(), kind, inputs, type);
+      ops.push_back(v->node());
+      return v;
+    };
+    Value * result = nullptr;
+    if (is_softmax || is_log_softmax) {
+      if (!isInnermostCPUDim(x, node->get<int64_t>(attr::dim).value())) continue;
+      // x - max(x) is never positive, so exp doesn't overflow
+      TypePtr type = withoutSizes(x);
+      Value * dim = graph->insertConstant(-1);
+      Value * dims = graph->insertConstant(std::vector<int64_t>{-1});
+      Value * keepdim = graph->insertConstant(true);
+      Value * one = graph->insertConstant(1);
+      Value * max = op(aten::max_values, {x, dim, keepdim}, type);
+      Value * shifted = op(aten::sub, {x, max, one}, type);
+      Value * exp = op(aten::exp, {shifted}, type);
+      Value * sum = op(aten::sum, {exp, dims, keepdim}, type);
+      if (is_softmax) {
+        result = op(aten::div, {exp, sum}, type);
+      } else {
+        Value * log_sum = op(aten::log, {sum}, type);
+        result = op(aten::sub, {shifted, log_sum, one}, type);
+      }
+      result->node()->s_(kDecomposedFrom, node->kind().toQualString());
+    } else {
+      Value * weight = node->namedInput(attr::weight);
+      Value * bias = node->namedInput(attr::bias);
+      auto normalized_shape = node->get<std::vector<int64_t>>(attr::normalized_shape).value();
+      // The decomposition broadcasts where layer_norm checks the sizes, so
+      // they must be known to match
+      if (normalized_shape.size() != 1 || !isInnermostCPUDim(x, -1) ||
+          !isDefinedTensor(weight) || !isDefinedTensor(bias) ||
+          !hasSizes(weight, normalized_shape) || !hasSizes(bias, normalized_shape)) {
+        continue;
+      }
+      auto x_type = x->type()->cast<CompleteTensorType>();
+      if (!x_type || x_type->sizes().back() != normalized_shape[0]) continue;
+      TypePtr type = withoutSizes(x);
+      double eps_value = node->get<double>(attr::eps).value();
+      Value * dims = graph->insertConstant(std::vector<int64_t>{-1});
+      Value * keepdim = graph->insertConstant(true);
+      Value * one = graph->insertConstant(1);
+      Value * eps = graph->insertConstant(eps_value);
+      Value * mean = op(aten::mean, {x, dims, keepdim}, type);
+      Value * centered = op(aten::sub, {x, mean, one}, type);
+      Value * squared = op(aten::mul, {centered, centered}, type);
+      Value * var = op(aten::mean, {squared, dims, keepdim}, type);
+      Value * var_eps = op(aten::add, {var, eps, one}, type);
+      Value * rstd = op(aten::rsqrt, {var_eps}, type);
+      Value * normalized = op(aten::mul, {centered, rstd}, type);
+      Value * scaled = op(aten::mul, {normalized, weight}, type);
+      result = op(aten::add, {scaled, bias, one}, type);
+      result->node()
+          ->s_(kDecomposedFrom, node->kind().toQualString())
+          ->is_(attr::normalized_shape, normalized_shape)
+          ->f_(attr::eps, eps_value);
+    }
+    result->setType(node->output()->type());
+    node->output()->replaceAllUsesWith(result);
+    GraphFuser(block, graph).fuseNodes(ops);
+    it.destroyCurrent();
+  }
+}
+
 } // anonymous namespace
 
+// The inverse of DecomposeRowNormalizations, for the fallback of a fusion
+// group. The decompositions are found from their tagged results, whose
+// inputs are the values the decomposition made of them.
+void RecomposeRowNormalizations(Graph& graph) {
+  for (auto it = graph.nodes().begin(); it != graph.nodes().end(); ++it) {
+    Node * node = *it;
+    if (!node->hasAttribute(kDecomposedFrom)) continue;
+    Symbol kind = Symbol::fromQualString(node->s(kDecomposedFrom));
+    WithInsertPoint guard(node);
+    Node * recomposed = nullptr;
+    if (kind == aten::softmax) {
+      // div(exp(sub(x, max)), sum)
+      Value * x = node->input(0)->node()->input(0)->node()->input(0);
+      recomposed = graph.create(aten::softmax, {x, graph.insertConstant(-1)});
+    } else if (kind == aten::log_softmax) {
+      // sub(sub(x, max), log(sum))
+      Value * x = node->input(0)->node()->input(0);
+      recomposed = graph.create(aten::log_softmax, {x, graph.insertConstant(-1)});
+    } else {
+      JIT_ASSERT(kind == aten::layer_norm);
+      // add(mul(mul(sub(x, mean), rstd), weight), bias)
+      Value * bias = node->input(1);
+      Node * scaled = node->input(0)->node();
+      Value * weight = scaled->input(1);
+      Value * x = scaled->input(0)->node()->input(0)->node()->input(0);
+      recomposed = graph.create(aten::layer_norm, {
+          x,
+          graph.insertConstant(node->is(attr::normalized_shape)),
+          weight,
+          bias,
+          graph.insertConstant(node->f(attr::eps)),
+          graph.insertConstant(false)});
+    }
+    graph.insertNode(recomposed)->output()->setType(node->output()->type());
+    node->output()->replaceAllUsesWith(recomposed->output());
+  }
+  EliminateDeadCode(graph.block());
+}
+
 void FuseGraph(std::shared_ptr<Graph>& graph) {
   // NYI on Windows
   #ifndef _WIN32
 
+  if (canFuseOnCPU()) {
+    DecomposeRowNormalizations(graph->block(), graph);
+  }
   GraphFuser(graph->block(), graph).run();
   // After FuseGraph some common subexpressions may come back
   EliminateCommonSubexpression(graph);
@@ -9,4 +9,8 @@ namespace torch { namespace jit {
 // On Windows will noop, NYI
 TORCH_API void FuseGraph(std::shared_ptr<Graph>& graph);
 
+// FuseGraph decomposes some ops into fusable ones on the CPU. This puts them
+// back together in the subgraph of a fusion group, for its fallback.
+TORCH_API void RecomposeRowNormalizations(Graph& graph);
+
 }}
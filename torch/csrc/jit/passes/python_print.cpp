@@ -1020,6 +1020,8 @@ TORCH_API bool printerHasSpecialCaseFor(Symbol sym) {
     prim::Load, // used in interpreter only
     prim::MMTreeReduce, // used as an optimization
     prim::MMBatchSide, // used as an optimization
+    prim::LinearBatchSide, // used as an optimization
+    prim::MMBatchStack, // used as an optimization
     prim::Store, // used in interpreter only
 
   };
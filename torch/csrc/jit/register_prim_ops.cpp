@@ -12,6 +12,7 @@
 #include "torch/csrc/variable_tensor_functions.h"
 
 #include <ATen/ExpandUtils.h>
+#include <ATen/Parallel.h>
 #include <ATen/WrapDimUtils.h>
 #include <c10/util/SmallVector.h>
 
@@ -640,7 +641,7 @@ RegisterOperators reg({
 
             push(stack, forked_interprester.getFuture());
 
-            c10::global_work_queue().run(std::move(continuation));
+            at::launch(std::move(continuation));
             return 0;
           };
         }),
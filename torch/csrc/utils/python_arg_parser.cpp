@@ -382,7 +382,15 @@ static void missing_args(const FunctionSignature& signature, int idx) {
 }
 
 static ssize_t find_param(FunctionSignature& signature, PyObject* name) {
+  // keywords are usually interned, like the parameter names
   ssize_t i = 0;
+  for (auto& param : signature.params) {
+    if (name == param.python_name) {
+      return i;
+    }
+    i++;
+  }
+  i = 0;
   for (auto& param : signature.params) {
     int cmp = PyObject_RichCompareBool(name, param.python_name, Py_EQ);
     if (cmp < 0) {
@@ -422,7 +430,7 @@ static void extra_kwargs(FunctionSignature& signature, PyObject* kwargs, ssize_t
 }
 
 bool FunctionSignature::parse(PyObject* args, PyObject* kwargs, PyObject* dst[],
-                              bool raise_exception) {
+                              bool raise_exception, bool* value_dependent) {
   auto nargs = PyTuple_GET_SIZE(args);
   ssize_t remaining_kwargs = kwargs ? PyDict_Size(kwargs) : 0;
   ssize_t arg_pos = 0;
@@ -455,7 +463,7 @@ bool FunctionSignature::parse(PyObject* args, PyObject* kwargs, PyObject* dst[],
         return false;
       }
       obj = PyTuple_GET_ITEM(args, arg_pos);
-    } else if (kwargs) {
+    } else if (remaining_kwargs > 0) {
       obj = PyDict_GetItem(kwargs, param.python_name);
       is_kwd = true;
     }
@@ -493,6 +501,11 @@ bool FunctionSignature::parse(PyObject* args, PyObject* kwargs, PyObject* dst[],
             param.type_name().c_str(), Py_TYPE(obj)->tp_name);
       }
     } else {
+      // Tensors can bind to numbers depending on their value, and so can
+      // objects with __index__ to a var-args IntList
+      if (value_dependent && (THPVariable_Check(obj) || (allow_varargs_intlist && arg_pos == 0))) {
+        *value_dependent = true;
+      }
       return false;
     }
 
@@ -531,6 +544,55 @@ PythonArgParser::PythonArgParser(std::vector<std::string> fmts, bool traceable)
   }
 }
 
+// Note [Signature cache]
+// ~~~~~~~~~~~~~~~~~~~~~~
+// With several signatures, the first one that the arguments bind to is
+// used, so a call whose arguments match the last signature is checked
+// against every other one first. But whether a signature fails mostly
+// depends on the types of the arguments, and the calls of a program keep
+// passing the same types. So when a call without keyword arguments binds to
+// signature i, and every signature before it failed because of the types of
+// the arguments only, the parser remembers i for these types, and the next
+// calls with the same types try signature i first. If an argument of a
+// failed signature was a tensor where a number was expected, it may bind
+// for another value, so nothing is remembered. A remembered signature
+// still checks the arguments, and if they don't bind after all, all the
+// signatures are tried in order. The parsers are static and only used with
+// the GIL held, so the cache needs no lock.
+
+bool PythonArgParser::cacheable(PyObject* args, PyObject* kwargs) const {
+  return PyTuple_GET_SIZE(args) <= kMaxCachedArgs && (!kwargs || PyDict_Size(kwargs) == 0);
+}
+
+PythonArgParser::SignatureCacheEntry* PythonArgParser::find_cached(PyObject* args) {
+  auto nargs = PyTuple_GET_SIZE(args);
+  for (auto& entry : signature_cache_) {
+    if (entry.nargs != nargs) continue;
+    bool same_types = true;
+    for (ssize_t i = 0; i < nargs && same_types; i++) {
+      same_types = entry.types[i] == Py_TYPE(PyTuple_GET_ITEM(args, i));
+    }
+    if (same_types) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void PythonArgParser::cache_signature(PyObject* args, int signature) {
+  auto& entry = signature_cache_[next_cache_entry_];
+  next_cache_entry_ = (next_cache_entry_ + 1) % kSignatureCacheSize;
+  for (ssize_t i = 0; i < entry.nargs; i++) {
+    Py_DECREF(entry.types[i]);
+  }
+  entry.nargs = PyTuple_GET_SIZE(args);
+  for (ssize_t i = 0; i < entry.nargs; i++) {
+    entry.types[i] = Py_TYPE(PyTuple_GET_ITEM(args, i));
+    Py_INCREF(entry.types[i]);
+  }
+  entry.signature = signature;
+}
+
 PythonArgs PythonArgParser::raw_parse(PyObject* args, PyObject* kwargs, PyObject* parsed_args[]) {
   if (signatures_.size() == 1) {
     auto& signature = signatures_[0];
@@ -538,9 +600,26 @@ PythonArgs PythonArgParser::raw_parse(PyObject* args, PyObject* kwargs, PyObject
     return PythonArgs(0, traceable, signature, parsed_args);
   }
 
+  bool cache = cacheable(args, kwargs);
+  if (cache) {
+    if (auto* entry = find_cached(args)) {
+      // parsing may run Python code, that may parse with this parser too
+      int idx = entry->signature;
+      auto& signature = signatures_[idx];
+      if (signature.parse(args, kwargs, parsed_args, false)) {
+        return PythonArgs(idx, traceable, signature, parsed_args);
+      }
+      cache = false;
+    }
+  }
+
   int i = 0;
+  bool value_dependent = false;
   for (auto& signature : signatures_) {
-    if (signature.parse(args, kwargs, parsed_args, false)) {
+    if (signature.parse(args, kwargs, parsed_args, false, &value_dependent)) {
+      if (cache && !value_dependent) {
+        cache_signature(args, i);
+      }
       return PythonArgs(i, traceable, signature, parsed_args);
     }
     i++;
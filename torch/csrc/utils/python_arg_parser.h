@@ -58,6 +58,7 @@
 #include "torch/csrc/autograd/variable.h"
 
 #include <ATen/ATen.h>
+#include <ATen/core/DimVector.h>
 
 #include <array>
 #include <cstddef>
@@ -94,10 +95,26 @@ private:
   void print_error(PyObject* args, PyObject* kwargs, PyObject* parsed_args[]);
   PythonArgs raw_parse(PyObject* args, PyObject* kwargs, PyObject* parsed_args[]);
 
+  // The signature that the last calls with the same types of positional
+  // arguments bound to, see Note [Signature cache]
+  static constexpr int kMaxCachedArgs = 6;
+  static constexpr int kSignatureCacheSize = 4;
+  struct SignatureCacheEntry {
+    ssize_t nargs = -1;
+    // owning references, so that a type isn't freed and its address reused
+    std::array<PyTypeObject*, kMaxCachedArgs> types;
+    int signature = -1;
+  };
+  bool cacheable(PyObject* args, PyObject* kwargs) const;
+  SignatureCacheEntry* find_cached(PyObject* args);
+  void cache_signature(PyObject* args, int signature);
+
   std::vector<FunctionSignature> signatures_;
   std::string function_name;
   ssize_t max_args;
   bool traceable;
+  std::array<SignatureCacheEntry, kSignatureCacheSize> signature_cache_;
+  int next_cache_entry_ = 0;
 };
 
 struct PythonArgs {
@@ -118,8 +135,9 @@ struct PythonArgs {
   inline std::vector<at::Tensor> tensorlist(int i);
   template<int N>
   inline std::array<at::Tensor, N> tensorlist_n(int i);
-  inline std::vector<int64_t> intlist(int i);
-  inline std::vector<int64_t> intlistWithDefault(int i, std::vector<int64_t> default_intlist);
+  // sizes of up to five dimensions don't allocate
+  inline at::DimVector intlist(int i);
+  inline at::DimVector intlistWithDefault(int i, at::IntList default_intlist);
   inline at::Generator* generator(int i);
   inline at::Storage storage(int i);
   inline at::ScalarType scalartype(int i);
@@ -145,7 +163,11 @@ struct PythonArgs {
 struct FunctionSignature {
   explicit FunctionSignature(const std::string& fmt);
 
-  bool parse(PyObject* args, PyObject* kwargs, PyObject* dst[], bool raise_exception);
+  // If parsing fails because an argument doesn't match its parameter and
+  // that may depend on the value of the argument and not only on its type,
+  // sets *value_dependent
+  bool parse(PyObject* args, PyObject* kwargs, PyObject* dst[], bool raise_exception,
+             bool* value_dependent = nullptr);
   std::string toString() const;
 
   std::string name;
@@ -250,14 +272,15 @@ inline std::vector<at::Tensor> PythonArgs::tensorlist(int i) {
   PyObject* arg = args[i];
   auto tuple = PyTuple_Check(arg);
   auto size = tuple ? PyTuple_GET_SIZE(arg) : PyList_GET_SIZE(arg);
-  std::vector<at::Tensor> res(size);
+  std::vector<at::Tensor> res;
+  res.reserve(size);
   for (int idx = 0; idx < size; idx++) {
     PyObject* obj = tuple ? PyTuple_GET_ITEM(arg, idx) : PyList_GET_ITEM(arg, idx);
     if (!THPVariable_Check(obj)) {
       throw TypeError("expected Tensor as element %d in argument %d, but got %s",
                  idx, i, Py_TYPE(obj)->tp_name);
     }
-    res[idx] = reinterpret_cast<THPVariable*>(obj)->cdata;
+    res.push_back(reinterpret_cast<THPVariable*>(obj)->cdata);
   }
   return res;
 }
@@ -283,20 +306,20 @@ inline std::array<at::Tensor, N> PythonArgs::tensorlist_n(int i) {
   return res;
 }
 
-inline std::vector<int64_t> PythonArgs::intlist(int i) {
+inline at::DimVector PythonArgs::intlist(int i) {
   return intlistWithDefault(i, signature.params[i].default_intlist);
 }
 
-inline std::vector<int64_t> PythonArgs::intlistWithDefault(int i, std::vector<int64_t> default_intlist) {
-  if (!args[i]) return default_intlist;
+inline at::DimVector PythonArgs::intlistWithDefault(int i, at::IntList default_intlist) {
+  if (!args[i]) return at::DimVector(default_intlist.begin(), default_intlist.end());
   PyObject* arg = args[i];
   auto size = signature.params[i].size;
   if (size > 0 && THPUtils_checkLong(arg)) {
-    return std::vector<int64_t>(size, THPUtils_unpackIndex(arg));
+    return at::DimVector(size, THPUtils_unpackIndex(arg));
   }
   auto tuple = PyTuple_Check(arg);
   size = tuple ? PyTuple_GET_SIZE(arg) : PyList_GET_SIZE(arg);
-  std::vector<int64_t> res(size);
+  at::DimVector res(size);
   for (int idx = 0; idx < size; idx++) {
     PyObject* obj = tuple ? PyTuple_GET_ITEM(arg, idx) : PyList_GET_ITEM(arg, idx);
     try {
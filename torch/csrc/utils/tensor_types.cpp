@@ -72,13 +72,18 @@ std::vector<std::pair<Backend, ScalarType>> all_declared_types() {
   // can't easily iterate over enum classes
   std::vector<Backend> backends = { Backend::CPU, Backend::CUDA, Backend::SparseCPU, Backend::SparseCUDA };
   std::vector<ScalarType> scalar_types = { ScalarType::Byte, ScalarType::Char, ScalarType::Double, ScalarType::Float,
-                                           ScalarType::Int, ScalarType::Long, ScalarType::Short, ScalarType::Half};
+                                           ScalarType::Int, ScalarType::Long, ScalarType::Short, ScalarType::Half,
+                                           ScalarType::BFloat16};
   for (auto& backend : backends) {
     for (auto& scalar_type : scalar_types) {
       // there is no sparse half types.
       if (scalar_type == ScalarType::Half && (backend == Backend::SparseCUDA || backend == Backend::SparseCPU)) {
         continue;
       }
+      // bfloat16 is only implemented for dense CPU tensors.
+      if (scalar_type == ScalarType::BFloat16 && backend != Backend::CPU) {
+        continue;
+      }
       ret.emplace_back(std::make_pair(backend, scalar_type));
     }
   }
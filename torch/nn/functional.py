@@ -1456,8 +1456,9 @@ def embedding(input, weight, padding_idx=None, max_norm=None, norm_type=2.,
 
 @torch._jit_internal.weak_script
 def embedding_bag(input, weight, offsets=None, max_norm=None, norm_type=2,
-                  scale_grad_by_freq=False, mode='mean', sparse=False):
-    # type: (Tensor, Tensor, Optional[Tensor], Optional[float], float, bool, str, bool) -> Tensor
+                  scale_grad_by_freq=False, mode='mean', sparse=False,
+                  per_sample_weights=None):
+    # type: (Tensor, Tensor, Optional[Tensor], Optional[float], float, bool, str, bool, Optional[Tensor]) -> Tensor
     r"""Computes sums, means or maxes of 'bags' of embeddings, without instantiating the
     intermediate embeddings.
 
@@ -1483,6 +1484,10 @@ def embedding_bag(input, weight, offsets=None, max_norm=None, norm_type=2,
         sparse (bool, optional): if ``True``, gradient w.r.t. :attr:`weight` will be a sparse tensor. See Notes under
                                  :class:`torch.nn.Embedding` for more details regarding sparse gradients.
                                  Note: this option is not supported when ``mode="max"``.
+        per_sample_weights (Tensor, optional): a tensor of float / double weights of the same shape
+                                 as :attr:`input`. Every embedding is scaled by its weight before
+                                 the bag is reduced. Only supported for ``mode="sum"`` on CPU.
+                                 Default ``None``: all weights are taken to be ``1``.
 
     Shape:
 
@@ -1528,6 +1533,18 @@ def embedding_bag(input, weight, offsets=None, max_norm=None, norm_type=2,
                       "and should now be `embedding_bag(input, weight, ...)`.")
         weight, input = input, weight
 
+    if per_sample_weights is not None:
+        if mode != 'sum':
+            raise NotImplementedError("embedding_bag: per_sample_weights was not None. "
+                                      "per_sample_weights is only supported for mode='sum' "
+                                      "(got mode='{}'). Please open a feature request on GitHub."
+                                      .format(mode))
+        if input.size() != torch.jit._unwrap_optional(per_sample_weights).size():
+            raise ValueError("embedding_bag: If per_sample_weights ({}) is not None, "
+                             "then it must have the same shape as the input ({})"
+                             .format(torch.jit._unwrap_optional(per_sample_weights).shape,
+                                     input.shape))
+
     if input.dim() == 2:
         if offsets is not None:
             raise ValueError("if input is 2D, then offsets has to be None"
@@ -1539,6 +1556,8 @@ def embedding_bag(input, weight, offsets=None, max_norm=None, norm_type=2,
                                    dtype=torch.long, device=input.device)
 
             input = input.reshape(-1)
+            if per_sample_weights is not None:
+                per_sample_weights = torch.jit._unwrap_optional(per_sample_weights).reshape(-1)
     elif input.dim() == 1:
         if offsets is None:
             raise ValueError("offsets has to be a 1D Tensor but got None")
@@ -1588,7 +1607,8 @@ def embedding_bag(input, weight, offsets=None, max_norm=None, norm_type=2,
         offsets,
         scale_grad_by_freq,
         mode_enum,
-        sparse)
+        sparse,
+        per_sample_weights)
     return ret
 
 
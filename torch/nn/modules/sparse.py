@@ -216,6 +216,10 @@ class EmbeddingBag(Module):
           having ``B`` bags. Empty bags (i.e., having 0-length) will have
           returned vectors filled by zeros.
 
+        - :attr:`per_sample_weights` (Tensor, optional) has the same shape as :attr:`input`
+          and holds one weight per index. With ``mode="sum"`` every embedding is scaled by
+          its weight before the bag is summed. Only supported on CPU.
+
     Output shape: ``B x embedding_dim``
 
     Examples::
@@ -251,11 +255,12 @@ class EmbeddingBag(Module):
         init.normal_(self.weight)
 
     @weak_script_method
-    def forward(self, input, offsets=None):
-        # type: (Tensor, Optional[Tensor]) -> Tensor
+    def forward(self, input, offsets=None, per_sample_weights=None):
+        # type: (Tensor, Optional[Tensor], Optional[Tensor]) -> Tensor
         return F.embedding_bag(input, self.weight, offsets,
                                self.max_norm, self.norm_type,
-                               self.scale_grad_by_freq, self.mode, self.sparse)
+                               self.scale_grad_by_freq, self.mode, self.sparse,
+                               per_sample_weights)
 
     def extra_repr(self):
         s = '{num_embeddings}, {embedding_dim}'
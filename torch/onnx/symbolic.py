@@ -360,14 +360,17 @@ def embedding(g, weight, indices, padding_idx, scale_grad_by_freq, sparse):
     return g.op("Gather", weight, indices)
 
 
-@parse_args('v', 'v', 'v', 'i', 'i', 'i')
+@parse_args('v', 'v', 'v', 'i', 'i', 'i', 'v')
 def embedding_bag(g,
                   embedding_matrix,
                   indices,
                   offsets,
                   scale_grad_by_freq,
                   mode,
-                  sparse):
+                  sparse,
+                  per_sample_weights):
+    if per_sample_weights is not None and per_sample_weights.node().kind() != "prim::Undefined":
+        return _unimplemented("embedding_bag", "per_sample_weights")
     return g.op("ATen",
                 embedding_matrix,
                 indices,
@@ -1,4 +1,5 @@
 from __future__ import absolute_import, division, print_function, unicode_literals
+import contextlib
 import torch
 import warnings
 
@@ -82,7 +83,7 @@ class CheckpointFunction(torch.autograd.Function):
         return (None,) + tuple(inp.grad for inp in detached_inputs)
 
 
-def checkpoint(function, *args):
+def checkpoint(function, *args, **kwargs):
     r"""Checkpoint a model or part of the model
 
     Checkpointing works by trading compute for memory. Rather than storing all
@@ -121,13 +122,97 @@ def checkpoint(function, *args):
             ``(activation, hidden)``, :attr:`function` should correctly use the
             first input as ``activation`` and the second input as ``hidden``
         args: tuple containing inputs to the :attr:`function`
+        native (bool, optional): run the checkpoint in the C++ autograd
+            instead of a Python :class:`~torch.autograd.Function`, which
+            avoids the Python overhead in backward. Only the CPU RNG state is
+            restored when :attr:`function` runs again, the CUDA one is not,
+            even if :attr:`preserve_rng_state` is set. Default: ``False``
 
     Returns:
         Output of running :attr:`function` on :attr:`*args`
     """
+    native = kwargs.pop('native', False)
+    if kwargs:
+        raise ValueError("Unexpected keyword arguments: " + ",".join(arg for arg in kwargs))
+    if native:
+        check_backward_validity(args)
+        returns_tensor = []
+
+        def run_function(*inputs):
+            outputs = function(*inputs)
+            if not returns_tensor:
+                returns_tensor.append(isinstance(outputs, torch.Tensor))
+            return outputs
+
+        outputs = torch.autograd._checkpoint(run_function, args)
+        return outputs[0] if returns_tensor[0] else tuple(outputs)
     return CheckpointFunction.apply(function, *args)
 
 
+@contextlib.contextmanager
+def offload_saved_tensors(enabled=True):
+    r"""Context-manager that moves the CUDA tensors saved for backward by the
+    operations run inside it to pinned host memory, and back to the device
+    when backward needs them.
+
+    This lowers the device memory used by the activations of a model, at the
+    cost of a copy to the host in forward and one back in backward. Like
+    :class:`torch.no_grad`, it is thread local. Tensors that are not
+    contiguous, and CPU tensors, are not moved.
+
+    Example:
+        >>> with torch.utils.checkpoint.offload_saved_tensors():
+        ...     loss = model(input).sum()
+        >>> loss.backward()
+    """
+    prev = torch.autograd._is_saved_tensors_offload_enabled()
+    torch.autograd._set_saved_tensors_offload(enabled)
+    try:
+        yield
+    finally:
+        torch.autograd._set_saved_tensors_offload(prev)
+
+
+@contextlib.contextmanager
+def record_saved_tensors_memory(enabled=True):
+    r"""Context-manager that counts the tensors saved for backward while it
+    is active in :func:`saved_tensors_memory_stats`.
+
+    Counting is off by default, since it updates counters shared by all
+    threads every time a tensor is saved. Unlike
+    :func:`offload_saved_tensors`, the switch is global, not thread local.
+    Tensors saved while counting are subtracted when they are freed, even if
+    counting was turned off in between.
+    """
+    prev = torch.autograd._is_saved_tensors_memory_stats_enabled()
+    torch.autograd._set_saved_tensors_memory_stats_enabled(enabled)
+    try:
+        yield
+    finally:
+        torch.autograd._set_saved_tensors_memory_stats_enabled(prev)
+
+
+def saved_tensors_memory_stats(reset_peak=False):
+    r"""Returns the bytes of the tensors saved for backward, in all threads,
+    by the operations run inside :func:`record_saved_tensors_memory`.
+
+    The dict has ``resident_bytes``, kept where they were computed,
+    ``offloaded_bytes``, moved to host memory by
+    :func:`offload_saved_tensors`, and the ``peak_resident_bytes`` and
+    ``peak_offloaded_bytes`` since the last reset. A tensor is counted again
+    for every operation that saves it. Comparing the peaks of a model with
+    and without :func:`checkpoint` shows the memory it saves.
+
+    Arguments:
+        reset_peak (bool, optional): set the peaks to the current number of
+            bytes after reading them. Default: ``False``
+    """
+    stats = torch.autograd._saved_tensors_memory_stats()
+    if reset_peak:
+        torch.autograd._reset_peak_saved_tensors_memory_stats()
+    return stats
+
+
 def checkpoint_sequential(functions, segments, *inputs):
     r"""A helper function for checkpointing sequential models.
 